@@ -20,10 +20,24 @@
 #ifndef __CDEMU_AUDIO_PRIVATE_H__
 #define __CDEMU_AUDIO_PRIVATE_H__
 
+/* Playback buffer: four seconds of audio, filled in batches of one second */
+#define AUDIO_SECTOR_SIZE 2352
+#define AUDIO_BUFFER_SECTORS (4*75)
+#define AUDIO_READ_BATCH 75
+
+/* State of reader thread */
+typedef enum
+{
+    AUDIO_READER_RUNNING = 0,
+    AUDIO_READER_COMPLETED = 1,
+    AUDIO_READER_FAILED = 2,
+} CdemuAudioReaderState;
+
 struct _CdemuAudioPrivate
 {
-    /* Thread */
+    /* Threads */
     GThread *playback_thread;
+    GThread *reader_thread;
 
     /* libao device */
     gint driver_id;
@@ -45,6 +59,19 @@ struct _CdemuAudioPrivate
     /* Status */
     gint status;
 
+    /* Ring buffer; counters are accessed atomically */
+    guint8 *buffer;
+    gint buffer_written; /* Number of sectors written into buffer */
+    gint buffer_played; /* Number of sectors played from buffer */
+
+    GMutex buffer_mutex; /* Used only for sleeping on buffer_cond */
+    GCond buffer_cond;
+
+    gint read_sector; /* Next sector to be read (reader thread only) */
+    gint reader_state; /* CdemuAudioReaderState */
+
+    gint underruns; /* Number of times buffer ran dry during playback */
+
     /* A hack to account for null driver's behaviour */
     gboolean null_hack;
 };
@@ -23,9 +23,114 @@
 #define __debug__ "AudioPlay"
 
 
+/* Playback is split between two threads, connected by a ring buffer that
+   holds several seconds of audio: the reader thread fills the buffer with
+   sectors' data, which it reads from the disc in batches, and the playback
+   thread drains it into the audio device, one sector at a time. The device
+   mutex is held only while a batch is being read; commands (including long
+   READs) therefore wait for at most a single batch, and in turn do not stall
+   the playback, as long as the buffer does not run dry.
+
+   The buffer has a single producer and a single consumer, and is lock-free:
+   each side advances its own counter (of sectors written and played,
+   respectively) with an atomic operation, after it has filled or consumed
+   the buffer slots. The buffer mutex and condition are used only to sleep
+   while the buffer is full (reader) or empty (player), and to wake up the
+   other side. */
+
+
+/**********************************************************************\
+ *                          Ring buffer functions                     *
+\**********************************************************************/
+static void cdemu_audio_buffer_wake (CdemuAudio *self)
+{
+    g_mutex_lock(&self->priv->buffer_mutex);
+    g_cond_broadcast(&self->priv->buffer_cond);
+    g_mutex_unlock(&self->priv->buffer_mutex);
+}
+
+static guint cdemu_audio_buffer_get_depth (CdemuAudio *self)
+{
+    /* Counters are free-running; unsigned difference accounts for wrap-around */
+    return (guint)g_atomic_int_get(&self->priv->buffer_written) - (guint)g_atomic_int_get(&self->priv->buffer_played);
+}
+
+
 /**********************************************************************\
  *                          Playback functions                        *
 \**********************************************************************/
+static gpointer cdemu_audio_reader_thread (CdemuAudio *self)
+{
+    gint reader_state = AUDIO_READER_COMPLETED;
+
+    CDEMU_DEBUG(self, DAEMON_DEBUG_AUDIOPLAY, "%s: reader thread start\n", __debug__);
+
+    while (self->priv->read_sector <= self->priv->end_sector) {
+        guint remaining = self->priv->end_sector - self->priv->read_sector + 1;
+        guint written = g_atomic_int_get(&self->priv->buffer_written);
+        guint slot = written % AUDIO_BUFFER_SECTORS;
+        guint num_free;
+        gint num_sectors, num_read;
+        GError *error = NULL;
+
+        /* Wait until there is room for a whole batch (or for the rest of
+           playing range) */
+        g_mutex_lock(&self->priv->buffer_mutex);
+        while (self->priv->status == AUDIO_STATUS_PLAYING && AUDIO_BUFFER_SECTORS - cdemu_audio_buffer_get_depth(self) < MIN(remaining, AUDIO_READ_BATCH)) {
+            g_cond_wait(&self->priv->buffer_cond, &self->priv->buffer_mutex);
+        }
+        g_mutex_unlock(&self->priv->buffer_mutex);
+
+        /* Make reader thread interruptible */
+        if (self->priv->status != AUDIO_STATUS_PLAYING) {
+            CDEMU_DEBUG(self, DAEMON_DEBUG_AUDIOPLAY, "%s: reader thread interrupted\n", __debug__);
+            break;
+        }
+
+        /* Batch must not wrap around the end of buffer */
+        num_free = AUDIO_BUFFER_SECTORS - cdemu_audio_buffer_get_depth(self);
+        num_sectors = MIN(MIN(num_free, remaining), MIN(AUDIO_BUFFER_SECTORS - slot, AUDIO_READ_BATCH));
+
+        /*** Lock device mutex ***/
+        g_mutex_lock(self->priv->device_mutex);
+
+        /* Read batch; reading stops at the first non-audio sector */
+        CDEMU_DEBUG(self, DAEMON_DEBUG_AUDIOPLAY, "%s: reading %d sectors at %d (0x%X)\n", __debug__, num_sectors, self->priv->read_sector, self->priv->read_sector);
+        num_read = mirage_disc_read_sectors(self->priv->disc, self->priv->read_sector, num_sectors, AUDIO_SECTOR_SIZE, self->priv->buffer + slot*AUDIO_SECTOR_SIZE, &error);
+
+        /*** Unlock device mutex ***/
+        g_mutex_unlock(self->priv->device_mutex);
+
+        /* This one covers read errors, sector not being an audio one and
+           sector changing from audio to data one */
+        if (num_read <= 0) {
+            if (error) {
+                CDEMU_DEBUG(self, DAEMON_DEBUG_AUDIOPLAY, "%s: failed to read sector 0x%X: %s\n", __debug__, self->priv->read_sector, error->message);
+                g_error_free(error);
+            } else {
+                CDEMU_DEBUG(self, DAEMON_DEBUG_AUDIOPLAY, "%s: non-audio sector 0x%X!\n", __debug__, self->priv->read_sector);
+            }
+            reader_state = AUDIO_READER_FAILED;
+            break;
+        }
+
+        /* Publish the sectors */
+        self->priv->read_sector += num_read;
+        g_atomic_int_set(&self->priv->buffer_written, written + num_read);
+
+        cdemu_audio_buffer_wake(self);
+    }
+
+    /* Let the player know there is nothing more to come; it finishes the
+       playback once it drains the buffer */
+    g_atomic_int_set(&self->priv->reader_state, reader_state);
+    cdemu_audio_buffer_wake(self);
+
+    CDEMU_DEBUG(self, DAEMON_DEBUG_AUDIOPLAY, "%s: reader thread end\n", __debug__);
+
+    return NULL;
+}
+
 static gpointer cdemu_audio_playback_thread (CdemuAudio *self)
 {
     gint audio_driver_id = self->priv->driver_id;
@@ -41,6 +146,8 @@ static gpointer cdemu_audio_playback_thread (CdemuAudio *self)
         self->priv->device = ao_open_live(audio_driver_id, &self->priv->format, NULL /* no options */);
         if (self->priv->device == NULL) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to open 'null' audio device!\n", __debug__);
+            self->priv->status = AUDIO_STATUS_ERROR; /* Audio operation stopped due to error */
+            cdemu_audio_buffer_wake(self); /* Stop the reader */
             return NULL;
         }
     }
@@ -55,14 +162,11 @@ static gpointer cdemu_audio_playback_thread (CdemuAudio *self)
     CDEMU_DEBUG(self, DAEMON_DEBUG_AUDIOPLAY, "%s: playback thread start\n", __debug__);
 
     while (1) {
-        /* Process sectors; we go over playing range, check sectors' type, keep
-           track of where we are and try to produce some sound. libao's play
+        /* Process sectors; we take them from the buffer in order, keep track
+           of where we are and try to produce some sound. libao's play
            function should keep our timing */
-        MirageSector *sector;
-        GError *error = NULL;
+        guint played = g_atomic_int_get(&self->priv->buffer_played);
         const guint8 *tmp_buffer;
-        gint tmp_len;
-        gint type;
 
         /* Make playback thread interruptible (i.e. if status is changed, it's
            going to end */
@@ -71,52 +175,45 @@ static gpointer cdemu_audio_playback_thread (CdemuAudio *self)
             break;
         }
 
-        /* Check if we have already reached the end */
-        if (self->priv->cur_sector > self->priv->end_sector) {
-            CDEMU_DEBUG(self, DAEMON_DEBUG_AUDIOPLAY, "%s: playback thread reached the end\n", __debug__);
-            self->priv->status = AUDIO_STATUS_COMPLETED; /* Audio operation successfully completed */
-            break;
+        /* Buffer is empty; either we have reached the end (or the sector
+           that cannot be played), or reader has not kept up */
+        if (!cdemu_audio_buffer_get_depth(self)) {
+            gint reader_state = g_atomic_int_get(&self->priv->reader_state);
+
+            if (reader_state == AUDIO_READER_COMPLETED) {
+                CDEMU_DEBUG(self, DAEMON_DEBUG_AUDIOPLAY, "%s: playback thread reached the end\n", __debug__);
+                self->priv->status = AUDIO_STATUS_COMPLETED; /* Audio operation successfully completed */
+                break;
+            } else if (reader_state == AUDIO_READER_FAILED) {
+                self->priv->status = AUDIO_STATUS_ERROR; /* Audio operation stopped due to error */
+                break;
+            }
+
+            /* Initial fill is not an underrun */
+            if (played) {
+                CDEMU_DEBUG(self, DAEMON_DEBUG_AUDIOPLAY, "%s: buffer underrun at sector %d (0x%X)!\n", __debug__, self->priv->cur_sector, self->priv->cur_sector);
+                g_atomic_int_inc(&self->priv->underruns);
+            }
+
+            g_mutex_lock(&self->priv->buffer_mutex);
+            while (self->priv->status == AUDIO_STATUS_PLAYING && !cdemu_audio_buffer_get_depth(self) && g_atomic_int_get(&self->priv->reader_state) == AUDIO_READER_RUNNING) {
+                g_cond_wait(&self->priv->buffer_cond, &self->priv->buffer_mutex);
+            }
+            g_mutex_unlock(&self->priv->buffer_mutex);
+
+            continue;
         }
 
-
-        /*** Lock device mutex ***/
-        g_mutex_lock(self->priv->device_mutex);
-
-        /* Get sector */
+        /* Save current position; device mutex is not taken here, so that
+           playback does not wait for commands */
         CDEMU_DEBUG(self, DAEMON_DEBUG_AUDIOPLAY, "%s: playing sector %d (0x%X)\n", __debug__, self->priv->cur_sector, self->priv->cur_sector);
-        sector = mirage_disc_get_sector(self->priv->disc, self->priv->cur_sector, &error);
-        if (!sector) {
-            CDEMU_DEBUG(self, DAEMON_DEBUG_AUDIOPLAY, "%s: failed to get sector 0x%X: %s\n", __debug__, self->priv->cur_sector, error->message);
-            g_error_free(error);
-            self->priv->status = AUDIO_STATUS_ERROR; /* Audio operation stopped due to error */
-            g_mutex_unlock(self->priv->device_mutex);
-            break;
-        }
-
-        /* This one covers both sector not being an audio one and sector changing
-           from audio to data one */
-        type = mirage_sector_get_sector_type(sector);
-        if (type != MIRAGE_SECTOR_AUDIO) {
-            CDEMU_DEBUG(self, DAEMON_DEBUG_AUDIOPLAY, "%s: non-audio sector!\n", __debug__);
-            g_object_unref(sector); /* Unref here; we won't need it anymore... */
-            self->priv->status = AUDIO_STATUS_ERROR; /* Audio operation stopped due to error */
-            g_mutex_unlock(self->priv->device_mutex);
-            break;
-        }
-
-        /* Save current position */
         if (self->priv->cur_sector_ptr) {
-            *self->priv->cur_sector_ptr = self->priv->cur_sector;
+            g_atomic_int_set(self->priv->cur_sector_ptr, self->priv->cur_sector);
         }
-        self->priv->cur_sector++;
-
-        /*** Unlock device mutex ***/
-        g_mutex_unlock(self->priv->device_mutex);
-
 
         /* Play sector */
-        mirage_sector_get_data(sector, &tmp_buffer, &tmp_len, NULL);
-        if (ao_play(self->priv->device, (gchar *)tmp_buffer, tmp_len) == 0) {
+        tmp_buffer = self->priv->buffer + (played % AUDIO_BUFFER_SECTORS)*AUDIO_SECTOR_SIZE;
+        if (ao_play(self->priv->device, (gchar *)tmp_buffer, AUDIO_SECTOR_SIZE) == 0) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_ERROR, "%s: playback error!\n", __debug__);
             self->priv->status = AUDIO_STATUS_ERROR; /* Audio operation stopped due to error */
             break;
@@ -131,9 +228,16 @@ static gpointer cdemu_audio_playback_thread (CdemuAudio *self)
             g_usleep(1*G_USEC_PER_SEC/75); /* One sector = 1/75th of second */
         }
 
-        g_object_unref(sector);
+        /* Release the slot */
+        self->priv->cur_sector++;
+        g_atomic_int_set(&self->priv->buffer_played, played + 1);
+
+        cdemu_audio_buffer_wake(self);
     }
 
+    /* If we stopped on our own, the reader might be waiting for room */
+    cdemu_audio_buffer_wake(self);
+
     CDEMU_DEBUG(self, DAEMON_DEBUG_AUDIOPLAY, "%s: playback thread end\n", __debug__);
 
     /* Close audio device */
@@ -144,20 +248,59 @@ static gpointer cdemu_audio_playback_thread (CdemuAudio *self)
     return NULL;
 }
 
+static void cdemu_audio_join_threads (CdemuAudio *self)
+{
+    /* Wait for the threads to finish */
+    if (self->priv->playback_thread) {
+        CDEMU_DEBUG(self, DAEMON_DEBUG_AUDIOPLAY, "%s: waiting for thread to finish\n", __debug__);
+        g_thread_join(self->priv->playback_thread);
+        self->priv->playback_thread = NULL;
+        CDEMU_DEBUG(self, DAEMON_DEBUG_AUDIOPLAY, "%s: thread finished\n", __debug__);
+    }
+
+    if (self->priv->reader_thread) {
+        g_thread_join(self->priv->reader_thread);
+        self->priv->reader_thread = NULL;
+    }
+}
+
 static void cdemu_audio_start_playing (CdemuAudio *self)
 {
     GError *local_error = NULL;
 
+    /* Threads of previous playback might have ended on their own */
+    cdemu_audio_join_threads(self);
+
+    /* Reset the buffer; reading starts at the current sector */
+    g_atomic_int_set(&self->priv->buffer_written, 0);
+    g_atomic_int_set(&self->priv->buffer_played, 0);
+    g_atomic_int_set(&self->priv->reader_state, AUDIO_READER_RUNNING);
+    self->priv->read_sector = self->priv->cur_sector;
+
     /* Set the status */
     self->priv->status = AUDIO_STATUS_PLAYING;
 
-    /* Start the playback thread; thread must be joinable, so we can wait for it
-       to end */
+    /* Start the reader and playback threads; threads must be joinable, so we
+       can wait for them to end */
+    self->priv->reader_thread = g_thread_try_new("CDEmu Device Audio Read thread", (GThreadFunc)cdemu_audio_reader_thread, self, &local_error);
+
+    if (!self->priv->reader_thread) {
+        CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to create audio reader thread: %s\n", __debug__, local_error->message);
+        g_error_free(local_error);
+        self->priv->status = AUDIO_STATUS_ERROR;
+        return;
+    }
+
     self->priv->playback_thread = g_thread_try_new("CDEmu Device Audio Play thread", (GThreadFunc)cdemu_audio_playback_thread, self, &local_error);
 
     if (!self->priv->playback_thread) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to create audio playback thread: %s\n", __debug__, local_error->message);
         g_error_free(local_error);
+
+        /* Stop the reader */
+        self->priv->status = AUDIO_STATUS_ERROR;
+        cdemu_audio_buffer_wake(self);
+        cdemu_audio_join_threads(self);
     }
 }
 
@@ -167,13 +310,11 @@ static void cdemu_audio_stop_playing (CdemuAudio *self, gint status)
        to provide us appropriate status */
     self->priv->status = status;
 
-    /* Wait for the thread to finish */
-    if (self->priv->playback_thread) {
-        CDEMU_DEBUG(self, DAEMON_DEBUG_AUDIOPLAY, "%s: waiting for thread to finish\n", __debug__);
-        g_thread_join(self->priv->playback_thread);
-        self->priv->playback_thread = NULL;
-        CDEMU_DEBUG(self, DAEMON_DEBUG_AUDIOPLAY, "%s: thread finished\n", __debug__);
-    }
+    /* Wake up threads that are waiting on the buffer, and wait for them to
+       finish; unplayed contents of the buffer are discarded, and in case
+       of pause, reading is resumed at the current sector */
+    cdemu_audio_buffer_wake(self);
+    cdemu_audio_join_threads(self);
 }
 
 
@@ -199,6 +340,9 @@ void cdemu_audio_initialize (CdemuAudio *self, const gchar *driver, gint *cur_se
         self->priv->driver_id = ao_driver_id("null");
     }
 
+    /* Allocate playback buffer */
+    self->priv->buffer = g_malloc(AUDIO_BUFFER_SECTORS*AUDIO_SECTOR_SIZE);
+
     /* Set the audio format */
     self->priv->format.bits = 16;
     self->priv->format.channels = 2;
@@ -299,6 +443,14 @@ gint cdemu_audio_get_status (CdemuAudio *self)
     return self->priv->status;
 }
 
+void cdemu_audio_get_buffer_statistics (CdemuAudio *self, guint *depth, guint *size, guint64 *underruns)
+{
+    /* Depth is meaningful only while playing */
+    *depth = (self->priv->status == AUDIO_STATUS_PLAYING) ? cdemu_audio_buffer_get_depth(self) : 0;
+    *size = AUDIO_BUFFER_SECTORS;
+    *underruns = (guint)g_atomic_int_get(&self->priv->underruns);
+}
+
 
 /**********************************************************************\
  *                             Object init                            *
@@ -310,9 +462,17 @@ static void cdemu_audio_init (CdemuAudio *self)
     self->priv = cdemu_audio_get_instance_private(self);
 
     self->priv->playback_thread = NULL;
+    self->priv->reader_thread = NULL;
     self->priv->device = NULL;
     self->priv->disc = NULL;
     self->priv->device_mutex = NULL;
+
+    self->priv->buffer = NULL;
+    self->priv->buffer_written = 0;
+    self->priv->buffer_played = 0;
+    self->priv->underruns = 0;
+    g_mutex_init(&self->priv->buffer_mutex);
+    g_cond_init(&self->priv->buffer_cond);
 }
 
 static void cdemu_audio_finalize (GObject *gobject)
@@ -322,6 +482,13 @@ static void cdemu_audio_finalize (GObject *gobject)
     /* Force the playback to stop */
     cdemu_audio_stop(self);
 
+    /* Threads might have ended on their own */
+    cdemu_audio_join_threads(self);
+
+    g_free(self->priv->buffer);
+    g_mutex_clear(&self->priv->buffer_mutex);
+    g_cond_clear(&self->priv->buffer_cond);
+
     /* Chain up to the parent class */
     return G_OBJECT_CLASS(cdemu_audio_parent_class)->finalize(gobject);
 }
@@ -56,6 +56,7 @@ gboolean cdemu_audio_resume (CdemuAudio *self);
 gboolean cdemu_audio_pause (CdemuAudio *self);
 gboolean cdemu_audio_stop (CdemuAudio *self);
 gint cdemu_audio_get_status (CdemuAudio *self);
+void cdemu_audio_get_buffer_statistics (CdemuAudio *self, guint *depth, guint *size, guint64 *underruns);
 
 G_END_DECLS
 
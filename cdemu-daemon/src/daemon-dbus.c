@@ -261,6 +261,18 @@ static void cdemu_daemon_dbus_handle_method_call (GDBusConnection *connection G_
         }
 
         g_free(option_name);
+    } else if (!g_strcmp0(method_name, "DeviceGetMetrics")) {
+        /* *** DeviceGetMetrics *** */
+        gint device_number;
+        CdemuDevice *device;
+
+        g_variant_get(parameters, "(i)", &device_number);
+        device = cdemu_daemon_get_device(self, device_number, &error);
+        if (device) {
+            ret = g_variant_new("(@a{sv})", cdemu_device_get_metrics(device));
+            succeeded = TRUE;
+            g_object_unref(device);
+        }
     } else if (!g_strcmp0(method_name, "GetNumberOfDevices")) {
         /* *** GetNumberOfDevices *** */
         ret = g_variant_new("(i)", g_list_length(self->priv->devices));
@@ -552,6 +564,18 @@ void cdemu_daemon_dbus_emit_device_mapping_ready (CdemuDaemon *self, gint number
     }
 }
 
+void cdemu_daemon_dbus_emit_device_metrics (CdemuDaemon *self, gint number, GVariant *metrics)
+{
+    if (self->priv->connection) {
+        g_dbus_connection_emit_signal(self->priv->connection, NULL,
+            "/Daemon", CDEMU_DAEMON_DBUS_NAME,
+            "DeviceMetrics", g_variant_new("(i@a{sv})", number, metrics),
+            NULL);
+    } else {
+        g_variant_unref(g_variant_ref_sink(metrics));
+    }
+}
+
 void cdemu_daemon_dbus_emit_device_added (CdemuDaemon *self)
 {
     if (self->priv->connection) {
@@ -650,6 +674,10 @@ static const gchar introspection_xml[] =
     "            <arg name='option_name' type='s' direction='in'/>"
     "            <arg name='option_values' type='v' direction='in'/>"
     "        </method>"
+    "        <method name='DeviceGetMetrics'>"
+    "            <arg name='device_number' type='i' direction='in'/>"
+    "            <arg name='metrics' type='a{sv}' direction='out'/>"
+    "        </method>"
 
     "        <!-- Device management methods -->"
     "        <method name='AddDevice' />"
@@ -666,6 +694,10 @@ static const gchar introspection_xml[] =
     "        <signal name='DeviceMappingReady'>"
     "            <arg name='device_number' type='i' direction='out'/>"
     "        </signal>"
+    "        <signal name='DeviceMetrics'>"
+    "            <arg name='device_number' type='i' direction='out'/>"
+    "            <arg name='metrics' type='a{sv}' direction='out'/>"
+    "        </signal>"
     "        <signal name='DeviceAdded' />"
     "        <signal name='DeviceRemoved' />"
     "    </interface>"
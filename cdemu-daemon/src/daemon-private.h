@@ -33,6 +33,9 @@ struct _CdemuDaemonPrivate
     guint cdemu_debug_mask; /* Default debug mask for CDEmu devices */
     guint mirage_debug_mask; /* Default debug mask for underlying libMirage context */
 
+    guint metrics_interval; /* Interval of DeviceMetrics signal, in seconds; 0 disables it */
+    guint metrics_source;
+
     /* Devices */
     GList *devices;
 
@@ -54,6 +57,7 @@ void cdemu_daemon_dbus_cleanup (CdemuDaemon *self);
 void cdemu_daemon_dbus_emit_device_status_changed (CdemuDaemon *self, gint number);
 void cdemu_daemon_dbus_emit_device_option_changed (CdemuDaemon *self, gint number, const gchar *option);
 void cdemu_daemon_dbus_emit_device_mapping_ready (CdemuDaemon *self, gint number);
+void cdemu_daemon_dbus_emit_device_metrics (CdemuDaemon *self, gint number, GVariant *metrics);
 void cdemu_daemon_dbus_emit_device_added (CdemuDaemon *self);
 void cdemu_daemon_dbus_emit_device_removed (CdemuDaemon *self);
 
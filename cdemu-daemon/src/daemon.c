@@ -45,6 +45,20 @@ static void device_mapping_ready_handler (CdemuDevice *device, CdemuDaemon *self
 }
 
 
+/**********************************************************************\
+ *                          Periodic metrics                          *
+\**********************************************************************/
+static gboolean metrics_callback (CdemuDaemon *self)
+{
+    for (GList *entry = self->priv->devices; entry; entry = entry->next) {
+        CdemuDevice *device = entry->data;
+        cdemu_daemon_dbus_emit_device_metrics(self, cdemu_device_get_device_number(device), cdemu_device_get_metrics(device));
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+
 /**********************************************************************\
  *                     Device restart on inactivity                   *
 \**********************************************************************/
@@ -91,7 +105,7 @@ static void device_kernel_io_error_handler (CdemuDevice *device, CdemuDaemon *se
 /******************************************************************************\
  *                                 Public API                                 *
 \******************************************************************************/
-gboolean cdemu_daemon_initialize_and_start (CdemuDaemon *self, gint num_devices, gchar *ctl_device, gchar *audio_driver, gboolean system_bus, guint cdemu_debug_mask, guint mirage_debug_mask)
+gboolean cdemu_daemon_initialize_and_start (CdemuDaemon *self, gint num_devices, gchar *ctl_device, gchar *audio_driver, gboolean system_bus, guint cdemu_debug_mask, guint mirage_debug_mask, guint metrics_interval)
 {
     MirageContext *context;
     GBusType bus_type = system_bus ? G_BUS_TYPE_SYSTEM : G_BUS_TYPE_SESSION;
@@ -102,6 +116,8 @@ gboolean cdemu_daemon_initialize_and_start (CdemuDaemon *self, gint num_devices,
     self->priv->cdemu_debug_mask = cdemu_debug_mask;
     self->priv->mirage_debug_mask = mirage_debug_mask;
 
+    self->priv->metrics_interval = metrics_interval;
+
     /* Create a MirageContext and use it as debug context */
     context = g_object_new(MIRAGE_TYPE_CONTEXT, NULL);
     mirage_context_set_debug_name(context, "cdemu");
@@ -134,9 +150,19 @@ gboolean cdemu_daemon_initialize_and_start (CdemuDaemon *self, gint num_devices,
     /* Register on D-Bus bus */
     cdemu_daemon_dbus_register_on_bus(self, bus_type);
 
+    /* Set up periodic emission of device metrics */
+    if (self->priv->metrics_interval) {
+        self->priv->metrics_source = g_timeout_add_seconds(self->priv->metrics_interval, (GSourceFunc)metrics_callback, self);
+    }
+
     /* Run the main loop */
     g_main_loop_run(self->priv->main_loop);
 
+    /* Stop emitting metrics */
+    if (self->priv->metrics_source) {
+        g_source_remove(self->priv->metrics_source);
+        self->priv->metrics_source = 0;
+    }
 
     /* Cleanup D-Bus */
     cdemu_daemon_dbus_cleanup(self);
@@ -242,6 +268,9 @@ static void cdemu_daemon_init (CdemuDaemon *self)
     self->priv->cdemu_debug_mask = 0;
     self->priv->mirage_debug_mask = 0;
 
+    self->priv->metrics_interval = 0;
+    self->priv->metrics_source = 0;
+
     /* Set version string */
     self->priv->version = g_strdup(CDEMU_DAEMON_VERSION);
 
@@ -55,6 +55,7 @@ static gint read_sector_data (MirageSector *sector, MirageDisc *disc, gint addre
 {
     guint8 *ptr = buffer;
     gint read_length = 0;
+    gboolean pooled_sector = FALSE;
 
     const guint8 *tmp_buf;
     gint tmp_len;
@@ -63,11 +64,13 @@ static gint read_sector_data (MirageSector *sector, MirageDisc *disc, gint addre
     if (sector) {
         g_object_ref(sector);
     } else {
-        /* ... otherwise, obtain it */
-        sector = mirage_disc_get_sector(disc, address, error);
-        if (!sector) {
+        /* ... otherwise, read it into one from the disc's sector pool */
+        sector = mirage_disc_acquire_sector(disc);
+        if (!mirage_disc_read_sector(disc, address, sector, error)) {
+            mirage_disc_release_sector(disc, sector);
             return -1;
         }
+        pooled_sector = TRUE;
     }
 
     /* Main channel selection byte */
@@ -156,19 +159,269 @@ static gint read_sector_data (MirageSector *sector, MirageDisc *disc, gint addre
     read_length += tmp_len;
 
     /* Release sector */
-    g_object_unref(sector);
+    if (pooled_sector) {
+        mirage_disc_release_sector(disc, sector);
+    } else {
+        g_object_unref(sector);
+    }
 
     return read_length;
 }
 
 
+/* READ CD recipe: main channel selection byte, expected sector type and
+   subchannel mode are compiled once per request into a per-sector-type
+   list of byte ranges within the raw sector, so that each sector can be
+   emitted from a single main channel buffer, without going through the
+   individual part accessors */
+#define READ_CD_NUM_SECTOR_TYPES (MIRAGE_SECTOR_MODE2_FORM2 + 1)
+
+typedef struct
+{
+    gint parts; /* MirageSectorValidData flags of selected parts */
+
+    gint num_ranges;
+    struct {
+        gint offset;
+        gint length;
+    } ranges[5];
+
+    gint c2_length;
+    gint length; /* Total main channel length */
+} ReadCdLayout;
+
+typedef struct
+{
+    guint8 mcsb_byte;
+    gint subchannel_mode;
+
+    ReadCdLayout layouts[READ_CD_NUM_SECTOR_TYPES];
+
+    MirageSectorSubchannelFormat subchannel_format;
+    gint subchannel_length;
+
+    /* Audio sectors can be read directly via libMirage's batched read */
+    gboolean batched_audio;
+} ReadCdRecipe;
+
+/* Subchannel of a run of sectors; when their track does not provide
+   subchannel data, it is generated for the whole run at once */
+#define READ_CD_SUBCHANNEL_BATCH 75
+
+typedef struct
+{
+    gint address; /* First sector covered by batch */
+    gint num_sectors; /* Number of sectors covered by batch */
+    gboolean generated; /* Is subchannel of covered sectors generated? */
+    guint8 data[READ_CD_SUBCHANNEL_BATCH*96];
+} ReadCdSubchannelBatch;
+
+/* Sync, header, subheader, data and EDC/ECC location within raw sector,
+   per sector type; zero length denotes part that is not present */
+static const struct {
+    gint offset;
+    gint length;
+} read_cd_sector_parts[READ_CD_NUM_SECTOR_TYPES][5] = {
+    /* MIRAGE_SECTOR_MODE0 */
+    { { 0, 12 }, { 12, 4 }, {  0, 0 }, { 16, 2336 }, {    0,   0 } },
+    /* MIRAGE_SECTOR_AUDIO */
+    { { 0,  0 }, {  0, 0 }, {  0, 0 }, {  0, 2352 }, {    0,   0 } },
+    /* MIRAGE_SECTOR_MODE1 */
+    { { 0, 12 }, { 12, 4 }, {  0, 0 }, { 16, 2048 }, { 2064, 288 } },
+    /* MIRAGE_SECTOR_MODE2 */
+    { { 0, 12 }, { 12, 4 }, {  0, 0 }, { 16, 2336 }, {    0,   0 } },
+    /* MIRAGE_SECTOR_MODE2_FORM1 */
+    { { 0, 12 }, { 12, 4 }, { 16, 8 }, { 24, 2048 }, { 2072, 280 } },
+    /* MIRAGE_SECTOR_MODE2_FORM2 */
+    { { 0, 12 }, { 12, 4 }, { 16, 8 }, { 24, 2324 }, { 2348,   4 } },
+};
+
+static void read_cd_recipe_compile (ReadCdRecipe *recipe, guint8 mcsb_byte, gint exp_sect_type, gint subchannel_mode)
+{
+    struct READ_CD_MSCB *mcsb = (struct READ_CD_MSCB *)&mcsb_byte;
+    const gboolean selected[5] = { mcsb->sync, mcsb->header, mcsb->subheader, mcsb->data, mcsb->edc_ecc };
+    const gint part_flags[5] = { MIRAGE_VALID_SYNC, MIRAGE_VALID_HEADER, MIRAGE_VALID_SUBHEADER, MIRAGE_VALID_DATA, MIRAGE_VALID_EDC_ECC };
+
+    memset(recipe, 0, sizeof(ReadCdRecipe));
+    recipe->mcsb_byte = mcsb_byte;
+    recipe->subchannel_mode = subchannel_mode;
+
+    for (gint type = 0; type < READ_CD_NUM_SECTOR_TYPES; type++) {
+        ReadCdLayout *layout = &recipe->layouts[type];
+
+        /* Selected parts; adjacent ones are merged into a single range */
+        for (gint i = 0; i < 5; i++) {
+            gint offset = read_cd_sector_parts[type][i].offset;
+            gint length = read_cd_sector_parts[type][i].length;
+
+            if (!selected[i] || !length) {
+                continue;
+            }
+
+            layout->parts |= part_flags[i];
+            layout->length += length;
+
+            if (layout->num_ranges && layout->ranges[layout->num_ranges-1].offset + layout->ranges[layout->num_ranges-1].length == offset) {
+                layout->ranges[layout->num_ranges-1].length += length;
+            } else {
+                layout->ranges[layout->num_ranges].offset = offset;
+                layout->ranges[layout->num_ranges].length = length;
+                layout->num_ranges++;
+            }
+        }
+
+        /* C2 error bits: filled with zeros */
+        switch (mcsb->c2_error) {
+            case 0x01: {
+                /* C2 error block data */
+                layout->c2_length = 294;
+                break;
+            }
+            case 0x02: {
+                /* C2 and block error bits */
+                layout->c2_length = 296;
+                break;
+            }
+            default: {
+                layout->c2_length = 0;
+                break;
+            }
+        }
+        layout->length += layout->c2_length;
+    }
+
+    /* Subchannel: we support only RAW and Q */
+    switch (subchannel_mode) {
+        case 0x01: {
+            recipe->subchannel_format = MIRAGE_SUBCHANNEL_PW;
+            recipe->subchannel_length = 96;
+            break;
+        }
+        case 0x02: {
+            recipe->subchannel_format = MIRAGE_SUBCHANNEL_Q;
+            recipe->subchannel_length = 16;
+            break;
+        }
+        default: {
+            recipe->subchannel_format = MIRAGE_SUBCHANNEL_NONE;
+            recipe->subchannel_length = 0;
+            break;
+        }
+    }
+
+    /* If audio sector's layout is its complete user data, runs of audio
+       sectors can be read in batches */
+    const ReadCdLayout *audio = &recipe->layouts[MIRAGE_SECTOR_AUDIO];
+
+    recipe->batched_audio = (exp_sect_type == 0 || exp_sect_type == MIRAGE_SECTOR_AUDIO)
+        && audio->length == 2352 && audio->num_ranges == 1
+        && recipe->subchannel_length == 0;
+}
+
+static gint read_cd_recipe_get_length (const ReadCdRecipe *recipe, gint sector_type)
+{
+    if (sector_type < 0 || sector_type >= READ_CD_NUM_SECTOR_TYPES) {
+        return -1;
+    }
+    return recipe->layouts[sector_type].length + recipe->subchannel_length;
+}
+
+static const guint8 *read_cd_subchannel_batch_lookup (ReadCdSubchannelBatch *batch, const ReadCdRecipe *recipe, MirageDisc *disc, gint address, gint end_address)
+{
+    if (!recipe->subchannel_length) {
+        return NULL;
+    }
+
+    /* Set up new batch once address leaves the current one */
+    if (address < batch->address || address >= batch->address + batch->num_sectors) {
+        MirageTrack *track = mirage_disc_get_track_by_address(disc, address, NULL);
+
+        batch->address = address;
+        batch->num_sectors = 1;
+        batch->generated = FALSE;
+
+        if (track) {
+            MirageFragment *fragment = mirage_track_find_fragment_with_subchannel(track, NULL);
+            gint track_end = mirage_track_layout_get_start_sector(track) + mirage_track_layout_get_length(track);
+
+            if (fragment) {
+                /* Track provides subchannel; it is taken from sectors */
+                batch->num_sectors = track_end - address;
+                g_object_unref(fragment);
+            } else {
+                batch->num_sectors = MIN(MIN(track_end, end_address) - address, READ_CD_SUBCHANNEL_BATCH);
+                batch->generated = mirage_track_generate_subchannel(track, address, TRUE, batch->num_sectors, recipe->subchannel_format, batch->data, NULL);
+            }
+
+            g_object_unref(track);
+        }
+    }
+
+    if (!batch->generated) {
+        return NULL;
+    }
+
+    return batch->data + (address - batch->address) * recipe->subchannel_length;
+}
+
+static gint read_cd_recipe_emit_sector (const ReadCdRecipe *recipe, MirageSector *sector, const guint8 *subchannel_data, guint8 *buffer, GError **error)
+{
+    gint sector_type = mirage_sector_get_sector_type(sector);
+    const ReadCdLayout *layout;
+    const guint8 *main_data;
+    guint8 *ptr = buffer;
+
+    /* Sector types not covered by recipe are handled part by part */
+    if (sector_type < 0 || sector_type >= READ_CD_NUM_SECTOR_TYPES) {
+        return read_sector_data(sector, NULL, 0, recipe->mcsb_byte, recipe->subchannel_mode, buffer, error);
+    }
+    layout = &recipe->layouts[sector_type];
+
+    /* Main channel */
+    if (layout->parts) {
+        if (!mirage_sector_get_main_data(sector, layout->parts, &main_data, NULL, error)) {
+            return -1;
+        }
+        for (gint i = 0; i < layout->num_ranges; i++) {
+            memcpy(ptr, main_data + layout->ranges[i].offset, layout->ranges[i].length);
+            ptr += layout->ranges[i].length;
+        }
+    }
+    memset(ptr, 0, layout->c2_length);
+    ptr += layout->c2_length;
+
+    /* Subchannel; unless already generated as part of batch, it is taken
+       from sector */
+    if (recipe->subchannel_length) {
+        if (!subchannel_data && !mirage_sector_get_subchannel(sector, recipe->subchannel_format, &subchannel_data, NULL, error)) {
+            return -1;
+        }
+        memcpy(ptr, subchannel_data, recipe->subchannel_length);
+        ptr += recipe->subchannel_length;
+    }
+
+    return ptr - buffer;
+}
+
+static void debug_sector_pool_statistics (CdemuDevice *self, MirageDisc *disc)
+{
+    if (CDEMU_DEBUG_ON(self, DAEMON_DEBUG_MMC)) {
+        guint64 allocations, acquisitions;
+
+        /* In steady state, number of allocations should not increase */
+        mirage_disc_get_sector_pool_statistics(disc, &allocations, &acquisitions);
+        CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: sector pool: %" G_GUINT64_FORMAT " sector allocation(s), %" G_GUINT64_FORMAT " acquisition(s)\n", __debug__, allocations, acquisitions);
+    }
+}
+
+
 /**********************************************************************\
  *                     Packet command implementations                 *
 \**********************************************************************/
 /* CLOSE TRACK/SESSION */
-static gboolean command_close_track_session (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_close_track_session (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct CLOSE_TRACK_SESSION_CDB *cdb = (struct CLOSE_TRACK_SESSION_CDB *)raw_cdb;
+    struct CLOSE_TRACK_SESSION_CDB *cdb = (struct CLOSE_TRACK_SESSION_CDB *)cmd->cdb;
 
     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: close function: %d, track/session: %d\n", __debug__, cdb->function, cdb->number);
 
@@ -178,7 +431,7 @@ static gboolean command_close_track_session (CdemuDevice *self, const guint8 *ra
 
         if (!self->priv->recording) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: no recording mode set!\n", __debug__);
-            cdemu_device_write_sense(self, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
+            cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
             return FALSE;
         }
 
@@ -189,7 +442,7 @@ static gboolean command_close_track_session (CdemuDevice *self, const guint8 *ra
 
         if (!self->priv->recording) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: no recording mode set!\n", __debug__);
-            cdemu_device_write_sense(self, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
+            cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
             return FALSE;
         }
 
@@ -200,14 +453,14 @@ static gboolean command_close_track_session (CdemuDevice *self, const guint8 *ra
 
         if (!self->priv->recording) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: no recording mode set!\n", __debug__);
-            cdemu_device_write_sense(self, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
+            cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
             return FALSE;
         }
 
         return self->priv->recording->close_session(self);
     } else {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: unimplemented close function: %d\n", __debug__, cdb->function);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
         return FALSE;
     }
 
@@ -215,12 +468,12 @@ static gboolean command_close_track_session (CdemuDevice *self, const guint8 *ra
 }
 
 /* GET CONFIGURATION*/
-static gboolean command_get_configuration (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_get_configuration (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct GET_CONFIGURATION_CDB *cdb = (struct GET_CONFIGURATION_CDB *)raw_cdb;
-    struct GET_CONFIGURATION_Header *ret_header = (struct GET_CONFIGURATION_Header *)self->priv->buffer;
-    self->priv->buffer_size = sizeof(struct GET_CONFIGURATION_Header);
-    guint8 *ret_data = self->priv->buffer+self->priv->buffer_size;
+    struct GET_CONFIGURATION_CDB *cdb = (struct GET_CONFIGURATION_CDB *)cmd->cdb;
+    struct GET_CONFIGURATION_Header *ret_header = (struct GET_CONFIGURATION_Header *)cmd->buffer;
+    cmd->buffer_size = sizeof(struct GET_CONFIGURATION_Header);
+    guint8 *ret_data = cmd->buffer+cmd->buffer_size;
 
     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: requesting features from 0x%X on, with RT flag 0x%X\n", __debug__, GUINT16_FROM_BE(cdb->sfn), cdb->rt);
 
@@ -246,7 +499,7 @@ static gboolean command_get_configuration (CdemuDevice *self, const guint8 *raw_
 
                 /* Copy feature */
                 memcpy(ret_data, feature, feature->length + 4);
-                self->priv->buffer_size += feature->length + 4;
+                cmd->buffer_size += feature->length + 4;
                 ret_data += feature->length + 4;
 
                 /* Break the loop if RT is 0x02 */
@@ -259,25 +512,25 @@ static gboolean command_get_configuration (CdemuDevice *self, const guint8 *raw_
     }
 
     /* Header */
-    ret_header->length = GUINT32_TO_BE(self->priv->buffer_size - 4);
+    ret_header->length = GUINT32_TO_BE(cmd->buffer_size - 4);
     ret_header->cur_profile = GUINT16_TO_BE(self->priv->current_profile);
 
     /* Write data */
-    cdemu_device_write_buffer(self, GUINT16_FROM_BE(cdb->length));
+    cdemu_device_write_buffer(self, cmd, GUINT16_FROM_BE(cdb->length));
 
     return TRUE;
 }
 
 /* GET EVENT/STATUS NOTIFICATION*/
-static gboolean command_get_event_status_notification (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_get_event_status_notification (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct GET_EVENT_STATUS_NOTIFICATION_CDB *cdb = (struct GET_EVENT_STATUS_NOTIFICATION_CDB*)raw_cdb;
-    struct GET_EVENT_STATUS_NOTIFICATION_Header *ret_header = (struct GET_EVENT_STATUS_NOTIFICATION_Header *)self->priv->buffer;
-    self->priv->buffer_size = sizeof(struct GET_EVENT_STATUS_NOTIFICATION_Header);
+    struct GET_EVENT_STATUS_NOTIFICATION_CDB *cdb = (struct GET_EVENT_STATUS_NOTIFICATION_CDB*)cmd->cdb;
+    struct GET_EVENT_STATUS_NOTIFICATION_Header *ret_header = (struct GET_EVENT_STATUS_NOTIFICATION_Header *)cmd->buffer;
+    cmd->buffer_size = sizeof(struct GET_EVENT_STATUS_NOTIFICATION_Header);
 
     if (!cdb->immed) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: asynchronous type not supported yet!\n", __debug__);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
         return FALSE;
     }
 
@@ -289,8 +542,8 @@ static gboolean command_get_event_status_notification (CdemuDevice *self, const
 
     /* Process event classes */
     if (cdb->media) {
-        struct GET_EVENT_STATUS_NOTIFICATION_MediaEventDescriptor *ret_desc = (struct GET_EVENT_STATUS_NOTIFICATION_MediaEventDescriptor *)(self->priv->buffer+self->priv->buffer_size);
-        self->priv->buffer_size += sizeof(struct GET_EVENT_STATUS_NOTIFICATION_MediaEventDescriptor);
+        struct GET_EVENT_STATUS_NOTIFICATION_MediaEventDescriptor *ret_desc = (struct GET_EVENT_STATUS_NOTIFICATION_MediaEventDescriptor *)(cmd->buffer+cmd->buffer_size);
+        cmd->buffer_size += sizeof(struct GET_EVENT_STATUS_NOTIFICATION_MediaEventDescriptor);
 
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: media event class\n", __debug__);
 
@@ -308,10 +561,10 @@ static gboolean command_get_event_status_notification (CdemuDevice *self, const
     }
 
     /* Header */
-    ret_header->length = GUINT16_TO_BE(self->priv->buffer_size - 2);
+    ret_header->length = GUINT16_TO_BE(cmd->buffer_size - 2);
 
     /* Write data */
-    cdemu_device_write_buffer(self, GUINT16_FROM_BE(cdb->length));
+    cdemu_device_write_buffer(self, cmd, GUINT16_FROM_BE(cdb->length));
 
     return TRUE;
 }
@@ -332,10 +585,10 @@ static void __copy_performance_descriptors (struct GET_PERFORMANCE_00_Header *he
     header->data_length = GUINT32_TO_BE(4 + total_descriptors*sizeof(struct GET_PERFORMANCE_00_Descriptor));
 }
 
-static gboolean __get_performance_00 (CdemuDevice *self, const struct GET_PERFORMANCE_CDB *cdb)
+static gboolean __get_performance_00 (CdemuDevice *self, CdemuCommand *cmd, const struct GET_PERFORMANCE_CDB *cdb)
 {
-    struct GET_PERFORMANCE_00_Header *ret_header = (struct GET_PERFORMANCE_00_Header *)self->priv->buffer;
-    self->priv->buffer_size = sizeof(struct GET_PERFORMANCE_00_Header);
+    struct GET_PERFORMANCE_00_Header *ret_header = (struct GET_PERFORMANCE_00_Header *)cmd->buffer;
+    cmd->buffer_size = sizeof(struct GET_PERFORMANCE_00_Header);
 
     /* Initialize header */
     ret_header->data_length = GUINT32_TO_BE(4); /* No descriptors */
@@ -345,7 +598,7 @@ static gboolean __get_performance_00 (CdemuDevice *self, const struct GET_PERFOR
     /* Validate the tolerance field - must be 10b */
     if (cdb->tolerance != 2) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: tolerance field is not 10b!\n", __debug__);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
         return FALSE;
     }
 
@@ -502,28 +755,28 @@ static gboolean __get_performance_00 (CdemuDevice *self, const struct GET_PERFOR
 }
 
 
-static gboolean command_get_performance (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_get_performance (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct GET_PERFORMANCE_CDB *cdb = (struct GET_PERFORMANCE_CDB *)raw_cdb;
+    struct GET_PERFORMANCE_CDB *cdb = (struct GET_PERFORMANCE_CDB *)cmd->cdb;
     guint16 max_descriptors = GUINT16_FROM_BE(cdb->descriptors);
 
     switch (cdb->type) {
         case 0x00: {
             /* Performance */
-            if (!__get_performance_00(self, cdb)) {
+            if (!__get_performance_00(self, cmd, cdb)) {
                 return FALSE;
             }
 
             /* Modify buffer length based on header size */
-            struct GET_PERFORMANCE_00_Header *ret_header = (struct GET_PERFORMANCE_00_Header *)self->priv->buffer;
-            self->priv->buffer_size = 4 + GUINT32_FROM_BE(ret_header->data_length);
+            struct GET_PERFORMANCE_00_Header *ret_header = (struct GET_PERFORMANCE_00_Header *)cmd->buffer;
+            cmd->buffer_size = 4 + GUINT32_FROM_BE(ret_header->data_length);
 
             break;
         }
         case 0x03: {
             /* Write Speed */
-            struct GET_PERFORMANCE_03_Header *ret_header = (struct GET_PERFORMANCE_03_Header *)self->priv->buffer;
-            self->priv->buffer_size = sizeof(struct GET_PERFORMANCE_03_Header);
+            struct GET_PERFORMANCE_03_Header *ret_header = (struct GET_PERFORMANCE_03_Header *)cmd->buffer;
+            cmd->buffer_size = sizeof(struct GET_PERFORMANCE_03_Header);
 
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: returning max %d write speed descriptors\n", __debug__, max_descriptors);
 
@@ -533,9 +786,9 @@ static gboolean command_get_performance (CdemuDevice *self, const guint8 *raw_cd
                 /* Make sure we don't return more descriptors than requested */
                 if (num_descriptors < max_descriptors) {
                     /* Copy descriptor */
-                    guint8 *desc_ptr = self->priv->buffer + self->priv->buffer_size;
+                    guint8 *desc_ptr = cmd->buffer + cmd->buffer_size;
                     memcpy(desc_ptr, list_iter->data, sizeof(struct GET_PERFORMANCE_03_Descriptor));
-                    self->priv->buffer_size += sizeof(struct GET_PERFORMANCE_03_Descriptor);
+                    cmd->buffer_size += sizeof(struct GET_PERFORMANCE_03_Descriptor);
                 }
 
                 num_descriptors++;
@@ -550,24 +803,24 @@ static gboolean command_get_performance (CdemuDevice *self, const guint8 *raw_cd
         }
         default: {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: unimplemented data type: %d\n", __debug__, cdb->type);
-            cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+            cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
             return FALSE;
         }
     }
 
     /* Write data */
-    cdemu_device_write_buffer(self, self->priv->buffer_size);
+    cdemu_device_write_buffer(self, cmd, cmd->buffer_size);
     return TRUE;
 }
 
 /* INQUIRY*/
-static gboolean command_inquiry_vpd (CdemuDevice *self, const struct INQUIRY_CDB *cdb)
+static gboolean command_inquiry_vpd (CdemuDevice *self, CdemuCommand *cmd, const struct INQUIRY_CDB *cdb)
 {
     switch (cdb->page_code) {
         case 0x00: {
             /* Supported VPD pages */
-            struct INQUIRY_VPD_Header *ret_header = (struct INQUIRY_VPD_Header *)self->priv->buffer;
-            self->priv->buffer_size = sizeof(struct INQUIRY_VPD_Header);
+            struct INQUIRY_VPD_Header *ret_header = (struct INQUIRY_VPD_Header *)cmd->buffer;
+            cmd->buffer_size = sizeof(struct INQUIRY_VPD_Header);
             ret_header->per_dev = 0x05; /* CD-ROM device */
             ret_header->page_code = 0; /* Page 0x00: Supported VPD pages */
             ret_header->page_length = 0;
@@ -581,15 +834,15 @@ static gboolean command_inquiry_vpd (CdemuDevice *self, const struct INQUIRY_CDB
             ret_list[num_pages++] = 0x83; /* Device identification (mandatory) */
 
             /* Modify reported length */
-            self->priv->buffer_size += num_pages;
+            cmd->buffer_size += num_pages;
             ret_header->page_length = num_pages;
 
             break;
         }
         case 0x80: {
             /* Serial number */
-            struct INQUIRY_VPD_Header *ret_header = (struct INQUIRY_VPD_Header *)self->priv->buffer;
-            self->priv->buffer_size = sizeof(struct INQUIRY_VPD_Header);
+            struct INQUIRY_VPD_Header *ret_header = (struct INQUIRY_VPD_Header *)cmd->buffer;
+            cmd->buffer_size = sizeof(struct INQUIRY_VPD_Header);
             ret_header->per_dev = 0x05; /* CD-ROM device */
             ret_header->page_code = 0x80; /* Page 0x80: Serial number */
             ret_header->page_length = 0;
@@ -601,24 +854,24 @@ static gboolean command_inquiry_vpd (CdemuDevice *self, const struct INQUIRY_CDB
                cache buffer, and hence this additional NULL is effectively
                discarded from the response. */
             gchar *ret_serial = (gchar *)(ret_header + 1);
-            gint serial_len = g_strlcpy(ret_serial, self->priv->device_serial, self->priv->buffer_capacity - self->priv->buffer_size);
+            gint serial_len = g_strlcpy(ret_serial, self->priv->device_serial, self->priv->buffer_capacity - cmd->buffer_size);
 
             /* Modify reported length */
-            self->priv->buffer_size += serial_len;
+            cmd->buffer_size += serial_len;
             ret_header->page_length += serial_len;
             break;
         }
         case 0x83: {
             /* Device identification */
-            struct INQUIRY_VPD_Header *ret_header = (struct INQUIRY_VPD_Header *)self->priv->buffer;
-            self->priv->buffer_size = sizeof(struct INQUIRY_VPD_Header);
+            struct INQUIRY_VPD_Header *ret_header = (struct INQUIRY_VPD_Header *)cmd->buffer;
+            cmd->buffer_size = sizeof(struct INQUIRY_VPD_Header);
             ret_header->per_dev = 0x05; /* CD-ROM device */
             ret_header->page_code = 0x83; /* Page 0x80: Serial number */
             ret_header->page_length = 0;
 
             /* Identifier header */
-            struct INQUIRY_VPD_IdentificationDescriptorHeader *id_header = (struct INQUIRY_VPD_IdentificationDescriptorHeader *)(self->priv->buffer + self->priv->buffer_size);
-            self->priv->buffer_size += sizeof(struct INQUIRY_VPD_IdentificationDescriptorHeader);
+            struct INQUIRY_VPD_IdentificationDescriptorHeader *id_header = (struct INQUIRY_VPD_IdentificationDescriptorHeader *)(cmd->buffer + cmd->buffer_size);
+            cmd->buffer_size += sizeof(struct INQUIRY_VPD_IdentificationDescriptorHeader);
             ret_header->page_length += sizeof(struct INQUIRY_VPD_IdentificationDescriptorHeader);
 
             id_header->protocol_id = 8; /* ATA/ATAPI */
@@ -630,7 +883,7 @@ static gboolean command_inquiry_vpd (CdemuDevice *self, const struct INQUIRY_CDB
             id_header->identifier_length = 0;
 
             /* T10 vendor identification (8-byte) */
-            gchar *vendor_id = (gchar *)(self->priv->buffer + self->priv->buffer_size);
+            gchar *vendor_id = (gchar *)(cmd->buffer + cmd->buffer_size);
 
             /* Fill with spaces and copy the vendor string; the lenght
                of the latter is guaranteed not to exceed 8 characters
@@ -638,7 +891,7 @@ static gboolean command_inquiry_vpd (CdemuDevice *self, const struct INQUIRY_CDB
             memset(vendor_id, 32, 8);
             memcpy(vendor_id, self->priv->id_vendor_id, strlen(self->priv->id_vendor_id));
 
-            self->priv->buffer_size += 8;
+            cmd->buffer_size += 8;
             ret_header->page_length += 8;
             id_header->identifier_length += 8;
 
@@ -647,10 +900,10 @@ static gboolean command_inquiry_vpd (CdemuDevice *self, const struct INQUIRY_CDB
                IDENTIFIER field is to concatenate the PRODUCT IDENTIFICATION
                field from the standard INQUIRY data and the PRODUCT SERIAL
                NUMBER field from the Unit Serial Number VPD page */
-            gchar *id_string = (gchar *)(self->priv->buffer + self->priv->buffer_size);
-            gint id_len = g_snprintf(id_string, self->priv->buffer_capacity - self->priv->buffer_size, "%s %s", self->priv->id_product_id, self->priv->device_serial);
+            gchar *id_string = (gchar *)(cmd->buffer + cmd->buffer_size);
+            gint id_len = g_snprintf(id_string, self->priv->buffer_capacity - cmd->buffer_size, "%s %s", self->priv->id_product_id, self->priv->device_serial);
 
-            self->priv->buffer_size += id_len;
+            cmd->buffer_size += id_len;
             ret_header->page_length += id_len;
             id_header->identifier_length += id_len;
 
@@ -660,36 +913,36 @@ static gboolean command_inquiry_vpd (CdemuDevice *self, const struct INQUIRY_CDB
             /* Unsupported; as stated in SPC, return CHECK CONDITION,
                ILLEGAL REQUEST and INVALID FIELD IN CDB */
             CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: VPD page %02Xh not implemented!\n", __debug__, cdb->page_code);
-            cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+            cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
             return FALSE;
         }
     }
 
     /* Write data */
-    cdemu_device_write_buffer(self, GUINT16_FROM_BE(cdb->length));
+    cdemu_device_write_buffer(self, cmd, GUINT16_FROM_BE(cdb->length));
 
     return TRUE;
 }
 
-static gboolean command_inquiry (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_inquiry (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct INQUIRY_CDB *cdb = (struct INQUIRY_CDB *)raw_cdb;
+    struct INQUIRY_CDB *cdb = (struct INQUIRY_CDB *)cmd->cdb;
 
-    struct INQUIRY_Data *ret_data = (struct INQUIRY_Data *)self->priv->buffer;
-    self->priv->buffer_size = sizeof(struct INQUIRY_Data);
+    struct INQUIRY_Data *ret_data = (struct INQUIRY_Data *)cmd->buffer;
+    cmd->buffer_size = sizeof(struct INQUIRY_Data);
 
     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: INQUIRY: EVPD=%d, PAGE CODE=02%Xh)\n", __debug__, cdb->evpd, cdb->page_code);
 
     /* Non-zero page code and zero EVPD is illegal as per SPC */
     if (!cdb->evpd && cdb->page_code) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: invalid field in CDB (EVPD=0 and non-zero PAGE CODE is illegal)\n", __debug__);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
         return FALSE;
     }
 
     /* Vital product data */
     if (cdb->evpd) {
-        return command_inquiry_vpd(self, cdb);
+        return command_inquiry_vpd(self, cmd, cdb);
     }
 
     /* Values here are more or less what my DVD-ROM drive gives me
@@ -721,47 +974,47 @@ static gboolean command_inquiry (CdemuDevice *self, const guint8 *raw_cdb)
     ret_data->ver_desc1 = GUINT16_TO_BE(0x02A0); /* We'll try to pass as MMC-3 device */
 
     /* Write data */
-    cdemu_device_write_buffer(self, GUINT16_FROM_BE(cdb->length));
+    cdemu_device_write_buffer(self, cmd, GUINT16_FROM_BE(cdb->length));
 
     return TRUE;
 }
 
 /* MODE SELECT*/
-static gboolean command_mode_select (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_mode_select (CdemuDevice *self, CdemuCommand *cmd)
 {
     gint transfer_len = 0;
     /*gint sp;
     gint pf;*/
 
     /* MODE SELECT (6) vs MODE SELECT (10) */
-    if (raw_cdb[0] == MODE_SELECT_6) {
-        struct MODE_SELECT_6_CDB *cdb = (struct MODE_SELECT_6_CDB *)raw_cdb;
+    if (cmd->cdb[0] == MODE_SELECT_6) {
+        struct MODE_SELECT_6_CDB *cdb = (struct MODE_SELECT_6_CDB *)cmd->cdb;
         /*sp = cdb->sp;
         pf = cdb->pf;*/
         transfer_len = cdb->length;
     } else {
-        struct MODE_SELECT_10_CDB *cdb = (struct MODE_SELECT_10_CDB *)raw_cdb;
+        struct MODE_SELECT_10_CDB *cdb = (struct MODE_SELECT_10_CDB *)cmd->cdb;
         /*sp = cdb->sp;
         pf = cdb->pf;*/
         transfer_len = GUINT16_FROM_BE(cdb->length);
     }
 
     /* Read the parameter list */
-    cdemu_device_read_buffer(self, transfer_len);
+    cdemu_device_read_buffer(self, cmd, transfer_len);
 
     /* Dump the parameter list */
     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: received parameters:\n", __debug__);
-    CDEMU_DEBUG_PRINT_BUFFER(self, DAEMON_DEBUG_MMC, __debug__, 16, self->priv->buffer, transfer_len);
+    CDEMU_DEBUG_PRINT_BUFFER(self, DAEMON_DEBUG_MMC, __debug__, 16, cmd->buffer, transfer_len);
 
     /* Try to decipher mode select data... MODE SENSE (6) vs MODE SENSE (10) */
     gint blkdesc_len = 0;
     gint offset = 0;
-    if (raw_cdb[0] == MODE_SELECT_6) {
-        struct MODE_SENSE_6_Header *header = (struct MODE_SENSE_6_Header *)self->priv->buffer;
+    if (cmd->cdb[0] == MODE_SELECT_6) {
+        struct MODE_SENSE_6_Header *header = (struct MODE_SENSE_6_Header *)cmd->buffer;
         blkdesc_len = header->blkdesc_len;
         offset = sizeof(struct MODE_SENSE_6_Header) + blkdesc_len;
-    } else if (raw_cdb[0] == MODE_SELECT_10) {
-        struct MODE_SENSE_10_Header *header = (struct MODE_SENSE_10_Header *)self->priv->buffer;
+    } else if (cmd->cdb[0] == MODE_SELECT_10) {
+        struct MODE_SENSE_10_Header *header = (struct MODE_SENSE_10_Header *)cmd->buffer;
         blkdesc_len = GUINT16_FROM_BE(header->blkdesc_len);
         offset = sizeof(struct MODE_SENSE_10_Header) + blkdesc_len;
     }
@@ -769,7 +1022,7 @@ static gboolean command_mode_select (CdemuDevice *self, const guint8 *raw_cdb)
     /* Someday when I'm in good mood I might implement this */
     if (blkdesc_len) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: block descriptor provided... but ATAPI devices shouldn't support that\n", __debug__);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_PARAMETER_LIST);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_PARAMETER_LIST);
         return FALSE;
     }
 
@@ -777,12 +1030,12 @@ static gboolean command_mode_select (CdemuDevice *self, const guint8 *raw_cdb)
     gint page_size = transfer_len - offset;
 
     if (page_size) {
-        gint page_code = ((struct ModePageGeneral *)(self->priv->buffer + offset))->code;
+        gint page_code = ((struct ModePageGeneral *)(cmd->buffer + offset))->code;
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: modifying mode page 0x%X (%d bytes)\n", __debug__, page_code, page_size);
 
-        if (!cdemu_device_modify_mode_page(self, self->priv->buffer + offset, page_size)) {
+        if (!cdemu_device_modify_mode_page(self, cmd->buffer + offset, page_size)) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: failed to modify code page 0x%X!\n", __debug__, page_code);
-            cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_PARAMETER_LIST);
+            cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_PARAMETER_LIST);
             return FALSE;
         }
     }
@@ -791,37 +1044,37 @@ static gboolean command_mode_select (CdemuDevice *self, const guint8 *raw_cdb)
 }
 
 /* MODE SENSE*/
-static gboolean command_mode_sense (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_mode_sense (CdemuDevice *self, CdemuCommand *cmd)
 {
     gint page_code = 0;
     gint transfer_len = 0;
     gint pc = 0;
 
     /* MODE SENSE (6) vs MODE SENSE (10) */
-    if (raw_cdb[0] == MODE_SENSE_6) {
-        struct MODE_SENSE_6_CDB *cdb = (struct MODE_SENSE_6_CDB *)raw_cdb;
+    if (cmd->cdb[0] == MODE_SENSE_6) {
+        struct MODE_SENSE_6_CDB *cdb = (struct MODE_SENSE_6_CDB *)cmd->cdb;
 
         pc = cdb->pc;
         page_code = cdb->page_code;
         transfer_len = cdb->length;
 
-        self->priv->buffer_size = sizeof(struct MODE_SENSE_6_Header);
+        cmd->buffer_size = sizeof(struct MODE_SENSE_6_Header);
     } else {
-        struct MODE_SENSE_10_CDB *cdb = (struct MODE_SENSE_10_CDB *)raw_cdb;
+        struct MODE_SENSE_10_CDB *cdb = (struct MODE_SENSE_10_CDB *)cmd->cdb;
 
         pc = cdb->pc;
         page_code = cdb->page_code;
         transfer_len = GUINT16_FROM_BE(cdb->length);
 
-        self->priv->buffer_size = sizeof(struct MODE_SENSE_10_Header);
+        cmd->buffer_size = sizeof(struct MODE_SENSE_10_Header);
     }
 
-    guint8 *ret_data = self->priv->buffer+self->priv->buffer_size;
+    guint8 *ret_data = cmd->buffer+cmd->buffer_size;
 
     /* We don't support saving mode pages */
     if (pc == 0x03) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: requested saved values; we don't support saving!\n", __debug__);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, SAVING_PARAMETERS_NOT_SUPPORTED);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, SAVING_PARAMETERS_NOT_SUPPORTED);
         return FALSE;
     }
 
@@ -857,7 +1110,7 @@ static gboolean command_mode_sense (CdemuDevice *self, const guint8 *raw_cdb)
             }
 
             memcpy(ret_data, mode_page, mode_page->length + 2);
-            self->priv->buffer_size += mode_page->length + 2;
+            cmd->buffer_size += mode_page->length + 2;
             ret_data += mode_page->length + 2;
 
             if (page_code != 0x3F) {
@@ -871,29 +1124,29 @@ static gboolean command_mode_sense (CdemuDevice *self, const guint8 *raw_cdb)
     /* If we aren't returning all pages, check if page was found */
     if (page_code != 0x3F && !page_found) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: page 0x%X not found!\n", __debug__, page_code);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
         return FALSE;
     }
 
     /* Header; MODE SENSE (6) vs MODE SENSE (10) */
-    if (raw_cdb[0] == MODE_SENSE_6) {
-        struct MODE_SENSE_6_Header *ret_header = (struct MODE_SENSE_6_Header *)self->priv->buffer;
-        ret_header->length = self->priv->buffer_size - 2;
-    } else if (raw_cdb[0] == MODE_SENSE_10) {
-        struct MODE_SENSE_10_Header *ret_header = (struct MODE_SENSE_10_Header *)self->priv->buffer;
-        ret_header->length = GUINT16_TO_BE(self->priv->buffer_size - 2);
+    if (cmd->cdb[0] == MODE_SENSE_6) {
+        struct MODE_SENSE_6_Header *ret_header = (struct MODE_SENSE_6_Header *)cmd->buffer;
+        ret_header->length = cmd->buffer_size - 2;
+    } else if (cmd->cdb[0] == MODE_SENSE_10) {
+        struct MODE_SENSE_10_Header *ret_header = (struct MODE_SENSE_10_Header *)cmd->buffer;
+        ret_header->length = GUINT16_TO_BE(cmd->buffer_size - 2);
     }
 
     /* Write data */
-    cdemu_device_write_buffer(self, transfer_len);
+    cdemu_device_write_buffer(self, cmd, transfer_len);
 
     return TRUE;
 }
 
 /* PAUSE/RESUME*/
-static gboolean command_pause_resume (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_pause_resume (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct PAUSE_RESUME_CDB *cdb = (struct PAUSE_RESUME_CDB *)raw_cdb;
+    struct PAUSE_RESUME_CDB *cdb = (struct PAUSE_RESUME_CDB *)cmd->cdb;
     gint audio_status = cdemu_audio_get_status(CDEMU_AUDIO(self->priv->audio_play));
 
     /* Resume */
@@ -904,7 +1157,7 @@ static gboolean command_pause_resume (CdemuDevice *self, const guint8 *raw_cdb)
         if ((audio_status != AUDIO_STATUS_PAUSED)
             && (audio_status != AUDIO_STATUS_PLAYING)) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: resume requested while in invalid state!\n", __debug__);
-            cdemu_device_write_sense(self, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
+            cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
             return FALSE;
         }
 
@@ -921,7 +1174,7 @@ static gboolean command_pause_resume (CdemuDevice *self, const guint8 *raw_cdb)
         if ((audio_status != AUDIO_STATUS_PAUSED)
             && (audio_status != AUDIO_STATUS_PLAYING)) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: pause requested while in invalid state!\n", __debug__);
-            cdemu_device_write_sense(self, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
+            cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
             return FALSE;
         }
 
@@ -935,24 +1188,24 @@ static gboolean command_pause_resume (CdemuDevice *self, const guint8 *raw_cdb)
 }
 
 /* PLAY AUDIO*/
-static gboolean command_play_audio (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_play_audio (CdemuDevice *self, CdemuCommand *cmd)
 {
     guint32 start_sector = 0;
     guint32 end_sector = 0;
 
     /* PLAY AUDIO (10) vs PLAY AUDIO (12) vs PLAY AUDIO MSF */
-    if (raw_cdb[0] == PLAY_AUDIO_10) {
-        struct PLAY_AUDIO_10_CDB *cdb = (struct PLAY_AUDIO_10_CDB *)raw_cdb;
+    if (cmd->cdb[0] == PLAY_AUDIO_10) {
+        struct PLAY_AUDIO_10_CDB *cdb = (struct PLAY_AUDIO_10_CDB *)cmd->cdb;
 
         start_sector = GUINT32_FROM_BE(cdb->lba);
         end_sector = GUINT32_FROM_BE(cdb->lba) + GUINT16_FROM_BE(cdb->play_len);
-    } else if (raw_cdb[0] == PLAY_AUDIO_12) {
-        struct PLAY_AUDIO_12_CDB *cdb = (struct PLAY_AUDIO_12_CDB *)raw_cdb;
+    } else if (cmd->cdb[0] == PLAY_AUDIO_12) {
+        struct PLAY_AUDIO_12_CDB *cdb = (struct PLAY_AUDIO_12_CDB *)cmd->cdb;
 
         start_sector = GUINT32_FROM_BE(cdb->lba);
         end_sector = GUINT32_FROM_BE(cdb->lba) + GUINT32_FROM_BE(cdb->play_len);
     } else {
-        struct PLAY_AUDIO_MSF_CDB *cdb = (struct PLAY_AUDIO_MSF_CDB *)raw_cdb;
+        struct PLAY_AUDIO_MSF_CDB *cdb = (struct PLAY_AUDIO_MSF_CDB *)cmd->cdb;
 
         start_sector = mirage_helper_msf2lba(cdb->start_m, cdb->start_s, cdb->start_f, TRUE);
         end_sector = mirage_helper_msf2lba(cdb->end_m, cdb->end_s, cdb->end_f, TRUE);
@@ -961,7 +1214,7 @@ static gboolean command_play_audio (CdemuDevice *self, const guint8 *raw_cdb)
      /* Check if we have medium loaded */
     if (!self->priv->loaded) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: medium not present\n", __debug__);
-        cdemu_device_write_sense(self, NOT_READY, MEDIUM_NOT_PRESENT);
+        cdemu_device_write_sense(self, cmd, NOT_READY, MEDIUM_NOT_PRESENT);
         return FALSE;
     }
 
@@ -978,9 +1231,9 @@ static gboolean command_play_audio (CdemuDevice *self, const guint8 *raw_cdb)
 }
 
 /* PREVENT/ALLOW MEDIUM REMOVAL*/
-static gboolean command_prevent_allow_medium_removal (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_prevent_allow_medium_removal (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct PREVENT_ALLOW_MEDIUM_REMOVAL_CDB *cdb = (struct PREVENT_ALLOW_MEDIUM_REMOVAL_CDB*)raw_cdb;
+    struct PREVENT_ALLOW_MEDIUM_REMOVAL_CDB *cdb = (struct PREVENT_ALLOW_MEDIUM_REMOVAL_CDB*)cmd->cdb;
     struct ModePage_0x2A *p_0x2A = cdemu_device_get_mode_page(self, 0x2A, MODE_PAGE_CURRENT);
 
     /* That's the locking, right? */
@@ -1000,7 +1253,7 @@ static gboolean command_prevent_allow_medium_removal (CdemuDevice *self, const g
 }
 
 /* READ (10) and READ (12)*/
-static gboolean command_read (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_read (CdemuDevice *self, CdemuCommand *cmd)
 {
     gint start_address; /* MUST be signed because it may be negative! */
     gint num_sectors;
@@ -1008,41 +1261,78 @@ static gboolean command_read (CdemuDevice *self, const guint8 *raw_cdb)
     struct ModePage_0x01 *p_0x01 = cdemu_device_get_mode_page(self, 0x01, MODE_PAGE_CURRENT);
 
     /* READ 10 vs READ 12 */
-    if (raw_cdb[0] == READ_10) {
-        struct READ_10_CDB *cdb = (struct READ_10_CDB *)raw_cdb;
+    if (cmd->cdb[0] == READ_10) {
+        struct READ_10_CDB *cdb = (struct READ_10_CDB *)cmd->cdb;
         start_address = GUINT32_FROM_BE(cdb->lba);
         num_sectors  = GUINT16_FROM_BE(cdb->length);
     } else {
-        struct READ_12_CDB *cdb = (struct READ_12_CDB *)raw_cdb;
+        struct READ_12_CDB *cdb = (struct READ_12_CDB *)cmd->cdb;
         start_address = GUINT32_FROM_BE(cdb->lba);
         num_sectors  = GUINT32_FROM_BE(cdb->length);
     }
 
     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: read request; start sector: 0x%X, number of sectors: %d\n", __debug__, start_address, num_sectors);
+    cmd->num_sectors = num_sectors;
 
     /* Check if we have medium loaded (because we use track later... >.<) */
     if (!self->priv->loaded) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: medium not present\n", __debug__);
-        cdemu_device_write_sense(self, NOT_READY, MEDIUM_NOT_PRESENT);
+        cdemu_device_write_sense(self, cmd, NOT_READY, MEDIUM_NOT_PRESENT);
         return FALSE;
     }
     MirageDisc *disc = self->priv->disc;
 
     /* Set up delay emulation */
-    cdemu_device_delay_begin(self, start_address, num_sectors);
+    cdemu_device_delay_begin(self, cmd, start_address, num_sectors);
 
-    /* Process each sector */
+    /* Unless bad sector emulation requires us to examine each sector,
+       contiguous runs of sectors are read in batches, directly into the
+       command's output buffer; this bypasses both sector objects and our
+       cache */
+    gboolean batched_read = !(self->priv->bad_sector_emulation && !p_0x01->dcr);
+
+    /* Process sectors */
     for (gint address = start_address; address < start_address + num_sectors; address++) {
         GError *error = NULL;
-        MirageSector *sector = mirage_disc_get_sector(disc, address, &error);
+
+        /* Sector might have already been read by read-ahead */
+        MirageSector *sector = cdemu_device_read_ahead_take_sector(self, address);
+
+        if (!sector && batched_read) {
+            guint32 out_available;
+            guint8 *out_buffer = cdemu_device_get_out_buffer(self, cmd, &out_available);
+            gint batch_size = MIN(out_available / 2048, (guint32)(start_address + num_sectors - address));
+            gint num_read = 0;
+
+            if (batch_size > 0) {
+                num_read = mirage_disc_read_sectors(disc, address, batch_size, 2048, out_buffer, NULL);
+            }
+            if (num_read > 0) {
+                cdemu_device_commit_out_buffer(self, cmd, num_read * 2048);
+                address += num_read - 1;
+
+                /* Needed for some other commands */
+                self->priv->current_address = address;
+                continue;
+            }
+
+            /* Sector could not be read as part of batch; fall back to
+               reading it on its own, which also takes care of reporting
+               the error */
+        }
+
         if (!sector) {
-            CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: failed to read sector: %s\n", __debug__, error->message);
-            g_error_free(error);
-            cdemu_device_write_sense_full(self, ILLEGAL_REQUEST, ILLEGAL_MODE_FOR_THIS_TRACK, 0, address);
-            return FALSE;
+            sector = mirage_disc_acquire_sector(disc);
+            if (!mirage_disc_read_sector(disc, address, sector, &error)) {
+                CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: failed to read sector: %s\n", __debug__, error->message);
+                g_error_free(error);
+                mirage_disc_release_sector(disc, sector);
+                cdemu_device_write_sense_full(self, cmd, ILLEGAL_REQUEST, ILLEGAL_MODE_FOR_THIS_TRACK, 0, address);
+                return FALSE;
+            }
         }
 
-        cdemu_device_flush_buffer(self);
+        cdemu_device_flush_buffer(self, cmd);
 
         /* Here we do the emulation of "bad sectors"... if we're dealing with
            a bad sector, then its EDC/ECC won't correspond to actual data. So
@@ -1056,8 +1346,8 @@ static gboolean command_read (CdemuDevice *self, const guint8 *raw_cdb)
             if ((sector_type == MIRAGE_SECTOR_MODE1 || sector_type == MIRAGE_SECTOR_MODE2_FORM1)
                 && !mirage_sector_verify_lec(sector)) {
                 CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: bad sector detected, triggering read error!\n", __debug__);
-                g_object_unref(sector);
-                cdemu_device_write_sense_full(self, MEDIUM_ERROR, UNRECOVERED_READ_ERROR, 0, address);
+                mirage_disc_release_sector(disc, sector);
+                cdemu_device_write_sense_full(self, cmd, MEDIUM_ERROR, UNRECOVERED_READ_ERROR, 0, address);
                 return FALSE;
             }
         }
@@ -1069,46 +1359,48 @@ static gboolean command_read (CdemuDevice *self, const guint8 *raw_cdb)
         mirage_sector_get_data(sector, &tmp_buf, &tmp_len, NULL);
         if (tmp_len != 2048) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: sector 0x%X does not have 2048-byte user data (%i)\n", __debug__, address, tmp_len);
-            g_object_unref(sector);
-            cdemu_device_write_sense_full(self, ILLEGAL_REQUEST, ILLEGAL_MODE_FOR_THIS_TRACK, 1, address);
+            mirage_disc_release_sector(disc, sector);
+            cdemu_device_write_sense_full(self, cmd, ILLEGAL_REQUEST, ILLEGAL_MODE_FOR_THIS_TRACK, 1, address);
             return FALSE;
         }
 
-        memcpy(self->priv->buffer+self->priv->buffer_size, tmp_buf, tmp_len);
-        self->priv->buffer_size += tmp_len;
+        memcpy(cmd->buffer+cmd->buffer_size, tmp_buf, tmp_len);
+        cmd->buffer_size += tmp_len;
 
         /* Needed for some other commands */
         self->priv->current_address = address;
         /* Free sector */
-        g_object_unref(sector);
+        mirage_disc_release_sector(disc, sector);
         /* Write sector */
-        cdemu_device_write_buffer(self, self->priv->buffer_size);
+        cdemu_device_write_buffer(self, cmd, cmd->buffer_size);
     }
 
-    /* Perform delay emulation */
-    cdemu_device_delay_finalize(self);
+    /* Schedule read-ahead of subsequent sectors */
+    cdemu_device_read_ahead_schedule(self, start_address, num_sectors);
+
+    debug_sector_pool_statistics(self, disc);
 
     return TRUE;
 }
 
 /* READ BUFFER CAPACITY */
-static gboolean command_read_buffer_capacity (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_read_buffer_capacity (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct READ_BUFFER_CAPACITY_CDB *cdb = (struct READ_BUFFER_CAPACITY_CDB *)raw_cdb;
-    struct READ_BUFFER_CAPACITY_Data *ret_data = (struct READ_BUFFER_CAPACITY_Data *)self->priv->buffer;
-    self->priv->buffer_size = sizeof(struct READ_BUFFER_CAPACITY_Data);
+    struct READ_BUFFER_CAPACITY_CDB *cdb = (struct READ_BUFFER_CAPACITY_CDB *)cmd->cdb;
+    struct READ_BUFFER_CAPACITY_Data *ret_data = (struct READ_BUFFER_CAPACITY_Data *)cmd->buffer;
+    cmd->buffer_size = sizeof(struct READ_BUFFER_CAPACITY_Data);
 
     /* Medium must be present */
     if (!self->priv->loaded) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: medium not present\n", __debug__);
-        cdemu_device_write_sense(self, NOT_READY, MEDIUM_NOT_PRESENT);
+        cdemu_device_write_sense(self, cmd, NOT_READY, MEDIUM_NOT_PRESENT);
         return FALSE;
     }
 
     /* Buffer capacity data */
     gint buffer_capacity = cdemu_device_get_kernel_io_buffer_size(self);
 
-    ret_data->data_length = GUINT16_TO_BE(self->priv->buffer_size - 2);
+    ret_data->data_length = GUINT16_TO_BE(cmd->buffer_size - 2);
     ret_data->block = cdb->block;
     if (ret_data->block) {
         ret_data->length_of_buffer = 0x00000000; /* Reserved */
@@ -1119,23 +1411,23 @@ static gboolean command_read_buffer_capacity (CdemuDevice *self, const guint8 *r
     }
 
     /* Write data */
-    cdemu_device_write_buffer(self, self->priv->buffer_size);
+    cdemu_device_write_buffer(self, cmd, cmd->buffer_size);
 
     return TRUE;
 }
 
 /* READ CAPACITY*/
-static gboolean command_read_capacity (CdemuDevice *self, const guint8 *raw_cdb G_GNUC_UNUSED)
+static gboolean command_read_capacity (CdemuDevice *self, CdemuCommand *cmd)
 {
-    /*struct READ_CAPACITY_CDB *cdb = (struct READ_CAPACITY_CDB *)raw_cdb;*/
-    struct READ_CAPACITY_Data *ret_data = (struct READ_CAPACITY_Data *)self->priv->buffer;
-    self->priv->buffer_size = sizeof(struct READ_CAPACITY_Data);
+    /*struct READ_CAPACITY_CDB *cdb = (struct READ_CAPACITY_CDB *)cmd->cdb;*/
+    struct READ_CAPACITY_Data *ret_data = (struct READ_CAPACITY_Data *)cmd->buffer;
+    cmd->buffer_size = sizeof(struct READ_CAPACITY_Data);
 
     gint last_sector = 0;
 
     if (!self->priv->loaded) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: medium not present\n", __debug__);
-        cdemu_device_write_sense(self, NOT_READY, MEDIUM_NOT_PRESENT);
+        cdemu_device_write_sense(self, cmd, NOT_READY, MEDIUM_NOT_PRESENT);
         return FALSE;
     }
 
@@ -1158,13 +1450,13 @@ static gboolean command_read_capacity (CdemuDevice *self, const guint8 *raw_cdb
     ret_data->block_size = GUINT32_TO_BE(2048);
 
     /* Write data */
-    cdemu_device_write_buffer(self, self->priv->buffer_size);
+    cdemu_device_write_buffer(self, cmd, cmd->buffer_size);
 
     return TRUE;
 }
 
 /* READ CD and READ CD MSF*/
-static gboolean command_read_cd (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_read_cd (CdemuDevice *self, CdemuCommand *cmd)
 {
     gint start_address; /* MUST be signed because it may be negative! */
     gint num_sectors;
@@ -1174,8 +1466,8 @@ static gboolean command_read_cd (CdemuDevice *self, const guint8 *raw_cdb)
     struct ModePage_0x01 *p_0x01 = cdemu_device_get_mode_page(self, 0x01, MODE_PAGE_CURRENT);
 
     /* READ CD vs READ CD MSF */
-    if (raw_cdb[0] == READ_CD) {
-        struct READ_CD_CDB *cdb = (struct READ_CD_CDB *)raw_cdb;
+    if (cmd->cdb[0] == READ_CD) {
+        struct READ_CD_CDB *cdb = (struct READ_CD_CDB *)cmd->cdb;
 
         start_address = GUINT32_FROM_BE(cdb->lba);
         num_sectors = GUINT24_FROM_BE(cdb->length);
@@ -1183,7 +1475,7 @@ static gboolean command_read_cd (CdemuDevice *self, const guint8 *raw_cdb)
         exp_sect_type = map_expected_sector_type(cdb->sect_type);
         subchannel_mode = cdb->subchan;
     } else {
-        struct READ_CD_MSF_CDB *cdb = (struct READ_CD_MSF_CDB *)raw_cdb;
+        struct READ_CD_MSF_CDB *cdb = (struct READ_CD_MSF_CDB *)cmd->cdb;
         gint32 end_address = 0;
 
         start_address = mirage_helper_msf2lba(cdb->start_m, cdb->start_s, cdb->start_f, TRUE);
@@ -1195,20 +1487,20 @@ static gboolean command_read_cd (CdemuDevice *self, const guint8 *raw_cdb)
     }
 
     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: READ CD:\n-> Address: 0x%08X\n-> Length: %i\n-> Expected sector (in libMirage type): 0x%X\n-> MCSB: 0x%X\n-> SubChannel: 0x%X\n",
-        __debug__, start_address, num_sectors, exp_sect_type, raw_cdb[9], subchannel_mode);
+        __debug__, start_address, num_sectors, exp_sect_type, cmd->cdb[9], subchannel_mode);
 
 
     /* Check if we have medium loaded */
     if (!self->priv->loaded) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: medium not present\n", __debug__);
-        cdemu_device_write_sense(self, NOT_READY, MEDIUM_NOT_PRESENT);
+        cdemu_device_write_sense(self, cmd, NOT_READY, MEDIUM_NOT_PRESENT);
         return FALSE;
     }
 
     /* Not supported for DVD-ROMs, right? */
     if (self->priv->current_profile == PROFILE_DVDROM) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: READ CD not supported on DVD Media!\n", __debug__);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
         return FALSE;
     }
 
@@ -1219,7 +1511,7 @@ static gboolean command_read_cd (CdemuDevice *self, const guint8 *raw_cdb)
     if (subchannel_mode == 0x04) {
         /* invalid subchannel requested (don't support R-W yet) */
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: R-W subchannel reading not supported yet\n", __debug__);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
         return FALSE;
     }
 
@@ -1227,21 +1519,29 @@ static gboolean command_read_cd (CdemuDevice *self, const guint8 *raw_cdb)
     MirageDisc* disc = self->priv->disc;
     MirageSector *first_sector;
     GError *error = NULL;
-    gint prev_sector_type G_GNUC_UNUSED;
+    gint prev_sector_type;
+    ReadCdRecipe recipe;
+    ReadCdSubchannelBatch subchannel_batch = { .num_sectors = 0 };
 
     /* Read first sector to determine its type */
-    first_sector = mirage_disc_get_sector(disc, start_address, &error);
-    if (!first_sector) {
+    first_sector = mirage_disc_acquire_sector(disc);
+    if (!mirage_disc_read_sector(disc, start_address, first_sector, &error)) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: failed to get start sector: %s\n", __debug__, error->message);
         g_error_free(error);
-        cdemu_device_write_sense_full(self, ILLEGAL_REQUEST, ILLEGAL_MODE_FOR_THIS_TRACK, 0, start_address);
+        mirage_disc_release_sector(disc, first_sector);
+        cdemu_device_write_sense_full(self, cmd, ILLEGAL_REQUEST, ILLEGAL_MODE_FOR_THIS_TRACK, 0, start_address);
         return FALSE;
     }
     prev_sector_type = mirage_sector_get_sector_type(first_sector);
-    g_object_unref(first_sector);
+    mirage_disc_release_sector(disc, first_sector);
 
     /* Set up delay emulation */
-    cdemu_device_delay_begin(self, start_address, num_sectors);
+    cdemu_device_delay_begin(self, cmd, start_address, num_sectors);
+    cmd->num_sectors = num_sectors;
+
+    /* Compile the layout of requested data. NOTE: we do not verify MCSB
+       for illegal combinations */
+    read_cd_recipe_compile(&recipe, cmd->cdb[9], exp_sect_type, subchannel_mode);
 
     /* Process each sector */
     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: start sector: 0x%X (%i); start + num: 0x%X (%i)\n", __debug__, start_address, start_address, start_address+num_sectors, start_address+num_sectors);
@@ -1250,15 +1550,47 @@ static gboolean command_read_cd (CdemuDevice *self, const guint8 *raw_cdb)
 
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: reading sector 0x%X (%i)\n", __debug__, address, address);
 
-        sector = mirage_disc_get_sector(disc, address, &error);
+        /* Sector might have already been read by read-ahead */
+        sector = cdemu_device_read_ahead_take_sector(self, address);
+
+        /* Within a run of audio sectors, attempt to read the remaining ones
+           in a batch, directly into the command's output buffer; audio
+           sectors are not subject to bad sector emulation, and batch stops
+           at the first sector whose user data is not 2352 bytes */
+        if (!sector && recipe.batched_audio && prev_sector_type == MIRAGE_SECTOR_AUDIO) {
+            guint32 out_available;
+            guint8 *out_buffer = cdemu_device_get_out_buffer(self, cmd, &out_available);
+            gint batch_size = MIN(out_available / 2352, (guint32)(start_address + num_sectors - address));
+            gint num_read = 0;
+
+            if (batch_size > 0) {
+                num_read = mirage_disc_read_sectors(disc, address, batch_size, 2352, out_buffer, NULL);
+            }
+            if (num_read > 0) {
+                cdemu_device_commit_out_buffer(self, cmd, num_read * 2352);
+                address += num_read - 1;
+
+                /* Needed for some other commands */
+                self->priv->current_address = address;
+                continue;
+            }
+
+            /* Sector is not an audio one (or could not be read as part of
+               batch); fall back to reading it on its own */
+        }
+
         if (!sector) {
-            CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: failed to get sector: %s!\n", __debug__, error->message);
-            g_error_free(error);
-            cdemu_device_write_sense_full(self, ILLEGAL_REQUEST, ILLEGAL_MODE_FOR_THIS_TRACK, 0, address);
-            return FALSE;
+            sector = mirage_disc_acquire_sector(disc);
+            if (!mirage_disc_read_sector(disc, address, sector, &error)) {
+                CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: failed to get sector: %s!\n", __debug__, error->message);
+                g_error_free(error);
+                mirage_disc_release_sector(disc, sector);
+                cdemu_device_write_sense_full(self, cmd, ILLEGAL_REQUEST, ILLEGAL_MODE_FOR_THIS_TRACK, 0, address);
+                return FALSE;
+            }
         }
 
-        cdemu_device_flush_buffer(self);
+        cdemu_device_flush_buffer(self, cmd);
 
         /* Expected sector stuff check... basically, if we have CDB->ExpectedSectorType
            set, we compare its translated value with our sector type, period. However, if
@@ -1269,8 +1601,8 @@ static gboolean command_read_cd (CdemuDevice *self, const guint8 *raw_cdb)
         /* Break if current sector type doesn't match expected one*/
         if (exp_sect_type && (sector_type != exp_sect_type)) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: expected sector type mismatch (expecting %i, got %i)!\n", __debug__, exp_sect_type, sector_type);
-            g_object_unref(sector);
-            cdemu_device_write_sense_full(self, ILLEGAL_REQUEST, ILLEGAL_MODE_FOR_THIS_TRACK, 1, address);
+            mirage_disc_release_sector(disc, sector);
+            cdemu_device_write_sense_full(self, cmd, ILLEGAL_REQUEST, ILLEGAL_MODE_FOR_THIS_TRACK, 1, address);
             return FALSE;
         }
 
@@ -1280,8 +1612,8 @@ static gboolean command_read_cd (CdemuDevice *self, const guint8 *raw_cdb)
                fact that Mode 2 Form 1 and Mode 2 Form 2 can alternate... */
             if (prev_sector_type != sector_type) {
                 CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: previous sector type (%i) different from current one (%i)!\n", __debug__, prev_sector_type, sector_type);
-                g_object_unref(sector);
-                cdemu_device_write_sense_full(self, ILLEGAL_REQUEST, ILLEGAL_MODE_FOR_THIS_TRACK, 0, address);
+                mirage_disc_release_sector(disc, sector);
+                cdemu_device_write_sense_full(self, cmd, ILLEGAL_REQUEST, ILLEGAL_MODE_FOR_THIS_TRACK, 0, address);
                 return FALSE;
             }
         }
@@ -1296,57 +1628,72 @@ static gboolean command_read_cd (CdemuDevice *self, const guint8 *raw_cdb)
             if ((sector_type == MIRAGE_SECTOR_MODE1 || sector_type == MIRAGE_SECTOR_MODE2_FORM1)
                 && !mirage_sector_verify_lec(sector)) {
                 CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: bad sector detected, triggering read error!\n", __debug__);
-                g_object_unref(sector);
-                cdemu_device_write_sense_full(self, MEDIUM_ERROR, UNRECOVERED_READ_ERROR, 0, address);
+                mirage_disc_release_sector(disc, sector);
+                cdemu_device_write_sense_full(self, cmd, MEDIUM_ERROR, UNRECOVERED_READ_ERROR, 0, address);
                 return FALSE;
             }
         }
 
-        /* We read data here. NOTE: we do not verify MCSB for illegal combinations */
-        gint read_length = read_sector_data(sector, NULL, 0, raw_cdb[9], subchannel_mode, self->priv->buffer+self->priv->buffer_size, &error);
+        /* We read data here; if the sector fits into the remaining output
+           buffer, it is emitted directly there, otherwise it goes through
+           our cache, which takes care of truncation */
+        guint32 out_available;
+        guint8 *out_buffer = cdemu_device_get_out_buffer(self, cmd, &out_available);
+        gint expected_length = read_cd_recipe_get_length(&recipe, sector_type);
+        gboolean direct = expected_length >= 0 && (guint32)expected_length <= out_available;
+
+        const guint8 *subchannel_data = read_cd_subchannel_batch_lookup(&subchannel_batch, &recipe, disc, address, start_address + num_sectors);
+
+        gint read_length = read_cd_recipe_emit_sector(&recipe, sector, subchannel_data, direct ? out_buffer : cmd->buffer+cmd->buffer_size, &error);
         if (read_length == -1) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: failed to read sector 0x%X: %s\n", __debug__, address, error->message);
             g_error_free(error);
-            g_object_unref(sector);
-            cdemu_device_write_sense_full(self, ILLEGAL_REQUEST, ILLEGAL_MODE_FOR_THIS_TRACK, 0, address);
+            mirage_disc_release_sector(disc, sector);
+            cdemu_device_write_sense_full(self, cmd, ILLEGAL_REQUEST, ILLEGAL_MODE_FOR_THIS_TRACK, 0, address);
             return FALSE;
         }
 
-        CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: read length: 0x%X, buffer size: 0x%X\n", __debug__, read_length, self->priv->buffer_size);
-        self->priv->buffer_size += read_length;
+        CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: read length: 0x%X, buffer size: 0x%X\n", __debug__, read_length, cmd->buffer_size);
 
         /* Previous sector type */
         prev_sector_type = sector_type;
         /* Needed for some other commands */
         self->priv->current_address = address;
         /* Free sector */
-        g_object_unref(sector);
+        mirage_disc_release_sector(disc, sector);
         /* Write sector */
-        cdemu_device_write_buffer(self, self->priv->buffer_size);
+        if (direct) {
+            cdemu_device_commit_out_buffer(self, cmd, read_length);
+        } else {
+            cmd->buffer_size += read_length;
+            cdemu_device_write_buffer(self, cmd, cmd->buffer_size);
+        }
     }
 
-    /* Perform delay emulation */
-    cdemu_device_delay_finalize(self);
+    /* Schedule read-ahead of subsequent sectors */
+    cdemu_device_read_ahead_schedule(self, start_address, num_sectors);
+
+    debug_sector_pool_statistics(self, disc);
 
     return TRUE;
 }
 
 /* READ DISC INFORMATION*/
-static gboolean command_read_disc_information (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_read_disc_information (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct READ_DISC_INFORMATION_CDB *cdb = (struct READ_DISC_INFORMATION_CDB *)raw_cdb;
+    struct READ_DISC_INFORMATION_CDB *cdb = (struct READ_DISC_INFORMATION_CDB *)cmd->cdb;
 
     /* Check if we have medium loaded */
     if (!self->priv->loaded) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: medium not present\n", __debug__);
-        cdemu_device_write_sense(self, NOT_READY, MEDIUM_NOT_PRESENT);
+        cdemu_device_write_sense(self, cmd, NOT_READY, MEDIUM_NOT_PRESENT);
         return FALSE;
     }
 
     switch (cdb->type) {
         case 0x000: {
-            struct READ_DISC_INFORMATION_Data *ret_data = (struct READ_DISC_INFORMATION_Data *)self->priv->buffer;
-            self->priv->buffer_size = sizeof(struct READ_DISC_INFORMATION_Data);
+            struct READ_DISC_INFORMATION_Data *ret_data = (struct READ_DISC_INFORMATION_Data *)cmd->buffer;
+            cmd->buffer_size = sizeof(struct READ_DISC_INFORMATION_Data);
 
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: standard disc information\n", __debug__);
 
@@ -1445,7 +1792,7 @@ static gboolean command_read_disc_information (CdemuDevice *self, const guint8 *
 
 
             /* Write gathered information */
-            ret_data->length = GUINT16_TO_BE(self->priv->buffer_size - 2);
+            ret_data->length = GUINT16_TO_BE(cmd->buffer_size - 2);
 
             ret_data->erasable = self->priv->rewritable_disc;
             ret_data->disc_status = disc_status;
@@ -1484,28 +1831,28 @@ static gboolean command_read_disc_information (CdemuDevice *self, const guint8 *
         }
         default: {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: data type 0x%X not supported!\n", __debug__, cdb->type);
-            cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+            cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
             return FALSE;
         }
     }
 
     /* Write data */
-    cdemu_device_write_buffer(self, self->priv->buffer_size);
+    cdemu_device_write_buffer(self, cmd, cmd->buffer_size);
 
     return TRUE;
 }
 
 /* READ DISC STRUCTURE*/
-static gboolean command_read_disc_structure (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_read_disc_structure (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct READ_DISC_STRUCTURE_CDB *cdb = (struct READ_DISC_STRUCTURE_CDB *)raw_cdb;
-    struct READ_DISC_STRUCTURE_Header *head = (struct READ_DISC_STRUCTURE_Header *)self->priv->buffer;
-    self->priv->buffer_size = sizeof(struct READ_DISC_STRUCTURE_Header);
+    struct READ_DISC_STRUCTURE_CDB *cdb = (struct READ_DISC_STRUCTURE_CDB *)cmd->cdb;
+    struct READ_DISC_STRUCTURE_Header *head = (struct READ_DISC_STRUCTURE_Header *)cmd->buffer;
+    cmd->buffer_size = sizeof(struct READ_DISC_STRUCTURE_Header);
 
     /* Check if we have medium loaded */
     if (!self->priv->loaded) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: medium not present\n", __debug__);
-        cdemu_device_write_sense(self, NOT_READY, MEDIUM_NOT_PRESENT);
+        cdemu_device_write_sense(self, cmd, NOT_READY, MEDIUM_NOT_PRESENT);
         return FALSE;
     }
 
@@ -1514,19 +1861,19 @@ static gboolean command_read_disc_structure (CdemuDevice *self, const guint8 *ra
         /* DVD and HD DVD types */
         if (self->priv->current_profile != PROFILE_DVDROM && self->priv->current_profile != PROFILE_DVDPLUSR) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: requested to read DVD structure from non-DVD medium!\n", __debug__);
-            cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+            cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
             return FALSE;
         }
     } else if (cdb->media_type == 0x01) {
         /* BluRay */
         if (self->priv->current_profile != PROFILE_BDROM && self->priv->current_profile != PROFILE_BDR_SRM) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: requested to read BD structure from non-BD medium!\n", __debug__);
-            cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+            cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
             return FALSE;
         }
     } else {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: invalid medium type code!\n", __debug__);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
         return FALSE;
     }
 
@@ -1537,8 +1884,8 @@ static gboolean command_read_disc_structure (CdemuDevice *self, const guint8 *ra
     gint struct_len = 0;
 
     if (mirage_disc_get_disc_structure(self->priv->disc, cdb->layer, cdb->format, &struct_data, &struct_len, NULL)) {
-        memcpy(self->priv->buffer+sizeof(struct READ_DISC_STRUCTURE_Header), struct_data, struct_len);
-        self->priv->buffer_size += struct_len;
+        memcpy(cmd->buffer+sizeof(struct READ_DISC_STRUCTURE_Header), struct_data, struct_len);
+        cmd->buffer_size += struct_len;
     } else {
         /* Structure not found in the image; try to fabricate it */
         guint8 *tmp_data = NULL;
@@ -1546,38 +1893,38 @@ static gboolean command_read_disc_structure (CdemuDevice *self, const guint8 *ra
 
         if (!cdemu_device_generate_disc_structure(self, cdb->layer, cdb->format, &tmp_data, &tmp_len)) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: structure %Xh in layer %Xh not provided by image and cannot be fabricated!\n", __debug__, cdb->format, cdb->layer);
-            cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+            cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
             return FALSE;
         }
 
-        memcpy(self->priv->buffer+sizeof(struct READ_DISC_STRUCTURE_Header), tmp_data, tmp_len);
-        self->priv->buffer_size += tmp_len;
+        memcpy(cmd->buffer+sizeof(struct READ_DISC_STRUCTURE_Header), tmp_data, tmp_len);
+        cmd->buffer_size += tmp_len;
 
         g_free(tmp_data);
     }
 
     /* Header */
-    head->length = GUINT16_TO_BE(self->priv->buffer_size - 2);
+    head->length = GUINT16_TO_BE(cmd->buffer_size - 2);
 
     /* Write data */
-    cdemu_device_write_buffer(self, GUINT16_FROM_BE(cdb->length));
+    cdemu_device_write_buffer(self, cmd, GUINT16_FROM_BE(cdb->length));
 
     return TRUE;
 }
 
 /* READ SUB-CHANNEL*/
-static gboolean command_read_subchannel (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_read_subchannel (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct READ_SUBCHANNEL_CDB *cdb = (struct READ_SUBCHANNEL_CDB *)raw_cdb;
-    struct READ_SUBCHANNEL_Header *ret_header = (struct READ_SUBCHANNEL_Header *)self->priv->buffer;
-    self->priv->buffer_size = sizeof(struct READ_SUBCHANNEL_Header);
+    struct READ_SUBCHANNEL_CDB *cdb = (struct READ_SUBCHANNEL_CDB *)cmd->cdb;
+    struct READ_SUBCHANNEL_Header *ret_header = (struct READ_SUBCHANNEL_Header *)cmd->buffer;
+    cmd->buffer_size = sizeof(struct READ_SUBCHANNEL_Header);
 
     MirageDisc *disc = self->priv->disc;
 
     /* Check if we have medium loaded */
     if (!self->priv->loaded) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: medium not present\n", __debug__);
-        cdemu_device_write_sense(self, NOT_READY, MEDIUM_NOT_PRESENT);
+        cdemu_device_write_sense(self, cmd, NOT_READY, MEDIUM_NOT_PRESENT);
         return FALSE;
     }
 
@@ -1592,8 +1939,8 @@ static gboolean command_read_subchannel (CdemuDevice *self, const guint8 *raw_cd
         switch (cdb->param_list) {
             case 0x01: {
                 /* Current position */
-                struct READ_SUBCHANNEL_Data1 *ret_data = (struct READ_SUBCHANNEL_Data1 *)(self->priv->buffer+self->priv->buffer_size);
-                self->priv->buffer_size += sizeof(struct READ_SUBCHANNEL_Data1);
+                struct READ_SUBCHANNEL_Data1 *ret_data = (struct READ_SUBCHANNEL_Data1 *)(cmd->buffer+cmd->buffer_size);
+                cmd->buffer_size += sizeof(struct READ_SUBCHANNEL_Data1);
 
                 gint current_address = self->priv->current_address;
 
@@ -1658,36 +2005,27 @@ static gboolean command_read_subchannel (CdemuDevice *self, const guint8 *raw_cd
             }
             case 0x02: {
                 /* MCN */
-                struct READ_SUBCHANNEL_Data2 *ret_data = (struct READ_SUBCHANNEL_Data2 *)(self->priv->buffer+self->priv->buffer_size);
-                self->priv->buffer_size += sizeof(struct READ_SUBCHANNEL_Data2);
+                struct READ_SUBCHANNEL_Data2 *ret_data = (struct READ_SUBCHANNEL_Data2 *)(cmd->buffer+cmd->buffer_size);
+                cmd->buffer_size += sizeof(struct READ_SUBCHANNEL_Data2);
 
                 CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: MCN/UPC/EAN\n", __debug__);
                 ret_data->fmt_code = 0x02;
 
-                /* Go over first 100 sectors; if MCN is present, it should be there */
-                for (gint sector = 0; sector < 100; sector++) {
-                    guint8 tmp_buf[16];
-
-                    if (read_sector_data(NULL, disc, sector, 0x00 /* MSCB: empty */, 0x02 /* Subchannel: Q */, tmp_buf, NULL) != 16) {
-                        CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to read subchannel of sector 0x%X!\n", __debug__, sector);
-                        continue;
-                    }
-
-                    if ((tmp_buf[0] & 0x0F) == 0x02) {
-                        /* Mode-2 Q found */
-                        mirage_helper_subchannel_q_decode_mcn(&tmp_buf[1], (gchar *)ret_data->mcn);
-                        ret_data->mcval = 1;
-                        CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: found MCN in subchannel of sector 0x%X: <%.13s>\n", __debug__, sector, ret_data->mcn);
-                        break;
-                    }
+                /* Mode-2 Q from the first 100 sectors (pre-scanned, or
+                   scanned now) */
+                const guint8 *tmp_buf = cdemu_device_metadata_get_mcn(self);
+                if (tmp_buf) {
+                    mirage_helper_subchannel_q_decode_mcn(&tmp_buf[1], (gchar *)ret_data->mcn);
+                    ret_data->mcval = 1;
+                    CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: MCN: <%.13s>\n", __debug__, ret_data->mcn);
                 }
 
                 break;
             }
             case 0x03: {
                 /* ISRC */
-                struct READ_SUBCHANNEL_Data3 *ret_data = (struct READ_SUBCHANNEL_Data3 *)(self->priv->buffer+self->priv->buffer_size);
-                self->priv->buffer_size += sizeof(struct READ_SUBCHANNEL_Data3);
+                struct READ_SUBCHANNEL_Data3 *ret_data = (struct READ_SUBCHANNEL_Data3 *)(cmd->buffer+cmd->buffer_size);
+                cmd->buffer_size += sizeof(struct READ_SUBCHANNEL_Data3);
 
                 CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: ISRC\n", __debug__);
                 ret_data->fmt_code = 0x03;
@@ -1695,42 +2033,22 @@ static gboolean command_read_subchannel (CdemuDevice *self, const guint8 *raw_cd
                 MirageTrack *track = mirage_disc_get_track_by_number(disc, cdb->track, NULL);
                 if (!track) {
                     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: failed to get track %i!\n", __debug__, cdb->track);
-                    cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+                    cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
                     return FALSE;
                 }
 
-                /* Go over first 100 sectors; if ISRC is present, it should be there */
-                for (gint address = 0; address < 100; address++) {
-                    guint8 tmp_buf[16];
-                    MirageSector *sector;
-
-                    /* Get sector */
-                    sector = mirage_track_get_sector(track, address, FALSE, NULL);
-                    if (!sector) {
-                        CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: failed to get sector 0x%X\n", __debug__, address);
-                        continue;
-                    }
-
-                    /* Read sector */
-                    if (read_sector_data(sector, NULL, 0, 0x00 /* MCSB: empty*/, 0x02 /* Subchannel: Q */, tmp_buf, NULL) != 16) {
-                        CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: failed to read subchannel of sector 0x%X\n", __debug__, address);
-                        continue;
-                    }
-
-                    g_object_unref(sector);
-
-                    if ((tmp_buf[0] & 0x0F) == 0x03) {
-                        /* Mode-3 Q found */
-                        /* Copy ADR/CTL and track number */
-                        ret_data->adr = tmp_buf[0] & 0x0F;
-                        ret_data->ctl = (tmp_buf[0] & 0xF0) >> 4;
-                        ret_data->track = tmp_buf[1];
-                        /* Copy ISRC */
-                        mirage_helper_subchannel_q_decode_isrc(&tmp_buf[1], (gchar *)ret_data->isrc);
-                        ret_data->tcval = 1;
-                        CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: found ISRC in subchannel of sector 0x%X: <%.12s>\n", __debug__, address, ret_data->isrc);
-                        break;
-                    }
+                /* Mode-3 Q from the first 100 sectors of track (pre-scanned,
+                   or scanned now) */
+                const guint8 *tmp_buf = cdemu_device_metadata_get_isrc(self, track);
+                if (tmp_buf) {
+                    /* Copy ADR/CTL and track number */
+                    ret_data->adr = tmp_buf[0] & 0x0F;
+                    ret_data->ctl = (tmp_buf[0] & 0xF0) >> 4;
+                    ret_data->track = tmp_buf[1];
+                    /* Copy ISRC */
+                    mirage_helper_subchannel_q_decode_isrc(&tmp_buf[1], (gchar *)ret_data->isrc);
+                    ret_data->tcval = 1;
+                    CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: ISRC: <%.12s>\n", __debug__, ret_data->isrc);
                 }
 
                 g_object_unref(track);
@@ -1746,29 +2064,29 @@ static gboolean command_read_subchannel (CdemuDevice *self, const guint8 *raw_cd
 
     /* Header */
     ret_header->audio_status = cdemu_audio_get_status(CDEMU_AUDIO(self->priv->audio_play)); /* Audio status */
-    ret_header->length = GUINT32_TO_BE(self->priv->buffer_size - 4);
+    ret_header->length = GUINT32_TO_BE(cmd->buffer_size - 4);
 
     /* Write data */
-    cdemu_device_write_buffer(self, GUINT16_FROM_BE(cdb->length));
+    cdemu_device_write_buffer(self, cmd, GUINT16_FROM_BE(cdb->length));
 
     return TRUE;
 }
 
 /* READ TOC/PMA/ATIP*/
-static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_read_toc_pma_atip (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct READ_TOC_PMA_ATIP_CDB *cdb = (struct READ_TOC_PMA_ATIP_CDB *)raw_cdb;
+    struct READ_TOC_PMA_ATIP_CDB *cdb = (struct READ_TOC_PMA_ATIP_CDB *)cmd->cdb;
 
     if (!self->priv->loaded) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: medium not present\n", __debug__);
-        cdemu_device_write_sense(self, NOT_READY, MEDIUM_NOT_PRESENT);
+        cdemu_device_write_sense(self, cmd, NOT_READY, MEDIUM_NOT_PRESENT);
         return FALSE;
     }
 
     /* MMC: No fabrication for DVD media is defined for forms other than 000b and 001b. */
     if ((self->priv->current_profile == PROFILE_DVDROM) && !((cdb->format == 0x00) || (cdb->format == 0x01))) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: invalid format type (0x%X) for DVD-ROM image!\n", __debug__, cdb->format);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
         return FALSE;
     }
 
@@ -1792,9 +2110,9 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
         case 0x00: {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: formatted TOC\n", __debug__);
             /* Formatted TOC */
-            struct READ_TOC_PMA_ATIP_0_Header *ret_header = (struct READ_TOC_PMA_ATIP_0_Header *)self->priv->buffer;
-            self->priv->buffer_size = sizeof(struct READ_TOC_PMA_ATIP_0_Header);
-            struct READ_TOC_PMA_ATIP_0_Descriptor *ret_desc = (struct READ_TOC_PMA_ATIP_0_Descriptor *)(self->priv->buffer+self->priv->buffer_size);
+            struct READ_TOC_PMA_ATIP_0_Header *ret_header = (struct READ_TOC_PMA_ATIP_0_Header *)cmd->buffer;
+            cmd->buffer_size = sizeof(struct READ_TOC_PMA_ATIP_0_Header);
+            struct READ_TOC_PMA_ATIP_0_Descriptor *ret_desc = (struct READ_TOC_PMA_ATIP_0_Descriptor *)(cmd->buffer+cmd->buffer_size);
 
             MirageTrack *cur_track;
 
@@ -1810,7 +2128,7 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
                 cur_track = mirage_disc_get_track_by_index(disc, -1, NULL);
                 if (!cur_track) {
                     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: no track found on disc!\n", __debug__);
-                    cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+                    cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
                     return FALSE;
                 }
 
@@ -1818,7 +2136,7 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
                 g_object_unref(cur_track);
                 if (cdb->number > num_tracks) {
                     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: starting track number (%i) exceeds last track number (%i)!\n", __debug__, cdb->number, num_tracks);
-                    cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+                    cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
                     return FALSE;
                 }
 
@@ -1852,7 +2170,7 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
                             ret_desc->lba = GUINT32_TO_BE(start_sector);
                         }
 
-                        self->priv->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_0_Descriptor);
+                        cmd->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_0_Descriptor);
                         ret_desc++;    /* next descriptor */
                     }
 
@@ -1864,7 +2182,7 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
             MirageSession *lsession = mirage_disc_get_session_by_index(disc, -1, NULL);
             if (!lsession) {
                 CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: no session found on disc!\n", __debug__);
-                cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+                cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
                 return FALSE;
             }
 
@@ -1886,7 +2204,7 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
             } else {
                 ret_desc->lba = GUINT32_TO_BE(start_sector);
             }
-            self->priv->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_0_Descriptor);
+            cmd->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_0_Descriptor);
 
             g_object_unref(cur_track);
 
@@ -1898,7 +2216,7 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
             g_object_unref(cur_track);
             g_object_unref(lsession);
 
-            ret_header->length = GUINT16_TO_BE(self->priv->buffer_size - 2);
+            ret_header->length = GUINT16_TO_BE(cmd->buffer_size - 2);
             ret_header->ftrack = 0x01;
             ret_header->ltrack = ltrack;
 
@@ -1907,8 +2225,8 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
         case 0x01: {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: multisession information\n", __debug__);
             /* Multi-session info */
-            struct READ_TOC_PMA_ATIP_1_Data *ret_data = (struct READ_TOC_PMA_ATIP_1_Data *)self->priv->buffer;
-            self->priv->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_1_Data);
+            struct READ_TOC_PMA_ATIP_1_Data *ret_data = (struct READ_TOC_PMA_ATIP_1_Data *)cmd->buffer;
+            cmd->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_1_Data);
 
             MirageSession *lsession;
             MirageTrack *ftrack;
@@ -1916,12 +2234,12 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
             lsession = mirage_disc_get_session_by_index(disc, -1, NULL);
             if (!lsession) {
                 CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: no session found on disc!\n", __debug__);
-                cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+                cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
                 return FALSE;
             }
 
             /* Header */
-            ret_data->length = GUINT16_TO_BE(self->priv->buffer_size - 2);
+            ret_data->length = GUINT16_TO_BE(cmd->buffer_size - 2);
             ret_data->fsession = 0x01;
             ret_data->lsession = mirage_session_layout_get_session_number(lsession);
 
@@ -1953,9 +2271,9 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
         case 0x02: {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: raw TOC\n", __debug__);
             /* Raw TOC */
-            struct READ_TOC_PMA_ATIP_2_Header *ret_header = (struct READ_TOC_PMA_ATIP_2_Header *)self->priv->buffer;
-            self->priv->buffer_size = sizeof(struct READ_TOC_PMA_ATIP_2_Header);
-            struct READ_TOC_PMA_ATIP_2_Descriptor *ret_desc = (struct READ_TOC_PMA_ATIP_2_Descriptor *)(self->priv->buffer+self->priv->buffer_size);
+            struct READ_TOC_PMA_ATIP_2_Header *ret_header = (struct READ_TOC_PMA_ATIP_2_Header *)cmd->buffer;
+            cmd->buffer_size = sizeof(struct READ_TOC_PMA_ATIP_2_Header);
+            struct READ_TOC_PMA_ATIP_2_Descriptor *ret_desc = (struct READ_TOC_PMA_ATIP_2_Descriptor *)(cmd->buffer+cmd->buffer_size);
 
             /* For each session with number above the requested one... */
             gint num_sessions = mirage_disc_get_number_of_sessions(disc);
@@ -1984,7 +2302,7 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
                     ret_desc->pmin = mirage_track_layout_get_track_number(cur_track);
                     ret_desc->psec = map_session_type(mirage_session_get_session_type(cur_session));
 
-                    self->priv->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_2_Descriptor);
+                    cmd->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_2_Descriptor);
                     ret_desc++;
 
                     g_object_unref(cur_track);
@@ -1998,7 +2316,7 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
                     ret_desc->point = 0xA1;
                     ret_desc->pmin = mirage_track_layout_get_track_number(cur_track);
 
-                    self->priv->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_2_Descriptor);
+                    cmd->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_2_Descriptor);
                     ret_desc++;
 
                     g_object_unref(cur_track);
@@ -2017,7 +2335,7 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
 
                     mirage_helper_lba2msf(leadout_start, TRUE, &ret_desc->pmin, &ret_desc->psec, &ret_desc->pframe);
 
-                    self->priv->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_2_Descriptor);
+                    cmd->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_2_Descriptor);
                     ret_desc++;
 
                     g_object_unref(cur_track);
@@ -2044,7 +2362,7 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
 
                         mirage_helper_lba2msf(cur_start, TRUE, &ret_desc->pmin, &ret_desc->psec, &ret_desc->pframe);
 
-                        self->priv->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_2_Descriptor);
+                        cmd->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_2_Descriptor);
                         ret_desc++;
 
                         g_object_unref(cur_track);
@@ -2086,7 +2404,7 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
                         ret_desc->psec = 0x3B;
                         ret_desc->pframe = 0x47;
 
-                        self->priv->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_2_Descriptor);
+                        cmd->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_2_Descriptor);
                         ret_desc++;
 
                         /* Add up C0 for session 1 */
@@ -2109,7 +2427,7 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
                             ret_desc->psec = 0x00;
                             ret_desc->pframe = 0x00;
 
-                            self->priv->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_2_Descriptor);
+                            cmd->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_2_Descriptor);
                             ret_desc++;
                         }
                     }
@@ -2124,11 +2442,11 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
             MirageSession *lsession = mirage_disc_get_session_by_index(disc, -1, NULL);
             if (!lsession) {
                 CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: no session found on disc!\n", __debug__);
-                cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+                cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
                 return FALSE;
             }
 
-            ret_header->length = GUINT16_TO_BE(self->priv->buffer_size - 2);
+            ret_header->length = GUINT16_TO_BE(cmd->buffer_size - 2);
             ret_header->fsession = 0x01;
             ret_header->lsession = mirage_session_layout_get_session_number(lsession);
 
@@ -2139,13 +2457,13 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
         case 0x04: {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: ATIP\n", __debug__);
             /* ATIP */
-            struct READ_TOC_PMA_ATIP_4_Header *ret_header = (struct READ_TOC_PMA_ATIP_4_Header *)self->priv->buffer;
-            self->priv->buffer_size = sizeof(struct READ_TOC_PMA_ATIP_4_Header);
+            struct READ_TOC_PMA_ATIP_4_Header *ret_header = (struct READ_TOC_PMA_ATIP_4_Header *)cmd->buffer;
+            cmd->buffer_size = sizeof(struct READ_TOC_PMA_ATIP_4_Header);
 
             /* ATIP data is available only for recordable/rewritable media */
             if (self->priv->recordable_disc) {
-                struct READ_TOC_PMA_ATIP_4_Descriptor *ret_descriptor = (struct READ_TOC_PMA_ATIP_4_Descriptor *)(self->priv->buffer + sizeof(struct READ_TOC_PMA_ATIP_4_Header));
-                self->priv->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_4_Descriptor);
+                struct READ_TOC_PMA_ATIP_4_Descriptor *ret_descriptor = (struct READ_TOC_PMA_ATIP_4_Descriptor *)(cmd->buffer + sizeof(struct READ_TOC_PMA_ATIP_4_Header));
+                cmd->buffer_size += sizeof(struct READ_TOC_PMA_ATIP_4_Descriptor);
 
                 ret_descriptor->one1 = 1;
                 ret_descriptor->itwp = 0x4; /* Copied from real CD-R */
@@ -2165,15 +2483,15 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
             }
 
             /* Header */
-            ret_header->length = GUINT16_TO_BE(self->priv->buffer_size - 2);
+            ret_header->length = GUINT16_TO_BE(cmd->buffer_size - 2);
 
             break;
         }
         case 0x05: {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: CD-Text\n", __debug__);
             /* CD-TEXT */
-            struct READ_TOC_PMA_ATIP_5_Header *ret_header = (struct READ_TOC_PMA_ATIP_5_Header *)self->priv->buffer;
-            self->priv->buffer_size = sizeof(struct READ_TOC_PMA_ATIP_5_Header);
+            struct READ_TOC_PMA_ATIP_5_Header *ret_header = (struct READ_TOC_PMA_ATIP_5_Header *)cmd->buffer;
+            cmd->buffer_size = sizeof(struct READ_TOC_PMA_ATIP_5_Header);
 
             guint8 *tmp_data = NULL;
             gint tmp_len  = 0;
@@ -2183,7 +2501,7 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
             session = mirage_disc_get_session_by_index(self->priv->disc, 0, NULL);
             if (!session) {
                 CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: no session found on disc!\n", __debug__);
-                cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+                cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
                 return FALSE;
             }
 
@@ -2194,34 +2512,34 @@ static gboolean command_read_toc_pma_atip (CdemuDevice *self, const guint8 *raw_
 
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: length of CD-TEXT data: 0x%X\n", __debug__, tmp_len);
 
-            memcpy(self->priv->buffer+sizeof(struct READ_TOC_PMA_ATIP_5_Header), tmp_data, tmp_len);
+            memcpy(cmd->buffer+sizeof(struct READ_TOC_PMA_ATIP_5_Header), tmp_data, tmp_len);
             g_free(tmp_data);
-            self->priv->buffer_size += tmp_len;
+            cmd->buffer_size += tmp_len;
 
             /* Header */
-            ret_header->length = GUINT16_TO_BE(self->priv->buffer_size - 2);
+            ret_header->length = GUINT16_TO_BE(cmd->buffer_size - 2);
 
             break;
         }
         default: {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: format %X not supported yet\n", __debug__, cdb->format);
-            cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+            cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
             return FALSE;
         }
     }
 
     /* Write data */
-    cdemu_device_write_buffer(self, GUINT16_FROM_BE(cdb->length));
+    cdemu_device_write_buffer(self, cmd, GUINT16_FROM_BE(cdb->length));
 
     return TRUE;
 }
 
 /* READ TRACK INFORMATION*/
-static gboolean command_read_track_information (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_read_track_information (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct READ_TRACK_INFORMATION_CDB *cdb = (struct READ_TRACK_INFORMATION_CDB *)raw_cdb;
-    struct READ_TRACK_INFORMATION_Data *ret_data = (struct READ_TRACK_INFORMATION_Data *)self->priv->buffer;
-    self->priv->buffer_size = sizeof(struct READ_TRACK_INFORMATION_Data);
+    struct READ_TRACK_INFORMATION_CDB *cdb = (struct READ_TRACK_INFORMATION_CDB *)cmd->cdb;
+    struct READ_TRACK_INFORMATION_Data *ret_data = (struct READ_TRACK_INFORMATION_Data *)cmd->buffer;
+    cmd->buffer_size = sizeof(struct READ_TRACK_INFORMATION_Data);
 
     MirageDisc *disc = self->priv->disc;
     MirageTrack *track = NULL;
@@ -2231,7 +2549,7 @@ static gboolean command_read_track_information (CdemuDevice *self, const guint8
 
     if (!self->priv->loaded) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: medium not present\n", __debug__);
-        cdemu_device_write_sense(self, NOT_READY, MEDIUM_NOT_PRESENT);
+        cdemu_device_write_sense(self, cmd, NOT_READY, MEDIUM_NOT_PRESENT);
         return FALSE;
     }
 
@@ -2356,12 +2674,12 @@ static gboolean command_read_track_information (CdemuDevice *self, const guint8
         start_sector = self->priv->medium_leadin;
     } else {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: couldn't find track!\n", __debug__);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
         return FALSE;
     }
 
     /* Write the obtained data */
-    ret_data->length = GUINT16_TO_BE(self->priv->buffer_size - 2);
+    ret_data->length = GUINT16_TO_BE(cmd->buffer_size - 2);
     ret_data->track_number0 = track_number >> 8;
     ret_data->session_number0 = session_number >> 8;
 
@@ -2383,20 +2701,20 @@ static gboolean command_read_track_information (CdemuDevice *self, const guint8
     ret_data->session_number1 = session_number & 0xFF;
 
     /* Write data */
-    cdemu_device_write_buffer(self, GUINT16_FROM_BE(cdb->length));
+    cdemu_device_write_buffer(self, cmd, GUINT16_FROM_BE(cdb->length));
 
     return TRUE;
 }
 
 /* REPORT KEY*/
-static gboolean command_report_key (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_report_key (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct REPORT_KEY_CDB *cdb = (struct REPORT_KEY_CDB *)raw_cdb;
+    struct REPORT_KEY_CDB *cdb = (struct REPORT_KEY_CDB *)cmd->cdb;
 
     if (cdb->key_format == 0x08) {
         /* RPC */
-        struct REPORT_KEY_8_Data *data = (struct REPORT_KEY_8_Data *)self->priv->buffer;
-        self->priv->buffer_size = sizeof(struct REPORT_KEY_8_Data);
+        struct REPORT_KEY_8_Data *data = (struct REPORT_KEY_8_Data *)cmd->buffer;
+        cmd->buffer_size = sizeof(struct REPORT_KEY_8_Data);
 
         data->type_code = 0; /* No region setting */
         data->vendor_resets = 4;
@@ -2404,32 +2722,32 @@ static gboolean command_report_key (CdemuDevice *self, const guint8 *raw_cdb)
         data->region_mask = 0xFF; /* It's what all my drives return... */
         data->rpc_scheme = 1; /* It's what all my drives return... */
 
-        data->length = GUINT16_TO_BE(self->priv->buffer_size - 2);
+        data->length = GUINT16_TO_BE(cmd->buffer_size - 2);
     } else {
         if (self->priv->current_profile != PROFILE_DVDROM) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: not supported with non-DVD media!\n", __debug__);
-            cdemu_device_write_sense(self, ILLEGAL_REQUEST, CANNOT_READ_MEDIUM_INCOMPATIBLE_FORMAT);
+            cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, CANNOT_READ_MEDIUM_INCOMPATIBLE_FORMAT);
             return FALSE;
         }
 
         /* We don't support these yet */
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: FIXME: not implemented yet!\n", __debug__);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB);
         return FALSE;
     }
 
     /* Write data */
-    cdemu_device_write_buffer(self, GUINT16_FROM_BE(cdb->length));
+    cdemu_device_write_buffer(self, cmd, GUINT16_FROM_BE(cdb->length));
 
     return TRUE;
 }
 
 /* REQUEST SENSE*/
-static gboolean command_request_sense (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_request_sense (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct REQUEST_SENSE_CDB *cdb = (struct REQUEST_SENSE_CDB *)raw_cdb;
-    struct REQUEST_SENSE_SenseFixed *sense = (struct REQUEST_SENSE_SenseFixed *)self->priv->buffer;
-    self->priv->buffer_size = sizeof(struct REQUEST_SENSE_SenseFixed);
+    struct REQUEST_SENSE_CDB *cdb = (struct REQUEST_SENSE_CDB *)cmd->cdb;
+    struct REQUEST_SENSE_SenseFixed *sense = (struct REQUEST_SENSE_SenseFixed *)cmd->buffer;
+    cmd->buffer_size = sizeof(struct REQUEST_SENSE_SenseFixed);
 
     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: returning sense data\n", __debug__);
 
@@ -2449,15 +2767,15 @@ static gboolean command_request_sense (CdemuDevice *self, const guint8 *raw_cdb)
     sense->ascq = cdemu_audio_get_status(CDEMU_AUDIO(self->priv->audio_play));
 
     /* Write data */
-    cdemu_device_write_buffer(self, cdb->length);
+    cdemu_device_write_buffer(self, cmd, cdb->length);
 
     return TRUE;
 }
 
 /* RESERVE TRACK */
-static gboolean command_reserve_track (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_reserve_track (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct RESERVE_TRACK_CDB *cdb = (struct RESERVE_TRACK_CDB *)raw_cdb;
+    struct RESERVE_TRACK_CDB *cdb = (struct RESERVE_TRACK_CDB *)cmd->cdb;
     guint track_length;
 
     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: reserve track: ARSV: %d RMZ: %d\n", __debug__, cdb->arsv, cdb->rmz);
@@ -2465,14 +2783,14 @@ static gboolean command_reserve_track (CdemuDevice *self, const guint8 *raw_cdb)
     /* Make sure we have recording mode set */
     if (!self->priv->recording) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: RESERVE TRACK called without recording mode set\n", __debug__);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
         return FALSE;
     }
 
     /* Make sure set recording mode implements reserve track */
     if (!self->priv->recording->reserve_track) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: RESERVE TRACK called in recoding mode that does not implement it (yet?)\n", __debug__);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
         return FALSE;
     }
 
@@ -2497,37 +2815,37 @@ static gboolean command_reserve_track (CdemuDevice *self, const guint8 *raw_cdb)
 
 
 /* SEEK (10)*/
-static gboolean command_seek (CdemuDevice *self, const guint8 *raw_cdb G_GNUC_UNUSED)
+static gboolean command_seek (CdemuDevice *self, CdemuCommand *cmd G_GNUC_UNUSED)
 {
-    /*struct SET_CD_SPEED_CDB *cdb = (struct SET_CD_SPEED_CDB *)raw_cdb;*/
+    /*struct SET_CD_SPEED_CDB *cdb = (struct SET_CD_SPEED_CDB *)cmd->cdb;*/
     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: nothing to do here yet...\n", __debug__);
     return TRUE;
 }
 
 /* SEND CUE SHEET */
-static gboolean command_send_cue_sheet (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_send_cue_sheet (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct SEND_CUE_SHEET_CDB *cdb = (struct SEND_CUE_SHEET_CDB *)raw_cdb;
+    struct SEND_CUE_SHEET_CDB *cdb = (struct SEND_CUE_SHEET_CDB *)cmd->cdb;
     struct ModePage_0x05 *p_0x05 = cdemu_device_get_mode_page(self, 0x05, MODE_PAGE_CURRENT);
     gint cue_sheet_size = GUINT24_FROM_BE(cdb->cue_sheet_size);
 
     /* Verify that we are in SAO/DAO mode */
     if (p_0x05->write_type != 2) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: CUE sheet sent when write type is not set to Session-at-Once!\n", __debug__);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
         return FALSE;
     }
 
     /* Read CUE sheet */
     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: reading CUE sheet (%d bytes)\n", __debug__, cue_sheet_size);
-    cdemu_device_read_buffer(self, cue_sheet_size);
+    cdemu_device_read_buffer(self, cmd, cue_sheet_size);
 
     /* Dump CUE sheet */
     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: received CUE sheet:\n", __debug__);
-    CDEMU_DEBUG_PRINT_BUFFER(self, DAEMON_DEBUG_MMC, __debug__, 8, self->priv->buffer, cue_sheet_size);
+    CDEMU_DEBUG_PRINT_BUFFER(self, DAEMON_DEBUG_MMC, __debug__, 8, cmd->buffer, cue_sheet_size);
 
     /* Parse CUE sheet */
-    if (!cdemu_device_sao_recording_parse_cue_sheet(self, self->priv->buffer, cue_sheet_size)) {
+    if (!cdemu_device_sao_recording_parse_cue_sheet(self, cmd->buffer, cue_sheet_size)) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: failed to parse CUE sheet!\n", __debug__);
         return FALSE;
     }
@@ -2538,9 +2856,9 @@ static gboolean command_send_cue_sheet (CdemuDevice *self, const guint8 *raw_cdb
 }
 
 /* SET CD SPEED*/
-static gboolean command_set_cd_speed (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_set_cd_speed (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct SET_CD_SPEED_CDB *cdb = (struct SET_CD_SPEED_CDB *)raw_cdb;
+    struct SET_CD_SPEED_CDB *cdb = (struct SET_CD_SPEED_CDB *)cmd->cdb;
     struct ModePage_0x2A *p_0x2A = cdemu_device_get_mode_page(self, 0x2A, MODE_PAGE_CURRENT);
 
     /* Set the value to mode page and do nothing else at the moment...
@@ -2567,26 +2885,26 @@ static gboolean command_set_cd_speed (CdemuDevice *self, const guint8 *raw_cdb)
 }
 
 /* SET STREAMING */
-static gboolean command_set_streaming (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_set_streaming (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct SET_STREAMING_CDB *cdb = (struct SET_STREAMING_CDB *)raw_cdb;
+    struct SET_STREAMING_CDB *cdb = (struct SET_STREAMING_CDB *)cmd->cdb;
     guint16 length = GUINT16_FROM_BE(cdb->length);
 
     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: performance descriptor type %d, length: %d\n", __debug__, cdb->type, length);
 
     /* Read descriptors */
-    cdemu_device_read_buffer(self, length);
+    cdemu_device_read_buffer(self, cmd, length);
 
     /* Dump descriptors */
-    CDEMU_DEBUG_PRINT_BUFFER(self, DAEMON_DEBUG_MMC, __debug__, 16, self->priv->buffer, length);
+    CDEMU_DEBUG_PRINT_BUFFER(self, DAEMON_DEBUG_MMC, __debug__, 16, cmd->buffer, length);
 
     return TRUE;
 }
 
 /* START/STOP UNIT */
-static gboolean command_start_stop_unit (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_start_stop_unit (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct START_STOP_UNIT_CDB *cdb = (struct START_STOP_UNIT_CDB *)raw_cdb;
+    struct START_STOP_UNIT_CDB *cdb = (struct START_STOP_UNIT_CDB *)cmd->cdb;
 
     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: lo_ej: %d; start: %d\n", __debug__, cdb->lo_ej, cdb->start);
 
@@ -2596,7 +2914,7 @@ static gboolean command_start_stop_unit (CdemuDevice *self, const guint8 *raw_cd
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: unloading disc...\n", __debug__);
             if (!cdemu_device_unload_disc_private(self, NULL)) {
                 CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: failed to unload disc\n", __debug__);
-                cdemu_device_write_sense(self, NOT_READY, MEDIUM_REMOVAL_PREVENTED);
+                cdemu_device_write_sense(self, cmd, NOT_READY, MEDIUM_REMOVAL_PREVENTED);
                 return FALSE;
             } else {
                 CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: successfully unloaded disc\n", __debug__);
@@ -2608,9 +2926,9 @@ static gboolean command_start_stop_unit (CdemuDevice *self, const guint8 *raw_cd
 }
 
 /* SYNCHRONIZE CACHE */
-static gboolean command_synchronize_cache (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_synchronize_cache (CdemuDevice *self, CdemuCommand *cmd)
 {
-    struct SYNCHRONIZE_CACHE_CDB *cdb = (struct SYNCHRONIZE_CACHE_CDB *)raw_cdb;
+    struct SYNCHRONIZE_CACHE_CDB *cdb = (struct SYNCHRONIZE_CACHE_CDB *)cmd->cdb;
     guint32 lba = GUINT32_FROM_BE(cdb->lba);
     guint16 blocks = GUINT16_FROM_BE(cdb->blocks);
 
@@ -2619,7 +2937,7 @@ static gboolean command_synchronize_cache (CdemuDevice *self, const guint8 *raw_
     /* Use recording structure */
     if (!self->priv->recording) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: no recording mode set!\n", __debug__);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
         return FALSE;
     }
 
@@ -2628,24 +2946,25 @@ static gboolean command_synchronize_cache (CdemuDevice *self, const guint8 *raw_
 
 
 /* TEST UNIT READY*/
-static gboolean command_test_unit_ready (CdemuDevice *self, const guint8 *raw_cdb G_GNUC_UNUSED)
+static gboolean command_test_unit_ready (CdemuDevice *self, CdemuCommand *cmd)
 {
-    /*struct TEST_UNIT_READY_CDB *cdb = (struct TEST_UNIT_READY_CDB *)raw_cdb;*/
+    /*struct TEST_UNIT_READY_CDB *cdb = (struct TEST_UNIT_READY_CDB *)cmd->cdb;*/
 
     /* Check if we have medium loaded */
     if (!self->priv->loaded) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: medium not present\n", __debug__);
-        cdemu_device_write_sense(self, NOT_READY, MEDIUM_NOT_PRESENT);
+        cdemu_device_write_sense(self, cmd, NOT_READY, MEDIUM_NOT_PRESENT);
         return FALSE;
     }
 
     /* SCSI requires us to report UNIT ATTENTION with NOT READY TO READY CHANGE,
        MEDIUM MAY HAVE CHANGED whenever medium changes... this is required for
-       linux SCSI layer to set medium block size properly upon disc insertion */
-    if (self->priv->media_event == MEDIA_EVENT_NEW_MEDIA) {
+       linux SCSI layer to set medium block size properly upon disc insertion.
+       As this command is executed without device mutex, the event is
+       consumed atomically */
+    if (g_atomic_int_compare_and_exchange(&self->priv->media_event, MEDIA_EVENT_NEW_MEDIA, MEDIA_EVENT_NOCHANGE)) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: reporting media changed\n", __debug__);
-        self->priv->media_event = MEDIA_EVENT_NOCHANGE;
-        cdemu_device_write_sense(self, UNIT_ATTENTION, NOT_READY_TO_READY_CHANGE_MEDIUM_MAY_HAVE_CHANGED);
+        cdemu_device_write_sense(self, cmd, UNIT_ATTENTION, NOT_READY_TO_READY_CHANGE_MEDIUM_MAY_HAVE_CHANGED);
         return FALSE;
     }
 
@@ -2653,33 +2972,37 @@ static gboolean command_test_unit_ready (CdemuDevice *self, const guint8 *raw_cd
 }
 
 /* WRITE (10) */
-static gboolean command_write (CdemuDevice *self, const guint8 *raw_cdb)
+static gboolean command_write (CdemuDevice *self, CdemuCommand *cmd)
 {
     gint start_address; /* MUST be signed because it may be negative! */
     gint num_sectors;
     gboolean succeeded = TRUE;
 
     /* WRITE 10 vs WRITE 12 */
-    if (raw_cdb[0] == WRITE_10) {
-        struct WRITE_10_CDB *cdb = (struct WRITE_10_CDB *)raw_cdb;
+    if (cmd->cdb[0] == WRITE_10) {
+        struct WRITE_10_CDB *cdb = (struct WRITE_10_CDB *)cmd->cdb;
         start_address = GUINT32_FROM_BE(cdb->lba);
         num_sectors  = GUINT16_FROM_BE(cdb->length);
     } else {
-        struct WRITE_12_CDB *cdb = (struct WRITE_12_CDB *)raw_cdb;
+        struct WRITE_12_CDB *cdb = (struct WRITE_12_CDB *)cmd->cdb;
         start_address = GUINT32_FROM_BE(cdb->lba);
         num_sectors  = GUINT32_FROM_BE(cdb->length);
     }
 
     /* Write */
     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: write request: start sector: 0x%X (%d), number of sectors: %d\n", __debug__, start_address, start_address, num_sectors);
+    cmd->num_sectors = num_sectors;
 
     if (!self->priv->recording) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: no recording mode set!\n", __debug__);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
         return FALSE;
     }
 
-    succeeded = self->priv->recording->write_sectors(self, start_address, num_sectors);
+    succeeded = self->priv->recording->write_sectors(self, cmd, start_address, num_sectors);
+
+    /* Commit layout of the track that sectors were appended to */
+    cdemu_device_recording_commit_layout(self);
 
     return succeeded;
 }
@@ -2688,175 +3011,307 @@ static gboolean command_write (CdemuDevice *self, const guint8 *raw_cdb)
 /**********************************************************************\
  *                      Packet command switch                         *
 \**********************************************************************/
-gint cdemu_device_execute_command (CdemuDevice *self, const guint8 *cdb)
+/* Locking required by packet commands; see cdemu_device_execute_command() */
+typedef enum
+{
+    COMMAND_EXCLUSIVE,
+    COMMAND_SHARED,
+    COMMAND_CONCURRENT,
+} CommandLocking;
+
+/* Memoization of responses; see cdemu_device_execute_command() */
+typedef enum
+{
+    MEMOIZE_NEVER,
+    MEMOIZE_RESPONSE,
+    MEMOIZE_INVALIDATE,
+} CommandMemoization;
+
+/* Packet command table */
+static const struct {
+    PacketCommand cmd;
+    gchar *debug_name;
+    gboolean (*implementation)(CdemuDevice *, CdemuCommand *);
+    gboolean interrupt_audio_play;
+    CommandLocking locking;
+    CommandMemoization memoization;
+} packet_commands[] = {
+    { CLOSE_TRACK_SESSION,
+      "CLOSE TRACK/SESSION",
+      command_close_track_session,
+      TRUE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_INVALIDATE },
+    { GET_EVENT_STATUS_NOTIFICATION,
+      "GET EVENT/STATUS NOTIFICATION",
+      command_get_event_status_notification,
+      FALSE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_NEVER },
+    { GET_CONFIGURATION,
+      "GET CONFIGURATION",
+      command_get_configuration,
+      FALSE,
+      COMMAND_CONCURRENT,
+      MEMOIZE_RESPONSE },
+    { GET_PERFORMANCE,
+      "GET PERFORMANCE",
+      command_get_performance,
+      FALSE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_NEVER },
+    { INQUIRY,
+      "INQUIRY",
+      command_inquiry,
+      FALSE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_NEVER },
+    { MODE_SELECT_6,
+      "MODE SELECT (6)",
+      command_mode_select,
+      FALSE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_INVALIDATE },
+    { MODE_SELECT_10,
+      "MODE SELECT (10)",
+      command_mode_select,
+      FALSE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_INVALIDATE },
+    { MODE_SENSE_6,
+      "MODE SENSE (6)",
+      command_mode_sense,
+      FALSE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_RESPONSE },
+    { MODE_SENSE_10,
+      "MODE SENSE (10)",
+      command_mode_sense,
+      FALSE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_RESPONSE },
+    { PAUSE_RESUME,
+      "PAUSE/RESUME",
+      command_pause_resume,
+      FALSE, /* Well, it does... but in it's own, unique way :P */
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_INVALIDATE },
+    { PLAY_AUDIO_10,
+      "PLAY AUDIO (10)",
+      command_play_audio,
+      TRUE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_INVALIDATE },
+    { PLAY_AUDIO_12,
+      "PLAY AUDIO (12)",
+      command_play_audio,
+      TRUE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_INVALIDATE },
+    { PLAY_AUDIO_MSF,
+      "PLAY AUDIO MSF",
+      command_play_audio,
+      TRUE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_INVALIDATE },
+    { PREVENT_ALLOW_MEDIUM_REMOVAL,
+      "PREVENT/ALLOW MEDIUM REMOVAL",
+      command_prevent_allow_medium_removal,
+      FALSE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_INVALIDATE },
+    { READ_10,
+      "READ (10)",
+      command_read,
+      TRUE,
+      COMMAND_SHARED,
+      MEMOIZE_NEVER },
+    { READ_12,
+      "READ (12)",
+      command_read,
+      TRUE,
+      COMMAND_SHARED,
+      MEMOIZE_NEVER },
+    { READ_BUFFER_CAPACITY,
+      "READ BUFFER CAPACITY",
+      command_read_buffer_capacity,
+      FALSE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_NEVER },
+    { READ_CAPACITY,
+      "READ CAPACITY",
+      command_read_capacity,
+      FALSE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_NEVER },
+    { READ_CD,
+      "READ CD",
+      command_read_cd,
+      FALSE,
+      COMMAND_SHARED,
+      MEMOIZE_NEVER },
+    { READ_CD_MSF,
+      "READ CD MSF",
+      command_read_cd,
+      FALSE,
+      COMMAND_SHARED,
+      MEMOIZE_NEVER },
+    { READ_DISC_INFORMATION,
+      "READ DISC INFORMATION",
+      command_read_disc_information,
+      TRUE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_RESPONSE },
+    { READ_DISC_STRUCTURE,
+      "READ DISC STRUCTURE",
+      command_read_disc_structure,
+      TRUE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_NEVER },
+    { READ_TOC_PMA_ATIP,
+      "READ TOC/PMA/ATIP",
+      command_read_toc_pma_atip,
+      FALSE,
+      COMMAND_SHARED,
+      MEMOIZE_RESPONSE },
+    { READ_TRACK_INFORMATION,
+      "READ TRACK INFORMATION",
+      command_read_track_information,
+      TRUE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_RESPONSE },
+    { READ_SUBCHANNEL,
+      "READ SUBCHANNEL",
+      command_read_subchannel,
+      FALSE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_RESPONSE },
+    { REPORT_KEY,
+      "REPORT KEY",
+      command_report_key,
+      TRUE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_NEVER },
+    { REQUEST_SENSE,
+      "REQUEST SENSE",
+      command_request_sense,
+      FALSE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_NEVER },
+    { RESERVE_TRACK,
+      "RESERVE TRACK",
+      command_reserve_track,
+      TRUE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_INVALIDATE },
+    { SEEK_10,
+      "SEEK (10)",
+      command_seek,
+      TRUE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_NEVER },
+    { SEND_CUE_SHEET,
+      "SEND CUE SHEET",
+      command_send_cue_sheet,
+      TRUE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_INVALIDATE },
+    { SET_CD_SPEED,
+      "SET CD SPEED",
+      command_set_cd_speed,
+      TRUE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_INVALIDATE },
+    { SET_STREAMING,
+      "SET STREAMING",
+      command_set_streaming,
+      TRUE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_INVALIDATE },
+    { START_STOP_UNIT,
+      "START/STOP UNIT",
+      command_start_stop_unit,
+      TRUE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_INVALIDATE },
+    { SYNCHRONIZE_CACHE,
+      "SYNCHRONIZE CACHE",
+      command_synchronize_cache,
+      FALSE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_INVALIDATE },
+    { TEST_UNIT_READY,
+      "TEST UNIT READY",
+      command_test_unit_ready,
+      FALSE,
+      COMMAND_CONCURRENT,
+      MEMOIZE_NEVER },
+    { WRITE_10,
+      "WRITE (10)",
+      command_write,
+      TRUE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_INVALIDATE },
+    { WRITE_12,
+      "WRITE (12)",
+      command_write,
+      TRUE,
+      COMMAND_EXCLUSIVE,
+      MEMOIZE_INVALIDATE },
+};
+
+/* Memoized responses are keyed by CDB, allocation length and an additional
+   command-specific state value; returns FALSE if response of this particular
+   command cannot be memoized */
+static gboolean command_get_memoization_state (CdemuDevice *self, const CdemuCommand *cmd, gint *state)
+{
+    *state = 0;
+
+    if (cmd->cdb[0] == READ_SUBCHANNEL) {
+        const struct READ_SUBCHANNEL_CDB *cdb = (const struct READ_SUBCHANNEL_CDB *)cmd->cdb;
+
+        /* Current position changes with each access and during audio play;
+           MCN and ISRC do not, but the header reports audio status */
+        if (cdb->subq && cdb->param_list == 0x01) {
+            return FALSE;
+        }
+        *state = cdemu_audio_get_status(CDEMU_AUDIO(self->priv->audio_play));
+    }
+
+    return TRUE;
+}
+
+const gchar *cdemu_device_get_command_name (guint8 opcode)
 {
+    for (guint i = 0; i < G_N_ELEMENTS(packet_commands); i++) {
+        if (packet_commands[i].cmd == opcode) {
+            return packet_commands[i].debug_name;
+        }
+    }
+
+    return NULL;
+}
+
+gint cdemu_device_execute_command (CdemuDevice *self, CdemuCommand *cmd)
+{
+    const guint8 *cdb = cmd->cdb;
     SenseStatus status = CHECK_CONDITION;
+    gint64 start_time = g_get_monotonic_time();
 
     /* Flush buffer */
-    cdemu_device_flush_buffer(self);
+    cdemu_device_flush_buffer(self, cmd);
+
+    /* Reset delay */
+    cmd->delay_amount = 0;
+
+    /* Reset metrics-related fields */
+    cmd->num_sectors = 0;
 
     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "\n");
     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X\n", __debug__,
         cdb[0], cdb[1], cdb[2], cdb[3], cdb[4], cdb[5],
         cdb[6], cdb[7], cdb[8], cdb[9], cdb[10], cdb[11]);
 
-    /* Packet command table */
-    static struct {
-        PacketCommand cmd;
-        gchar *debug_name;
-        gboolean (*implementation)(CdemuDevice *, const guint8 *);
-        gboolean interrupt_audio_play;
-    } packet_commands[] = {
-        { CLOSE_TRACK_SESSION,
-          "CLOSE TRACK/SESSION",
-          command_close_track_session,
-          TRUE },
-        { GET_EVENT_STATUS_NOTIFICATION,
-          "GET EVENT/STATUS NOTIFICATION",
-          command_get_event_status_notification,
-          FALSE },
-        { GET_CONFIGURATION,
-          "GET CONFIGURATION",
-          command_get_configuration,
-          FALSE, },
-        { GET_PERFORMANCE,
-          "GET PERFORMANCE",
-          command_get_performance,
-          FALSE, },
-        { INQUIRY,
-          "INQUIRY",
-          command_inquiry,
-          FALSE },
-        { MODE_SELECT_6,
-          "MODE SELECT (6)",
-          command_mode_select,
-          FALSE },
-        { MODE_SELECT_10,
-          "MODE SELECT (10)",
-          command_mode_select,
-          FALSE },
-        { MODE_SENSE_6,
-          "MODE SENSE (6)",
-          command_mode_sense,
-          FALSE },
-        { MODE_SENSE_10,
-          "MODE SENSE (10)",
-          command_mode_sense,
-          FALSE },
-        { PAUSE_RESUME,
-          "PAUSE/RESUME",
-          command_pause_resume,
-          FALSE /* Well, it does... but in it's own, unique way :P */ },
-        { PLAY_AUDIO_10,
-          "PLAY AUDIO (10)",
-          command_play_audio,
-          TRUE },
-        { PLAY_AUDIO_12,
-          "PLAY AUDIO (12)",
-          command_play_audio,
-          TRUE },
-        { PLAY_AUDIO_MSF,
-          "PLAY AUDIO MSF",
-          command_play_audio,
-          TRUE },
-        { PREVENT_ALLOW_MEDIUM_REMOVAL,
-          "PREVENT/ALLOW MEDIUM REMOVAL",
-          command_prevent_allow_medium_removal,
-          FALSE },
-        { READ_10,
-          "READ (10)",
-          command_read,
-          TRUE },
-        { READ_12,
-          "READ (12)",
-          command_read,
-          TRUE },
-        { READ_BUFFER_CAPACITY,
-          "READ BUFFER CAPACITY",
-          command_read_buffer_capacity,
-          FALSE },
-        { READ_CAPACITY,
-          "READ CAPACITY",
-          command_read_capacity,
-          FALSE },
-        { READ_CD,
-          "READ CD",
-          command_read_cd,
-          FALSE },
-        { READ_CD_MSF,
-          "READ CD MSF",
-          command_read_cd,
-          FALSE },
-        { READ_DISC_INFORMATION,
-          "READ DISC INFORMATION",
-          command_read_disc_information,
-          TRUE },
-        { READ_DISC_STRUCTURE,
-          "READ DISC STRUCTURE",
-          command_read_disc_structure,
-          TRUE },
-        { READ_TOC_PMA_ATIP,
-          "READ TOC/PMA/ATIP",
-          command_read_toc_pma_atip,
-          FALSE },
-        { READ_TRACK_INFORMATION,
-          "READ TRACK INFORMATION",
-          command_read_track_information,
-          TRUE },
-        { READ_SUBCHANNEL,
-          "READ SUBCHANNEL",
-          command_read_subchannel,
-          FALSE },
-        { REPORT_KEY,
-          "REPORT KEY",
-          command_report_key,
-          TRUE },
-        { REQUEST_SENSE,
-          "REQUEST SENSE",
-          command_request_sense,
-          FALSE },
-        { RESERVE_TRACK,
-          "RESERVE TRACK",
-          command_reserve_track,
-          TRUE },
-        { SEEK_10,
-          "SEEK (10)",
-          command_seek,
-          TRUE },
-        { SEND_CUE_SHEET,
-          "SEND CUE SHEET",
-          command_send_cue_sheet,
-          TRUE },
-        { SET_CD_SPEED,
-          "SET CD SPEED",
-          command_set_cd_speed,
-          TRUE },
-        { SET_STREAMING,
-          "SET STREAMING",
-          command_set_streaming,
-          TRUE },
-        { START_STOP_UNIT,
-          "START/STOP UNIT",
-          command_start_stop_unit,
-          TRUE },
-        { SYNCHRONIZE_CACHE,
-          "SYNCHRONIZE CACHE",
-          command_synchronize_cache,
-          FALSE },
-        { TEST_UNIT_READY,
-          "TEST UNIT READY",
-          command_test_unit_ready,
-          FALSE },
-        { WRITE_10,
-          "WRITE (10)",
-          command_write,
-          TRUE },
-        { WRITE_12,
-          "WRITE (12)",
-          command_write,
-          TRUE },
-    };
-
     /* Find the command and execute its implementation handler */
     for (guint i = 0; i < G_N_ELEMENTS(packet_commands); i++) {
         if (packet_commands[i].cmd == cdb[0]) {
@@ -2864,8 +3319,23 @@ gint cdemu_device_execute_command (CdemuDevice *self, const guint8 *cdb)
 
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: command: %s\n", __debug__, packet_commands[i].debug_name);
 
-            /* Lock */
-            g_mutex_lock(self->priv->device_mutex);
+            /* Lock. Commands that modify device state are executed
+               exclusively. Commands that only read it can be executed
+               concurrently; those that access the disc still serialize on
+               the device mutex, as libMirage objects are not thread-safe,
+               but they do not hold it while their delay emulation (and
+               I/O with kernel) is performed. State that commands executed
+               without device mutex read is modified only with command lock
+               held exclusively */
+            if (packet_commands[i].locking == COMMAND_EXCLUSIVE) {
+                cdemu_device_command_lock_exclusive(self);
+            } else {
+                cdemu_device_command_lock_shared(self);
+            }
+
+            if (packet_commands[i].locking != COMMAND_CONCURRENT) {
+                g_mutex_lock(self->priv->device_mutex);
+            }
 
             /* FIXME: If there is deferred error sense available, return CHECK CONDITION
                with that sense. We do not execute requested command. */
@@ -2877,22 +3347,57 @@ gint cdemu_device_execute_command (CdemuDevice *self, const guint8 *cdb)
                     cdemu_audio_stop(CDEMU_AUDIO(self->priv->audio_play));
                 }
             }
-            /* Execute the command */
-            succeeded = packet_commands[i].implementation(self, cdb);
+            /* Execute the command, unless its response has been memoized.
+               Commands that modify the state memoized responses depend on
+               invalidate them; as they are all executed exclusively, this
+               cannot interfere with commands whose responses are memoized */
+            gint memoization_state = 0;
+            gboolean memoize = packet_commands[i].memoization == MEMOIZE_RESPONSE && command_get_memoization_state(self, cmd, &memoization_state);
+
+            if (memoize && cdemu_device_responses_lookup(self, cmd, memoization_state)) {
+                succeeded = TRUE;
+            } else {
+                succeeded = packet_commands[i].implementation(self, cmd);
+                if (succeeded && memoize) {
+                    cdemu_device_responses_store(self, cmd, memoization_state);
+                }
+            }
+
+            if (packet_commands[i].memoization == MEMOIZE_INVALIDATE) {
+                cdemu_device_responses_invalidate(self);
+            }
+
             status = (succeeded) ? GOOD : CHECK_CONDITION;
 
             /* Unlock */
-            g_mutex_unlock(self->priv->device_mutex);
+            if (packet_commands[i].locking != COMMAND_CONCURRENT) {
+                g_mutex_unlock(self->priv->device_mutex);
+            }
+
+            if (packet_commands[i].locking == COMMAND_EXCLUSIVE) {
+                cdemu_device_command_unlock_exclusive(self);
+            } else {
+                cdemu_device_command_unlock_shared(self);
+            }
+
+            /* Perform delay emulation */
+            if (succeeded) {
+                cdemu_device_delay_finalize(self, cmd);
+            }
 
             CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: command completed with status %d\n", __debug__, status);
 
+            cdemu_device_metrics_record(self, cmd, status, g_get_monotonic_time() - start_time);
+
             return status;
         }
     }
 
     /* Command not found */
     CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: packet command %02Xh not implemented yet!\n", __debug__, cdb[0]);
-    cdemu_device_write_sense(self, ILLEGAL_REQUEST, INVALID_COMMAND_OPERATION_CODE);
+    cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, INVALID_COMMAND_OPERATION_CODE);
+
+    cdemu_device_metrics_record(self, cmd, status, g_get_monotonic_time() - start_time);
 
     return status;
 }
@@ -26,7 +26,7 @@
 /**********************************************************************\
  *                      Delay calculation                             *
 \**********************************************************************/
-static void cdemu_device_delay_increase (CdemuDevice *self, gint address, gint num_sectors)
+static void cdemu_device_delay_increase (CdemuDevice *self, CdemuCommand *cmd, gint address, gint num_sectors)
 {
     gdouble rps = 12000.0/60; /* Rotations per second; fixed at 12000 RPMs for now */
     gdouble dpm_angle = 0;
@@ -88,10 +88,10 @@ static void cdemu_device_delay_increase (CdemuDevice *self, gint address, gint n
             while (rotations >= 10.0) {
                 rotations -= 10.0;
             }
-            self->priv->delay_amount += 20.0*1000; /* Shortcut takes about 20 ms */
+            cmd->delay_amount += 20.0*1000; /* Shortcut takes about 20 ms */
         }
 
-        self->priv->delay_amount += rotations/rps*1000000; /* Delay, in microseconds */
+        cmd->delay_amount += rotations/rps*1000000; /* Delay, in microseconds */
     }
 
     /* Transfer delay; emulates the time needed to read all the sectors. Related
@@ -107,7 +107,7 @@ static void cdemu_device_delay_increase (CdemuDevice *self, gint address, gint n
         gdouble sps = spr*rps; /* Sectors per second */
 
         CDEMU_DEBUG(self, DAEMON_DEBUG_DELAY, "%s: %d sectors at %f sectors/second\n", __debug__, num_sectors, sps);
-        self->priv->delay_amount += num_sectors/sps*1000000; /* Delay, in microseconds */
+        cmd->delay_amount += num_sectors/sps*1000000; /* Delay, in microseconds */
     }
 }
 
@@ -115,23 +115,25 @@ static void cdemu_device_delay_increase (CdemuDevice *self, gint address, gint n
 /**********************************************************************\
  *                          Delay API                                 *
 \**********************************************************************/
-void cdemu_device_delay_begin (CdemuDevice *self, gint address, gint num_sectors)
+void cdemu_device_delay_begin (CdemuDevice *self, CdemuCommand *cmd, gint address, gint num_sectors)
 {
     /* Simply get current time here; we'll need it to compensate for processing
        time when performing actual delay */
-    self->priv->delay_begin = g_get_monotonic_time();
+    cmd->delay_begin = g_get_monotonic_time();
 
     /* Reset delay */
-    self->priv->delay_amount = 0;
+    cmd->delay_amount = 0;
+    cmd->delay_processing = 0;
+    cmd->delay_performed = 0;
 
     /* Increase delay */
-    cdemu_device_delay_increase(self, address, num_sectors);
+    cdemu_device_delay_increase(self, cmd, address, num_sectors);
 }
 
-void cdemu_device_delay_finalize (CdemuDevice *self)
+void cdemu_device_delay_finalize (CdemuDevice *self, CdemuCommand *cmd)
 {
     /* If there's no delay to perform, don't bother doing anything... */
-    if (!self->priv->delay_amount) {
+    if (!cmd->delay_amount) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_DELAY, "%s: no delay to perform\n", __debug__);
         return;
     }
@@ -140,13 +142,23 @@ void cdemu_device_delay_finalize (CdemuDevice *self)
     gint64 delay_now = g_get_monotonic_time();
 
     /* Calculate time difference */
-    gint64 delay_diff = delay_now - self->priv->delay_begin;
+    gint64 delay_diff = delay_now - cmd->delay_begin;
 
-    CDEMU_DEBUG(self, DAEMON_DEBUG_DELAY, "%s: calculated delay: %" G_GINT64_FORMAT " microseconds\n", __debug__, self->priv->delay_amount);
+    CDEMU_DEBUG(self, DAEMON_DEBUG_DELAY, "%s: calculated delay: %" G_GINT64_FORMAT " microseconds\n", __debug__, cmd->delay_amount);
     CDEMU_DEBUG(self, DAEMON_DEBUG_DELAY, "%s: processing time: %" G_GINT64_FORMAT " microseconds\n", __debug__, delay_diff);
-
-    /* Compensate for the processing time */
-    gint64 delay = self->priv->delay_amount - delay_diff;
+    cmd->delay_processing = delay_diff;
+
+    /* Reserve our slot on device's timeline; the emulated drive starts
+       servicing the command once it is done with the previously queued
+       ones, so commands executed in parallel do not sleep their delays
+       at the same time. Processing time is compensated for, as the delay
+       is measured from the command's beginning */
+    g_mutex_lock(&self->priv->delay_mutex);
+    gint64 delay_end = MAX(self->priv->delay_busy_until, cmd->delay_begin) + cmd->delay_amount;
+    self->priv->delay_busy_until = delay_end;
+    g_mutex_unlock(&self->priv->delay_mutex);
+
+    gint64 delay = delay_end - delay_now;
     CDEMU_DEBUG(self, DAEMON_DEBUG_DELAY, "%s: actual delay: %" G_GINT64_FORMAT " microseconds\n", __debug__, delay);
 
     if (delay < 0) {
@@ -155,5 +167,6 @@ void cdemu_device_delay_finalize (CdemuDevice *self)
     }
 
     g_usleep(delay);
+    cmd->delay_performed = delay;
 }
 
@@ -29,24 +29,8 @@
 #define OTHER_SECTORS TO_SECTOR(MAX_SENSE + sizeof(struct vhba_response))
 #define BUF_SIZE (512 * (MAX_SECTORS + OTHER_SECTORS))
 
-/* Kernel I/O structures, also defined in VHBA module's source */
-#define MAX_COMMAND_SIZE 16
-
-struct vhba_request
-{
-    guint32 tag;
-    guint32 lun;
-    guint8 cdb[MAX_COMMAND_SIZE];
-    guint8 cdb_len;
-    guint32 data_len;
-};
-
-struct vhba_response
-{
-    guint32 tag;
-    guint32 status;
-    guint32 data_len;
-};
+/* Maximum number of requests processed concurrently */
+#define NUM_REQUESTS 8
 
 
 /* Compute the required kernel I/O buffer size */
@@ -59,34 +43,34 @@ gsize cdemu_device_get_kernel_io_buffer_size (CdemuDevice *self G_GNUC_UNUSED)
 /**********************************************************************\
  *             Data buffer (cache) <-> kernel I/O buffer              *
 \**********************************************************************/
-void cdemu_device_write_buffer (CdemuDevice *self, guint32 length)
+void cdemu_device_write_buffer (CdemuDevice *self, CdemuCommand *cmd, guint32 length)
 {
     guint32 len;
 
     CDEMU_DEBUG(self, DAEMON_DEBUG_KERNEL_IO, "%s: write data from cache (%d bytes)\n", __debug__, length);
 
     /* Minimum of requested write length and actual data in our cache */
-    len = MIN(self->priv->buffer_size, length);
+    len = MIN(cmd->buffer_size, length);
 
     /* Make sure there is enough space in (remaining) command output buffer */
-    if (self->priv->cmd_out_buffer_pos + len > self->priv->cmd->out_len) {
+    if (cmd->out_pos + len > cmd->out_len) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_KERNEL_IO, "%s: OUT buffer too small, truncating!\n", __debug__);
-        len = self->priv->cmd->out_len - self->priv->cmd_out_buffer_pos;
+        len = cmd->out_len - cmd->out_pos;
     }
 
-    CDEMU_DEBUG(self, DAEMON_DEBUG_KERNEL_IO, "%s: copying %d bytes to OUT buffer at offset %d\n", __debug__, len, self->priv->cmd_out_buffer_pos);
-    memcpy(self->priv->cmd->out + self->priv->cmd_out_buffer_pos, self->priv->buffer, len);
-    self->priv->cmd_out_buffer_pos += len;
+    CDEMU_DEBUG(self, DAEMON_DEBUG_KERNEL_IO, "%s: copying %d bytes to OUT buffer at offset %d\n", __debug__, len, cmd->out_pos);
+    memcpy(cmd->out + cmd->out_pos, cmd->buffer, len);
+    cmd->out_pos += len;
 }
 
-void cdemu_device_read_buffer (CdemuDevice *self, guint32 length)
+void cdemu_device_read_buffer (CdemuDevice *self, CdemuCommand *cmd, guint32 length)
 {
     guint32 len;
 
     CDEMU_DEBUG(self, DAEMON_DEBUG_KERNEL_IO, "%s: read data to cache (%d bytes)\n", __debug__, length);
 
     /* Minimum of requested read length and (remaining) data in command input buffer */
-    len = MIN(self->priv->cmd->in_len - self->priv->cmd_in_buffer_pos, length);
+    len = MIN(cmd->in_len - cmd->in_pos, length);
 
     /* Make sure there is enough space in our cache */
     if (len > self->priv->buffer_capacity) {
@@ -94,26 +78,42 @@ void cdemu_device_read_buffer (CdemuDevice *self, guint32 length)
         len = self->priv->buffer_capacity;
     }
 
-    CDEMU_DEBUG(self, DAEMON_DEBUG_KERNEL_IO, "%s: copying %d bytes from IN buffer at offset %d\n", __debug__, len, self->priv->cmd_in_buffer_pos);
-    memcpy(self->priv->buffer, self->priv->cmd->in + self->priv->cmd_in_buffer_pos, len);
-    self->priv->buffer_size = len;
-    self->priv->cmd_in_buffer_pos += len;
+    CDEMU_DEBUG(self, DAEMON_DEBUG_KERNEL_IO, "%s: copying %d bytes from IN buffer at offset %d\n", __debug__, len, cmd->in_pos);
+    memcpy(cmd->buffer, cmd->in + cmd->in_pos, len);
+    cmd->buffer_size = len;
+    cmd->in_pos += len;
 }
 
 
-void cdemu_device_flush_buffer (CdemuDevice *self)
+void cdemu_device_flush_buffer (CdemuDevice *self, CdemuCommand *cmd)
 {
     CDEMU_DEBUG(self, DAEMON_DEBUG_KERNEL_IO, "%s: flushing cache\n", __debug__);
 
-    memset(self->priv->buffer, 0, self->priv->buffer_size);
-    self->priv->buffer_size = 0;
+    memset(cmd->buffer, 0, cmd->buffer_size);
+    cmd->buffer_size = 0;
+}
+
+
+/* Direct access to the (remaining) command output buffer, for commands
+   that can produce their data in place instead of going through our cache;
+   the data written is accounted for by cdemu_device_commit_out_buffer() */
+guint8 *cdemu_device_get_out_buffer (CdemuDevice *self G_GNUC_UNUSED, CdemuCommand *cmd, guint32 *available)
+{
+    *available = cmd->out_len - cmd->out_pos;
+    return cmd->out + cmd->out_pos;
+}
+
+void cdemu_device_commit_out_buffer (CdemuDevice *self, CdemuCommand *cmd, guint32 length)
+{
+    CDEMU_DEBUG(self, DAEMON_DEBUG_KERNEL_IO, "%s: %d bytes written directly to OUT buffer at offset %d\n", __debug__, length, cmd->out_pos);
+    cmd->out_pos += length;
 }
 
 
 /**********************************************************************\
  *                       Sense buffer I/O                             *
 \**********************************************************************/
-void cdemu_device_write_sense_full (CdemuDevice *self, SenseKey sense_key, guint16 asc_ascq, gint ili, guint32 command_info)
+void cdemu_device_write_sense_full (CdemuDevice *self, CdemuCommand *cmd, SenseKey sense_key, guint16 asc_ascq, gint ili, guint32 command_info)
 {
     /* Initialize sense */
     struct REQUEST_SENSE_SenseFixed sense;
@@ -138,35 +138,121 @@ void cdemu_device_write_sense_full (CdemuDevice *self, SenseKey sense_key, guint
     CDEMU_DEBUG(self, DAEMON_DEBUG_KERNEL_IO, "%s: writing sense (%" G_GSIZE_MODIFIER "d bytes) to OUT buffer\n", __debug__, sizeof(struct REQUEST_SENSE_SenseFixed));
 
     /* Write sense directly into command's output buffer */
-    memcpy(self->priv->cmd->out, &sense, sizeof(struct REQUEST_SENSE_SenseFixed));
-    self->priv->cmd_out_buffer_pos = sizeof(struct REQUEST_SENSE_SenseFixed);
+    memcpy(cmd->out, &sense, sizeof(struct REQUEST_SENSE_SenseFixed));
+    cmd->out_pos = sizeof(struct REQUEST_SENSE_SenseFixed);
 }
 
-void cdemu_device_write_sense (CdemuDevice *self, SenseKey sense_key, guint16 asc_ascq)
+void cdemu_device_write_sense (CdemuDevice *self, CdemuCommand *cmd, SenseKey sense_key, guint16 asc_ascq)
 {
-    return cdemu_device_write_sense_full(self, sense_key, asc_ascq, 0, 0x0000);
+    return cdemu_device_write_sense_full(self, cmd, sense_key, asc_ascq, 0, 0x0000);
+}
+
+
+/**********************************************************************\
+ *                          Request slots                             *
+\**********************************************************************/
+/* Each outstanding request occupies a slot that holds its kernel I/O
+   buffer and command state. The I/O thread reads requests into idle slots
+   and hands them over to the command worker pool; workers write the
+   responses and return the slots to the idle queue. The number of slots
+   thus limits the number of requests that are processed concurrently */
+typedef struct
+{
+    guint8 *kernel_io_buffer;
+    CdemuCommand cmd;
+} CdemuRequest;
+
+static CdemuRequest *cdemu_device_request_new (CdemuDevice *self)
+{
+    CdemuRequest *request = g_new0(CdemuRequest, 1);
+
+    request->kernel_io_buffer = g_malloc0(BUF_SIZE);
+    request->cmd.buffer = g_malloc0(self->priv->buffer_capacity);
+
+    return request;
+}
+
+static void cdemu_device_request_free (CdemuRequest *request)
+{
+    g_free(request->cmd.buffer);
+    g_free(request->kernel_io_buffer);
+    g_free(request);
 }
 
 
 /**********************************************************************\
  *                    Kernel <-> userspace I/O                        *
 \**********************************************************************/
+static void cdemu_device_command_worker (CdemuRequest *request, CdemuDevice *self)
+{
+    gint fd = g_io_channel_unix_get_fd(self->priv->io_channel);
+    gssize ret;
+
+    CdemuCommand *cmd = &request->cmd;
+    struct vhba_request *vreq = (gpointer)request->kernel_io_buffer;
+    struct vhba_response *vres = (gpointer)request->kernel_io_buffer;
+    guint32 tag = vreq->tag;
+
+    /* Execute command */
+    gint status = cdemu_device_execute_command(self, cmd);
+
+    /* Note that vreq and vres share buffer */
+    vres->tag = tag;
+    vres->status = status;
+    vres->data_len = cmd->out_pos;
+
+    /* Write response */
+    CDEMU_DEBUG(self, DAEMON_DEBUG_KERNEL_IO, "%s: writing response; tag %d\n", __debug__, vres->tag);
+
+    /* Only the response header and the actual data need to be written;
+       VHBA module does not copy anything beyond data_len either */
+    g_mutex_lock(&self->priv->io_mutex);
+    ret = write(fd, vres, sizeof(struct vhba_response) + vres->data_len);
+    g_mutex_unlock(&self->priv->io_mutex);
+    if (ret < (gssize)sizeof(struct vhba_response)) {
+        CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to write response to control device (%" G_GSIZE_MODIFIER "d bytes; at least %" G_GSIZE_MODIFIER "d required)!\n", __debug__, ret, sizeof(struct vhba_response));
+        /* Signal the kernel I/O error, so daemon can restart the device */
+        g_signal_emit_by_name(self, "kernel-io-error", NULL);
+    }
+
+    /* Return the slot */
+    g_async_queue_push(self->priv->idle_requests, request);
+}
+
 static gboolean cdemu_device_io_handler (GIOChannel *source, GIOCondition condition G_GNUC_UNUSED, CdemuDevice *self)
 {
     gint fd = g_io_channel_unix_get_fd(source);
     gssize ret;
 
-    CdemuCommand cmd;
-    struct vhba_request *vreq = (gpointer)self->priv->kernel_io_buffer;
-    struct vhba_response *vres = (gpointer)self->priv->kernel_io_buffer;
+    CdemuRequest *request;
+    CdemuCommand *cmd;
+    struct vhba_request *vreq;
+    struct vhba_response *vres;
 
     CDEMU_DEBUG(self, DAEMON_DEBUG_KERNEL_IO, "%s: I/O handler invoked\n", __debug__);
 
+    /* Grab an idle slot; if all are taken, wait for one of the outstanding
+       requests to complete */
+    request = g_async_queue_pop(self->priv->idle_requests);
+    cmd = &request->cmd;
+    vreq = (gpointer)request->kernel_io_buffer;
+    vres = (gpointer)request->kernel_io_buffer;
+
     /* Read request */
     CDEMU_DEBUG(self, DAEMON_DEBUG_KERNEL_IO, "%s: reading request\n", __debug__);
 
+    g_mutex_lock(&self->priv->io_mutex);
     ret = read(fd, vreq, BUF_SIZE);
+    g_mutex_unlock(&self->priv->io_mutex);
     if (ret < (gssize)sizeof(struct vhba_request)) {
+        g_async_queue_push(self->priv->idle_requests, request);
+
+        /* The request might have been picked up already, if the
+           watch fired more than once for it */
+        if (ret < 0 && errno == EAGAIN) {
+            return TRUE;
+        }
+
         CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to read request from control device (%" G_GSIZE_MODIFIER "d bytes; at least %" G_GSIZE_MODIFIER "d required)!\n", __debug__, ret, sizeof(struct vhba_request));
         /* Signal the kernel I/O error, so daemon can restart the device */
         g_signal_emit_by_name(self, "kernel-io-error", NULL);
@@ -176,40 +262,25 @@ static gboolean cdemu_device_io_handler (GIOChannel *source, GIOCondition condit
     CDEMU_DEBUG(self, DAEMON_DEBUG_KERNEL_IO, "%s: successfully read request; cmd %02Xh, in/out len %d, tag %d\n", __debug__, vreq->cdb[0], vreq->data_len, vreq->tag);
 
     /* Initialize CDEMU_Command */
-    memcpy(cmd.cdb, vreq->cdb, vreq->cdb_len);
+    memcpy(cmd->cdb, vreq->cdb, MIN(vreq->cdb_len, 12));
     if (vreq->cdb_len < 12) {
-        memset(cmd.cdb + vreq->cdb_len, 0, 12 - vreq->cdb_len);
+        memset(cmd->cdb + vreq->cdb_len, 0, 12 - vreq->cdb_len);
     }
 
-    cmd.in = (guint8 *)(vreq + 1);
-    cmd.out = (guint8 *)(vres + 1);
-    cmd.in_len = cmd.out_len = vreq->data_len;
+    cmd->in = (guint8 *)(vreq + 1);
+    cmd->out = (guint8 *)(vres + 1);
+    cmd->in_len = cmd->out_len = vreq->data_len;
 
-    if (cmd.out_len > BUF_SIZE - sizeof(struct vhba_response)) {
-        cmd.out_len = BUF_SIZE - sizeof(struct vhba_response);
+    if (cmd->out_len > BUF_SIZE - sizeof(struct vhba_response)) {
+        cmd->out_len = BUF_SIZE - sizeof(struct vhba_response);
     }
 
     /* Reset command in/out buffer positions */
-    self->priv->cmd = &cmd;
-    self->priv->cmd_out_buffer_pos = 0;
-    self->priv->cmd_in_buffer_pos = 0;
-
-    /* Note that vreq and vres share buffer */
-    vres->tag = vreq->tag;
-    vres->status = cdemu_device_execute_command(self, cmd.cdb);
+    cmd->out_pos = 0;
+    cmd->in_pos = 0;
 
-    vres->data_len = self->priv->cmd_out_buffer_pos;
-
-    /* Write response */
-    CDEMU_DEBUG(self, DAEMON_DEBUG_KERNEL_IO, "%s: writing response\n", __debug__);
-
-    ret = write(fd, vres, BUF_SIZE);
-    if (ret < (gssize)sizeof(struct vhba_response)) {
-        CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to write response to control device (%" G_GSIZE_MODIFIER "d bytes; at least %" G_GSIZE_MODIFIER "d required)!\n", __debug__, ret, sizeof(struct vhba_response));
-        /* Signal the kernel I/O error, so daemon can restart the device */
-        g_signal_emit_by_name(self, "kernel-io-error", NULL);
-        return TRUE;
-    }
+    /* Hand the request over to the worker pool */
+    g_thread_pool_push(self->priv->command_pool, request, NULL);
 
     CDEMU_DEBUG(self, DAEMON_DEBUG_KERNEL_IO, "%s: I/O handler done\n\n", __debug__);
 
@@ -230,18 +301,10 @@ static gpointer cdemu_device_io_thread (CdemuDevice *self)
 /**********************************************************************\
  *                      Start/stop functions                          *
 \**********************************************************************/
-gboolean cdemu_device_start (CdemuDevice *self, const gchar *ctl_device)
+static gboolean cdemu_device_start_io (CdemuDevice *self)
 {
     GError *local_error = NULL;
 
-    /* Open control device and set up I/O channel */
-    self->priv->io_channel = g_io_channel_new_file(ctl_device, "r+", &local_error);
-    if (!self->priv->io_channel) {
-        CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to open control device %s: %s!\n", __debug__, ctl_device, local_error->message);
-        g_error_free(local_error);
-        return FALSE;
-    }
-
     /* Try setting non-blocking operation */
     if (g_io_channel_set_flags(self->priv->io_channel, G_IO_FLAG_NONBLOCK, &local_error) != G_IO_STATUS_NORMAL) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to set NONBLOCK flag to control device: %s!\n", __debug__, local_error->message);
@@ -266,6 +329,19 @@ gboolean cdemu_device_start (CdemuDevice *self, const gchar *ctl_device)
         self->priv->device_serial = g_strdup_printf("%03d", device_number);
     }
 
+    /* Set up request slots and command worker pool */
+    self->priv->idle_requests = g_async_queue_new();
+    for (self->priv->num_requests = 0; self->priv->num_requests < NUM_REQUESTS; self->priv->num_requests++) {
+        g_async_queue_push(self->priv->idle_requests, cdemu_device_request_new(self));
+    }
+
+    self->priv->command_pool = g_thread_pool_new((GFunc)cdemu_device_command_worker, self, NUM_REQUESTS, FALSE, &local_error);
+    if (!self->priv->command_pool) {
+        CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to create command worker pool: %s\n", __debug__, local_error->message);
+        g_error_free(local_error);
+        return FALSE;
+    }
+
     /* Create I/O watch */
     self->priv->io_watch = g_io_create_watch(self->priv->io_channel, G_IO_IN);
     g_source_set_callback(self->priv->io_watch, (GSourceFunc)cdemu_device_io_handler, self, NULL);
@@ -283,6 +359,33 @@ gboolean cdemu_device_start (CdemuDevice *self, const gchar *ctl_device)
     return TRUE;
 }
 
+gboolean cdemu_device_start (CdemuDevice *self, const gchar *ctl_device)
+{
+    GError *local_error = NULL;
+
+    /* Open control device and set up I/O channel */
+    self->priv->io_channel = g_io_channel_new_file(ctl_device, "r+", &local_error);
+    if (!self->priv->io_channel) {
+        CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to open control device %s: %s!\n", __debug__, ctl_device, local_error->message);
+        g_error_free(local_error);
+        return FALSE;
+    }
+
+    return cdemu_device_start_io(self);
+}
+
+/* Starts the device on an already-open descriptor that speaks the VHBA
+   control device protocol (one vhba_request/vhba_response per read/write),
+   such as a SOCK_SEQPACKET socket used as a userspace stand-in for the
+   kernel module. The descriptor is closed when the device is stopped */
+gboolean cdemu_device_start_with_fd (CdemuDevice *self, gint fd)
+{
+    self->priv->io_channel = g_io_channel_unix_new(fd);
+    g_io_channel_set_close_on_unref(self->priv->io_channel, TRUE);
+
+    return cdemu_device_start_io(self);
+}
+
 void cdemu_device_stop (CdemuDevice *self)
 {
     /* Stop the I/O thread */
@@ -299,12 +402,6 @@ void cdemu_device_stop (CdemuDevice *self)
 		self->priv->io_watch = NULL;
 	}
 
-    /* Close the I/O channel */
-    if (self->priv->io_channel) {
-        g_io_channel_unref(self->priv->io_channel);
-        self->priv->io_channel = NULL;
-    }
-
     /* Unref thread */
     if (self->priv->io_thread) {
         /* Wait for the thread to finish (also releases the reference
@@ -314,6 +411,27 @@ void cdemu_device_stop (CdemuDevice *self)
         self->priv->io_thread = NULL;
     }
 
+    /* Wait for outstanding requests to complete */
+    if (self->priv->command_pool) {
+        g_thread_pool_free(self->priv->command_pool, FALSE, TRUE);
+        self->priv->command_pool = NULL;
+    }
+
+    /* Free request slots */
+    if (self->priv->idle_requests) {
+        for (; self->priv->num_requests > 0; self->priv->num_requests--) {
+            cdemu_device_request_free(g_async_queue_pop(self->priv->idle_requests));
+        }
+        g_async_queue_unref(self->priv->idle_requests);
+        self->priv->idle_requests = NULL;
+    }
+
+    /* Close the I/O channel */
+    if (self->priv->io_channel) {
+        g_io_channel_unref(self->priv->io_channel);
+        self->priv->io_channel = NULL;
+    }
+
     /* Clear device mappings */
     if (self->priv->device_sg) {
         g_free(self->priv->device_sg);
@@ -84,6 +84,12 @@ static gboolean cdemu_device_load_disc_private (CdemuDevice *self, gchar **filen
         }
     }
 
+    /* Memoized responses describe the previous state */
+    cdemu_device_responses_invalidate(self);
+
+    /* Start subchannel metadata pre-scan */
+    cdemu_device_metadata_reset(self);
+
     /* Signal event */
     self->priv->media_event = MEDIA_EVENT_NEW_MEDIA;
 
@@ -98,9 +104,11 @@ gboolean cdemu_device_load_disc (CdemuDevice *self, gchar **filenames, GVariant
     gboolean succeeded = TRUE;
 
     /* Load */
+    cdemu_device_command_lock_exclusive(self);
     g_mutex_lock(self->priv->device_mutex);
     succeeded = cdemu_device_load_disc_private(self, filenames, options, error);
     g_mutex_unlock(self->priv->device_mutex);
+    cdemu_device_command_unlock_exclusive(self);
 
     return succeeded;
 }
@@ -239,6 +247,7 @@ static gboolean cdemu_device_create_blank_disc_private (CdemuDevice *self, const
 
     self->priv->open_session = NULL;
     self->priv->open_track = NULL;
+    self->priv->open_track_updating = FALSE;
 
     /* Loading succeeded */
     self->priv->loaded = TRUE;
@@ -249,6 +258,12 @@ static gboolean cdemu_device_create_blank_disc_private (CdemuDevice *self, const
     /* Set default recording mode */
     cdemu_device_recording_set_mode(self, 1); /* TAO */
 
+    /* Memoized responses describe the previous state */
+    cdemu_device_responses_invalidate(self);
+
+    /* Start subchannel metadata pre-scan */
+    cdemu_device_metadata_reset(self);
+
     /* Signal event */
     self->priv->media_event = MEDIA_EVENT_NEW_MEDIA;
 
@@ -264,9 +279,11 @@ gboolean cdemu_device_create_blank_disc (CdemuDevice *self, const gchar *filenam
     gboolean succeeded = TRUE;
 
     /* Create */
+    cdemu_device_command_lock_exclusive(self);
     g_mutex_lock(self->priv->device_mutex);
     succeeded = cdemu_device_create_blank_disc_private(self, filename, options, error);
     g_mutex_unlock(self->priv->device_mutex);
+    cdemu_device_command_unlock_exclusive(self);
 
     return succeeded;
 }
@@ -286,6 +303,9 @@ gboolean cdemu_device_unload_disc_private (CdemuDevice *self, GError **error)
 
     /* Unload only if we're loaded */
     if (self->priv->loaded) {
+        /* Drop read-ahead window; its sectors belong to the disc's pool */
+        cdemu_device_read_ahead_reset(self);
+
         /* Delete disc */
         g_object_unref(self->priv->disc);
         self->priv->disc = NULL;
@@ -298,6 +318,7 @@ gboolean cdemu_device_unload_disc_private (CdemuDevice *self, GError **error)
         if (self->priv->open_track) {
             g_object_unref(self->priv->open_track);
             self->priv->open_track = NULL;
+            self->priv->open_track_updating = FALSE;
         }
 
         if (self->priv->open_session) {
@@ -324,6 +345,11 @@ gboolean cdemu_device_unload_disc_private (CdemuDevice *self, GError **error)
         /* Current profile: None */
         cdemu_device_set_profile(self, ProfileIndex_NONE);
 
+        /* Memoized responses and subchannel metadata describe the
+           previous state */
+        cdemu_device_responses_invalidate(self);
+        cdemu_device_metadata_reset(self);
+
         /* Send notification */
         g_signal_emit_by_name(self, "status-changed", NULL);
     }
@@ -335,6 +361,7 @@ gboolean cdemu_device_unload_disc (CdemuDevice *self, GError **error)
 {
     gboolean succeeded;
 
+    cdemu_device_command_lock_exclusive(self);
     g_mutex_lock(self->priv->device_mutex);
 
     /* This call is the equivalent of the user pressing the mechanical
@@ -349,6 +376,7 @@ gboolean cdemu_device_unload_disc (CdemuDevice *self, GError **error)
     succeeded = cdemu_device_unload_disc_private(self, error);
 
     g_mutex_unlock(self->priv->device_mutex);
+    cdemu_device_command_unlock_exclusive(self);
 
     /* Ignore the command's return value to avoid bothering the clients
        with errors when device is most likely locked, and will be
@@ -0,0 +1,208 @@
+/*
+ *  CDEmu daemon: device - subchannel metadata
+ *  Copyright (C) 2006-2014 Rok Mandeljc
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "cdemu.h"
+#include "device-private.h"
+
+#define __debug__ "Metadata"
+
+
+/* MCN and ISRC are reported by READ SUBCHANNEL the way real devices do
+   it: by looking for Mode-2 and Mode-3 Q in the subchannel of the first
+   100 sectors of disc and track, respectively (according to INF8090, if
+   present, they must be encoded in at least one sector out of 100
+   consecutive sectors). The Q found by such a scan is kept in a table, so
+   that subsequent requests become table look-ups.
+
+   When subchannel pre-scan is enabled, the table is filled in advance by
+   the read-ahead worker thread, in the time it has no sectors to read
+   ahead; one entry (MCN, or ISRC of a single track) is scanned at a time,
+   with the device mutex held, so commands are kept waiting for at most a
+   single entry's scan. Entries that have not been scanned yet are scanned
+   on demand. The table is protected by the device mutex.
+
+   Recordable discs change as they are being written; for those, the table
+   is bypassed and each request performs its own scan. */
+
+
+/**********************************************************************\
+ *                              Scanning                              *
+\**********************************************************************/
+static void cdemu_device_metadata_scan_mcn (CdemuDevice *self, CdemuQMetadata *entry)
+{
+    MirageDisc *disc = self->priv->disc;
+    MirageSector *sector = mirage_disc_acquire_sector(disc);
+
+    entry->found = FALSE;
+
+    /* Go over first 100 sectors; if MCN is present, it should be there */
+    for (gint address = 0; address < 100; address++) {
+        const guint8 *buf;
+
+        if (!mirage_disc_read_sector(disc, address, sector, NULL)
+            || !mirage_sector_get_subchannel(sector, MIRAGE_SUBCHANNEL_Q, &buf, NULL, NULL)) {
+            CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to read subchannel of sector 0x%X!\n", __debug__, address);
+            continue;
+        }
+
+        if ((buf[0] & 0x0F) == 0x02) {
+            /* Mode-2 Q found */
+            memcpy(entry->q, buf, sizeof(entry->q));
+            entry->found = TRUE;
+            CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: found MCN in subchannel of sector 0x%X\n", __debug__, address);
+            break;
+        }
+    }
+
+    mirage_disc_release_sector(disc, sector);
+
+    entry->scanned = TRUE;
+}
+
+static void cdemu_device_metadata_scan_isrc (CdemuDevice *self, MirageTrack *track, CdemuQMetadata *entry)
+{
+    entry->found = FALSE;
+
+    /* Go over first 100 sectors; if ISRC is present, it should be there */
+    for (gint address = 0; address < 100; address++) {
+        MirageSector *sector;
+        const guint8 *buf;
+
+        /* Get sector */
+        sector = mirage_track_get_sector(track, address, FALSE, NULL);
+        if (!sector) {
+            CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: failed to get sector 0x%X\n", __debug__, address);
+            continue;
+        }
+
+        if (!mirage_sector_get_subchannel(sector, MIRAGE_SUBCHANNEL_Q, &buf, NULL, NULL)) {
+            CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: failed to read subchannel of sector 0x%X\n", __debug__, address);
+            g_object_unref(sector);
+            continue;
+        }
+
+        if ((buf[0] & 0x0F) == 0x03) {
+            /* Mode-3 Q found */
+            memcpy(entry->q, buf, sizeof(entry->q));
+            entry->found = TRUE;
+            CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: found ISRC in subchannel of sector 0x%X\n", __debug__, address);
+        }
+
+        g_object_unref(sector);
+
+        if (entry->found) {
+            break;
+        }
+    }
+
+    entry->scanned = TRUE;
+}
+
+
+/**********************************************************************\
+ *                            Metadata API                            *
+\**********************************************************************/
+/* NOTE: functions below expect the device mutex to be held by the caller */
+void cdemu_device_metadata_reset (CdemuDevice *self)
+{
+    memset(&self->priv->metadata, 0, sizeof(self->priv->metadata));
+
+    /* Wake up the worker thread to start the pre-scan */
+    if (self->priv->metadata_prescan && self->priv->loaded) {
+        g_cond_signal(&self->priv->read_ahead_cond);
+    }
+}
+
+const guint8 *cdemu_device_metadata_get_mcn (CdemuDevice *self)
+{
+    CdemuQMetadata *entry = &self->priv->metadata.mcn;
+    CdemuQMetadata tmp_entry;
+
+    if (self->priv->recordable_disc) {
+        /* Bypass the table; returned Q is valid until next call */
+        cdemu_device_metadata_scan_mcn(self, &tmp_entry);
+        memcpy(self->priv->metadata.bypass_q, tmp_entry.q, sizeof(tmp_entry.q));
+        return tmp_entry.found ? self->priv->metadata.bypass_q : NULL;
+    }
+
+    if (!entry->scanned) {
+        cdemu_device_metadata_scan_mcn(self, entry);
+    }
+
+    return entry->found ? entry->q : NULL;
+}
+
+const guint8 *cdemu_device_metadata_get_isrc (CdemuDevice *self, MirageTrack *track)
+{
+    gint track_number = mirage_track_layout_get_track_number(track);
+    CdemuQMetadata tmp_entry;
+    CdemuQMetadata *entry;
+
+    if (self->priv->recordable_disc || track_number < 1 || track_number > 99) {
+        /* Bypass the table; returned Q is valid until next call */
+        cdemu_device_metadata_scan_isrc(self, track, &tmp_entry);
+        memcpy(self->priv->metadata.bypass_q, tmp_entry.q, sizeof(tmp_entry.q));
+        return tmp_entry.found ? self->priv->metadata.bypass_q : NULL;
+    }
+
+    entry = &self->priv->metadata.isrc[track_number];
+    if (!entry->scanned) {
+        cdemu_device_metadata_scan_isrc(self, track, entry);
+    }
+
+    return entry->found ? entry->q : NULL;
+}
+
+gboolean cdemu_device_metadata_scan_next (CdemuDevice *self)
+{
+    CdemuSubchannelMetadata *metadata = &self->priv->metadata;
+
+    if (!self->priv->metadata_prescan || !self->priv->loaded || self->priv->recordable_disc) {
+        return FALSE;
+    }
+
+    /* MCN first... */
+    if (!metadata->mcn.scanned) {
+        CDEMU_DEBUG(self, DAEMON_DEBUG_DEVICE, "%s: pre-scanning MCN\n", __debug__);
+        cdemu_device_metadata_scan_mcn(self, &metadata->mcn);
+        return TRUE;
+    }
+
+    /* ... then ISRCs of tracks, one at a time */
+    while (metadata->next_track < mirage_disc_get_number_of_tracks(self->priv->disc)) {
+        MirageTrack *track = mirage_disc_get_track_by_index(self->priv->disc, metadata->next_track++, NULL);
+        gint track_number;
+
+        if (!track) {
+            continue;
+        }
+
+        track_number = mirage_track_layout_get_track_number(track);
+        if (track_number >= 1 && track_number <= 99 && !metadata->isrc[track_number].scanned) {
+            CDEMU_DEBUG(self, DAEMON_DEBUG_DEVICE, "%s: pre-scanning ISRC of track %d\n", __debug__, track_number);
+            cdemu_device_metadata_scan_isrc(self, track, &metadata->isrc[track_number]);
+            g_object_unref(track);
+            return TRUE;
+        }
+
+        g_object_unref(track);
+    }
+
+    return FALSE;
+}
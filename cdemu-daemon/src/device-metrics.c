@@ -0,0 +1,177 @@
+/*
+ *  CDEmu daemon: device - metrics
+ *  Copyright (C) 2006-2014 Rok Mandeljc
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "cdemu.h"
+#include "device-private.h"
+
+#define __debug__ "Metrics"
+
+
+/* Metrics are collected for every executed command, once it has completed
+   (including its delay emulation). As commands are executed concurrently
+   by the worker pool, the counters are protected by their own mutex, which
+   is held only for the duration of the update; neither the device mutex
+   nor the command lock are involved, so collection does not add any
+   contention to command execution itself.
+
+   All counters are monotonic and count from the device's creation; clients
+   are expected to compute rates from differences between two snapshots.
+   Service time histogram bucket 0 holds commands that completed in less
+   than 1 microsecond, and bucket N (N > 0) the ones that completed within
+   [2^(N-1), 2^N) microseconds; the last bucket is open-ended. */
+
+
+/**********************************************************************\
+ *                            Collection                              *
+\**********************************************************************/
+void cdemu_device_metrics_record (CdemuDevice *self, CdemuCommand *cmd, gint status, gint64 service_time)
+{
+    CdemuMetrics *metrics = self->priv->metrics;
+    CdemuOpcodeMetrics *opcode = &metrics->opcodes[cmd->cdb[0]];
+    gint bucket = 0;
+
+    service_time = MAX(service_time, 0);
+    while (bucket < METRICS_NUM_BUCKETS - 1 && service_time >= (G_GINT64_CONSTANT(1) << bucket)) {
+        bucket++;
+    }
+
+    g_mutex_lock(&self->priv->metrics_mutex);
+
+    opcode->count++;
+    opcode->total_time += service_time;
+    opcode->histogram[bucket]++;
+
+    if (status != GOOD) {
+        opcode->errors++;
+    } else {
+        /* Data transfer */
+        metrics->bytes_in += cmd->in_pos;
+        metrics->bytes_out += cmd->out_pos;
+
+        if (cmd->cdb[0] == WRITE_10 || cmd->cdb[0] == WRITE_12) {
+            metrics->sectors_written += cmd->num_sectors;
+        } else {
+            metrics->sectors_read += cmd->num_sectors;
+        }
+
+        /* Delay emulation */
+        if (cmd->delay_amount) {
+            metrics->delayed_commands++;
+            metrics->delay_time += cmd->delay_performed;
+            metrics->processing_time += cmd->delay_processing;
+        }
+    }
+
+    g_mutex_unlock(&self->priv->metrics_mutex);
+}
+
+
+/**********************************************************************\
+ *                              Snapshot                              *
+\**********************************************************************/
+static GVariant *cdemu_device_metrics_encode_opcodes (const CdemuMetrics *metrics)
+{
+    GVariantBuilder builder;
+
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a(ysttat)"));
+
+    for (gint i = 0; i < 256; i++) {
+        const CdemuOpcodeMetrics *opcode = &metrics->opcodes[i];
+        const gchar *name;
+        GVariant *histogram;
+
+        if (!opcode->count) {
+            continue;
+        }
+
+        name = cdemu_device_get_command_name(i);
+        histogram = g_variant_new_fixed_array(G_VARIANT_TYPE_UINT64, opcode->histogram, METRICS_NUM_BUCKETS, sizeof(guint64));
+
+        g_variant_builder_add(&builder, "(ystt@at)", (guint8)i, name ? name : "", opcode->count, opcode->errors, opcode->total_time, histogram);
+    }
+
+    return g_variant_builder_end(&builder);
+}
+
+GVariant *cdemu_device_get_metrics (CdemuDevice *self)
+{
+    CdemuMetrics *metrics = g_new(CdemuMetrics, 1);
+    GVariantBuilder builder;
+    guint64 read_ahead_hits, read_ahead_misses;
+    guint64 cache_hits = 0, cache_misses = 0, cache_evictions = 0;
+    gsize cache_size = 0;
+    guint64 response_hits, response_misses;
+    guint audio_buffer_depth, audio_buffer_size;
+    guint64 audio_underruns;
+
+    /* Take a consistent copy of the counters, so that encoding does not
+       hold up the command workers */
+    g_mutex_lock(&self->priv->metrics_mutex);
+    memcpy(metrics, self->priv->metrics, sizeof(CdemuMetrics));
+    g_mutex_unlock(&self->priv->metrics_mutex);
+
+    /* Read-ahead statistics are protected by device mutex */
+    g_mutex_lock(self->priv->device_mutex);
+    read_ahead_hits = self->priv->read_ahead_hits;
+    read_ahead_misses = self->priv->read_ahead_misses;
+    g_mutex_unlock(self->priv->device_mutex);
+
+    /* Memoized command responses */
+    cdemu_device_responses_get_statistics(self, &response_hits, &response_misses);
+
+    /* Audio playback buffer */
+    cdemu_audio_get_buffer_statistics(self->priv->audio_play, &audio_buffer_depth, &audio_buffer_size, &audio_underruns);
+
+    /* Block cache of the context in which discs are loaded */
+    mirage_context_cache_get_statistics(self->priv->mirage_context, &cache_hits, &cache_misses, &cache_evictions, &cache_size);
+
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+
+    g_variant_builder_add(&builder, "{sv}", "timestamp", g_variant_new_int64(g_get_monotonic_time()));
+
+    g_variant_builder_add(&builder, "{sv}", "sectors-read", g_variant_new_uint64(metrics->sectors_read));
+    g_variant_builder_add(&builder, "{sv}", "sectors-written", g_variant_new_uint64(metrics->sectors_written));
+    g_variant_builder_add(&builder, "{sv}", "bytes-in", g_variant_new_uint64(metrics->bytes_in));
+    g_variant_builder_add(&builder, "{sv}", "bytes-out", g_variant_new_uint64(metrics->bytes_out));
+
+    g_variant_builder_add(&builder, "{sv}", "delayed-commands", g_variant_new_uint64(metrics->delayed_commands));
+    g_variant_builder_add(&builder, "{sv}", "delay-time", g_variant_new_uint64(metrics->delay_time));
+    g_variant_builder_add(&builder, "{sv}", "processing-time", g_variant_new_uint64(metrics->processing_time));
+
+    g_variant_builder_add(&builder, "{sv}", "read-ahead-hits", g_variant_new_uint64(read_ahead_hits));
+    g_variant_builder_add(&builder, "{sv}", "read-ahead-misses", g_variant_new_uint64(read_ahead_misses));
+
+    g_variant_builder_add(&builder, "{sv}", "cache-hits", g_variant_new_uint64(cache_hits));
+    g_variant_builder_add(&builder, "{sv}", "cache-misses", g_variant_new_uint64(cache_misses));
+    g_variant_builder_add(&builder, "{sv}", "cache-evictions", g_variant_new_uint64(cache_evictions));
+    g_variant_builder_add(&builder, "{sv}", "cache-size", g_variant_new_uint64(cache_size));
+
+    g_variant_builder_add(&builder, "{sv}", "response-hits", g_variant_new_uint64(response_hits));
+    g_variant_builder_add(&builder, "{sv}", "response-misses", g_variant_new_uint64(response_misses));
+
+    g_variant_builder_add(&builder, "{sv}", "audio-buffer-depth", g_variant_new_uint32(audio_buffer_depth));
+    g_variant_builder_add(&builder, "{sv}", "audio-buffer-size", g_variant_new_uint32(audio_buffer_size));
+    g_variant_builder_add(&builder, "{sv}", "audio-underruns", g_variant_new_uint64(audio_underruns));
+
+    g_variant_builder_add(&builder, "{sv}", "commands", cdemu_device_metrics_encode_opcodes(metrics));
+
+    g_free(metrics);
+
+    return g_variant_builder_end(&builder);
+}
@@ -27,6 +27,113 @@ struct _CdemuCommand
     guint in_len;
     guint8 *out;
     guint out_len;
+
+    /* Command in/out buffer positions */
+    guint in_pos;
+    guint out_pos;
+
+    /* Buffer/"cache" */
+    guint8 *buffer;
+    guint buffer_size;
+
+    /* Delay emulation */
+    gint64 delay_begin;
+    gint64 delay_amount;
+    gint64 delay_processing; /* Processing time measured by delay emulation */
+    gint64 delay_performed; /* Actual delay */
+
+    /* Number of sectors read or written; for metrics */
+    gint num_sectors;
+};
+
+/* Per-device metrics; see device-metrics.c */
+#define METRICS_NUM_BUCKETS 24
+
+typedef struct
+{
+    guint64 count;
+    guint64 errors;
+    guint64 total_time; /* Service time, in microseconds */
+    guint64 histogram[METRICS_NUM_BUCKETS]; /* log2 service time histogram */
+} CdemuOpcodeMetrics;
+
+typedef struct
+{
+    guint64 sectors_read;
+    guint64 sectors_written;
+    guint64 bytes_in;
+    guint64 bytes_out;
+
+    guint64 delayed_commands;
+    guint64 delay_time;
+    guint64 processing_time;
+
+    CdemuOpcodeMetrics opcodes[256];
+} CdemuMetrics;
+
+/* Memoized command responses; see device-responses.c */
+#define RESPONSE_CACHE_SIZE 16
+
+typedef struct
+{
+    /* Key */
+    guint8 cdb[12];
+    guint out_len;
+    gint state;
+
+    guint generation; /* Entry is valid only if it matches cache's generation */
+
+    guint8 *data;
+    guint length;
+    guint capacity;
+} CdemuResponseEntry;
+
+typedef struct
+{
+    guint generation;
+    gint next_entry;
+
+    guint64 hits;
+    guint64 misses;
+
+    CdemuResponseEntry entries[RESPONSE_CACHE_SIZE];
+} CdemuResponseCache;
+
+/* Subchannel metadata; see device-metadata.c */
+typedef struct
+{
+    gboolean scanned;
+    gboolean found;
+    guint8 q[16]; /* Mode-2 (MCN) or Mode-3 (ISRC) Q */
+} CdemuQMetadata;
+
+typedef struct
+{
+    CdemuQMetadata mcn;
+    CdemuQMetadata isrc[100]; /* Indexed by track number */
+
+    gint next_track; /* Index of next track to be pre-scanned */
+
+    guint8 bypass_q[16]; /* Result of a scan that bypassed the table */
+} CdemuSubchannelMetadata;
+
+/* Kernel I/O structures, also defined in VHBA module's source */
+#define MAX_COMMAND_SIZE 16
+
+struct vhba_request
+{
+    guint32 tag;
+    guint32 lun;
+    guint8 cdb[MAX_COMMAND_SIZE];
+    guint8 cdb_len;
+    guint32 data_len;
+};
+
+struct vhba_response
+{
+    guint32 tag;
+    guint32 status;
+    guint32 data_len;
 };
 
 struct _CdemuDevicePrivate
@@ -39,6 +146,11 @@ struct _CdemuDevicePrivate
     GMainLoop *main_loop;
     GSource *io_watch;
 
+    /* Serializes access to control device; VHBA module passes requests and
+       responses through a single per-device buffer, so the I/O thread and
+       command workers must not read from/write to it at the same time */
+    GMutex io_mutex;
+
     /* Device stuff */
     gint number;
     gchar *device_name;
@@ -48,19 +160,58 @@ struct _CdemuDevicePrivate
     /* Device mutex */
     GMutex *device_mutex;
 
-    /* Command */
-    CdemuCommand *cmd;
-    guint cmd_out_buffer_pos;
-    guint cmd_in_buffer_pos;
+    /* Command lock; held in shared mode by commands that do not modify
+       device state, and in exclusive mode by all others */
+    GRWLock command_lock;
 
-    /* Kernel I/O buffer */
-    guint8 *kernel_io_buffer;
+    /* Writer preference for command lock; see cdemu_device_command_lock_exclusive() */
+    GMutex command_gate_mutex;
+    GCond command_gate_cond;
+    gint exclusive_pending;
 
-    /* Buffer/"cache" */
-    guint8 *buffer;
-    guint buffer_size;
+    /* Outstanding requests */
+    GThreadPool *command_pool;
+    GAsyncQueue *idle_requests;
+    gint num_requests;
+
+    /* Delay emulation; emulated drive can only service one command at
+       a time, so delays of concurrently executed commands are queued
+       one after another instead of being performed in parallel */
+    GMutex delay_mutex;
+    gint64 delay_busy_until;
+
+    /* Buffer/"cache" capacity */
     guint buffer_capacity;
 
+    /* Read-ahead */
+    GThread *read_ahead_thread;
+    GCond read_ahead_cond;
+    gboolean read_ahead_quit;
+
+    gboolean read_ahead_enabled;
+    gint read_ahead_window_size;
+
+    GQueue read_ahead_window; /* Pre-read sectors, starting at read_ahead_start */
+    gint read_ahead_start;
+    gint read_ahead_end; /* Address at which window filling stops; -1 when idle */
+    gint read_ahead_last_address; /* End of last read request */
+
+    gint read_ahead_served;
+    guint64 read_ahead_hits;
+    guint64 read_ahead_misses;
+
+    /* Subchannel metadata */
+    gboolean metadata_prescan;
+    CdemuSubchannelMetadata metadata;
+
+    /* Metrics */
+    GMutex metrics_mutex;
+    CdemuMetrics *metrics;
+
+    /* Memoized command responses */
+    GMutex responses_mutex;
+    CdemuResponseCache *responses;
+
     /* Audio play */
     CdemuAudio *audio_play;
 
@@ -86,8 +237,6 @@ struct _CdemuDevicePrivate
     GList *features_list;
 
     /* Delay emulation */
-    gint64 delay_begin;
-    gint64 delay_amount;
     gdouble current_angle;
 
     gboolean dpm_emulation;
@@ -121,6 +270,7 @@ struct _CdemuDevicePrivate
 
     MirageSession *open_session;
     MirageTrack *open_track;
+    gboolean open_track_updating;
     gboolean last_session_closed;
     gboolean disc_closed;
 
@@ -141,7 +291,7 @@ struct _CdemuRecording
     gint (*get_next_writable_address) (CdemuDevice *self);
     gboolean (*close_track) (CdemuDevice *self);
     gboolean (*close_session) (CdemuDevice *self);
-    gboolean (*write_sectors) (CdemuDevice *self, gint start_address, gint num_sectors);
+    gboolean (*write_sectors) (CdemuDevice *self, CdemuCommand *cmd, gint start_address, gint num_sectors);
     gboolean (*reserve_track) (CdemuDevice *self, guint length);
 };
 
@@ -158,13 +308,31 @@ struct ModePageEntry
 #define GUINT24_FROM_BE(x) (GUINT32_FROM_BE(x) >> 8)
 #define GUINT24_TO_BE(x)   (GUINT32_TO_BE(x) >> 8)
 
+/* Command lock */
+void cdemu_device_command_lock_exclusive (CdemuDevice *self);
+void cdemu_device_command_unlock_exclusive (CdemuDevice *self);
+void cdemu_device_command_lock_shared (CdemuDevice *self);
+void cdemu_device_command_unlock_shared (CdemuDevice *self);
+
 /* Commands */
-gint cdemu_device_execute_command (CdemuDevice *self, const guint8 *cdb);
+gint cdemu_device_execute_command (CdemuDevice *self, CdemuCommand *cmd);
+const gchar *cdemu_device_get_command_name (guint8 opcode);
 void cdemu_device_dump_buffer (CdemuDevice *self, gint debug_level, const gchar *prefix, gint width, const guint8 *buffer, gint length);
 
 /* Delay emulation */
-void cdemu_device_delay_begin (CdemuDevice *self, gint address, gint num_sectors);
-void cdemu_device_delay_finalize (CdemuDevice *self);
+void cdemu_device_delay_begin (CdemuDevice *self, CdemuCommand *cmd, gint address, gint num_sectors);
+void cdemu_device_delay_finalize (CdemuDevice *self, CdemuCommand *cmd);
+
+/* Metrics */
+void cdemu_device_metrics_record (CdemuDevice *self, CdemuCommand *cmd, gint status, gint64 service_time);
+
+/* Memoized command responses */
+void cdemu_device_responses_init (CdemuDevice *self);
+void cdemu_device_responses_cleanup (CdemuDevice *self);
+void cdemu_device_responses_invalidate (CdemuDevice *self);
+gboolean cdemu_device_responses_lookup (CdemuDevice *self, CdemuCommand *cmd, gint state);
+void cdemu_device_responses_store (CdemuDevice *self, CdemuCommand *cmd, gint state);
+void cdemu_device_responses_get_statistics (CdemuDevice *self, guint64 *hits, guint64 *misses);
 
 /* Disc structure fabrication */
 gboolean cdemu_device_generate_disc_structure (CdemuDevice *self, gint layer, gint format, guint8 **structure_buffer, gint *structure_length);
@@ -178,12 +346,27 @@ void cdemu_device_set_profile (CdemuDevice *self, ProfileIndex profile_index);
 /* Kernel <-> userspace I/O */
 gsize cdemu_device_get_kernel_io_buffer_size (CdemuDevice *self);
 
-void cdemu_device_write_buffer (CdemuDevice *self, guint32 length);
-void cdemu_device_read_buffer (CdemuDevice *self, guint32 length);
-void cdemu_device_flush_buffer (CdemuDevice *self);
+void cdemu_device_write_buffer (CdemuDevice *self, CdemuCommand *cmd, guint32 length);
+void cdemu_device_read_buffer (CdemuDevice *self, CdemuCommand *cmd, guint32 length);
+void cdemu_device_flush_buffer (CdemuDevice *self, CdemuCommand *cmd);
+guint8 *cdemu_device_get_out_buffer (CdemuDevice *self, CdemuCommand *cmd, guint32 *available);
+void cdemu_device_commit_out_buffer (CdemuDevice *self, CdemuCommand *cmd, guint32 length);
+
+void cdemu_device_write_sense_full (CdemuDevice *self, CdemuCommand *cmd, SenseKey sense_key, guint16 asc_ascq, gint ili, guint32 command_info);
+void cdemu_device_write_sense (CdemuDevice *self, CdemuCommand *cmd, SenseKey sense_key, guint16 asc_ascq);
+
+/* Read-ahead */
+gboolean cdemu_device_read_ahead_start (CdemuDevice *self);
+void cdemu_device_read_ahead_stop (CdemuDevice *self);
+void cdemu_device_read_ahead_reset (CdemuDevice *self);
+MirageSector *cdemu_device_read_ahead_take_sector (CdemuDevice *self, gint address);
+void cdemu_device_read_ahead_schedule (CdemuDevice *self, gint start_address, gint num_sectors);
 
-void cdemu_device_write_sense_full (CdemuDevice *self, SenseKey sense_key, guint16 asc_ascq, gint ili, guint32 command_info);
-void cdemu_device_write_sense (CdemuDevice *self, SenseKey sense_key, guint16 asc_ascq);
+/* Subchannel metadata */
+void cdemu_device_metadata_reset (CdemuDevice *self);
+const guint8 *cdemu_device_metadata_get_mcn (CdemuDevice *self);
+const guint8 *cdemu_device_metadata_get_isrc (CdemuDevice *self, MirageTrack *track);
+gboolean cdemu_device_metadata_scan_next (CdemuDevice *self);
 
 /* Load/unload */
 gboolean cdemu_device_unload_disc_private (CdemuDevice *self, GError **error);
@@ -197,6 +380,7 @@ gboolean cdemu_device_modify_mode_page (CdemuDevice *self, const guint8 *new_dat
 /* Recording */
 gboolean cdemu_device_sao_recording_parse_cue_sheet (CdemuDevice *self, const guint8 *cue_sheet, gint cue_sheet_size);
 void cdemu_device_recording_set_mode (CdemuDevice *self, gint mode);
+void cdemu_device_recording_commit_layout (CdemuDevice *self);
 
 
 #endif /* __CDEMU_DEVICE_PRIVATE_H__ */
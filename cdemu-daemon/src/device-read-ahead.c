@@ -0,0 +1,226 @@
+/*
+ *  CDEmu daemon: device - read-ahead
+ *  Copyright (C) 2006-2014 Rok Mandeljc
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "cdemu.h"
+#include "device-private.h"
+
+#define __debug__ "Read-ahead"
+
+
+/* The read-ahead engine keeps a window of pre-read sectors that directly
+   follows the last sector of a sequential READ (10), READ (12) or READ CD
+   request. The window is filled by a worker thread in the time between
+   two requests (i.e., while the response travels to the kernel and the
+   application processes it), so that the next request in the sequence can
+   be served from memory.
+
+   All disc access within the daemon is serialized by the device mutex;
+   the worker thread adheres to this and holds the mutex while reading
+   a sector. It drops the mutex after each sector, so an incoming command
+   is never kept waiting for more than a single sector read. The window
+   itself, as well as all other read-ahead fields, are also protected by
+   the device mutex. Sectors in the window are acquired from the disc's
+   sector pool; once taken out of the window, they are owned by the caller,
+   which releases them back to the pool as usual.
+
+   When there is nothing to read ahead, the worker thread performs the
+   subchannel metadata pre-scan (see device-metadata.c) instead. */
+
+
+/**********************************************************************\
+ *                          Window handling                           *
+\**********************************************************************/
+static void cdemu_device_read_ahead_clear_window (CdemuDevice *self)
+{
+    MirageSector *sector;
+
+    while ((sector = g_queue_pop_head(&self->priv->read_ahead_window))) {
+        mirage_disc_release_sector(self->priv->disc, sector);
+    }
+
+    self->priv->read_ahead_start = 0;
+    self->priv->read_ahead_end = -1;
+}
+
+
+/**********************************************************************\
+ *                            Worker thread                           *
+\**********************************************************************/
+static gpointer cdemu_device_read_ahead_thread (CdemuDevice *self)
+{
+    CDEMU_DEBUG(self, DAEMON_DEBUG_DEVICE, "%s: read-ahead thread started\n", __debug__);
+
+    g_mutex_lock(self->priv->device_mutex);
+
+    while (!self->priv->read_ahead_quit) {
+        GError *local_error = NULL;
+        MirageSector *sector;
+        gint address;
+
+        /* Wait until there is something to read; in the meantime, pre-scan
+           subchannel metadata, one entry at a time */
+        if (!self->priv->read_ahead_enabled || !self->priv->loaded || self->priv->read_ahead_end < 0) {
+            if (cdemu_device_metadata_scan_next(self)) {
+                g_mutex_unlock(self->priv->device_mutex);
+                g_thread_yield();
+                g_mutex_lock(self->priv->device_mutex);
+            } else {
+                g_cond_wait(&self->priv->read_ahead_cond, self->priv->device_mutex);
+            }
+            continue;
+        }
+
+        address = self->priv->read_ahead_start + g_queue_get_length(&self->priv->read_ahead_window);
+        if (address >= self->priv->read_ahead_end) {
+            /* Window is full */
+            self->priv->read_ahead_end = -1;
+            continue;
+        }
+
+        /* Read next sector */
+        sector = mirage_disc_acquire_sector(self->priv->disc);
+        if (!mirage_disc_read_sector(self->priv->disc, address, sector, &local_error)) {
+            /* Most likely we ran past the end of the disc; stop here and
+               let the actual read command handle (and report) the error */
+            CDEMU_DEBUG(self, DAEMON_DEBUG_DEVICE, "%s: failed to read sector 0x%X: %s; stopping read-ahead\n", __debug__, address, local_error->message);
+            g_error_free(local_error);
+            mirage_disc_release_sector(self->priv->disc, sector);
+            self->priv->read_ahead_end = -1;
+            continue;
+        }
+
+        g_queue_push_tail(&self->priv->read_ahead_window, sector);
+
+        /* Give pending command a chance to grab the mutex */
+        g_mutex_unlock(self->priv->device_mutex);
+        g_thread_yield();
+        g_mutex_lock(self->priv->device_mutex);
+    }
+
+    g_mutex_unlock(self->priv->device_mutex);
+
+    CDEMU_DEBUG(self, DAEMON_DEBUG_DEVICE, "%s: read-ahead thread finished\n", __debug__);
+
+    return NULL;
+}
+
+
+/**********************************************************************\
+ *                          Read-ahead API                            *
+\**********************************************************************/
+gboolean cdemu_device_read_ahead_start (CdemuDevice *self)
+{
+    GError *local_error = NULL;
+
+    self->priv->read_ahead_quit = FALSE;
+    self->priv->read_ahead_thread = g_thread_try_new("CDEmu Device Read-ahead thread", (GThreadFunc)cdemu_device_read_ahead_thread, self, &local_error);
+    if (!self->priv->read_ahead_thread) {
+        CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to start read-ahead thread: %s\n", __debug__, local_error->message);
+        g_error_free(local_error);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+void cdemu_device_read_ahead_stop (CdemuDevice *self)
+{
+    if (!self->priv->read_ahead_thread) {
+        return;
+    }
+
+    g_mutex_lock(self->priv->device_mutex);
+    self->priv->read_ahead_quit = TRUE;
+    g_cond_signal(&self->priv->read_ahead_cond);
+    g_mutex_unlock(self->priv->device_mutex);
+
+    /* Wait for the thread to finish (also releases the reference
+       to thread object) */
+    g_thread_join(self->priv->read_ahead_thread);
+    self->priv->read_ahead_thread = NULL;
+}
+
+/* NOTE: functions below expect the device mutex to be held by the caller */
+void cdemu_device_read_ahead_reset (CdemuDevice *self)
+{
+    cdemu_device_read_ahead_clear_window(self);
+    self->priv->read_ahead_last_address = -1;
+    self->priv->read_ahead_served = 0;
+}
+
+MirageSector *cdemu_device_read_ahead_take_sector (CdemuDevice *self, gint address)
+{
+    GQueue *window = &self->priv->read_ahead_window;
+
+    if (!self->priv->read_ahead_enabled) {
+        return NULL;
+    }
+
+    /* Drop sectors that were skipped over */
+    while (!g_queue_is_empty(window) && self->priv->read_ahead_start < address) {
+        mirage_disc_release_sector(self->priv->disc, g_queue_pop_head(window));
+        self->priv->read_ahead_start++;
+    }
+
+    if (!g_queue_is_empty(window) && self->priv->read_ahead_start == address) {
+        self->priv->read_ahead_start++;
+        self->priv->read_ahead_served++;
+        return g_queue_pop_head(window);
+    }
+
+    return NULL;
+}
+
+void cdemu_device_read_ahead_schedule (CdemuDevice *self, gint start_address, gint num_sectors)
+{
+    gint end_address = start_address + num_sectors;
+    gboolean sequential;
+
+    if (!self->priv->read_ahead_enabled) {
+        return;
+    }
+
+    /* Update statistics */
+    self->priv->read_ahead_served = MIN(self->priv->read_ahead_served, num_sectors);
+    self->priv->read_ahead_hits += self->priv->read_ahead_served;
+    self->priv->read_ahead_misses += num_sectors - self->priv->read_ahead_served;
+    self->priv->read_ahead_served = 0;
+
+    /* Read-ahead is triggered only by a request that directly follows the
+       previous one; random access invalidates the window */
+    sequential = (start_address == self->priv->read_ahead_last_address);
+    self->priv->read_ahead_last_address = end_address;
+
+    if (!sequential) {
+        cdemu_device_read_ahead_clear_window(self);
+        return;
+    }
+
+    /* Move the window to the end of current request, keeping the sectors
+       that have already been read past it */
+    if (g_queue_is_empty(&self->priv->read_ahead_window) || self->priv->read_ahead_start != end_address) {
+        cdemu_device_read_ahead_clear_window(self);
+        self->priv->read_ahead_start = end_address;
+    }
+    self->priv->read_ahead_end = end_address + self->priv->read_ahead_window_size;
+
+    CDEMU_DEBUG(self, DAEMON_DEBUG_DEVICE, "%s: sequential access; reading ahead sectors 0x%X-0x%X (%d already in window)\n", __debug__, end_address, self->priv->read_ahead_end - 1, g_queue_get_length(&self->priv->read_ahead_window));
+
+    g_cond_signal(&self->priv->read_ahead_cond);
+}
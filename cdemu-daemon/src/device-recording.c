@@ -26,6 +26,14 @@
 \**********************************************************************/
 #define __debug__ "Recording"
 
+void cdemu_device_recording_commit_layout (CdemuDevice *self)
+{
+    if (self->priv->open_track_updating) {
+        mirage_track_layout_commit_update(self->priv->open_track);
+        self->priv->open_track_updating = FALSE;
+    }
+}
+
 static gboolean cdemu_device_recording_write_sector (CdemuDevice *self, MirageSector *sector)
 {
     GError *local_error = NULL;
@@ -53,6 +61,14 @@ static gboolean cdemu_device_recording_write_sector (CdemuDevice *self, MirageSe
         CDEMU_DEBUG_PRINT_BUFFER(self, DAEMON_DEBUG_RECORDING, __debug__, 16, data, 16);
     }
 
+    /* Sectors written by a single command are appended within a batched
+       layout update, which is committed at the end of the command (or when
+       the track is closed) */
+    if (!self->priv->open_track_updating) {
+        mirage_track_layout_begin_update(self->priv->open_track);
+        self->priv->open_track_updating = TRUE;
+    }
+
     /* Put sector to track */
     if (!mirage_track_put_sector(self->priv->open_track, sector, &local_error)) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to write sector to track: %s!\n", __debug__, local_error->message);
@@ -68,6 +84,9 @@ static gboolean cdemu_device_recording_close_track (CdemuDevice *self)
     if (self->priv->open_track) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_RECORDING, "%s: closing track\n", __debug__);
 
+        /* Commit pending layout update */
+        cdemu_device_recording_commit_layout(self);
+
         /* Release the reference we hold */
         g_object_unref(self->priv->open_track);
         self->priv->open_track = NULL;
@@ -363,7 +382,7 @@ static gboolean cdemu_device_tao_recording_write_sector (CdemuDevice *self, Mira
     return TRUE;
 }
 
-static gboolean cdemu_device_tao_recording_write_sectors (CdemuDevice *self, gint start_address, gint num_sectors)
+static gboolean cdemu_device_tao_recording_write_sectors (CdemuDevice *self, CdemuCommand *cmd, gint start_address, gint num_sectors)
 {
     const struct ModePage_0x05 *p_0x05 = cdemu_device_get_mode_page(self, 0x05, MODE_PAGE_CURRENT);
     gboolean is_cd_rom = mirage_disc_get_medium_type(self->priv->disc) == MIRAGE_MEDIUM_CD;
@@ -388,7 +407,7 @@ static gboolean cdemu_device_tao_recording_write_sectors (CdemuDevice *self, gin
         CDEMU_DEBUG(self, DAEMON_DEBUG_RECORDING, "%s: sector %d\n", __debug__, address);
 
         /* Read data from host */
-        cdemu_device_read_buffer(self, format->main_size + format->subchannel_size);
+        cdemu_device_read_buffer(self, cmd, format->main_size + format->subchannel_size);
 
         /* If we have a track open, we have already determined sector
            type and do not have to do it again */
@@ -397,7 +416,7 @@ static gboolean cdemu_device_tao_recording_write_sectors (CdemuDevice *self, gin
         }
 
         /* Feed sector data */
-        if (!mirage_sector_feed_data(sector, address, sector_type, self->priv->buffer, format->main_size, format->subchannel_format, self->priv->buffer + format->main_size, format->subchannel_size, 0, &local_error)) {
+        if (!mirage_sector_feed_data(sector, address, sector_type, cmd->buffer, format->main_size, format->subchannel_format, cmd->buffer + format->main_size, format->subchannel_size, 0, &local_error)) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to feed sector for writing: %s!\n", __debug__, local_error->message);
             g_error_free(local_error);
             local_error = NULL;
@@ -595,7 +614,7 @@ static gboolean cdemu_device_raw_recording_write_sector (CdemuDevice *self, gint
     return TRUE;
 }
 
-static gboolean cdemu_device_raw_recording_write_sectors (CdemuDevice *self, gint start_address, gint num_sectors)
+static gboolean cdemu_device_raw_recording_write_sectors (CdemuDevice *self, CdemuCommand *cmd, gint start_address, gint num_sectors)
 {
     MirageSector *sector = g_object_new(MIRAGE_TYPE_SECTOR, NULL);
 
@@ -610,10 +629,10 @@ static gboolean cdemu_device_raw_recording_write_sectors (CdemuDevice *self, gin
         CDEMU_DEBUG(self, DAEMON_DEBUG_RECORDING, "%s: sector %d\n", __debug__, address);
 
         /* Read data from host */
-        cdemu_device_read_buffer(self, format->main_size + format->subchannel_size);
+        cdemu_device_read_buffer(self, cmd, format->main_size + format->subchannel_size);
 
         /* Feed the sector; in raw recording, sectors are scrambled and raw */
-        if (!mirage_sector_feed_data(sector, address, MIRAGE_SECTOR_RAW_SCRAMBLED, self->priv->buffer, format->main_size, format->subchannel_format, self->priv->buffer + format->main_size, format->subchannel_size, 0, &local_error)) {
+        if (!mirage_sector_feed_data(sector, address, MIRAGE_SECTOR_RAW_SCRAMBLED, cmd->buffer, format->main_size, format->subchannel_format, cmd->buffer + format->main_size, format->subchannel_size, 0, &local_error)) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to feed sector for writing: %s!\n", __debug__, local_error->message);
             g_error_free(local_error);
             local_error = NULL;
@@ -811,12 +830,12 @@ static gboolean cdemu_device_sao_recording_open_track (CdemuDevice *self)
     return TRUE;
 }
 
-static gboolean cdemu_device_sao_recording_write_sectors (CdemuDevice *self, gint start_address, gint num_sectors)
+static gboolean cdemu_device_sao_recording_write_sectors (CdemuDevice *self, CdemuCommand *cmd, gint start_address, gint num_sectors)
 {
     /* We need a valid CUE sheet */
     if (!self->priv->cue_sheet) {
         CDEMU_DEBUG(self, DAEMON_DEBUG_RECORDING, "%s: CUE sheet not set!\n", __debug__);
-        cdemu_device_write_sense(self, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
+        cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
         return FALSE;
     }
 
@@ -841,10 +860,10 @@ static gboolean cdemu_device_sao_recording_write_sectors (CdemuDevice *self, gin
             main_format_ptr = sao_main_formats_find(self->priv->sao_leadin_format);
             subchannel_format_ptr = sao_subchannel_formats_find(self->priv->sao_leadin_format);
 
-            cdemu_device_read_buffer(self, main_format_ptr->data_size + subchannel_format_ptr->data_size);
+            cdemu_device_read_buffer(self, cmd, main_format_ptr->data_size + subchannel_format_ptr->data_size);
 
             /* Feed the sector */
-            if (!mirage_sector_feed_data(sector, address, MIRAGE_SECTOR_AUDIO, self->priv->buffer, main_format_ptr->data_size, subchannel_format_ptr->mode, self->priv->buffer + main_format_ptr->data_size, subchannel_format_ptr->data_size, main_format_ptr->ignore_data, &local_error)) {
+            if (!mirage_sector_feed_data(sector, address, MIRAGE_SECTOR_AUDIO, cmd->buffer, main_format_ptr->data_size, subchannel_format_ptr->mode, cmd->buffer + main_format_ptr->data_size, subchannel_format_ptr->data_size, main_format_ptr->ignore_data, &local_error)) {
                 CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to feed sector for writing: %s!\n", __debug__, local_error->message);
                 g_error_free(local_error);
                 local_error = NULL;
@@ -867,7 +886,7 @@ static gboolean cdemu_device_sao_recording_write_sectors (CdemuDevice *self, gin
             self->priv->cue_entry = mirage_session_get_track_by_address(self->priv->cue_sheet, address, NULL);
             if (!self->priv->cue_entry) {
                 CDEMU_DEBUG(self, DAEMON_DEBUG_RECORDING, "%s: failed to find track entry in CUE sheet for address %d!\n", __debug__, address);
-                cdemu_device_write_sense(self, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
+                cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
                 succeeded = FALSE;
                 goto finish;
             }
@@ -899,7 +918,7 @@ static gboolean cdemu_device_sao_recording_write_sectors (CdemuDevice *self, gin
             cue_fragment = mirage_track_get_fragment_by_address(self->priv->cue_entry, address - track_start, NULL);
             if (!cue_fragment) {
                 CDEMU_DEBUG(self, DAEMON_DEBUG_RECORDING, "%s: failed to find fragment entry in CUE track entry for address %d!\n", __debug__, address);
-                cdemu_device_write_sense(self, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
+                cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
                 succeeded = FALSE;
                 goto finish;
             }
@@ -917,20 +936,20 @@ static gboolean cdemu_device_sao_recording_write_sectors (CdemuDevice *self, gin
         /* Make sure we have data format descriptors set */
         if (!main_format_ptr|| !subchannel_format_ptr) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_RECORDING, "%s: data format not set!\n", __debug__);
-            cdemu_device_write_sense(self, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
+            cdemu_device_write_sense(self, cmd, ILLEGAL_REQUEST, COMMAND_SEQUENCE_ERROR);
             succeeded = FALSE;
             goto finish;
         }
 
         /* Read data from host */
-        cdemu_device_read_buffer(self, main_format_ptr->data_size + subchannel_format_ptr->data_size);
+        cdemu_device_read_buffer(self, cmd, main_format_ptr->data_size + subchannel_format_ptr->data_size);
 
         /* Get sector type from CUE entry instead of main_format_ptr, as
            it is more accurate, especially in case of RAW SAO recording */
         gint sector_type = mirage_track_get_sector_type(self->priv->cue_entry);
 
         /* Feed the sector */
-        if (!mirage_sector_feed_data(sector, address, sector_type, self->priv->buffer, main_format_ptr->data_size, subchannel_format_ptr->mode, self->priv->buffer + main_format_ptr->data_size, subchannel_format_ptr->data_size, main_format_ptr->ignore_data, &local_error)) {
+        if (!mirage_sector_feed_data(sector, address, sector_type, cmd->buffer, main_format_ptr->data_size, subchannel_format_ptr->mode, cmd->buffer + main_format_ptr->data_size, subchannel_format_ptr->data_size, main_format_ptr->ignore_data, &local_error)) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to feed sector for writing: %s!\n", __debug__, local_error->message);
             g_error_free(local_error);
             local_error = NULL;
@@ -1264,7 +1283,7 @@ static gboolean cdemu_device_dao_recording_reserve_track (CdemuDevice *self, gui
     return TRUE;
 }
 
-static gboolean cdemu_device_dao_recording_write_sectors (CdemuDevice *self, gint start_address, gint num_sectors)
+static gboolean cdemu_device_dao_recording_write_sectors (CdemuDevice *self, CdemuCommand *cmd, gint start_address, gint num_sectors)
 {
     /* At this point, the track should already be open due to a call to
        RESERVE TRACK... if not, open one by reserving a track of length 0 */
@@ -1293,10 +1312,10 @@ static gboolean cdemu_device_dao_recording_write_sectors (CdemuDevice *self, gin
         CDEMU_DEBUG(self, DAEMON_DEBUG_RECORDING, "%s: sector %d\n", __debug__, address);
 
         /* Read data from host */
-        cdemu_device_read_buffer(self, 2048);
+        cdemu_device_read_buffer(self, cmd, 2048);
 
         /* Feed sector data */
-        if (!mirage_sector_feed_data(sector, address, MIRAGE_SECTOR_MODE1, self->priv->buffer, 2048, MIRAGE_SUBCHANNEL_NONE, NULL, 0, 0, &local_error)) {
+        if (!mirage_sector_feed_data(sector, address, MIRAGE_SECTOR_MODE1, cmd->buffer, 2048, MIRAGE_SUBCHANNEL_NONE, NULL, 0, 0, &local_error)) {
             CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to feed sector for writing: %s!\n", __debug__, local_error->message);
             g_error_free(local_error);
             local_error = NULL;
@@ -0,0 +1,176 @@
+/*
+ *  CDEmu daemon: device - memoized command responses
+ *  Copyright (C) 2006-2014 Rok Mandeljc
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "cdemu.h"
+#include "device-private.h"
+
+#define __debug__ "Responses"
+
+
+/* Hosts keep polling commands whose responses depend only on the CDB and
+   on the state of device and medium (TOC, disc and track information,
+   features, mode pages); these responses are memoized, keyed by the CDB,
+   the allocation length (size of the command's output buffer) and an
+   optional command-specific state value.
+
+   Whenever device or medium state changes, the cache's generation is
+   incremented, which invalidates all entries at once; their buffers are
+   reused by subsequent stores. All state changes are performed with the
+   command lock held exclusively, while the commands whose responses are
+   memoized hold it as well (in either mode); therefore, the generation
+   cannot change while such a command is being executed. The entries
+   themselves are protected by their own mutex, because some of memoized
+   commands are executed concurrently. */
+
+
+/**********************************************************************\
+ *                           Initialization                           *
+\**********************************************************************/
+void cdemu_device_responses_init (CdemuDevice *self)
+{
+    g_mutex_init(&self->priv->responses_mutex);
+    self->priv->responses = g_new0(CdemuResponseCache, 1);
+
+    /* Entries start at generation 0, so cache starts at 1 */
+    self->priv->responses->generation = 1;
+}
+
+void cdemu_device_responses_cleanup (CdemuDevice *self)
+{
+    if (self->priv->responses) {
+        for (gint i = 0; i < RESPONSE_CACHE_SIZE; i++) {
+            g_free(self->priv->responses->entries[i].data);
+        }
+        g_free(self->priv->responses);
+        self->priv->responses = NULL;
+    }
+
+    g_mutex_clear(&self->priv->responses_mutex);
+}
+
+void cdemu_device_responses_invalidate (CdemuDevice *self)
+{
+    g_mutex_lock(&self->priv->responses_mutex);
+    self->priv->responses->generation++;
+    g_mutex_unlock(&self->priv->responses_mutex);
+
+    CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: memoized responses invalidated\n", __debug__);
+}
+
+
+/**********************************************************************\
+ *                          Lookup and store                          *
+\**********************************************************************/
+static CdemuResponseEntry *cdemu_device_responses_find_entry (CdemuResponseCache *cache, const CdemuCommand *cmd, gint state)
+{
+    for (gint i = 0; i < RESPONSE_CACHE_SIZE; i++) {
+        CdemuResponseEntry *entry = &cache->entries[i];
+
+        if (entry->generation == cache->generation
+            && entry->out_len == cmd->out_len
+            && entry->state == state
+            && !memcmp(entry->cdb, cmd->cdb, sizeof(entry->cdb))) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+gboolean cdemu_device_responses_lookup (CdemuDevice *self, CdemuCommand *cmd, gint state)
+{
+    CdemuResponseCache *cache = self->priv->responses;
+    CdemuResponseEntry *entry;
+
+    g_mutex_lock(&self->priv->responses_mutex);
+
+    entry = cdemu_device_responses_find_entry(cache, cmd, state);
+    if (entry) {
+        /* Response is copied in its entirety; allocation length is part
+           of the key, so it fits */
+        memcpy(cmd->out, entry->data, entry->length);
+        cmd->out_pos = entry->length;
+        cache->hits++;
+    } else {
+        cache->misses++;
+    }
+
+    g_mutex_unlock(&self->priv->responses_mutex);
+
+    if (entry) {
+        CDEMU_DEBUG(self, DAEMON_DEBUG_MMC, "%s: returning memoized response (%d bytes)\n", __debug__, cmd->out_pos);
+    }
+
+    return entry != NULL;
+}
+
+void cdemu_device_responses_store (CdemuDevice *self, CdemuCommand *cmd, gint state)
+{
+    CdemuResponseCache *cache = self->priv->responses;
+    CdemuResponseEntry *entry = NULL;
+
+    g_mutex_lock(&self->priv->responses_mutex);
+
+    /* Another worker might have stored the same response in the meantime */
+    if (cdemu_device_responses_find_entry(cache, cmd, state)) {
+        g_mutex_unlock(&self->priv->responses_mutex);
+        return;
+    }
+
+    /* Prefer an invalidated entry; otherwise, replace them in round-robin
+       fashion */
+    for (gint i = 0; i < RESPONSE_CACHE_SIZE; i++) {
+        if (cache->entries[i].generation != cache->generation) {
+            entry = &cache->entries[i];
+            break;
+        }
+    }
+    if (!entry) {
+        entry = &cache->entries[cache->next_entry];
+        cache->next_entry = (cache->next_entry + 1) % RESPONSE_CACHE_SIZE;
+    }
+
+    /* Store the response; buffer is reused if it is large enough */
+    if (entry->capacity < cmd->out_pos) {
+        g_free(entry->data);
+        entry->data = g_malloc(cmd->out_pos);
+        entry->capacity = cmd->out_pos;
+    }
+    memcpy(entry->data, cmd->out, cmd->out_pos);
+    entry->length = cmd->out_pos;
+
+    memcpy(entry->cdb, cmd->cdb, sizeof(entry->cdb));
+    entry->out_len = cmd->out_len;
+    entry->state = state;
+    entry->generation = cache->generation;
+
+    g_mutex_unlock(&self->priv->responses_mutex);
+}
+
+
+/**********************************************************************\
+ *                             Statistics                             *
+\**********************************************************************/
+void cdemu_device_responses_get_statistics (CdemuDevice *self, guint64 *hits, guint64 *misses)
+{
+    g_mutex_lock(&self->priv->responses_mutex);
+    *hits = self->priv->responses->hits;
+    *misses = self->priv->responses->misses;
+    g_mutex_unlock(&self->priv->responses_mutex);
+}
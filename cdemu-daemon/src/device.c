@@ -49,7 +49,6 @@ gboolean cdemu_device_initialize (CdemuDevice *self, gint number, const gchar *a
 {
     MirageContext *context;
     GSource *source;
-    gint buffer_size;
 
     self->priv->mapping_complete = FALSE;
 
@@ -83,20 +82,19 @@ gboolean cdemu_device_initialize (CdemuDevice *self, gint number, const gchar *a
     mirage_contextual_set_context(MIRAGE_CONTEXTUAL(self), context);
     g_object_unref(context);
 
-    /* Allocate kernel I/O buffer */
-    buffer_size = cdemu_device_get_kernel_io_buffer_size(self);
-    self->priv->kernel_io_buffer = g_try_malloc0(buffer_size);
-    if (!self->priv->kernel_io_buffer) {
-        CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to allocate kernel I/O buffer (%d bytes)!\n", __debug__, buffer_size);
-        return FALSE;
-    }
+    /* Buffer/"cache" capacity; 4kB should be enough for everything, I think.
+       The buffers themselves are allocated per request slot, along with
+       kernel I/O buffers, in cdemu_device_start() */
+    self->priv->buffer_capacity = 4096;
 
-    /* Allocate buffer/"cache"; 4kB should be enough for everything, I think */
-    buffer_size = 4096;
-    self->priv->buffer_capacity = buffer_size;
-    self->priv->buffer = g_try_malloc0(buffer_size);
-    if (!self->priv->buffer) {
-        CDEMU_DEBUG(self, DAEMON_DEBUG_WARNING, "%s: failed to allocate cache buffer (%d bytes)!\n", __debug__, buffer_size);
+    /* Subchannel metadata pre-scan is enabled by default */
+    self->priv->metadata_prescan = TRUE;
+
+    /* Set up read-ahead; enabled by default, with 64 kB window */
+    self->priv->read_ahead_enabled = TRUE;
+    self->priv->read_ahead_window_size = 32;
+    cdemu_device_read_ahead_reset(self);
+    if (!cdemu_device_read_ahead_start(self)) {
         return FALSE;
     }
 
@@ -141,6 +139,51 @@ gint cdemu_device_get_device_number (CdemuDevice *self)
 }
 
 
+/**********************************************************************\
+ *                            Command lock                            *
+\**********************************************************************/
+/* GRWLock does not give writers preference over readers, so a continuous
+   stream of commands that hold command lock in shared mode (e.g., READ)
+   could indefinitely starve the ones that need it exclusively (e.g., load,
+   unload, MODE SELECT). Therefore, a pending exclusive lock holder stops
+   new shared lock holders from taking the lock until it acquires it */
+void cdemu_device_command_lock_exclusive (CdemuDevice *self)
+{
+    g_mutex_lock(&self->priv->command_gate_mutex);
+    self->priv->exclusive_pending++;
+    g_mutex_unlock(&self->priv->command_gate_mutex);
+
+    cdemu_device_command_lock_exclusive(self);
+
+    g_mutex_lock(&self->priv->command_gate_mutex);
+    if (!--self->priv->exclusive_pending) {
+        g_cond_broadcast(&self->priv->command_gate_cond);
+    }
+    g_mutex_unlock(&self->priv->command_gate_mutex);
+}
+
+void cdemu_device_command_unlock_exclusive (CdemuDevice *self)
+{
+    cdemu_device_command_unlock_exclusive(self);
+}
+
+void cdemu_device_command_lock_shared (CdemuDevice *self)
+{
+    g_mutex_lock(&self->priv->command_gate_mutex);
+    while (self->priv->exclusive_pending) {
+        g_cond_wait(&self->priv->command_gate_cond, &self->priv->command_gate_mutex);
+    }
+    g_mutex_unlock(&self->priv->command_gate_mutex);
+
+    cdemu_device_command_lock_shared(self);
+}
+
+void cdemu_device_command_unlock_shared (CdemuDevice *self)
+{
+    cdemu_device_command_unlock_shared(self);
+}
+
+
 /**********************************************************************\
  *                            Device status                           *
 \**********************************************************************/
@@ -195,6 +238,15 @@ GVariant *cdemu_device_get_option (CdemuDevice *self, gchar *option_name, GError
     } else if (!g_strcmp0(option_name, "device-id")) {
         /* *** device-id *** */
         option_value = g_variant_new("(ssss)", self->priv->id_vendor_id, self->priv->id_product_id, self->priv->id_revision, self->priv->id_vendor_specific);
+    } else if (!g_strcmp0(option_name, "read-ahead")) {
+        /* *** read-ahead *** */
+        option_value = g_variant_new("(bi)", self->priv->read_ahead_enabled, self->priv->read_ahead_window_size);
+    } else if (!g_strcmp0(option_name, "read-ahead-statistics")) {
+        /* *** read-ahead-statistics *** */
+        option_value = g_variant_new("(tt)", self->priv->read_ahead_hits, self->priv->read_ahead_misses);
+    } else if (!g_strcmp0(option_name, "subchannel-prescan")) {
+        /* *** subchannel-prescan *** */
+        option_value = g_variant_new("b", self->priv->metadata_prescan);
     } else if (!g_strcmp0(option_name, "daemon-debug-mask")) {
         /* *** daemon-debug-mask *** */
         MirageContext *context = mirage_contextual_get_context(MIRAGE_CONTEXTUAL(self));
@@ -223,7 +275,9 @@ gboolean cdemu_device_set_option (CdemuDevice *self, gchar *option_name, GVarian
 {
     gboolean succeeded = TRUE;
 
-    /* Lock */
+    /* Lock; options affect the data that is reported by commands
+       executed without device mutex */
+    cdemu_device_command_lock_exclusive(self);
     g_mutex_lock(self->priv->device_mutex);
 
     /* Get option */
@@ -275,6 +329,47 @@ gboolean cdemu_device_set_option (CdemuDevice *self, gchar *option_name, GVarian
             g_free(revision);
             g_free(vendor_specific);
         }
+    } else if (!g_strcmp0(option_name, "read-ahead")) {
+        /* *** read-ahead *** */
+        if (!g_variant_is_of_type(option_value, G_VARIANT_TYPE("(bi)"))) {
+            g_set_error(error, CDEMU_ERROR, CDEMU_ERROR_INVALID_ARGUMENT, Q_("Invalid argument type for option '%s'!"), option_name);
+            succeeded = FALSE;
+        } else {
+            gboolean enabled;
+            gint window_size;
+            g_variant_get(option_value, "(bi)", &enabled, &window_size);
+
+            if (window_size < 1 || window_size > 1024) {
+                g_set_error(error, CDEMU_ERROR, CDEMU_ERROR_INVALID_ARGUMENT, Q_("Invalid read-ahead window size %d; must be between 1 and 1024 sectors!"), window_size);
+                succeeded = FALSE;
+            } else {
+                /* Drop the current window; it will be re-filled using new
+                   settings on next sequential read */
+                cdemu_device_read_ahead_reset(self);
+                self->priv->read_ahead_enabled = enabled;
+                self->priv->read_ahead_window_size = window_size;
+            }
+        }
+    } else if (!g_strcmp0(option_name, "read-ahead-statistics")) {
+        /* *** read-ahead-statistics *** */
+        if (!g_variant_is_of_type(option_value, G_VARIANT_TYPE("(tt)"))) {
+            g_set_error(error, CDEMU_ERROR, CDEMU_ERROR_INVALID_ARGUMENT, Q_("Invalid argument type for option '%s'!"), option_name);
+            succeeded = FALSE;
+        } else {
+            /* Allows clients to reset the counters */
+            g_variant_get(option_value, "(tt)", &self->priv->read_ahead_hits, &self->priv->read_ahead_misses);
+        }
+    } else if (!g_strcmp0(option_name, "subchannel-prescan")) {
+        /* *** subchannel-prescan *** */
+        if (!g_variant_is_of_type(option_value, G_VARIANT_TYPE("b"))) {
+            g_set_error(error, CDEMU_ERROR, CDEMU_ERROR_INVALID_ARGUMENT, Q_("Invalid argument type for option '%s'!"), option_name);
+            succeeded = FALSE;
+        } else {
+            g_variant_get(option_value, "b", &self->priv->metadata_prescan);
+
+            /* Wake up the worker thread in case pre-scan got enabled */
+            g_cond_signal(&self->priv->read_ahead_cond);
+        }
     } else if (!g_strcmp0(option_name, "daemon-debug-mask")) {
         /* *** daemon-debug-mask *** */
         if (!g_variant_is_of_type(option_value, G_VARIANT_TYPE("i"))) {
@@ -306,8 +401,14 @@ gboolean cdemu_device_set_option (CdemuDevice *self, gchar *option_name, GVarian
         succeeded = FALSE;
     }
 
+    /* Options may affect memoized responses */
+    if (succeeded) {
+        cdemu_device_responses_invalidate(self);
+    }
+
     /* Unlock */
     g_mutex_unlock(self->priv->device_mutex);
+    cdemu_device_command_unlock_exclusive(self);
 
     /* Signal that option has been changed */
     if (succeeded) {
@@ -332,14 +433,35 @@ static void cdemu_device_init (CdemuDevice *self)
     self->priv->main_context = NULL;
     self->priv->main_loop = NULL;
     self->priv->io_watch = NULL;
+    g_mutex_init(&self->priv->io_mutex);
 
     self->priv->device_name = NULL;
     self->priv->device_serial = NULL;
 
     self->priv->device_mutex = NULL;
 
-    self->priv->kernel_io_buffer = NULL;
-    self->priv->buffer = NULL;
+    g_rw_lock_init(&self->priv->command_lock);
+    g_mutex_init(&self->priv->command_gate_mutex);
+    g_cond_init(&self->priv->command_gate_cond);
+    self->priv->exclusive_pending = 0;
+
+    self->priv->command_pool = NULL;
+    self->priv->idle_requests = NULL;
+    self->priv->num_requests = 0;
+
+    g_mutex_init(&self->priv->delay_mutex);
+    self->priv->delay_busy_until = 0;
+
+    self->priv->read_ahead_thread = NULL;
+    g_cond_init(&self->priv->read_ahead_cond);
+    g_queue_init(&self->priv->read_ahead_window);
+    self->priv->read_ahead_hits = 0;
+    self->priv->read_ahead_misses = 0;
+
+    g_mutex_init(&self->priv->metrics_mutex);
+    self->priv->metrics = g_new0(CdemuMetrics, 1);
+
+    cdemu_device_responses_init(self);
 
     self->priv->audio_play = NULL;
 
@@ -374,6 +496,9 @@ static void cdemu_device_dispose (GObject *gobject)
     /* Stop the device */
     cdemu_device_stop(self);
 
+    /* Stop read-ahead thread */
+    cdemu_device_read_ahead_stop(self);
+
     /* Unload disc */
     self->priv->locked = FALSE; /* Make sure we can unload the disc */
     cdemu_device_unload_disc(self, NULL);
@@ -424,12 +549,6 @@ static void cdemu_device_finalize (GObject *gobject)
     g_free(self->priv->device_sg);
     g_free(self->priv->device_sr);
 
-    /* Free kernel I/O buffer */
-    g_free(self->priv->kernel_io_buffer);
-
-    /* Free buffer/"cache" */
-    g_free(self->priv->buffer);
-
     /* Free device name */
     g_free(self->priv->device_name);
 
@@ -442,6 +561,27 @@ static void cdemu_device_finalize (GObject *gobject)
     g_free(self->priv->id_revision);
     g_free(self->priv->id_vendor_specific);
 
+    /* Free delay emulation mutex */
+    g_mutex_clear(&self->priv->delay_mutex);
+
+    /* Free read-ahead condition */
+    g_cond_clear(&self->priv->read_ahead_cond);
+
+    /* Free metrics */
+    g_free(self->priv->metrics);
+    g_mutex_clear(&self->priv->metrics_mutex);
+
+    /* Free memoized responses */
+    cdemu_device_responses_cleanup(self);
+
+    /* Free control device mutex */
+    g_mutex_clear(&self->priv->io_mutex);
+
+    /* Free command lock */
+    g_rw_lock_clear(&self->priv->command_lock);
+    g_mutex_clear(&self->priv->command_gate_mutex);
+    g_cond_clear(&self->priv->command_gate_cond);
+
     /* Free mutex */
     g_mutex_clear(self->priv->device_mutex);
     g_free(self->priv->device_mutex);
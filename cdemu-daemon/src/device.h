@@ -67,10 +67,13 @@ gboolean cdemu_device_unload_disc (CdemuDevice *self, GError **error);
 GVariant *cdemu_device_get_option (CdemuDevice *self, gchar *option_name, GError **error);
 gboolean cdemu_device_set_option (CdemuDevice *self, gchar *option_name, GVariant *option_value, GError **error);
 
+GVariant *cdemu_device_get_metrics (CdemuDevice *self);
+
 gboolean cdemu_device_setup_mapping (CdemuDevice *self);
 void cdemu_device_get_mapping (CdemuDevice *self, gchar **sr_device, gchar **sg_device);
 
 gboolean cdemu_device_start (CdemuDevice *self, const gchar *ctl_device);
+gboolean cdemu_device_start_with_fd (CdemuDevice *self, gint fd);
 void cdemu_device_stop (CdemuDevice *self);
 
 G_END_DECLS
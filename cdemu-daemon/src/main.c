@@ -30,6 +30,7 @@ static gchar *bus = "session";
 static gchar *log_filename = NULL;
 static guint cdemu_debug_mask = 0;
 static guint mirage_debug_mask = 0;
+static guint metrics_interval = 0;
 
 static GOptionEntry option_entries[] = {
     { "num-devices", 'n', 0, G_OPTION_ARG_INT, &num_devices, N_("Number of devices"), N_("N") },
@@ -39,6 +40,7 @@ static GOptionEntry option_entries[] = {
     { "logfile", 'l', 0, G_OPTION_ARG_STRING, &log_filename, N_("Logfile"), N_("logfile") },
     { "default-cdemu-debug-mask", 0, 0, G_OPTION_ARG_INT, &cdemu_debug_mask, N_("Default debug mask for CDEmu devices"), N_("mask") },
     { "default-mirage-debug-mask", 0, 0, G_OPTION_ARG_INT, &mirage_debug_mask, N_("Default debug mask for underlying libMirage"), N_("mask") },
+    { "metrics-interval", 'm', 0, G_OPTION_ARG_INT, &metrics_interval, N_("Interval of device metrics signal, in seconds (0 disables it)"), N_("seconds") },
     { NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL }
 };
 
@@ -134,6 +136,7 @@ int main (int argc, char **argv)
     g_message(Q_(" - bus type: %s\n"), bus);
     g_message(Q_(" - default CDEmu debug mask: 0x%X\n"), cdemu_debug_mask);
     g_message(Q_(" - default libMirage debug mask: 0x%X\n"), mirage_debug_mask);
+    g_message(Q_(" - metrics interval: %u s\n"), metrics_interval);
     g_message("\n");
 
     /* Decipher bus type */
@@ -159,7 +162,7 @@ int main (int argc, char **argv)
     setup_signal_trap();
 
     /* Initialize and start daemon */
-    if (cdemu_daemon_initialize_and_start(daemon_obj, num_devices, ctl_device, audio_driver, use_system_bus, cdemu_debug_mask, mirage_debug_mask)) {
+    if (cdemu_daemon_initialize_and_start(daemon_obj, num_devices, ctl_device, audio_driver, use_system_bus, cdemu_debug_mask, mirage_debug_mask, metrics_interval)) {
         /* Printed when daemon stops */
         g_message(Q_("Stopping daemon.\n"));
     } else {
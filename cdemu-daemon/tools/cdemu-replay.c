@@ -0,0 +1,780 @@
+/*
+ *  CDEmu daemon: SCSI command replay harness
+ *  Copyright (C) 2006-2014 Rok Mandeljc
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* Loads an image into a CDEmu device and replays a SCSI command trace
+   against it, without the VHBA kernel module. The trace is either read
+   from a file or synthesized from one of the built-in workloads (e.g.,
+   an installer's READ (10) mix or a CD ripper's READ CD stream).
+
+   In "pipe" mode (default), the device is started on one end of a
+   SOCK_SEQPACKET socket pair that stands in for the VHBA control device;
+   the harness writes vhba_request messages to the other end and collects
+   vhba_response messages, keeping up to --queue-depth requests in flight.
+   This exercises the complete kernel I/O path, including request slots
+   and the command worker pool. In "direct" mode, commands are executed
+   one at a time via cdemu_device_execute_command().
+
+   For each opcode, the number of commands, failures, transferred bytes,
+   latency percentiles and a log2 latency histogram are reported.
+
+   Trace file format: one command per line, given as hexadecimal CDB bytes
+   followed by "len=N" (data transfer length in bytes; defaults to 0).
+   Empty lines and everything following a '#' are ignored. Example:
+
+     28 00 00 00 10 00 00 00 20 00 len=65536  # READ (10), 32 sectors */
+
+#include "cdemu.h"
+#include "device-private.h"
+
+#include <string.h>
+#include <sys/socket.h>
+
+
+/* Maximum number of commands in flight in pipe mode; matches the number
+   of request slots in the device, and stays below the socket's default
+   datagram queue length (net.unix.max_dgram_qlen), so that the device
+   never has to wait for us to pick up a response */
+#define MAX_QUEUE_DEPTH 8
+
+/* Number of log2 latency histogram buckets; bucket 0 holds latencies below
+   1 µs, bucket N latencies in [2^(N-1), 2^N) µs */
+#define NUM_BUCKETS 32
+
+
+/**********************************************************************\
+ *                              Options                               *
+\**********************************************************************/
+static gchar *workload = NULL;
+static gchar *trace_file = NULL;
+static gchar *save_trace_file = NULL;
+static gint num_commands = 10000;
+static gint transfer_length = 0;
+static gint seed = 0;
+static gint queue_depth = 4;
+static gchar *mode = NULL;
+static gint cdemu_debug_mask = 0;
+static gint mirage_debug_mask = 0;
+static gchar **filenames = NULL;
+
+/* Size of the device's kernel I/O buffer; bounds request and response size */
+static gsize io_buffer_size = 0;
+
+static GOptionEntry option_entries[] = {
+    { "workload", 'w', 0, G_OPTION_ARG_STRING, &workload, "Synthesized workload (read10-seq, read10-random, readcd-seq, installer; default: read10-seq)", "WORKLOAD" },
+    { "trace", 't', 0, G_OPTION_ARG_FILENAME, &trace_file, "Replay commands from trace file instead of synthesized workload", "FILE" },
+    { "save-trace", 'o', 0, G_OPTION_ARG_FILENAME, &save_trace_file, "Save the replayed command trace to file", "FILE" },
+    { "count", 'n', 0, G_OPTION_ARG_INT, &num_commands, "Number of commands in synthesized workload (default: 10000)", "N" },
+    { "transfer", 'l', 0, G_OPTION_ARG_INT, &transfer_length, "Transfer length in sectors for synthesized reads (default: 32 for READ (10), 26 for READ CD)", "SECTORS" },
+    { "seed", 's', 0, G_OPTION_ARG_INT, &seed, "Seed for synthesized workloads (default: 0)", "SEED" },
+    { "queue-depth", 'q', 0, G_OPTION_ARG_INT, &queue_depth, "Maximum number of commands in flight in pipe mode (default: 4, max: 8)", "N" },
+    { "mode", 'm', 0, G_OPTION_ARG_STRING, &mode, "Command submission mode (pipe, direct; default: pipe)", "MODE" },
+    { "cdemu-debug-mask", 'c', 0, G_OPTION_ARG_INT, &cdemu_debug_mask, "CDEmu debug mask (default: 0)", "MASK" },
+    { "mirage-debug-mask", 'd', 0, G_OPTION_ARG_INT, &mirage_debug_mask, "libMirage debug mask (default: 0)", "MASK" },
+    { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &filenames, NULL, "IMAGE_FILE..." },
+    { NULL }
+};
+
+
+/**********************************************************************\
+ *                             Command trace                          *
+\**********************************************************************/
+typedef struct
+{
+    guint8 cdb[MAX_COMMAND_SIZE];
+    guint8 cdb_len;
+    guint32 data_len;
+} TraceCommand;
+
+static void trace_append (GArray *trace, const guint8 *cdb, guint8 cdb_len, guint32 data_len)
+{
+    TraceCommand command;
+
+    memset(&command, 0, sizeof(command));
+    memcpy(command.cdb, cdb, cdb_len);
+    command.cdb_len = cdb_len;
+    command.data_len = data_len;
+
+    g_array_append_val(trace, command);
+}
+
+static GArray *trace_load (const gchar *filename, GError **error)
+{
+    GArray *trace;
+    gchar *contents;
+    gchar **lines;
+
+    if (!g_file_get_contents(filename, &contents, NULL, error)) {
+        return NULL;
+    }
+
+    trace = g_array_new(FALSE, FALSE, sizeof(TraceCommand));
+    lines = g_strsplit(contents, "\n", -1);
+    g_free(contents);
+
+    for (gint i = 0; lines[i]; i++) {
+        gchar *comment = strchr(lines[i], '#');
+        gchar **tokens;
+        guint8 cdb[MAX_COMMAND_SIZE];
+        guint8 cdb_len = 0;
+        guint32 data_len = 0;
+        gboolean valid = TRUE;
+
+        if (comment) {
+            *comment = '\0';
+        }
+
+        tokens = g_strsplit_set(g_strstrip(lines[i]), " \t", -1);
+        for (gint j = 0; tokens[j] && valid; j++) {
+            gchar *endptr;
+
+            if (!tokens[j][0]) {
+                continue;
+            }
+
+            if (g_str_has_prefix(tokens[j], "len=")) {
+                guint64 value = g_ascii_strtoull(tokens[j] + 4, &endptr, 0);
+                valid = !*endptr && value <= io_buffer_size - sizeof(struct vhba_response);
+                data_len = value;
+            } else {
+                guint64 value = g_ascii_strtoull(tokens[j], &endptr, 16);
+                valid = !*endptr && value <= 0xFF && cdb_len < MAX_COMMAND_SIZE;
+                if (valid) {
+                    cdb[cdb_len++] = value;
+                }
+            }
+        }
+        g_strfreev(tokens);
+
+        if (!valid) {
+            g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s:%d: invalid trace line", filename, i + 1);
+            g_strfreev(lines);
+            g_array_free(trace, TRUE);
+            return NULL;
+        }
+
+        if (cdb_len) {
+            trace_append(trace, cdb, cdb_len, data_len);
+        }
+    }
+
+    g_strfreev(lines);
+
+    return trace;
+}
+
+static gboolean trace_save (GArray *trace, const gchar *filename, GError **error)
+{
+    GString *contents = g_string_new(NULL);
+    gboolean succeeded;
+
+    for (guint i = 0; i < trace->len; i++) {
+        const TraceCommand *command = &g_array_index(trace, TraceCommand, i);
+        const gchar *name = cdemu_device_get_command_name(command->cdb[0]);
+
+        for (gint j = 0; j < command->cdb_len; j++) {
+            g_string_append_printf(contents, "%02X ", command->cdb[j]);
+        }
+        g_string_append_printf(contents, "len=%u", command->data_len);
+        if (name) {
+            g_string_append_printf(contents, "  # %s", name);
+        }
+        g_string_append_c(contents, '\n');
+    }
+
+    succeeded = g_file_set_contents(filename, contents->str, contents->len, error);
+    g_string_free(contents, TRUE);
+
+    return succeeded;
+}
+
+
+/**********************************************************************\
+ *                        Synthesized workloads                       *
+\**********************************************************************/
+static void append_read10 (GArray *trace, guint32 address, guint16 length)
+{
+    guint8 cdb[10] = { READ_10, 0, address >> 24, address >> 16, address >> 8, address, 0, length >> 8, length, 0 };
+    trace_append(trace, cdb, sizeof(cdb), length * 2048);
+}
+
+static void append_read_cd (GArray *trace, guint32 address, guint32 length)
+{
+    /* Any sector type; sync, all headers, user data and EDC/ECC, with raw
+       P-W subchannel; 2448 bytes per sector, like a CD ripper would use */
+    guint8 cdb[12] = { READ_CD, 0, address >> 24, address >> 16, address >> 8, address, length >> 16, length >> 8, length, 0xF8, 0x01, 0 };
+    trace_append(trace, cdb, sizeof(cdb), length * (2352 + 96));
+}
+
+static void append_simple (GArray *trace, const guint8 *cdb, guint8 cdb_len)
+{
+    /* Allocation length is in bytes 7-8 for 10-byte CDBs and byte 4 for
+       6-byte ones */
+    guint32 data_len = cdb_len == 10 ? (cdb[7] << 8) | cdb[8] : cdb_len == 6 ? cdb[4] : 0;
+    trace_append(trace, cdb, cdb_len, data_len);
+}
+
+static GArray *trace_synthesize (const gchar *name, guint32 num_sectors, GError **error)
+{
+    static const guint8 cdb_tur[6] = { TEST_UNIT_READY, 0, 0, 0, 0, 0 };
+    static const guint8 cdb_gesn[10] = { GET_EVENT_STATUS_NOTIFICATION, 0x01, 0, 0, 0x10, 0, 0, 0, 0x08, 0 };
+    static const guint8 cdb_toc[10] = { READ_TOC_PMA_ATIP, 0, 0, 0, 0, 0, 0, 0x03, 0x24, 0 };
+
+    GArray *trace = g_array_new(FALSE, FALSE, sizeof(TraceCommand));
+    GRand *random_generator = g_rand_new_with_seed(seed);
+    guint32 max_transfer = io_buffer_size - sizeof(struct vhba_response);
+    guint32 address = 0;
+
+    if (!num_sectors) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "disc has no sectors");
+        goto fail;
+    }
+
+    if (!g_strcmp0(name, "read10-seq") || !g_strcmp0(name, "read10-random")) {
+        gboolean randomize = !g_strcmp0(name, "read10-random");
+        guint32 length = MIN((guint32)(transfer_length ? transfer_length : 32), max_transfer / 2048);
+        length = MIN(length, num_sectors);
+
+        for (gint i = 0; i < num_commands; i++) {
+            if (randomize) {
+                address = g_rand_int_range(random_generator, 0, num_sectors - length + 1);
+            } else if (address + length > num_sectors) {
+                address = 0;
+            }
+            append_read10(trace, address, length);
+            address += length;
+        }
+    } else if (!g_strcmp0(name, "readcd-seq")) {
+        guint32 length = MIN((guint32)(transfer_length ? transfer_length : 26), max_transfer / (2352 + 96));
+        length = MIN(length, num_sectors);
+
+        for (gint i = 0; i < num_commands; i++) {
+            if (address + length > num_sectors) {
+                address = 0;
+            }
+            append_read_cd(trace, address, length);
+            address += length;
+        }
+    } else if (!g_strcmp0(name, "installer")) {
+        /* Mostly sequential runs of large READ (10) requests from random
+           file offsets, interleaved with small directory/metadata reads
+           and the polling that desktop environments do in the background */
+        guint32 max_length = MIN((guint32)(transfer_length ? transfer_length : 32), max_transfer / 2048);
+        max_length = MIN(max_length, num_sectors);
+        gint run = 0;
+
+        for (gint i = 0; i < num_commands; i++) {
+            gint choice = g_rand_int_range(random_generator, 0, 100);
+
+            if (choice < 70) {
+                guint32 length = g_rand_int_range(random_generator, 1, max_length + 1);
+                if (!run || address + length > num_sectors) {
+                    address = g_rand_int_range(random_generator, 0, num_sectors - length + 1);
+                    run = g_rand_int_range(random_generator, 8, 128);
+                }
+                append_read10(trace, address, length);
+                address += length;
+                run--;
+            } else if (choice < 85) {
+                guint32 length = MIN((guint32)g_rand_int_range(random_generator, 1, 5), num_sectors);
+                append_read10(trace, g_rand_int_range(random_generator, 0, num_sectors - length + 1), length);
+            } else if (choice < 93) {
+                append_simple(trace, cdb_tur, sizeof(cdb_tur));
+            } else if (choice < 98) {
+                append_simple(trace, cdb_gesn, sizeof(cdb_gesn));
+            } else {
+                append_simple(trace, cdb_toc, sizeof(cdb_toc));
+            }
+        }
+    } else {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "unknown workload '%s'", name);
+        goto fail;
+    }
+
+    g_rand_free(random_generator);
+    return trace;
+
+fail:
+    g_rand_free(random_generator);
+    g_array_free(trace, TRUE);
+    return NULL;
+}
+
+
+/**********************************************************************\
+ *                            Statistics                              *
+\**********************************************************************/
+typedef struct
+{
+    guint64 num_commands;
+    guint64 num_errors;
+    guint64 num_bytes;
+    guint64 histogram[NUM_BUCKETS];
+    gint64 max_latency; /* µs */
+} OpcodeStats;
+
+static OpcodeStats stats[256];
+
+static void stats_add (guint8 opcode, gint status, guint32 data_len, gint64 latency)
+{
+    OpcodeStats *entry = &stats[opcode];
+    gint bucket = 0;
+
+    while (bucket < NUM_BUCKETS - 1 && latency >= (G_GINT64_CONSTANT(1) << bucket)) {
+        bucket++;
+    }
+
+    entry->num_commands++;
+    if (status != GOOD) {
+        entry->num_errors++;
+    } else {
+        entry->num_bytes += data_len;
+    }
+    entry->histogram[bucket]++;
+    entry->max_latency = MAX(entry->max_latency, latency);
+}
+
+/* Upper bound of the histogram bucket that contains given percentile */
+static gint64 stats_get_percentile (const OpcodeStats *entry, gdouble percentile)
+{
+    guint64 threshold = (guint64)(entry->num_commands * percentile / 100.0 + 0.5);
+    guint64 count = 0;
+
+    for (gint i = 0; i < NUM_BUCKETS; i++) {
+        count += entry->histogram[i];
+        if (count >= MAX(threshold, 1)) {
+            return MIN(G_GINT64_CONSTANT(1) << i, entry->max_latency);
+        }
+    }
+
+    return entry->max_latency;
+}
+
+static void stats_print (gint64 total_time)
+{
+    gdouble seconds = total_time / 1e6;
+    guint64 total_commands = 0;
+    guint64 total_bytes = 0;
+
+    g_print("%-32s %10s %8s %10s %10s %10s %10s\n", "Opcode", "Commands", "Errors", "MB", "p50 [us]", "p99 [us]", "max [us]");
+    for (gint opcode = 0; opcode < 256; opcode++) {
+        const OpcodeStats *entry = &stats[opcode];
+        const gchar *name = cdemu_device_get_command_name(opcode);
+        gchar *label;
+
+        if (!entry->num_commands) {
+            continue;
+        }
+
+        label = g_strdup_printf("%02Xh %s", opcode, name ? name : "(unknown)");
+        g_print("%-32s %10" G_GUINT64_FORMAT " %8" G_GUINT64_FORMAT " %10.2f %10" G_GINT64_FORMAT " %10" G_GINT64_FORMAT " %10" G_GINT64_FORMAT "\n",
+            label,
+            entry->num_commands,
+            entry->num_errors,
+            entry->num_bytes / (1024.0*1024),
+            stats_get_percentile(entry, 50),
+            stats_get_percentile(entry, 99),
+            entry->max_latency);
+        g_free(label);
+
+        total_commands += entry->num_commands;
+        total_bytes += entry->num_bytes;
+    }
+
+    g_print("\nTotal: %" G_GUINT64_FORMAT " commands in %.3f s; %.0f commands/s, %.2f MB/s\n",
+        total_commands,
+        seconds,
+        seconds > 0 ? total_commands / seconds : 0,
+        seconds > 0 ? total_bytes / seconds / (1024*1024) : 0);
+
+    /* Latency histograms */
+    for (gint opcode = 0; opcode < 256; opcode++) {
+        const OpcodeStats *entry = &stats[opcode];
+        const gchar *name = cdemu_device_get_command_name(opcode);
+        gint first = NUM_BUCKETS, last = 0;
+
+        if (!entry->num_commands) {
+            continue;
+        }
+
+        for (gint i = 0; i < NUM_BUCKETS; i++) {
+            if (entry->histogram[i]) {
+                first = MIN(first, i);
+                last = i;
+            }
+        }
+
+        g_print("\n%02Xh %s latency histogram:\n", opcode, name ? name : "(unknown)");
+        for (gint i = first; i <= last; i++) {
+            gint bar = (gint)(entry->histogram[i] * 50 / entry->num_commands);
+            gchar *range;
+
+            if (i) {
+                range = g_strdup_printf("[%" G_GINT64_FORMAT ", %" G_GINT64_FORMAT ")", G_GINT64_CONSTANT(1) << (i - 1), G_GINT64_CONSTANT(1) << i);
+            } else {
+                range = g_strdup("[0, 1)");
+            }
+
+            g_print("  %-24s %10" G_GUINT64_FORMAT " %6.2f%% ", range, entry->histogram[i], 100.0 * entry->histogram[i] / entry->num_commands);
+            for (gint j = 0; j < bar; j++) {
+                g_print("#");
+            }
+            g_print("\n");
+
+            g_free(range);
+        }
+    }
+}
+
+
+/**********************************************************************\
+ *                         Direct execution                           *
+\**********************************************************************/
+static gint execute_direct (CdemuDevice *device, CdemuCommand *cmd, const TraceCommand *command, guint8 *in, guint8 *out)
+{
+    memset(cmd->cdb, 0, sizeof(cmd->cdb));
+    memcpy(cmd->cdb, command->cdb, MIN(command->cdb_len, (gint)sizeof(cmd->cdb)));
+
+    cmd->in = in;
+    cmd->out = out;
+    cmd->in_len = cmd->out_len = command->data_len;
+    cmd->in_pos = cmd->out_pos = 0;
+
+    return cdemu_device_execute_command(device, cmd);
+}
+
+static gboolean replay_direct (CdemuDevice *device, GArray *trace, gint64 *total_time)
+{
+    CdemuCommand cmd;
+    guint8 *in = g_malloc0(io_buffer_size);
+    guint8 *out = g_malloc0(io_buffer_size);
+    gint64 start_time;
+
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.buffer = g_malloc0(device->priv->buffer_capacity);
+
+    start_time = g_get_monotonic_time();
+    for (guint i = 0; i < trace->len; i++) {
+        const TraceCommand *command = &g_array_index(trace, TraceCommand, i);
+        gint64 command_start = g_get_monotonic_time();
+        gint status = execute_direct(device, &cmd, command, in, out);
+
+        stats_add(command->cdb[0], status, cmd.out_pos, g_get_monotonic_time() - command_start);
+    }
+    *total_time = g_get_monotonic_time() - start_time;
+
+    g_free(cmd.buffer);
+    g_free(out);
+    g_free(in);
+
+    return TRUE;
+}
+
+
+/**********************************************************************\
+ *                       VHBA stand-in (socket pair)                  *
+\**********************************************************************/
+static gboolean send_request (gint fd, guint32 tag, const TraceCommand *command, guint8 *buffer)
+{
+    struct vhba_request *vreq = (gpointer)buffer;
+    gsize length = sizeof(*vreq);
+
+    memset(vreq, 0, sizeof(*vreq));
+    vreq->tag = tag;
+    memcpy(vreq->cdb, command->cdb, command->cdb_len);
+    vreq->cdb_len = command->cdb_len;
+    vreq->data_len = command->data_len;
+
+    /* The trace does not record data direction; reads never need input
+       data, while other commands get a zero-filled payload, as some of them
+       (e.g., MODE SELECT) expect one */
+    if (command->cdb[0] != READ_10 && command->cdb[0] != READ_12 && command->cdb[0] != READ_CD && command->cdb[0] != READ_CD_MSF) {
+        gsize payload = MIN(command->data_len, io_buffer_size - sizeof(*vreq));
+        memset(vreq + 1, 0, payload);
+        length += payload;
+    }
+
+    return write(fd, buffer, length) == (gssize)length;
+}
+
+static void kernel_io_error_handler (CdemuDevice *device G_GNUC_UNUSED, gint *fd)
+{
+    /* Unblock the pending read in replay_pipe() */
+    g_printerr("Device reported kernel I/O error!\n");
+    shutdown(*fd, SHUT_RDWR);
+}
+
+static gboolean replay_pipe (CdemuDevice *device, GArray *trace, gint64 *total_time)
+{
+    gint fds[2];
+    gint buffer_size = 4*1024*1024;
+    gint device_sndbuf = 0;
+    socklen_t optlen = sizeof(device_sndbuf);
+    gsize max_response = 0;
+    gulong handler_id;
+    guint8 *buffer;
+    gint64 *submit_times;
+    gint64 start_time;
+    guint next = 0, completed = 0;
+    gint outstanding = 0;
+    gint depth;
+    gboolean succeeded = TRUE;
+
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) < 0) {
+        g_printerr("Failed to create socket pair: %s\n", g_strerror(errno));
+        return FALSE;
+    }
+
+    /* The device writes responses without blocking; make sure the socket
+       buffer can hold all the responses we keep in flight. The kernel
+       might cap the requested size, so limit the queue depth accordingly
+       (allowing for some per-message overhead) */
+    for (gint i = 0; i < 2; i++) {
+        setsockopt(fds[i], SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
+        setsockopt(fds[i], SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    }
+    getsockopt(fds[1], SOL_SOCKET, SO_SNDBUF, &device_sndbuf, &optlen);
+
+    for (guint i = 0; i < trace->len; i++) {
+        max_response = MAX(max_response, g_array_index(trace, TraceCommand, i).data_len);
+    }
+    max_response += sizeof(struct vhba_response) + 4096;
+
+    depth = CLAMP((gint)(device_sndbuf / max_response), 1, MIN(queue_depth, MAX_QUEUE_DEPTH));
+    if (depth < queue_depth) {
+        g_print("Queue depth limited to %d (socket buffer size: %d bytes)\n\n", depth, device_sndbuf);
+    }
+
+    handler_id = g_signal_connect(device, "kernel-io-error", (GCallback)kernel_io_error_handler, &fds[0]);
+
+    if (!cdemu_device_start_with_fd(device, fds[1])) {
+        g_printerr("Failed to start device I/O!\n");
+        cdemu_device_stop(device);
+        g_signal_handler_disconnect(device, handler_id);
+        close(fds[0]);
+        return FALSE;
+    }
+
+    buffer = g_malloc0(io_buffer_size);
+    submit_times = g_new0(gint64, trace->len);
+
+    start_time = g_get_monotonic_time();
+    while (completed < trace->len) {
+        struct vhba_response *vres = (gpointer)buffer;
+        const TraceCommand *command;
+        gssize ret;
+
+        /* Fill the queue */
+        while (outstanding < depth && next < trace->len) {
+            submit_times[next] = g_get_monotonic_time();
+            if (!send_request(fds[0], next, &g_array_index(trace, TraceCommand, next), buffer)) {
+                g_printerr("Failed to write request: %s\n", g_strerror(errno));
+                succeeded = FALSE;
+                goto end;
+            }
+            next++;
+            outstanding++;
+        }
+
+        /* Collect a response; they may complete out of order */
+        ret = read(fds[0], buffer, io_buffer_size);
+        if (ret < (gssize)sizeof(*vres) || vres->tag >= next) {
+            g_printerr("Failed to read response (%" G_GSSIZE_FORMAT " bytes)!\n", ret);
+            succeeded = FALSE;
+            goto end;
+        }
+
+        command = &g_array_index(trace, TraceCommand, vres->tag);
+        stats_add(command->cdb[0], vres->status, vres->data_len, g_get_monotonic_time() - submit_times[vres->tag]);
+
+        outstanding--;
+        completed++;
+    }
+    *total_time = g_get_monotonic_time() - start_time;
+
+end:
+    cdemu_device_stop(device);
+    g_signal_handler_disconnect(device, handler_id);
+    close(fds[0]);
+
+    g_free(submit_times);
+    g_free(buffer);
+
+    return succeeded;
+}
+
+
+/**********************************************************************\
+ *                               Main                                 *
+\**********************************************************************/
+/* Issues TEST UNIT READY until the device stops reporting UNIT ATTENTION
+   for the newly-loaded disc, then obtains the number of sectors via
+   READ CAPACITY */
+static gboolean prepare_device (CdemuDevice *device, guint32 *num_sectors)
+{
+    static const TraceCommand tur = { { TEST_UNIT_READY }, 6, 0 };
+    static const TraceCommand read_capacity = { { READ_CAPACITY }, 10, 8 };
+
+    CdemuCommand cmd;
+    guint8 *in = g_malloc0(io_buffer_size);
+    guint8 *out = g_malloc0(io_buffer_size);
+    gboolean ready = FALSE;
+
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.buffer = g_malloc0(device->priv->buffer_capacity);
+
+    for (gint i = 0; i < 10 && !ready; i++) {
+        ready = execute_direct(device, &cmd, &tur, in, out) == GOOD;
+    }
+
+    if (ready && execute_direct(device, &cmd, &read_capacity, in, out) == GOOD && cmd.out_pos >= 8) {
+        *num_sectors = ((out[0] << 24) | (out[1] << 16) | (out[2] << 8) | out[3]) + 1;
+    } else {
+        ready = FALSE;
+    }
+
+    g_free(cmd.buffer);
+    g_free(out);
+    g_free(in);
+
+    return ready;
+}
+
+int main (int argc, char **argv)
+{
+    GOptionContext *option_context;
+    GError *local_error = NULL;
+    CdemuDevice *device;
+    GArray *trace = NULL;
+    guint32 num_sectors = 0;
+    gint64 total_time = 0;
+    gboolean direct;
+    gint ret = EXIT_SUCCESS;
+
+    option_context = g_option_context_new("- replay SCSI commands against a CDEmu device");
+    g_option_context_add_main_entries(option_context, option_entries, NULL);
+    if (!g_option_context_parse(option_context, &argc, &argv, &local_error)) {
+        g_printerr("Failed to parse options: %s\n", local_error->message);
+        g_error_free(local_error);
+        g_option_context_free(option_context);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(option_context);
+
+    if (!filenames || !filenames[0]) {
+        g_printerr("No image file given!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (mode && g_strcmp0(mode, "pipe") && g_strcmp0(mode, "direct")) {
+        g_printerr("Invalid mode '%s'!\n", mode);
+        return EXIT_FAILURE;
+    }
+    direct = !g_strcmp0(mode, "direct");
+
+    if (num_commands < 1 || queue_depth < 1 || transfer_length < 0) {
+        g_printerr("Invalid number of commands, queue depth or transfer length!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!mirage_initialize(&local_error)) {
+        g_printerr("Failed to initialize libMirage: %s\n", local_error->message);
+        g_error_free(local_error);
+        return EXIT_FAILURE;
+    }
+    ao_initialize();
+
+    /* Create device and load the image */
+    device = g_object_new(CDEMU_TYPE_DEVICE, NULL);
+    if (!cdemu_device_initialize(device, 0, "null", cdemu_debug_mask, mirage_debug_mask)) {
+        g_printerr("Failed to initialize device!\n");
+        ret = EXIT_FAILURE;
+        goto end;
+    }
+
+    if (!cdemu_device_load_disc(device, filenames, g_variant_new("a{sv}", NULL), &local_error)) {
+        g_printerr("Failed to load image: %s\n", local_error->message);
+        g_error_free(local_error);
+        ret = EXIT_FAILURE;
+        goto end;
+    }
+
+    io_buffer_size = cdemu_device_get_kernel_io_buffer_size(device);
+
+    /* Device serial is normally obtained from the kernel module when the
+       device is started; direct mode never starts it */
+    if (!device->priv->device_serial) {
+        device->priv->device_serial = g_strdup("000");
+    }
+
+    if (!prepare_device(device, &num_sectors)) {
+        g_printerr("Device did not become ready!\n");
+        ret = EXIT_FAILURE;
+        goto end;
+    }
+
+    /* Build the trace */
+    if (trace_file) {
+        trace = trace_load(trace_file, &local_error);
+    } else {
+        trace = trace_synthesize(workload ? workload : "read10-seq", num_sectors, &local_error);
+    }
+    if (!trace) {
+        g_printerr("Failed to prepare command trace: %s\n", local_error->message);
+        g_error_free(local_error);
+        ret = EXIT_FAILURE;
+        goto end;
+    }
+
+    if (save_trace_file && !trace_save(trace, save_trace_file, &local_error)) {
+        g_printerr("Failed to save command trace: %s\n", local_error->message);
+        g_error_free(local_error);
+        ret = EXIT_FAILURE;
+        goto end;
+    }
+
+    g_print("Image: %s (%u sectors)\n", filenames[0], num_sectors);
+    g_print("Trace: %s, %u commands; mode: %s\n\n", trace_file ? trace_file : (workload ? workload : "read10-seq"), trace->len, direct ? "direct" : "pipe");
+
+    /* Replay */
+    if (direct) {
+        replay_direct(device, trace, &total_time);
+    } else if (!replay_pipe(device, trace, &total_time)) {
+        ret = EXIT_FAILURE;
+        goto end;
+    }
+
+    stats_print(total_time);
+
+end:
+    if (trace) {
+        g_array_free(trace, TRUE);
+    }
+    g_object_unref(device);
+
+    ao_shutdown();
+    mirage_shutdown(NULL);
+
+    g_strfreev(filenames);
+    g_free(workload);
+    g_free(trace_file);
+    g_free(save_trace_file);
+    g_free(mode);
+
+    return ret;
+}
@@ -42,18 +42,6 @@ struct _MirageFilterStreamCsoPrivate
     CSO_Part *parts;
     gint num_parts;
     gint num_indices;
-
-    /* Inflate buffer */
-    guint8 *inflate_buffer;
-    gint inflate_buffer_size;
-    gint cached_part;
-
-    /* I/O buffer */
-    guint8 *io_buffer;
-    gint io_buffer_size;
-
-    /* Zlib stream */
-    z_stream zlib_stream;
 };
 
 
@@ -63,7 +51,6 @@ struct _MirageFilterStreamCsoPrivate
 static gboolean mirage_filter_stream_cso_read_index (MirageFilterStreamCso *self, GError **error)
 {
     MirageStream *stream = mirage_filter_stream_get_underlying_stream(MIRAGE_FILTER_STREAM(self));
-    z_stream *zlib_stream = &self->priv->zlib_stream;
 
     ciso_header_t *header = &self->priv->header;
     gint ret;
@@ -139,35 +126,8 @@ static gboolean mirage_filter_stream_cso_read_index (MirageFilterStreamCso *self
     /* EOF index has no size */
     self->priv->parts[self->priv->num_indices - 1].comp_size = 0;
 
-    /* Initialize zlib stream */
-    zlib_stream->zalloc = Z_NULL;
-    zlib_stream->zfree = Z_NULL;
-    zlib_stream->opaque = Z_NULL;
-    zlib_stream->avail_in = 0;
-    zlib_stream->next_in = Z_NULL;
-
-    ret = inflateInit2(zlib_stream, 15);
-
-    if (ret != Z_OK) {
-        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_STREAM_ERROR, Q_("Failed to initialize zlib's inflate (error: %d)!"), ret);
-        return FALSE;
-    }
-
-    /* Allocate inflate buffer */
-    self->priv->inflate_buffer_size = header->block_size;
-    self->priv->inflate_buffer = g_try_malloc(self->priv->inflate_buffer_size);
-    if (!self->priv->inflate_buffer) {
-        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_STREAM_ERROR, Q_("Failed to allocate memory for inflate buffer!"));
-        return FALSE;
-    }
-
-    /* Allocate I/O buffer */
-    self->priv->io_buffer_size = header->block_size;
-    self->priv->io_buffer = g_try_malloc(self->priv->io_buffer_size);
-    if (!self->priv->io_buffer) {
-        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_STREAM_ERROR, Q_("Failed to allocate memory for I/O buffer!"));
-        return FALSE;
-    }
+    /* Set part size for part cache */
+    mirage_filter_stream_simplified_set_part_size(MIRAGE_FILTER_STREAM(self), header->block_size);
 
     /* Set file size */
     mirage_filter_stream_simplified_set_stream_length(MIRAGE_FILTER_STREAM(self), header->total_bytes);
@@ -228,11 +188,96 @@ static gboolean mirage_filter_stream_cso_open (MirageFilterStream *_self, Mirage
 }
 
 
-static gssize mirage_filter_stream_cso_partial_read (MirageFilterStream *_self, void *buffer, gsize count)
+static GBytes *mirage_filter_stream_cso_read_raw_part (MirageFilterStream *_self, guint64 index)
 {
     MirageFilterStreamCso *self = MIRAGE_FILTER_STREAM_CSO(_self);
     MirageStream *stream = mirage_filter_stream_get_underlying_stream(_self);
+    const CSO_Part *part;
+    gsize raw_size;
+    guint8 *raw_data;
+    gssize ret;
+
+    if (index >= (guint64)self->priv->num_parts) {
+        return NULL;
+    }
+    part = &self->priv->parts[index];
+
+    /* Uncompressed parts are stored whole */
+    raw_size = part->raw ? self->priv->header.block_size : part->comp_size;
+
+    /* Seek to the position */
+    if (!mirage_stream_seek(stream, part->offset, G_SEEK_SET, NULL)) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to seek to %" G_GOFFSET_MODIFIER "d in underlying stream!\n", __debug__, part->offset);
+        return NULL;
+    }
+
+    /* Read part's data */
+    raw_data = g_malloc(raw_size);
+
+    ret = mirage_stream_read(stream, raw_data, raw_size, NULL);
+    if (ret == -1) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read %" G_GSIZE_MODIFIER "d bytes from underlying stream!\n", __debug__, raw_size);
+        g_free(raw_data);
+        return NULL;
+    } else if (ret == 0) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: unexpectedly reached EOF!\n", __debug__);
+        g_free(raw_data);
+        return NULL;
+    }
+
+    return g_bytes_new_take(raw_data, ret);
+}
+
+static gssize mirage_filter_stream_cso_decode_raw_part (MirageFilterStream *_self, guint64 index, GBytes *raw_data, guint8 *buffer, gsize buffer_size)
+{
+    MirageFilterStreamCso *self = MIRAGE_FILTER_STREAM_CSO(_self);
+    const CSO_Part *part = &self->priv->parts[index];
+    z_stream zlib_stream;
+    gsize raw_size;
+    const guint8 *raw_buffer = g_bytes_get_data(raw_data, &raw_size);
+    gint ret;
+
+    /* Uncompressed part */
+    if (part->raw) {
+        raw_size = MIN(raw_size, buffer_size);
+        memcpy(buffer, raw_buffer, raw_size);
+        return raw_size;
+    }
+
+    /* NOTE: this function may be called from worker threads, so we use
+       a private inflate engine */
+    zlib_stream.zalloc = Z_NULL;
+    zlib_stream.zfree = Z_NULL;
+    zlib_stream.opaque = Z_NULL;
+    zlib_stream.avail_in = raw_size;
+    zlib_stream.next_in = (guint8 *)raw_buffer;
+    zlib_stream.avail_out = buffer_size;
+    zlib_stream.next_out = buffer;
+
+    ret = inflateInit2(&zlib_stream, -15);
+    if (ret != Z_OK) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to initialize inflate engine (error: %d)!\n", __debug__, ret);
+        return -1;
+    }
+
+    /* Uncompress whole part */
+    ret = inflate(&zlib_stream, Z_FINISH);
+    if (ret == Z_NEED_DICT || ret == Z_MEM_ERROR || ret == Z_DATA_ERROR || zlib_stream.avail_out) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to inflate part: %s!\n", __debug__, zlib_stream.msg);
+        inflateEnd(&zlib_stream);
+        return -1;
+    }
+
+    inflateEnd(&zlib_stream);
+
+    return buffer_size;
+}
+
+static gssize mirage_filter_stream_cso_partial_read (MirageFilterStream *_self, void *buffer, gsize count)
+{
+    MirageFilterStreamCso *self = MIRAGE_FILTER_STREAM_CSO(_self);
     goffset position = mirage_filter_stream_simplified_get_position(_self);
+    const guint8 *part_data;
     gint part_idx;
 
     /* Find part that corresponds tho current position */
@@ -243,85 +288,21 @@ static gssize mirage_filter_stream_cso_partial_read (MirageFilterStream *_self,
         return 0;
     }
 
-    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position: %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) -> part #%d (cached: #%d)\n", __debug__, position, position, part_idx, self->priv->cached_part);
-
-    /* If we do not have part in cache, uncompress it */
-    if (part_idx != self->priv->cached_part) {
-        const CSO_Part *part = &self->priv->parts[part_idx];
-        z_stream *zlib_stream = &self->priv->zlib_stream;
-        gint ret;
-
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: part not cached, reading...\n", __debug__);
-
-        /* Seek to the position */
-        if (!mirage_stream_seek(stream, part->offset, G_SEEK_SET, NULL)) {
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to seek to %" G_GOFFSET_MODIFIER "d in underlying stream!\n", __debug__, part->offset);
-            return -1;
-        }
-
-        /* Read a part, either raw or compressed */
-        if (part->raw) {
-            /* Read uncompressed part */
-            ret = mirage_stream_read(stream, self->priv->inflate_buffer, self->priv->inflate_buffer_size, NULL);
-            if (ret == -1) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read %d bytes from underlying stream!\n", __debug__, self->priv->inflate_buffer_size);
-                return -1;
-            } else if (ret == 0) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: unexpectedly reached EOF!\n", __debug__);
-                return -1;
-            }
-        } else {
-            /* Reset inflate engine */
-            ret = inflateReset2(zlib_stream, -15);
-            if (ret != Z_OK) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to reset inflate engine!\n", __debug__);
-                return -1;
-            }
-
-            /* Uncompress whole part */
-            zlib_stream->avail_in = 0;
-            zlib_stream->avail_out = self->priv->inflate_buffer_size;
-            zlib_stream->next_out = self->priv->inflate_buffer;
-
-            do {
-                /* Read */
-                if (!zlib_stream->avail_in) {
-                    /* Read some compressed data */
-                    ret = mirage_stream_read(stream, self->priv->io_buffer, part->comp_size, NULL);
-                    if (ret == -1) {
-                        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read %d bytes from underlying stream!\n", __debug__, self->priv->io_buffer_size);
-                        return -1;
-                    } else if (ret == 0) {
-                        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: unexpectedly reached EOF\n!", __debug__);
-                        return -1;
-                    }
-                    zlib_stream->avail_in = ret;
-                    zlib_stream->next_in = self->priv->io_buffer;
-                }
-
-                /* Inflate */
-                ret = inflate(zlib_stream, Z_NO_FLUSH);
-                if (ret == Z_NEED_DICT || ret == Z_MEM_ERROR || ret == Z_DATA_ERROR) {
-                    MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to inflate part: %s\n!", __debug__, zlib_stream->msg);
-                    return -1;
-                }
-            } while (zlib_stream->avail_out);
-        }
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position: %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) -> part #%d\n", __debug__, position, position, part_idx);
 
-        /* Set currently cached part */
-        self->priv->cached_part = part_idx;
-    } else {
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: part already cached\n", __debug__);
+    /* Get decoded part */
+    part_data = mirage_filter_stream_simplified_get_part(_self, part_idx, NULL);
+    if (!part_data) {
+        return -1;
     }
 
-
     /* Copy data */
     goffset part_offset = position % self->priv->header.block_size;
     count = MIN(count, self->priv->header.block_size - part_offset);
 
     MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: offset within part: %" G_GOFFSET_MODIFIER "d, copying %" G_GSIZE_MODIFIER "d bytes\n", __debug__, part_offset, count);
 
-    memcpy(buffer, &self->priv->inflate_buffer[part_offset], count);
+    memcpy(buffer, part_data + part_offset, count);
 
     return count;
 }
@@ -356,10 +337,6 @@ static void mirage_filter_stream_cso_init (MirageFilterStreamCso *self)
 
     self->priv->num_parts = 0;
     self->priv->parts = NULL;
-
-    self->priv->cached_part = -1;
-    self->priv->inflate_buffer = NULL;
-    self->priv->io_buffer = NULL;
 }
 
 static void mirage_filter_stream_cso_finalize (GObject *gobject)
@@ -367,10 +344,6 @@ static void mirage_filter_stream_cso_finalize (GObject *gobject)
     MirageFilterStreamCso *self = MIRAGE_FILTER_STREAM_CSO(gobject);
 
     g_free(self->priv->parts);
-    g_free(self->priv->inflate_buffer);
-    g_free(self->priv->io_buffer);
-
-    inflateEnd(&self->priv->zlib_stream);
 
     /* Chain up to the parent class */
     return G_OBJECT_CLASS(mirage_filter_stream_cso_parent_class)->finalize(gobject);
@@ -386,6 +359,8 @@ static void mirage_filter_stream_cso_class_init (MirageFilterStreamCsoClass *kla
     filter_stream_class->open = mirage_filter_stream_cso_open;
 
     filter_stream_class->simplified_partial_read = mirage_filter_stream_cso_partial_read;
+    filter_stream_class->simplified_read_raw_part = mirage_filter_stream_cso_read_raw_part;
+    filter_stream_class->simplified_decode_raw_part = mirage_filter_stream_cso_decode_raw_part;
 }
 
 static void mirage_filter_stream_cso_class_finalize (MirageFilterStreamCsoClass *klass G_GNUC_UNUSED)
@@ -106,12 +106,6 @@ struct _MirageFilterStreamDaaPrivate
     guint8 *io_buffer;
     gint io_buffer_size;
 
-    /* Inflate buffer */
-    guint8 *inflate_buffer;
-    gint inflate_buffer_size;
-    gint cached_chunk; /* Index of currently cached chunk */
-    gsize cached_chunk_size;
-
     /* Compression */
     z_stream zlib_stream;
 
@@ -394,7 +388,7 @@ static gboolean mirage_filter_stream_daa_initialize_zlib (MirageFilterStreamDaa
     return TRUE;
 }
 
-static gint mirage_filter_stream_daa_inflate_zlib (MirageFilterStreamDaa *self, guint8 *in_buf, gsize in_len)
+static gint mirage_filter_stream_daa_inflate_zlib (MirageFilterStreamDaa *self, guint8 *in_buf, gsize in_len, guint8 *out_buf, gsize out_len)
 {
     z_stream *zlib_stream = &self->priv->zlib_stream;
     gint ret;
@@ -404,8 +398,8 @@ static gint mirage_filter_stream_daa_inflate_zlib (MirageFilterStreamDaa *self,
 
     zlib_stream->next_in = in_buf;
     zlib_stream->avail_in = in_len;
-    zlib_stream->next_out = self->priv->inflate_buffer;
-    zlib_stream->avail_out = self->priv->inflate_buffer_size;
+    zlib_stream->next_out = out_buf;
+    zlib_stream->avail_out = out_len;
 
     ret = inflate(zlib_stream, Z_SYNC_FLUSH);
     if (ret != Z_STREAM_END) {
@@ -425,7 +419,7 @@ static gboolean mirage_filter_stream_daa_initialize_lzma (MirageFilterStreamDaa
     return TRUE;
 }
 
-static gint mirage_filter_stream_daa_inflate_lzma (MirageFilterStreamDaa *self, guint8 *in_buf, gsize in_len)
+static gint mirage_filter_stream_daa_inflate_lzma (MirageFilterStreamDaa *self, guint8 *in_buf, gsize in_len, guint8 *out_buf, gsize out_len)
 {
     ELzmaStatus status;
     SizeT inlen, outlen;
@@ -437,8 +431,8 @@ static gint mirage_filter_stream_daa_inflate_lzma (MirageFilterStreamDaa *self,
 
     /* LZMA */
     inlen = in_len;
-    outlen = self->priv->inflate_buffer_size;
-    if (LzmaDec_DecodeToBuf(&self->priv->lzma_decoder, self->priv->inflate_buffer, &outlen, in_buf, &inlen, LZMA_FINISH_END, &status) != SZ_OK) {
+    outlen = out_len;
+    if (LzmaDec_DecodeToBuf(&self->priv->lzma_decoder, out_buf, &outlen, in_buf, &inlen, LZMA_FINISH_END, &status) != SZ_OK) {
         MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to inflate (status: %d)!\n", __debug__, status);
         return 0;
     }
@@ -454,7 +448,7 @@ static gint mirage_filter_stream_daa_inflate_lzma (MirageFilterStreamDaa *self,
             guint32 state;
             MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: applying x86 BCJ filter to decompressed data\n", __debug__);
             x86_Convert_Init(state);
-            x86_Convert(self->priv->inflate_buffer, outlen, 0, &state, 0);
+            x86_Convert(out_buf, outlen, 0, &state, 0);
             break;
         }
         default: {
@@ -1246,15 +1240,8 @@ static gboolean mirage_filter_stream_daa_parse_daa_file (MirageFilterStreamDaa *
         return FALSE;
     }
 
-    /* Allocate inflate buffer */
-    self->priv->inflate_buffer_size = self->priv->chunk_size;
-    MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: allocating inflate buffer: 0x%X\n", __debug__, self->priv->inflate_buffer_size);
-    self->priv->inflate_buffer = g_try_malloc(self->priv->inflate_buffer_size);
-    if (!self->priv->inflate_buffer) {
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to allocate inflate buffer (%d bytes)!\n", __debug__, self->priv->inflate_buffer_size);
-        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_PARSER_ERROR, Q_("Failed to allocate inflate buffer (%d bytes)!"), self->priv->inflate_buffer_size);
-        return FALSE;
-    }
+    /* Set part size for part cache */
+    mirage_filter_stream_simplified_set_part_size(MIRAGE_FILTER_STREAM(self), self->priv->chunk_size);
 
     /* Parse descriptors */
     if (!mirage_filter_stream_daa_parse_descriptors(self, error)) {
@@ -1321,93 +1308,96 @@ static gboolean mirage_filter_stream_daa_open (MirageFilterStream *_self, Mirage
 }
 
 
-static gssize mirage_filter_stream_daa_partial_read (MirageFilterStream *_self, void *buffer, gsize count)
+static gssize mirage_filter_stream_daa_decode_part (MirageFilterStream *_self, guint64 index, guint8 *buffer, gsize buffer_size)
 {
     MirageFilterStreamDaa *self = MIRAGE_FILTER_STREAM_DAA(_self);
-    goffset position = mirage_filter_stream_simplified_get_position(MIRAGE_FILTER_STREAM(self));
-    gint chunk_index;
-
-    /* Find chunk that corresponds to current position */
-    chunk_index = position / self->priv->chunk_size;
-    if (chunk_index >= self->priv->num_chunks) {
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) beyond end of stream, doing nothing!\n", __debug__, position, position);
-        return 0;
+    gint chunk_index = index;
+    DAA_Chunk *chunk = &self->priv->chunk_table[chunk_index];
+    gsize expected_inflated_size, inflated_size;
+
+    /* Determine expected inflated size */
+    if (chunk_index == self->priv->num_chunks-1) {
+        /* Last chunk: remainder */
+        expected_inflated_size = self->priv->header.iso_size % self->priv->chunk_size;
+    } else {
+        expected_inflated_size = self->priv->chunk_size;
     }
 
-    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position: %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) -> chunk #%d (cached: #%d)\n", __debug__, position, position, chunk_index, self->priv->cached_chunk);
-
-    /* Inflate, if necessary */
-    if (chunk_index != self->priv->cached_chunk) {
-        DAA_Chunk *chunk = &self->priv->chunk_table[chunk_index];
-        gsize expected_inflated_size, inflated_size;
-
-        /* Determine expected inflated size */
-        if (chunk_index == self->priv->num_chunks-1) {
-            /* Last chunk: remainder */
-            expected_inflated_size = self->priv->header.iso_size % self->priv->chunk_size;
-        } else {
-            expected_inflated_size = self->priv->chunk_size;
-        }
+    /* Read chunk */
+    if (!mirage_filter_stream_daa_read_from_stream(self, chunk->offset, chunk->length, self->priv->io_buffer, NULL)) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read data for chunk #%i\n", __debug__, chunk_index);
+        return -1;
+    }
 
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: chunk not cached, reading...\n", __debug__);
+    /* Decrypt if encrypted */
+    if (self->priv->encrypted) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: decrypting...\n", __debug__);
+        mirage_filter_stream_daa_decrypt_buffer(self, self->priv->io_buffer, chunk->length);
+    }
 
-        /* Read chunk */
-        if (!mirage_filter_stream_daa_read_from_stream(self, chunk->offset, chunk->length, self->priv->io_buffer, NULL)) {
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read data for chunk #%i\n", __debug__, chunk_index);
-            return -1;
+    /* Inflate */
+    memset(buffer, 0, buffer_size); /* Clear the buffer in case we get a failure */
+    switch (chunk->compression) {
+        case COMPRESSION_NONE: {
+            inflated_size = chunk->length - 4;
+            memcpy(buffer, self->priv->io_buffer, inflated_size);
+            break;
         }
-
-        /* Decrypt if encrypted */
-        if (self->priv->encrypted) {
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: decrypting...\n", __debug__);
-            mirage_filter_stream_daa_decrypt_buffer(self, self->priv->io_buffer, chunk->length);
+        case COMPRESSION_ZLIB: {
+            inflated_size = mirage_filter_stream_daa_inflate_zlib(self, self->priv->io_buffer, chunk->length, buffer, buffer_size);
+            break;
         }
-
-        /* Inflate */
-        memset(self->priv->inflate_buffer, 0, self->priv->inflate_buffer_size); /* Clear the buffer in case we get a failure */
-        switch (chunk->compression) {
-            case COMPRESSION_NONE: {
-                inflated_size = chunk->length - 4;
-                memcpy(self->priv->inflate_buffer, self->priv->io_buffer, inflated_size);
-                break;
-            }
-            case COMPRESSION_ZLIB: {
-                inflated_size = mirage_filter_stream_daa_inflate_zlib(self, self->priv->io_buffer, chunk->length);
-                break;
-            }
-            case COMPRESSION_LZMA: {
-                inflated_size = mirage_filter_stream_daa_inflate_lzma(self, self->priv->io_buffer, chunk->length);
-                break;
-            }
-            default: {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: invalid chunk compression type %d!\n", __debug__, chunk->compression);
-                return -1;
-            }
+        case COMPRESSION_LZMA: {
+            inflated_size = mirage_filter_stream_daa_inflate_lzma(self, self->priv->io_buffer, chunk->length, buffer, buffer_size);
+            break;
         }
-
-        /* Inflated size should match the expected one */
-        if (inflated_size != expected_inflated_size && chunk_index != self->priv->num_chunks - 1) {
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to inflate whole chunk #%i (0x%" G_GSIZE_MODIFIER "X bytes instead of 0x%" G_GSIZE_MODIFIER "X)\n", __debug__, chunk_index, inflated_size, expected_inflated_size);
+        default: {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: invalid chunk compression type %d!\n", __debug__, chunk->compression);
             return -1;
-        } else {
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: successfully inflated chunk #%i (0x%" G_GSIZE_MODIFIER "X bytes)\n", __debug__, chunk_index, inflated_size);
         }
+    }
 
-        /* Set the index of currently inflated chunk */
-        self->priv->cached_chunk = chunk_index;
-        self->priv->cached_chunk_size = inflated_size;
+    /* Inflated size should match the expected one */
+    if (inflated_size != expected_inflated_size && chunk_index != self->priv->num_chunks - 1) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to inflate whole chunk #%i (0x%" G_GSIZE_MODIFIER "X bytes instead of 0x%" G_GSIZE_MODIFIER "X)\n", __debug__, chunk_index, inflated_size, expected_inflated_size);
+        return -1;
     } else {
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: chunk already cached\n", __debug__);
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: successfully inflated chunk #%i (0x%" G_GSIZE_MODIFIER "X bytes)\n", __debug__, chunk_index, inflated_size);
     }
 
+    return inflated_size;
+}
+
+static gssize mirage_filter_stream_daa_partial_read (MirageFilterStream *_self, void *buffer, gsize count)
+{
+    MirageFilterStreamDaa *self = MIRAGE_FILTER_STREAM_DAA(_self);
+    goffset position = mirage_filter_stream_simplified_get_position(MIRAGE_FILTER_STREAM(self));
+    const guint8 *chunk_data;
+    gsize chunk_size;
+    gint chunk_index;
+
+    /* Find chunk that corresponds to current position */
+    chunk_index = position / self->priv->chunk_size;
+    if (chunk_index >= self->priv->num_chunks) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) beyond end of stream, doing nothing!\n", __debug__, position, position);
+        return 0;
+    }
+
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position: %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) -> chunk #%d\n", __debug__, position, position, chunk_index);
+
+    /* Get inflated chunk */
+    chunk_data = mirage_filter_stream_simplified_get_part(_self, chunk_index, &chunk_size);
+    if (!chunk_data) {
+        return -1;
+    }
 
     /* Copy data */
     gint chunk_offset = position % self->priv->chunk_size;
-    count = MIN(count, self->priv->cached_chunk_size - chunk_offset);
+    count = MIN(count, chunk_size - chunk_offset);
 
     MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: offset within chunk: %d, copying %" G_GSIZE_MODIFIER "d bytes\n", __debug__, chunk_offset, count);
 
-    memcpy(buffer, self->priv->inflate_buffer + chunk_offset, count);
+    memcpy(buffer, chunk_data + chunk_offset, count);
 
     return count;
 }
@@ -1444,9 +1434,6 @@ static void mirage_filter_stream_daa_init (MirageFilterStreamDaa *self)
     self->priv->chunk_table = NULL;
     self->priv->part_table = NULL;
     self->priv->io_buffer = NULL;
-    self->priv->inflate_buffer = NULL;
-
-    self->priv->cached_chunk = -1;
 }
 
 static void mirage_filter_stream_daa_finalize (GObject *gobject)
@@ -1473,7 +1460,6 @@ static void mirage_filter_stream_daa_finalize (GObject *gobject)
 
     /* Free buffer */
     g_free(self->priv->io_buffer);
-    g_free(self->priv->inflate_buffer);
 
     /* Chain up to the parent class */
     return G_OBJECT_CLASS(mirage_filter_stream_daa_parent_class)->finalize(gobject);
@@ -1489,6 +1475,7 @@ static void mirage_filter_stream_daa_class_init (MirageFilterStreamDaaClass *kla
     filter_stream_class->open = mirage_filter_stream_daa_open;
 
     filter_stream_class->simplified_partial_read = mirage_filter_stream_daa_partial_read;
+    filter_stream_class->simplified_decode_part = mirage_filter_stream_daa_decode_part;
 }
 
 static void mirage_filter_stream_daa_class_finalize (MirageFilterStreamDaaClass *klass G_GNUC_UNUSED)
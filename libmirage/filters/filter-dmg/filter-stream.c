@@ -56,10 +56,8 @@ struct _MirageFilterStreamDmgPrivate
     DMG_Part *parts;
     gint num_parts;
 
-    /* Inflate buffer */
-    guint8 *inflate_buffer;
+    /* Inflate buffer size (size of the largest decoded part) */
     guint inflate_buffer_size;
-    gint cached_part;
 
     /* I/O buffer */
     guint8 *io_buffer;
@@ -558,12 +556,8 @@ static gboolean mirage_filter_stream_dmg_read_index (MirageFilterStreamDmg *self
         return FALSE;
     }
 
-    /* Allocate inflate buffer */
-    self->priv->inflate_buffer = g_try_malloc(self->priv->inflate_buffer_size);
-    if (!self->priv->inflate_buffer && self->priv->inflate_buffer_size) {
-        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_STREAM_ERROR, Q_("Failed to allocate memory for inflate buffer!"));
-        return FALSE;
-    }
+    /* Set part size for part cache */
+    mirage_filter_stream_simplified_set_part_size(MIRAGE_FILTER_STREAM(self), self->priv->inflate_buffer_size);
 
     /* Allocate I/O buffer */
     self->priv->io_buffer = g_try_malloc(self->priv->io_buffer_size);
@@ -810,10 +804,119 @@ static gssize mirage_filter_stream_dmg_read_raw_chunk (MirageFilterStreamDmg *se
     return have_read;
 }
 
+static gssize mirage_filter_stream_dmg_decode_part (MirageFilterStream *_self, guint64 index, guint8 *buffer, gsize buffer_size)
+{
+    MirageFilterStreamDmg *self = MIRAGE_FILTER_STREAM_DMG(_self);
+    gint part_idx = index;
+    const DMG_Part *part = &self->priv->parts[part_idx];
+    z_stream *zlib_stream = &self->priv->zlib_stream;
+    bz_stream *bzip2_stream = &self->priv->bzip2_stream;
+    gint ret;
+
+    /* Read a part */
+    if (part->type == RAW) {
+        /* Read uncompressed part */
+        ret = mirage_filter_stream_dmg_read_raw_chunk (self, buffer, part_idx);
+        if (ret != part->in_length) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read raw chunk!\n", __debug__);
+            return -1;
+        }
+    } else if (part->type == ZLIB) {
+        /* Reset inflate engine */
+        ret = inflateReset2(zlib_stream, 15);
+        if (ret != Z_OK) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to reset inflate engine!\n", __debug__);
+            return -1;
+        }
+
+        /* Uncompress whole part */
+        zlib_stream->avail_in  = part->in_length;
+        zlib_stream->next_in   = self->priv->io_buffer;
+        zlib_stream->avail_out = buffer_size;
+        zlib_stream->next_out  = buffer;
+
+        /* Read some compressed data */
+        ret = mirage_filter_stream_dmg_read_raw_chunk (self, self->priv->io_buffer, part_idx);
+        if (ret != part->in_length) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read raw chunk!\n", __debug__);
+            return -1;
+        }
+
+        do {
+            /* Inflate */
+            ret = inflate(zlib_stream, Z_NO_FLUSH);
+            if (ret == Z_NEED_DICT || ret == Z_MEM_ERROR || ret == Z_DATA_ERROR) {
+                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to inflate part: %s!\n", __debug__, zlib_stream->msg);
+                return -1;
+            }
+        } while (zlib_stream->avail_in);
+    } else if (part->type == BZLIB) {
+        /* Reset decompress engine */
+        ret = BZ2_bzDecompressInit(bzip2_stream, 0, 0);
+        if (ret != BZ_OK) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to initialize decompress engine!\n", __debug__);
+            return -1;
+        }
+
+        /* Uncompress whole part */
+        bzip2_stream->avail_in  = part->in_length;
+        bzip2_stream->next_in   = (gchar *) self->priv->io_buffer;
+        bzip2_stream->avail_out = buffer_size;
+        bzip2_stream->next_out  = (gchar *) buffer;
+
+        /* Read some compressed data */
+        ret = mirage_filter_stream_dmg_read_raw_chunk (self, self->priv->io_buffer, part_idx);
+        if (ret != part->in_length) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read raw chunk!\n", __debug__);
+            return -1;
+        }
+
+        do {
+            /* Inflate */
+            ret = BZ2_bzDecompress(bzip2_stream);
+            if (ret < 0) {
+                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to inflate part: %d!\n", __debug__, ret);
+                return -1;
+            }
+        } while (bzip2_stream->avail_in);
+
+        /* Uninitialize decompress engine */
+        ret = BZ2_bzDecompressEnd(bzip2_stream);
+        if (ret != BZ_OK) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to uninitialize decompress engine!\n", __debug__);
+            return -1;
+        }
+    } else if (part->type == ADC) {
+        gsize written_bytes;
+
+        /* Read some compressed data */
+        ret = mirage_filter_stream_dmg_read_raw_chunk (self, self->priv->io_buffer, part_idx);
+        if (ret != part->in_length) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read raw chunk!\n", __debug__);
+            return -1;
+        }
+
+        /* Inflate */
+        ret = (gint) adc_decompress(part->in_length, self->priv->io_buffer, part->num_sectors * DMG_SECTOR_SIZE,
+                       buffer, &written_bytes);
+
+        g_assert (ret == part->in_length);
+        g_assert (written_bytes == part->num_sectors * DMG_SECTOR_SIZE);
+    } else {
+        /* We should never get here... */
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: Encountered unknown chunk type %u!\n", __debug__, part->type);
+        return -1;
+    }
+
+    return part->num_sectors * DMG_SECTOR_SIZE;
+}
+
 static gssize mirage_filter_stream_dmg_partial_read (MirageFilterStream *_self, void *buffer, gsize count)
 {
     MirageFilterStreamDmg *self = MIRAGE_FILTER_STREAM_DMG(_self);
     goffset position = mirage_filter_stream_simplified_get_position(MIRAGE_FILTER_STREAM(self));
+    const DMG_Part *part;
+    const guint8 *part_data = NULL;
     gint part_idx = -1;
 
     /* Find part that corresponds to current position */
@@ -831,125 +934,18 @@ static gssize mirage_filter_stream_dmg_partial_read (MirageFilterStream *_self,
         return 0;
     }
 
-    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position: %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) -> part #%d (cached: #%d)\n", __debug__, position, position, part_idx, self->priv->cached_part);
-
-    /* If we do not have part in cache, uncompress it */
-    if (part_idx != self->priv->cached_part) {
-        const DMG_Part *part = &self->priv->parts[part_idx];
-        z_stream *zlib_stream = &self->priv->zlib_stream;
-        bz_stream *bzip2_stream = &self->priv->bzip2_stream;
-        gint ret;
-
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: part not cached, reading...\n", __debug__);
-
-        /* Read a part */
-        if (part->type == ZERO || part->type == IGNORE) {
-            /* We don't use internal buffers for zero data */
-        } else if (part->type == RAW) {
-            /* Read uncompressed part */
-            ret = mirage_filter_stream_dmg_read_raw_chunk (self, self->priv->inflate_buffer, part_idx);
-            if (ret != part->in_length) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read raw chunk!\n", __debug__);
-                return -1;
-            }
-        } else if (part->type == ZLIB) {
-            /* Reset inflate engine */
-            ret = inflateReset2(zlib_stream, 15);
-            if (ret != Z_OK) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to reset inflate engine!\n", __debug__);
-                return -1;
-            }
-
-            /* Uncompress whole part */
-            zlib_stream->avail_in  = part->in_length;
-            zlib_stream->next_in   = self->priv->io_buffer;
-            zlib_stream->avail_out = self->priv->inflate_buffer_size;
-            zlib_stream->next_out  = self->priv->inflate_buffer;
-
-            /* Read some compressed data */
-            ret = mirage_filter_stream_dmg_read_raw_chunk (self, self->priv->io_buffer, part_idx);
-            if (ret != part->in_length) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read raw chunk!\n", __debug__);
-                return -1;
-            }
-
-            do {
-                /* Inflate */
-                ret = inflate(zlib_stream, Z_NO_FLUSH);
-                if (ret == Z_NEED_DICT || ret == Z_MEM_ERROR || ret == Z_DATA_ERROR) {
-                    MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to inflate part: %s!\n", __debug__, zlib_stream->msg);
-                    return -1;
-                }
-            } while (zlib_stream->avail_in);
-        } else if (part->type == BZLIB) {
-            /* Reset decompress engine */
-            ret = BZ2_bzDecompressInit(bzip2_stream, 0, 0);
-            if (ret != BZ_OK) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to initialize decompress engine!\n", __debug__);
-                return -1;
-            }
-
-            /* Uncompress whole part */
-            bzip2_stream->avail_in  = part->in_length;
-            bzip2_stream->next_in   = (gchar *) self->priv->io_buffer;
-            bzip2_stream->avail_out = self->priv->inflate_buffer_size;
-            bzip2_stream->next_out  = (gchar *) self->priv->inflate_buffer;
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position: %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) -> part #%d\n", __debug__, position, position, part_idx);
 
-            /* Read some compressed data */
-            ret = mirage_filter_stream_dmg_read_raw_chunk (self, self->priv->io_buffer, part_idx);
-            if (ret != part->in_length) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read raw chunk!\n", __debug__);
-                return -1;
-            }
-
-            do {
-                /* Inflate */
-                ret = BZ2_bzDecompress(bzip2_stream);
-                if (ret < 0) {
-                    MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to inflate part: %d!\n", __debug__, ret);
-                    return -1;
-                }
-            } while (bzip2_stream->avail_in);
-
-            /* Uninitialize decompress engine */
-            ret = BZ2_bzDecompressEnd(bzip2_stream);
-            if (ret != BZ_OK) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to uninitialize decompress engine!\n", __debug__);
-                return -1;
-            }
-        } else if (part->type == ADC) {
-            gsize written_bytes;
-
-            /* Read some compressed data */
-            ret = mirage_filter_stream_dmg_read_raw_chunk (self, self->priv->io_buffer, part_idx);
-            if (ret != part->in_length) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read raw chunk!\n", __debug__);
-                return -1;
-            }
-
-            /* Inflate */
-            ret = (gint) adc_decompress(part->in_length, self->priv->io_buffer, part->num_sectors * DMG_SECTOR_SIZE,
-                           self->priv->inflate_buffer, &written_bytes);
-
-            g_assert (ret == part->in_length);
-            g_assert (written_bytes == part->num_sectors * DMG_SECTOR_SIZE);
-        } else {
-            /* We should never get here... */
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: Encountered unknown chunk type %u!\n", __debug__, part->type);
+    /* Get decoded part; zero parts are not decoded */
+    part = &self->priv->parts[part_idx];
+    if (part->type != ZERO && part->type != IGNORE) {
+        part_data = mirage_filter_stream_simplified_get_part(_self, part_idx, NULL);
+        if (!part_data) {
             return -1;
         }
-
-        /* Set currently cached part */
-        if (part->type != ZERO && part->type != IGNORE) {
-            self->priv->cached_part = part_idx;
-        }
-    } else {
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: part already cached\n", __debug__);
     }
 
     /* Copy data */
-    const DMG_Part *part = &self->priv->parts[part_idx];
-
     gsize   part_size = part->num_sectors * DMG_SECTOR_SIZE;
     guint64 part_offset = position - (part->first_sector * DMG_SECTOR_SIZE);
     count = MIN(count, part_size - part_offset);
@@ -959,7 +955,7 @@ static gssize mirage_filter_stream_dmg_partial_read (MirageFilterStream *_self,
     if (part->type == ZERO || part->type == IGNORE) {
         memset(buffer, 0, count);
     } else {
-        memcpy(buffer, &self->priv->inflate_buffer[part_offset], count);
+        memcpy(buffer, &part_data[part_offset], count);
     }
 
     return count;
@@ -1005,8 +1001,6 @@ static void mirage_filter_stream_dmg_init (MirageFilterStreamDmg *self)
     self->priv->num_parts = 0;
     self->priv->parts = NULL;
 
-    self->priv->cached_part = -1;
-    self->priv->inflate_buffer = NULL;
     self->priv->io_buffer = NULL;
 }
 
@@ -1020,7 +1014,6 @@ static void mirage_filter_stream_dmg_finalize (GObject *gobject)
     g_free(self->priv->streams);
 
     g_free(self->priv->parts);
-    g_free(self->priv->inflate_buffer);
     g_free(self->priv->io_buffer);
 
     inflateEnd(&self->priv->zlib_stream);
@@ -1044,6 +1037,7 @@ static void mirage_filter_stream_dmg_class_init (MirageFilterStreamDmgClass *kla
     filter_stream_class->open = mirage_filter_stream_dmg_open;
 
     filter_stream_class->simplified_partial_read = mirage_filter_stream_dmg_partial_read;
+    filter_stream_class->simplified_decode_part = mirage_filter_stream_dmg_decode_part;
 }
 
 static void mirage_filter_stream_dmg_class_finalize (MirageFilterStreamDmgClass *klass G_GNUC_UNUSED)
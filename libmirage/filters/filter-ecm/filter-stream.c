@@ -36,6 +36,15 @@ typedef struct
 
 static const guint8 ecm_signature[4] = { 'E', 'C', 'M', 0x00 };
 
+/* Index cache; ID needs to be changed whenever index format changes */
+#define INDEX_ID "FILTER-ECM/1"
+#define INDEX_TYPE "(ta(yixtxt))"
+#define INDEX_TYPE_GET "(t@a(yixtxt))"
+
+/* Number of sectors that are read from underlying stream and reconstructed
+   together, as a single decoded part */
+#define ECM_CHUNK_BLOCKS 32
+
 
 /**********************************************************************\
  *                          Private structure                         *
@@ -47,10 +56,8 @@ struct _MirageFilterStreamEcmPrivate
     gint num_parts;
     gint allocated_parts;
 
-    /* Cache */
-    gint cached_part;
-    gint cached_block;
-    guint8 buffer[2352];
+    /* Most recently accessed part; starting point for part lookup */
+    gint current_part;
 };
 
 
@@ -97,6 +104,96 @@ static gboolean mirage_filter_stream_ecm_append_part (MirageFilterStreamEcm *sel
     return TRUE;
 }
 
+static void mirage_filter_stream_ecm_save_index (MirageFilterStreamEcm *self, guint64 file_size)
+{
+    GVariantBuilder builder;
+
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a(yixtxt)"));
+    for (gint i = 0; i < self->priv->num_parts; i++) {
+        const ECM_Part *part = &self->priv->parts[i];
+        g_variant_builder_add(&builder, "(yixtxt)", part->type, part->num, (gint64)part->raw_offset, (guint64)part->raw_size, (gint64)part->offset, (guint64)part->size);
+    }
+
+    mirage_filter_stream_save_index(MIRAGE_FILTER_STREAM(self), INDEX_ID, g_variant_new(INDEX_TYPE, file_size, &builder));
+}
+
+static gboolean mirage_filter_stream_ecm_load_index (MirageFilterStreamEcm *self)
+{
+    GVariant *index;
+    GVariant *parts;
+    guint64 file_size;
+    guint64 offset = 0;
+    gsize num_parts;
+    gboolean succeeded = TRUE;
+
+    index = mirage_filter_stream_load_index(MIRAGE_FILTER_STREAM(self), INDEX_ID, G_VARIANT_TYPE(INDEX_TYPE));
+    if (!index) {
+        return FALSE;
+    }
+
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: loading cached part index\n", __debug__);
+
+    g_variant_get(index, INDEX_TYPE_GET, &file_size, &parts);
+
+    num_parts = g_variant_n_children(parts);
+    if (!num_parts || num_parts > G_MAXINT) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: invalid number of parts in cached index!\n", __debug__);
+        succeeded = FALSE;
+        goto end;
+    }
+
+    self->priv->parts = g_try_new(ECM_Part, num_parts);
+    if (!self->priv->parts) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to allocate %" G_GSIZE_FORMAT " ECM parts!\n", __debug__, num_parts);
+        succeeded = FALSE;
+        goto end;
+    }
+    self->priv->num_parts = self->priv->allocated_parts = num_parts;
+
+    for (gsize i = 0; i < num_parts; i++) {
+        ECM_Part *part = &self->priv->parts[i];
+        gint64 raw_offset, part_offset;
+        guint64 raw_size, size;
+
+        g_variant_get_child(parts, i, "(yixtxt)", &part->type, &part->num, &raw_offset, &raw_size, &part_offset, &size);
+        part->raw_offset = raw_offset;
+        part->raw_size = raw_size;
+        part->offset = part_offset;
+        part->size = size;
+
+        /* Validate the entry; parts must be contiguous */
+        if (part->type > 3 || part->num < 1 || raw_offset < (gint64)sizeof(ecm_signature) || part_offset < 0 || (guint64)part_offset != offset) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: invalid part #%" G_GSIZE_FORMAT " in cached index!\n", __debug__, i);
+            succeeded = FALSE;
+            goto end;
+        }
+        offset += size;
+    }
+
+    if (offset != file_size) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: size of parts in cached index does not match file size!\n", __debug__);
+        succeeded = FALSE;
+        goto end;
+    }
+
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: number of parts: %d!\n", __debug__, self->priv->num_parts);
+
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: file size: %" G_GINT64_MODIFIER "d (0x%" G_GINT64_MODIFIER "X)\n", __debug__, file_size, file_size);
+    mirage_filter_stream_simplified_set_stream_length(MIRAGE_FILTER_STREAM(self), file_size);
+
+end:
+    if (!succeeded) {
+        g_free(self->priv->parts);
+        self->priv->parts = NULL;
+        self->priv->num_parts = self->priv->allocated_parts = 0;
+    }
+
+    g_variant_unref(parts);
+    g_variant_unref(index);
+
+    return succeeded;
+}
+
 static gboolean mirage_filter_stream_ecm_build_index (MirageFilterStreamEcm *self, GError **error)
 {
     MirageStream *stream = mirage_filter_stream_get_underlying_stream(MIRAGE_FILTER_STREAM(self));
@@ -214,6 +311,9 @@ static gboolean mirage_filter_stream_ecm_build_index (MirageFilterStreamEcm *sel
     MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: file size: %" G_GINT64_MODIFIER "d (0x%" G_GINT64_MODIFIER "X)\n", __debug__, file_size, file_size);
     mirage_filter_stream_simplified_set_stream_length(MIRAGE_FILTER_STREAM(self), file_size);
 
+    /* Store index into cache, so that next time we can skip this */
+    mirage_filter_stream_ecm_save_index(self, file_size);
+
     MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: index building completed\n", __debug__);
 
     return TRUE;
@@ -244,12 +344,15 @@ static gboolean mirage_filter_stream_ecm_open (MirageFilterStream *_self, Mirage
 
     MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: parsing the underlying stream data...\n", __debug__);
 
-    /* Build index */
-    if (!mirage_filter_stream_ecm_build_index(self, error)) {
+    /* Load index from cache, or build it */
+    if (!mirage_filter_stream_ecm_load_index(self) && !mirage_filter_stream_ecm_build_index(self, error)) {
         MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: parsing failed!\n\n", __debug__);
         return FALSE;
     }
 
+    /* Decoded parts are chunks of reconstructed sectors */
+    mirage_filter_stream_simplified_set_part_size(_self, ECM_CHUNK_BLOCKS * 2352);
+
     MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: parsing completed successfully\n\n", __debug__);
 
     return TRUE;
@@ -261,8 +364,8 @@ static gint mirage_filter_stream_ecm_find_part (MirageFilterStreamEcm *self, gof
     const ECM_Part *part;
     gint part_index;
 
-    /* Check if position is within currently cached part */
-    part_index = self->priv->cached_part;
+    /* Check if position is within most recently accessed part */
+    part_index = self->priv->current_part;
     if (part_index != -1 ) {
         part = &self->priv->parts[part_index];
         if (position >= part->offset && position < (part->offset + part->size)) {
@@ -284,8 +387,8 @@ static gint mirage_filter_stream_ecm_find_part (MirageFilterStreamEcm *self, gof
         return part_index;
     }
 
-    /* Seek from currently cached part */
-    part_index = (self->priv->cached_part != -1) ? self->priv->cached_part : 0;
+    /* Seek from most recently accessed part */
+    part_index = (self->priv->current_part != -1) ? self->priv->current_part : 0;
     part = &self->priv->parts[part_index];
 
     if (position < part->offset) {
@@ -310,6 +413,179 @@ static gint mirage_filter_stream_ecm_find_part (MirageFilterStreamEcm *self, gof
     return -1;
 }
 
+static gint mirage_filter_stream_ecm_get_raw_block_size (guint8 type)
+{
+    switch (type) {
+        case ECM_MODE1_2352: return 3+2048;
+        case ECM_MODE2_FORM1_2336: return 4+2048;
+        case ECM_MODE2_FORM2_2336: return 4+2324;
+        default: return 0;
+    }
+}
+
+static gint mirage_filter_stream_ecm_get_block_size (guint8 type)
+{
+    switch (type) {
+        case ECM_MODE1_2352: return 2352;
+        case ECM_MODE2_FORM1_2336: return 2336;
+        case ECM_MODE2_FORM2_2336: return 2336;
+        default: return 0;
+    }
+}
+
+static GBytes *mirage_filter_stream_ecm_read_raw_part (MirageFilterStream *_self, guint64 index)
+{
+    MirageFilterStreamEcm *self = MIRAGE_FILTER_STREAM_ECM(_self);
+    MirageStream *stream = mirage_filter_stream_get_underlying_stream(_self);
+    const ECM_Part *part;
+    gint part_idx, chunk_idx;
+    gint first_block, num_blocks;
+    gint raw_block_size;
+    goffset stream_offset;
+    gsize raw_size;
+    guint8 *raw_data;
+
+    /* Part index is stored in upper, and chunk index in lower 32 bits */
+    part_idx = index >> 32;
+    chunk_idx = index & 0xFFFFFFFF;
+
+    if (part_idx >= self->priv->num_parts) {
+        return NULL;
+    }
+    part = &self->priv->parts[part_idx];
+
+    raw_block_size = mirage_filter_stream_ecm_get_raw_block_size(part->type);
+    if (!raw_block_size) {
+        return NULL;
+    }
+
+    first_block = chunk_idx * ECM_CHUNK_BLOCKS;
+    if (first_block >= part->num) {
+        return NULL;
+    }
+    num_blocks = MIN(ECM_CHUNK_BLOCKS, part->num - first_block);
+
+    /* Raw data of all blocks in the chunk is read at once */
+    stream_offset = part->raw_offset + (goffset)first_block*raw_block_size;
+    raw_size = num_blocks*raw_block_size;
+
+    if (!mirage_stream_seek(stream, stream_offset, G_SEEK_SET, NULL)) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to seek to %" G_GOFFSET_MODIFIER "d in underlying stream!\n", __debug__, stream_offset);
+        return NULL;
+    }
+
+    raw_data = g_malloc(raw_size);
+
+    if (mirage_stream_read(stream, raw_data, raw_size, NULL) != raw_size) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read %" G_GSIZE_MODIFIER "d bytes from underlying stream!\n", __debug__, raw_size);
+        g_free(raw_data);
+        return NULL;
+    }
+
+    return g_bytes_new_take(raw_data, raw_size);
+}
+
+static gssize mirage_filter_stream_ecm_decode_raw_part (MirageFilterStream *_self, guint64 index, GBytes *raw_data, guint8 *buffer, gsize buffer_size)
+{
+    MirageFilterStreamEcm *self = MIRAGE_FILTER_STREAM_ECM(_self);
+    const ECM_Part *part;
+    gint raw_block_size, block_size;
+    gint num_blocks;
+    gsize raw_size;
+    const guint8 *raw_buffer = g_bytes_get_data(raw_data, &raw_size);
+    guint8 sector[2352];
+
+    /* NOTE: this function may be called from worker threads; it must not
+       access the underlying stream or any other mutable state */
+    part = &self->priv->parts[index >> 32];
+
+    raw_block_size = mirage_filter_stream_ecm_get_raw_block_size(part->type);
+    block_size = mirage_filter_stream_ecm_get_block_size(part->type);
+    if (!raw_block_size) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: unhandled type %d!\n", __debug__, part->type);
+        return -1;
+    }
+
+    num_blocks = raw_size / raw_block_size;
+    if ((gsize)num_blocks*block_size > buffer_size) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: chunk with %d blocks does not fit into part buffer!\n", __debug__, num_blocks);
+        return -1;
+    }
+
+    /* Reconstruct sector data; the decoded chunk consists of consecutive
+       blocks, exactly as they appear in the decoded stream. Mode 1 sectors
+       are reconstructed in place, while Mode 2 sectors, which lack the
+       sync pattern and header, are reconstructed in a temporary buffer */
+    for (gint i = 0; i < num_blocks; i++) {
+        const guint8 *raw_block = raw_buffer + i*raw_block_size;
+        guint8 *block = buffer + i*block_size;
+
+        switch (part->type) {
+            case ECM_MODE1_2352: {
+                /* Copy data */
+                memcpy(block+0x00C, raw_block, 0x003);
+                memcpy(block+0x010, raw_block+0x003, 0x800);
+
+                /* Set sync pattern */
+                memcpy(block, mirage_pattern_sync, sizeof(mirage_pattern_sync));
+
+                /* Set mode byte in header */
+                block[0x00F] = 1;
+
+                /* Clear intermediate field; it is covered by ECC, and the
+                   buffer may contain data from elsewhere */
+                memset(block+0x814, 0, 8);
+
+                /* Generate EDC */
+                mirage_helper_sector_edc_ecc_compute_edc_block(block+0x000, 0x810, block+0x810);
+
+                /* Generate ECC P/Q codes */
+                mirage_helper_sector_edc_ecc_compute_ecc_block(block+0x00C, 86, 24, 2, 86, block+0x81C); /* P */
+                mirage_helper_sector_edc_ecc_compute_ecc_block(block+0x00C, 52, 43, 86, 88, block+0x8C8); /* Q */
+
+                break;
+            }
+            case ECM_MODE2_FORM1_2336: {
+                /* Copy data */
+                memcpy(sector+0x014, raw_block, 0x804);
+
+                /* Make sure that header fields are zeroed out */
+                memset(sector+0x00C, 0, 4);
+
+                /* Duplicate subheader */
+                memcpy(sector+0x010, sector+0x014, 4);
+
+                /* Generate EDC */
+                mirage_helper_sector_edc_ecc_compute_edc_block(sector+0x010, 0x808, sector+0x818);
+
+                /* Generate ECC P/Q codes */
+                mirage_helper_sector_edc_ecc_compute_ecc_block(sector+0x00C, 86, 24, 2, 86, sector+0x81C); /* P */
+                mirage_helper_sector_edc_ecc_compute_ecc_block(sector+0x00C, 52, 43, 86, 88, sector+0x8C8); /* Q */
+
+                memcpy(block, sector+0x010, 2336);
+
+                break;
+            }
+            case ECM_MODE2_FORM2_2336: {
+                /* Copy data */
+                memcpy(sector+0x014, raw_block, 0x918);
+
+                /* Duplicate subheader */
+                memcpy(sector+0x010, sector+0x014, 4);
+
+                /* Generate EDC */
+                mirage_helper_sector_edc_ecc_compute_edc_block(sector+0x010, 0x91C, sector+0x92C);
+
+                memcpy(block, sector+0x010, 2336);
+
+                break;
+            }
+        }
+    }
+
+    return num_blocks*block_size;
+}
+
 static gssize mirage_filter_stream_ecm_partial_read (MirageFilterStream *_self, void *buffer, gsize count)
 {
     MirageFilterStreamEcm *self = MIRAGE_FILTER_STREAM_ECM(_self);
@@ -320,8 +596,10 @@ static gssize mirage_filter_stream_ecm_partial_read (MirageFilterStream *_self,
 
     goffset part_offset, stream_offset;
 
-    gint block_idx;
-    gint block_size, raw_block_size, skip_bytes;
+    gint chunk_idx;
+    gint block_size;
+    gsize chunk_offset, chunk_length;
+    const guint8 *chunk_data;
 
     /* Find part that corresponds to current position */
     part_idx = mirage_filter_stream_ecm_find_part(self, position);
@@ -363,23 +641,14 @@ static gssize mirage_filter_stream_ecm_partial_read (MirageFilterStream *_self,
         }
         case ECM_MODE1_2352: {
             MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: part type: Mode 1 (2051 -> 2352)\n", __debug__);
-            block_size = 2352;
-            raw_block_size = 3+2048;
-            skip_bytes = 0;
             break;
         }
         case ECM_MODE2_FORM1_2336: {
             MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: part type: Mode 2 Form 1 (2052 -> 2336)\n", __debug__);
-            block_size = 2336;
-            raw_block_size = 4+2048;
-            skip_bytes = 16;
             break;
         }
         case ECM_MODE2_FORM2_2336: {
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: part type: Mode 2 Form 1 (2328 -> 2336)\n", __debug__);
-            block_size = 2336;
-            raw_block_size = 4+2324;
-            skip_bytes = 16;
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: part type: Mode 2 Form 2 (2328 -> 2336)\n", __debug__);
             break;
         }
         default: {
@@ -388,109 +657,32 @@ static gssize mirage_filter_stream_ecm_partial_read (MirageFilterStream *_self,
         }
     }
 
-    /* Compute the block number within part */
-    block_idx = part_offset / block_size;
+    /* Compute the chunk number within part */
+    block_size = mirage_filter_stream_ecm_get_block_size(part->type);
+    chunk_idx = part_offset / (block_size * ECM_CHUNK_BLOCKS);
+    chunk_offset = part_offset % (block_size * ECM_CHUNK_BLOCKS);
 
-    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: reading from block %d in part %d\n", __debug__, block_idx, part_idx);
-
-    /* If this particular block in this particular part is not cached,
-       read the data and reconstruct ECC/EDC */
-    if (part_idx != self->priv->cached_part || block_idx != self->priv->cached_block) {
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: block not cached, reading...\n", __debug__);
-
-        /* Compute offset within underlying stream */
-        stream_offset = part->raw_offset + block_idx*raw_block_size;
-
-        if (!mirage_stream_seek(stream, stream_offset, G_SEEK_SET, NULL)) {
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to seek to %" G_GOFFSET_MODIFIER "d in underlying stream!\n", __debug__, part_offset);
-            return -1;
-        }
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: reading from chunk %d in part %d\n", __debug__, chunk_idx, part_idx);
 
-        /* Read and reconstruct sector data */
-        switch (part->type) {
-            case ECM_MODE1_2352: {
-                /* Read data */
-                if (mirage_stream_read(stream, self->priv->buffer+0x00C, 0x003, NULL) != 0x003) {
-                    MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read %d bytes from underlying stream!\n", __debug__, 0x003);
-                    return -1;
-                }
-                if (mirage_stream_read(stream, self->priv->buffer+0x010, 0x800, NULL) != 0x800) {
-                    MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read %d bytes from underlying stream!\n", __debug__, 0x800);
-                    return -1;
-                }
-
-                /* Set sync pattern */
-                memcpy(self->priv->buffer, mirage_pattern_sync, sizeof(mirage_pattern_sync));
-
-                /* Set mode byte in header */
-                self->priv->buffer[0x00F] = 1;
-
-                /* Generate EDC */
-                mirage_helper_sector_edc_ecc_compute_edc_block(self->priv->buffer+0x000, 0x810, self->priv->buffer+0x810);
-
-                /* Generate ECC P/Q codes */
-                mirage_helper_sector_edc_ecc_compute_ecc_block(self->priv->buffer+0x00C, 86, 24, 2, 86, self->priv->buffer+0x81C); /* P */
-                mirage_helper_sector_edc_ecc_compute_ecc_block(self->priv->buffer+0x00C, 52, 43, 86, 88, self->priv->buffer+0x8C8); /* Q */
-
-                break;
-            }
-            case ECM_MODE2_FORM1_2336: {
-                /* Read data */
-                if (mirage_stream_read(stream, self->priv->buffer+0x014, 0x804, NULL) != 0x804) {
-                    MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read %d bytes from underlying stream!\n", __debug__, 0x804);
-                    return -1;
-                }
-
-                /* Make sure that header fields are zeroed out */
-                memset(self->priv->buffer+0x00C, 0, 4);
-
-                /* Duplicate subheader */
-                memcpy(self->priv->buffer+0x010, self->priv->buffer+0x014, 4);
-
-                /* Generate EDC */
-                mirage_helper_sector_edc_ecc_compute_edc_block(self->priv->buffer+0x010, 0x808, self->priv->buffer+0x818);
-
-                /* Generate ECC P/Q codes */
-                mirage_helper_sector_edc_ecc_compute_ecc_block(self->priv->buffer+0x00C, 86, 24, 2, 86, self->priv->buffer+0x81C); /* P */
-                mirage_helper_sector_edc_ecc_compute_ecc_block(self->priv->buffer+0x00C, 52, 43, 86, 88, self->priv->buffer+0x8C8); /* Q */
-
-                break;
-            }
-            case ECM_MODE2_FORM2_2336: {
-                /* Read data */
-                if (mirage_stream_read(stream, self->priv->buffer+0x014, 0x918, NULL) != 0x918) {
-                    MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read %d bytes from underlying stream!\n", __debug__, 0x918);
-                    return -1;
-                }
-
-                /* Duplicate subheader */
-                memcpy(self->priv->buffer+0x010, self->priv->buffer+0x014, 4);
-
-                /* Generate EDC */
-                mirage_helper_sector_edc_ecc_compute_edc_block(self->priv->buffer+0x010, 0x91C, self->priv->buffer+0x92C);
-
-                break;
-            }
-            default: {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: unhandled type %d!\n", __debug__, part->type);
-                return -1;
-            }
-        }
+    /* Get reconstructed sector data */
+    chunk_data = mirage_filter_stream_simplified_get_part(_self, ((guint64)part_idx << 32) | chunk_idx, &chunk_length);
+    if (!chunk_data) {
+        return -1;
+    }
+    self->priv->current_part = part_idx;
 
-        /* Set currently cached block and part */
-        self->priv->cached_part = part_idx;
-        self->priv->cached_block = block_idx;
-    } else {
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: block already cached\n", __debug__);
+    if (chunk_offset >= chunk_length) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: offset %" G_GSIZE_MODIFIER "d beyond end of chunk!\n", __debug__, chunk_offset);
+        return -1;
     }
 
-    /* Copy data */
-    gint block_offset = part_offset % block_size;
-    count = MIN(count, block_size - block_offset);
+    /* Copy data; decoded chunk is contiguous, so we can copy across
+       block boundaries */
+    count = MIN(count, chunk_length - chunk_offset);
 
-    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: offset within block: %d, copying %" G_GSIZE_MODIFIER "d bytes\n", __debug__, block_offset, count);
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: offset within chunk: %" G_GSIZE_MODIFIER "d, copying %" G_GSIZE_MODIFIER "d bytes\n", __debug__, chunk_offset, count);
 
-    memcpy(buffer, self->priv->buffer + skip_bytes + block_offset, count);
+    memcpy(buffer, chunk_data + chunk_offset, count);
 
     return count;
 }
@@ -528,8 +720,7 @@ static void mirage_filter_stream_ecm_init (MirageFilterStreamEcm *self)
     self->priv->num_parts = 0;
     self->priv->parts = NULL;
 
-    self->priv->cached_part = -1;
-    self->priv->cached_block = -1;
+    self->priv->current_part = -1;
 }
 
 static void mirage_filter_stream_ecm_finalize (GObject *gobject)
@@ -552,6 +743,8 @@ static void mirage_filter_stream_ecm_class_init (MirageFilterStreamEcmClass *kla
     filter_stream_class->open = mirage_filter_stream_ecm_open;
 
     filter_stream_class->simplified_partial_read = mirage_filter_stream_ecm_partial_read;
+    filter_stream_class->simplified_read_raw_part = mirage_filter_stream_ecm_read_raw_part;
+    filter_stream_class->simplified_decode_raw_part = mirage_filter_stream_ecm_decode_raw_part;
 }
 
 static void mirage_filter_stream_ecm_class_finalize (MirageFilterStreamEcmClass *klass G_GNUC_UNUSED)
@@ -27,12 +27,18 @@
 #define WINSIZE 32768 /* sliding window size - 32 kB */
 #define CHUNKSIZE 16384 /* file input buffer size - 16 kB */
 
+/* Index cache; ID needs to be changed whenever index format changes */
+#define INDEX_ID "FILTER-GZIP/1"
+#define INDEX_TYPE "(tta(xxyay))"
+#define INDEX_TYPE_GET "(tt@a(xxyay))"
+
 typedef struct
 {
     goffset offset;
     gint size;
 
     goffset raw_offset;
+    gint raw_size;
     gint bits;
     guint8 window[WINSIZE];
 } GZIP_Part;
@@ -58,10 +64,8 @@ struct _MirageFilterStreamGzipPrivate
     gint num_parts;
     gint allocated_parts;
 
-    /* Cache */
-    gint cached_part;
-    guint8 *part_buffer;
-    gint part_buffer_size;
+    /* Most recently accessed part; starting point for part lookup */
+    gint current_part;
 
     /* Zlib stream */
     z_stream zlib_stream;
@@ -71,17 +75,27 @@ struct _MirageFilterStreamGzipPrivate
 /**********************************************************************\
  *                           Part indexing                            *
 \**********************************************************************/
-static gboolean mirage_filter_stream_gzip_compute_part_sizes (MirageFilterStreamGzip *self, guint64 file_size, GError **error)
+static goffset mirage_filter_stream_gzip_get_raw_start (const GZIP_Part *part)
+{
+    /* If part does not start at byte boundary, its first bits are stored
+       in the preceding byte */
+    return part->bits ? part->raw_offset - 1 : part->raw_offset;
+}
+
+static void mirage_filter_stream_gzip_compute_part_sizes (MirageFilterStreamGzip *self, guint64 file_size, guint64 raw_file_size)
 {
     GZIP_Part *part;
     gint max_size = 0;
 
-    /* Compute sizes for all parts but last one, based on their offsets */
+    /* Compute sizes for all parts but last one, based on their offsets;
+       compressed data of a part ends within the byte preceding the next
+       part's raw offset */
     for (gint i = 0; i < self->priv->num_parts - 1; i++) {
         part = &self->priv->parts[i];
 
         part->size = (part+1)->offset - part->offset;
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: part #%d: offset: %" G_GOFFSET_MODIFIER "d, size: %d\n", __debug__, i, part->offset, part->size);
+        part->raw_size = (part+1)->raw_offset - mirage_filter_stream_gzip_get_raw_start(part);
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: part #%d: offset: %" G_GOFFSET_MODIFIER "d, size: %d, raw size: %d\n", __debug__, i, part->offset, part->size, part->raw_size);
 
         max_size = MAX(max_size, part->size);
     }
@@ -89,21 +103,15 @@ static gboolean mirage_filter_stream_gzip_compute_part_sizes (MirageFilterStream
     /* Last part size */
     part = &self->priv->parts[self->priv->num_parts-1];
     part->size = file_size - part->offset;
-    MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: part #%d: offset: %" G_GOFFSET_MODIFIER "d, size: %d\n", __debug__, self->priv->num_parts-1, part->offset, part->size);
+    part->raw_size = raw_file_size - mirage_filter_stream_gzip_get_raw_start(part);
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: part #%d: offset: %" G_GOFFSET_MODIFIER "d, size: %d, raw size: %d\n", __debug__, self->priv->num_parts-1, part->offset, part->size, part->raw_size);
 
     max_size = MAX(max_size, part->size);
 
     MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: largest part size: %d\n", __debug__, max_size);
 
-    /* Allocate part buffer */
-    self->priv->part_buffer_size = max_size;
-    self->priv->part_buffer = g_try_malloc(self->priv->part_buffer_size);
-    if (!self->priv->part_buffer) {
-        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_STREAM_ERROR, Q_("Failed to allocate part buffer (%d bytes)!"), self->priv->part_buffer_size);
-        return FALSE;
-    }
-
-    return TRUE;
+    /* Set part size for part cache */
+    mirage_filter_stream_simplified_set_part_size(MIRAGE_FILTER_STREAM(self), max_size);
 }
 
 static gboolean mirage_filter_stream_gzip_append_part (MirageFilterStreamGzip *self, gint bits, goffset raw_offset, goffset offset, gint left, guint8 *window, GError **error)
@@ -149,12 +157,125 @@ static gboolean mirage_filter_stream_gzip_append_part (MirageFilterStreamGzip *s
     return TRUE;
 }
 
+static void mirage_filter_stream_gzip_save_index (MirageFilterStreamGzip *self, guint64 file_size, guint64 raw_file_size)
+{
+    GVariantBuilder builder;
+
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a(xxyay)"));
+    for (gint i = 0; i < self->priv->num_parts; i++) {
+        const GZIP_Part *part = &self->priv->parts[i];
+        g_variant_builder_add(&builder, "(xxy@ay)", part->offset, part->raw_offset, part->bits, g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, part->window, WINSIZE, sizeof(guint8)));
+    }
+
+    mirage_filter_stream_save_index(MIRAGE_FILTER_STREAM(self), INDEX_ID, g_variant_new(INDEX_TYPE, file_size, raw_file_size, &builder));
+}
+
+static gboolean mirage_filter_stream_gzip_load_index (MirageFilterStreamGzip *self)
+{
+    MirageStream *stream = mirage_filter_stream_get_underlying_stream(MIRAGE_FILTER_STREAM(self));
+    goffset stream_length;
+    GVariant *index;
+    GVariant *parts;
+    guint64 file_size, raw_file_size;
+    gsize num_parts;
+    gboolean succeeded = TRUE;
+
+    index = mirage_filter_stream_load_index(MIRAGE_FILTER_STREAM(self), INDEX_ID, G_VARIANT_TYPE(INDEX_TYPE));
+    if (!index) {
+        return FALSE;
+    }
+
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: loading cached part index\n", __debug__);
+
+    g_variant_get(index, INDEX_TYPE_GET, &file_size, &raw_file_size, &parts);
+
+    /* Compressed data must fit into underlying stream */
+    mirage_stream_seek(stream, 0, G_SEEK_END, NULL);
+    stream_length = mirage_stream_tell(stream);
+    if (!raw_file_size || raw_file_size > (guint64)stream_length) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: invalid compressed size in cached index!\n", __debug__);
+        succeeded = FALSE;
+        goto end;
+    }
+
+    num_parts = g_variant_n_children(parts);
+    if (!num_parts || num_parts > G_MAXINT) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: invalid number of parts in cached index!\n", __debug__);
+        succeeded = FALSE;
+        goto end;
+    }
+
+    self->priv->parts = g_try_new(GZIP_Part, num_parts);
+    if (!self->priv->parts) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to allocate %" G_GSIZE_FORMAT " GZIP parts!\n", __debug__, num_parts);
+        succeeded = FALSE;
+        goto end;
+    }
+    self->priv->num_parts = self->priv->allocated_parts = num_parts;
+
+    for (gsize i = 0; i < num_parts; i++) {
+        GZIP_Part *part = &self->priv->parts[i];
+        GVariant *window;
+        const guint8 *window_data;
+        gsize window_size;
+        guint8 bits;
+
+        g_variant_get_child(parts, i, "(xxy@ay)", &part->offset, &part->raw_offset, &bits, &window);
+        part->bits = bits;
+
+        window_data = g_variant_get_fixed_array(window, &window_size, sizeof(guint8));
+        if (window_size == WINSIZE) {
+            memcpy(part->window, window_data, WINSIZE);
+        }
+        g_variant_unref(window);
+
+        /* Validate the entry; parts must cover the whole file without holes
+           (i.e., the first one starts at offset 0), and both their offsets
+           and compressed data must be strictly increasing */
+        if (window_size != WINSIZE || part->bits > 7 || part->raw_offset < 1 || (guint64)part->raw_offset > raw_file_size
+            || part->offset < 0 || (guint64)part->offset >= file_size
+            || (i == 0 && part->offset != 0)
+            || (i > 0 && (part->offset <= (part-1)->offset || part->raw_offset <= mirage_filter_stream_gzip_get_raw_start(part-1)))) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: invalid part #%" G_GSIZE_FORMAT " in cached index!\n", __debug__, i);
+            succeeded = FALSE;
+            goto end;
+        }
+    }
+
+    /* Last part's compressed data must not be empty */
+    if (raw_file_size <= (guint64)mirage_filter_stream_gzip_get_raw_start(&self->priv->parts[num_parts-1])) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: invalid compressed size in cached index!\n", __debug__);
+        succeeded = FALSE;
+        goto end;
+    }
+
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: number of parts: %d\n", __debug__, self->priv->num_parts);
+
+    mirage_filter_stream_gzip_compute_part_sizes(self, file_size, raw_file_size);
+
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: file size: %" G_GINT64_MODIFIER "d (0x%" G_GINT64_MODIFIER "X)\n", __debug__, file_size, file_size);
+    mirage_filter_stream_simplified_set_stream_length(MIRAGE_FILTER_STREAM(self), file_size);
+
+end:
+    if (!succeeded) {
+        g_free(self->priv->parts);
+        self->priv->parts = NULL;
+        self->priv->num_parts = self->priv->allocated_parts = 0;
+    }
+
+    g_variant_unref(parts);
+    g_variant_unref(index);
+
+    return succeeded;
+}
+
 static gboolean mirage_filter_stream_gzip_build_index (MirageFilterStreamGzip *self, GError **error)
 {
     MirageStream *stream = mirage_filter_stream_get_underlying_stream(MIRAGE_FILTER_STREAM(self));
     z_stream *zlib_stream = &self->priv->zlib_stream;
 
     goffset totalIn, totalOut, last;
+    goffset raw_file_size;
     gint ret;
 
 
@@ -258,15 +379,18 @@ static gboolean mirage_filter_stream_gzip_build_index (MirageFilterStreamGzip *s
     /* Release unused allocated parts */
     self->priv->parts = g_renew(GZIP_Part, self->priv->parts, self->priv->num_parts);
 
-    /* Compute sizes of parts and allocate part buffer */
-    if (!mirage_filter_stream_gzip_compute_part_sizes(self, totalOut, error)) {
-        return FALSE;
-    }
+    /* Compute sizes of parts; the compressed data ends within the last
+       chunk that we have read */
+    raw_file_size = mirage_stream_tell(stream);
+    mirage_filter_stream_gzip_compute_part_sizes(self, totalOut, raw_file_size);
 
     /* Store file size (= totalOut) */
     MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: file size: %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X)\n", __debug__, totalOut, totalOut);
     mirage_filter_stream_simplified_set_stream_length(MIRAGE_FILTER_STREAM(self), totalOut);
 
+    /* Store index into cache, so that next time we can skip this */
+    mirage_filter_stream_gzip_save_index(self, totalOut, raw_file_size);
+
     MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: index building completed\n", __debug__);
 
     return TRUE;
@@ -297,8 +421,8 @@ static gboolean mirage_filter_stream_gzip_open (MirageFilterStream *_self, Mirag
 
     MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: parsing the underlying stream data...\n", __debug__);
 
-    /* Build index */
-    if (!mirage_filter_stream_gzip_build_index(self, error)) {
+    /* Load index from cache, or build it */
+    if (!mirage_filter_stream_gzip_load_index(self) && !mirage_filter_stream_gzip_build_index(self, error)) {
         MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: parsing failed!\n\n", __debug__);
         return FALSE;
     }
@@ -314,8 +438,8 @@ static gint mirage_filter_stream_gzip_find_part (MirageFilterStreamGzip *self, g
     const GZIP_Part *part;
     gint part_index;
 
-    /* Check if position is within currently cached part */
-    part_index = self->priv->cached_part;
+    /* Check if position is within most recently accessed part */
+    part_index = self->priv->current_part;
     if (part_index != -1 ) {
         part = &self->priv->parts[part_index];
         if (position >= part->offset && position < (part->offset + part->size)) {
@@ -337,8 +461,8 @@ static gint mirage_filter_stream_gzip_find_part (MirageFilterStreamGzip *self, g
         return part_index;
     }
 
-    /* Seek from currently cached part */
-    part_index = (self->priv->cached_part != -1) ? self->priv->cached_part : 0;
+    /* Seek from most recently accessed part */
+    part_index = (self->priv->current_part != -1) ? self->priv->current_part : 0;
     part = &self->priv->parts[part_index];
 
     if (position < part->offset) {
@@ -363,98 +487,117 @@ static gint mirage_filter_stream_gzip_find_part (MirageFilterStreamGzip *self, g
     return -1;
 }
 
-static gssize mirage_filter_stream_gzip_partial_read (MirageFilterStream *_self, void *buffer, gsize count)
+static GBytes *mirage_filter_stream_gzip_read_raw_part (MirageFilterStream *_self, guint64 index)
 {
     MirageFilterStreamGzip *self = MIRAGE_FILTER_STREAM_GZIP(_self);
     MirageStream *stream = mirage_filter_stream_get_underlying_stream(_self);
-    goffset position = mirage_filter_stream_simplified_get_position(_self);
     const GZIP_Part *part;
-    gint part_idx;
+    goffset underlying_stream_offset;
+    guint8 *raw_data;
 
-    /* Find part that corresponds to current position */
-    part_idx = mirage_filter_stream_gzip_find_part(self, position);
-    if (part_idx == -1) {
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) beyond end of stream, doing nothing!\n", __debug__, position, position);
-        return 0;
+    if (index >= (guint64)self->priv->num_parts) {
+        return NULL;
     }
-    part = &self->priv->parts[part_idx];
+    part = &self->priv->parts[index];
 
-    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position: %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) -> part #%d (cached: #%d)\n", __debug__, position, position, part_idx, self->priv->cached_part);
+    /* Offset in underlying stream */
+    underlying_stream_offset = mirage_filter_stream_gzip_get_raw_start(part);
 
-    /* If we do not have part in cache, uncompress it */
-    if (part_idx != self->priv->cached_part) {
-        z_stream *zlib_stream = &self->priv->zlib_stream;
-        goffset underlying_stream_offset;
-        gint ret;
+    /* Seek to the position */
+    if (!mirage_stream_seek(stream, underlying_stream_offset, G_SEEK_SET, NULL)) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to seek to %" G_GOFFSET_MODIFIER "d in underlying stream!\n", __debug__, underlying_stream_offset);
+        return NULL;
+    }
 
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: part not cached, reading...\n", __debug__);
+    /* Read part's compressed data */
+    raw_data = g_try_malloc(part->raw_size);
+    if (!raw_data) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to allocate buffer for part (%d bytes)!\n", __debug__, part->raw_size);
+        return NULL;
+    }
 
-        /* Offset in underlying stream */
-        underlying_stream_offset = part->raw_offset;
-        if (part->bits) {
-            underlying_stream_offset--;
-        }
+    if (mirage_stream_read(stream, raw_data, part->raw_size, NULL) != part->raw_size) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read %d bytes from underlying stream!\n", __debug__, part->raw_size);
+        g_free(raw_data);
+        return NULL;
+    }
 
-        /* Seek to the position */
-        if (!mirage_stream_seek(stream, underlying_stream_offset, G_SEEK_SET, NULL)) {
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to seek to %" G_GOFFSET_MODIFIER "d in underlying stream!\n", __debug__, underlying_stream_offset);
-            return -1;
-        }
+    return g_bytes_new_take(raw_data, part->raw_size);
+}
 
-        /* Reset inflate engine */
-        ret = inflateReset2(zlib_stream, -15); /* -15 = raw inflate */
-        if (ret != Z_OK) {
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to reset inflate engine!\n", __debug__);
-            return -1;
-        }
+static gssize mirage_filter_stream_gzip_decode_raw_part (MirageFilterStream *_self, guint64 index, GBytes *raw_data, guint8 *buffer, gsize buffer_size G_GNUC_UNUSED)
+{
+    MirageFilterStreamGzip *self = MIRAGE_FILTER_STREAM_GZIP(_self);
+    const GZIP_Part *part = &self->priv->parts[index];
+    z_stream zlib_stream;
+    gsize raw_size;
+    const guint8 *raw_buffer = g_bytes_get_data(raw_data, &raw_size);
+    gint ret;
 
-        /* Initialize inflate on the part */
-        if (part->bits) {
-            guint8 value;
-            ret = mirage_stream_read(stream, &value, sizeof(value), NULL);
-            if (ret != sizeof(value)) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read bits!\n", __debug__);
-                return -1;
-            }
-            inflatePrime(zlib_stream, part->bits, value >> (8 - part->bits));
-        }
-        inflateSetDictionary(zlib_stream, part->window, WINSIZE);
+    /* NOTE: this function may be called from worker threads, so we use
+       a private inflate engine */
+    zlib_stream.zalloc = Z_NULL;
+    zlib_stream.zfree = Z_NULL;
+    zlib_stream.opaque = Z_NULL;
+    zlib_stream.avail_in = 0;
+    zlib_stream.next_in = Z_NULL;
 
-        /* Uncompress whole part */
-        zlib_stream->avail_in = 0;
-        zlib_stream->avail_out = part->size;
-        zlib_stream->next_out = self->priv->part_buffer;
+    ret = inflateInit2(&zlib_stream, -15); /* -15 = raw inflate */
+    if (ret != Z_OK) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to initialize inflate engine (error: %d)!\n", __debug__, ret);
+        return -1;
+    }
 
-        do {
-            /* Read */
-            if (!zlib_stream->avail_in) {
-                /* Read some compressed data */
-                ret = mirage_stream_read(stream, self->priv->io_buffer, self->priv->io_buffer_size, NULL);
-                if (ret == -1) {
-                    MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read %d bytes from underlying stream!", __debug__, CHUNKSIZE);
-                    return -1;
-                } else if (ret == 0) {
-                    MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: inexpectedly reached EOF!", __debug__);
-                    return -1;
-                }
-                zlib_stream->avail_in = ret;
-                zlib_stream->next_in = self->priv->io_buffer;
-            }
+    /* Initialize inflate on the part */
+    if (part->bits) {
+        inflatePrime(&zlib_stream, part->bits, raw_buffer[0] >> (8 - part->bits));
+        raw_buffer++;
+        raw_size--;
+    }
+    inflateSetDictionary(&zlib_stream, part->window, WINSIZE);
+
+    /* Uncompress whole part */
+    zlib_stream.avail_in = raw_size;
+    zlib_stream.next_in = (guint8 *)raw_buffer;
+    zlib_stream.avail_out = part->size;
+    zlib_stream.next_out = buffer;
+
+    ret = inflate(&zlib_stream, Z_NO_FLUSH);
+    if (ret == Z_NEED_DICT || ret == Z_MEM_ERROR || ret == Z_DATA_ERROR || zlib_stream.avail_out) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to inflate part: %s!\n", __debug__, zlib_stream.msg);
+        inflateEnd(&zlib_stream);
+        return -1;
+    }
 
-            /* Inflate */
-            ret = inflate(zlib_stream, Z_NO_FLUSH);
-            if (ret == Z_NEED_DICT || ret == Z_MEM_ERROR || ret == Z_DATA_ERROR) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to inflate part: %s!", __debug__, zlib_stream->msg);
-                return -1;
-            }
-        } while (zlib_stream->avail_out);
+    inflateEnd(&zlib_stream);
 
+    return part->size;
+}
 
-        /* Set currently cached part */
-        self->priv->cached_part = part_idx;
-    } else {
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: part already cached\n", __debug__);
+static gssize mirage_filter_stream_gzip_partial_read (MirageFilterStream *_self, void *buffer, gsize count)
+{
+    MirageFilterStreamGzip *self = MIRAGE_FILTER_STREAM_GZIP(_self);
+    goffset position = mirage_filter_stream_simplified_get_position(_self);
+    const GZIP_Part *part;
+    const guint8 *part_data;
+    gint part_idx;
+
+    /* Find part that corresponds to current position */
+    part_idx = mirage_filter_stream_gzip_find_part(self, position);
+    if (part_idx == -1) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) beyond end of stream, doing nothing!\n", __debug__, position, position);
+        return 0;
+    }
+    part = &self->priv->parts[part_idx];
+
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position: %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) -> part #%d\n", __debug__, position, position, part_idx);
+
+    /* Get decoded part */
+    part_data = mirage_filter_stream_simplified_get_part(_self, part_idx, NULL);
+    if (!part_data) {
+        return -1;
     }
+    self->priv->current_part = part_idx;
 
     /* Copy data */
     goffset part_offset = position - part->offset;
@@ -462,7 +605,7 @@ static gssize mirage_filter_stream_gzip_partial_read (MirageFilterStream *_self,
 
     MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: offset within part: %" G_GOFFSET_MODIFIER "d, copying %" G_GSIZE_MODIFIER "d bytes\n", __debug__, part_offset, count);
 
-    memcpy(buffer, self->priv->part_buffer + part_offset, count);
+    memcpy(buffer, part_data + part_offset, count);
 
     return count;
 }
@@ -495,7 +638,7 @@ static void mirage_filter_stream_gzip_init (MirageFilterStreamGzip *self)
         Q_("gzip-compressed images (*.gz)"), "application/x-gzip"
     );
 
-    self->priv->cached_part = -1;
+    self->priv->current_part = -1;
 
     self->priv->allocated_parts = 0;
     self->priv->num_parts = 0;
@@ -503,7 +646,6 @@ static void mirage_filter_stream_gzip_init (MirageFilterStreamGzip *self)
 
     self->priv->io_buffer = NULL;
     self->priv->window_buffer = NULL;
-    self->priv->part_buffer = NULL;
 }
 
 static void mirage_filter_stream_gzip_finalize (GObject *gobject)
@@ -511,7 +653,6 @@ static void mirage_filter_stream_gzip_finalize (GObject *gobject)
     MirageFilterStreamGzip *self = MIRAGE_FILTER_STREAM_GZIP(gobject);
 
     g_free(self->priv->parts);
-    g_free(self->priv->part_buffer);
 
     g_free(self->priv->io_buffer);
     g_free(self->priv->window_buffer);
@@ -532,6 +673,8 @@ static void mirage_filter_stream_gzip_class_init (MirageFilterStreamGzipClass *k
     filter_stream_class->open = mirage_filter_stream_gzip_open;
 
     filter_stream_class->simplified_partial_read = mirage_filter_stream_gzip_partial_read;
+    filter_stream_class->simplified_read_raw_part = mirage_filter_stream_gzip_read_raw_part;
+    filter_stream_class->simplified_decode_raw_part = mirage_filter_stream_gzip_decode_raw_part;
 }
 
 static void mirage_filter_stream_gzip_class_finalize (MirageFilterStreamGzipClass *klass G_GNUC_UNUSED)
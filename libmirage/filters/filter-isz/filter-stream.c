@@ -42,11 +42,6 @@ struct _MirageFilterStreamIszPrivate
     ISZ_Chunk *parts;
     gint num_parts;
 
-    /* Inflate buffer */
-    guint8 *inflate_buffer;
-    gint inflate_buffer_size;
-    gint cached_part;
-
     /* I/O buffer */
     guint8 *io_buffer;
     gint io_buffer_size;
@@ -496,13 +491,8 @@ static gboolean mirage_filter_stream_isz_read_index (MirageFilterStreamIsz *self
         return FALSE;
     }
 
-    /* Allocate inflate buffer */
-    self->priv->inflate_buffer_size = header->block_size;
-    self->priv->inflate_buffer = g_try_malloc(self->priv->inflate_buffer_size);
-    if (!self->priv->inflate_buffer) {
-        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_STREAM_ERROR, Q_("Failed to allocate memory for inflate buffer!"));
-        return FALSE;
-    }
+    /* Set part size for part cache */
+    mirage_filter_stream_simplified_set_part_size(MIRAGE_FILTER_STREAM(self), header->block_size);
 
     /* Allocate I/O buffer */
     self->priv->io_buffer_size = header->block_size;
@@ -675,121 +665,125 @@ static gssize mirage_filter_stream_isz_read_raw_chunk (MirageFilterStreamIsz *se
     return have_read;
 }
 
-static gssize mirage_filter_stream_isz_partial_read (MirageFilterStream *_self, void *buffer, gsize count)
+static gssize mirage_filter_stream_isz_decode_part (MirageFilterStream *_self, guint64 index, guint8 *buffer, gsize buffer_size)
 {
     MirageFilterStreamIsz *self = MIRAGE_FILTER_STREAM_ISZ(_self);
-    goffset position = mirage_filter_stream_simplified_get_position(MIRAGE_FILTER_STREAM(self));
-    gint part_idx;
-
-    /* Find part that corresponds to current position */
-    part_idx = position / self->priv->header.block_size;
-
-    if (part_idx >= self->priv->num_parts) {
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) beyond end of stream, doing nothing!\n", __debug__, position, position);
-        return 0;
-    }
+    gint part_idx = index;
+    const ISZ_Chunk *part = &self->priv->parts[part_idx];
+    z_stream  *zlib_stream = &self->priv->zlib_stream;
+    bz_stream *bzip2_stream = &self->priv->bzip2_stream;
 
-    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position: %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) -> part #%d (cached: #%d)\n", __debug__, position, position, part_idx, self->priv->cached_part);
+    gint ret;
 
-    /* If we do not have part in cache, uncompress it */
-    if (part_idx != self->priv->cached_part) {
-        const ISZ_Chunk *part = &self->priv->parts[part_idx];
-        z_stream  *zlib_stream = &self->priv->zlib_stream;
-        bz_stream *bzip2_stream = &self->priv->bzip2_stream;
+    /* Read a part, either zero, raw or compressed */
+    if (part->type == ZERO) {
+        /* Return a zero-filled buffer */
+        memset (buffer, 0, buffer_size);
+    } else if (part->type == DATA) {
+        /* Read uncompressed part */
+        ret = mirage_filter_stream_isz_read_raw_chunk (self, buffer, part_idx);
+        if (ret != part->length) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read raw chunk!\n", __debug__);
+            return -1;
+        }
+    } else if (part->type == ZLIB) {
+        /* Reset inflate engine */
+        ret = inflateReset2(zlib_stream, 15);
+        if (ret != Z_OK) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to reset inflate engine!\n", __debug__);
+            return -1;
+        }
 
-        gint ret;
+        /* Uncompress whole part */
+        zlib_stream->avail_in  = part->length;
+        zlib_stream->next_in   = self->priv->io_buffer;
+        zlib_stream->avail_out = buffer_size;
+        zlib_stream->next_out  = buffer;
 
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: part not cached, reading...\n", __debug__);
+        /* Read some compressed data */
+        ret = mirage_filter_stream_isz_read_raw_chunk (self, self->priv->io_buffer, part_idx);
+        if (ret != part->length) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read raw chunk!\n", __debug__);
+            return -1;
+        }
 
-        /* Read a part, either zero, raw or compressed */
-        if (part->type == ZERO) {
-            /* Return a zero-filled buffer */
-            memset (self->priv->inflate_buffer, 0, self->priv->inflate_buffer_size);
-        } else if (part->type == DATA) {
-            /* Read uncompressed part */
-            ret = mirage_filter_stream_isz_read_raw_chunk (self, self->priv->inflate_buffer, part_idx);
-            if (ret != part->length) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read raw chunk!\n", __debug__);
-                return -1;
-            }
-        } else if (part->type == ZLIB) {
-            /* Reset inflate engine */
-            ret = inflateReset2(zlib_stream, 15);
-            if (ret != Z_OK) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to reset inflate engine!\n", __debug__);
+        /* Inflate */
+        do {
+            ret = inflate(zlib_stream, Z_NO_FLUSH);
+            if (ret == Z_NEED_DICT || ret == Z_MEM_ERROR || ret == Z_DATA_ERROR) {
+                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to inflate part: %s!\n", __debug__, zlib_stream->msg);
                 return -1;
             }
+        } while (zlib_stream->avail_in);
+    } else if (part->type == BZ2) {
+        /* Reset decompress engine */
+        ret = BZ2_bzDecompressInit(bzip2_stream, 0, 0);
+        if (ret != BZ_OK) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to initialize decompress engine!\n", __debug__);
+            return -1;
+        }
 
-            /* Uncompress whole part */
-            zlib_stream->avail_in  = part->length;
-            zlib_stream->next_in   = self->priv->io_buffer;
-            zlib_stream->avail_out = self->priv->inflate_buffer_size;
-            zlib_stream->next_out  = self->priv->inflate_buffer;
+        /* Uncompress whole part */
+        bzip2_stream->avail_in  = part->length;
+        bzip2_stream->next_in   = (gchar *) self->priv->io_buffer;
+        bzip2_stream->avail_out = buffer_size;
+        bzip2_stream->next_out  = (gchar *) buffer;
 
-            /* Read some compressed data */
-            ret = mirage_filter_stream_isz_read_raw_chunk (self, self->priv->io_buffer, part_idx);
-            if (ret != part->length) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read raw chunk!\n", __debug__);
-                return -1;
-            }
+        /* Read some compressed data */
+        ret = mirage_filter_stream_isz_read_raw_chunk (self, self->priv->io_buffer, part_idx);
+        if (ret != part->length) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read raw chunk!\n", __debug__);
+            return -1;
+        }
 
-            /* Inflate */
-            do {
-                ret = inflate(zlib_stream, Z_NO_FLUSH);
-                if (ret == Z_NEED_DICT || ret == Z_MEM_ERROR || ret == Z_DATA_ERROR) {
-                    MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to inflate part: %s!\n", __debug__, zlib_stream->msg);
-                    return -1;
-                }
-            } while (zlib_stream->avail_in);
-        } else if (part->type == BZ2) {
-            /* Reset decompress engine */
-            ret = BZ2_bzDecompressInit(bzip2_stream, 0, 0);
-            if (ret != BZ_OK) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to initialize decompress engine!\n", __debug__);
+        /* Restore a correct header */
+        memcpy (self->priv->io_buffer, "BZh", 3);
+
+        /* Inflate */
+        do {
+            ret = BZ2_bzDecompress(bzip2_stream);
+            if (ret < 0) {
+                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to inflate part: %d!\n", __debug__, ret);
                 return -1;
             }
+        } while (bzip2_stream->avail_in);
 
-            /* Uncompress whole part */
-            bzip2_stream->avail_in  = part->length;
-            bzip2_stream->next_in   = (gchar *) self->priv->io_buffer;
-            bzip2_stream->avail_out = self->priv->inflate_buffer_size;
-            bzip2_stream->next_out  = (gchar *) self->priv->inflate_buffer;
+        /* Uninitialize decompress engine */
+        ret = BZ2_bzDecompressEnd(bzip2_stream);
+        if (ret != BZ_OK) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to uninitialize decompress engine!\n", __debug__);
+            return -1;
+        }
+    } else {
+        /* We should never get here... */
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: Encountered unknown chunk type %u!\n", __debug__, part->type);
+        return -1;
+    }
 
-            /* Read some compressed data */
-            ret = mirage_filter_stream_isz_read_raw_chunk (self, self->priv->io_buffer, part_idx);
-            if (ret != part->length) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read raw chunk!\n", __debug__);
-                return -1;
-            }
+    return buffer_size;
+}
+
+static gssize mirage_filter_stream_isz_partial_read (MirageFilterStream *_self, void *buffer, gsize count)
+{
+    MirageFilterStreamIsz *self = MIRAGE_FILTER_STREAM_ISZ(_self);
+    goffset position = mirage_filter_stream_simplified_get_position(MIRAGE_FILTER_STREAM(self));
+    const guint8 *part_data;
+    gint part_idx;
 
-            /* Restore a correct header */
-            memcpy (self->priv->io_buffer, "BZh", 3);
+    /* Find part that corresponds to current position */
+    part_idx = position / self->priv->header.block_size;
 
-            /* Inflate */
-            do {
-                ret = BZ2_bzDecompress(bzip2_stream);
-                if (ret < 0) {
-                    MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to inflate part: %d!\n", __debug__, ret);
-                    return -1;
-                }
-            } while (bzip2_stream->avail_in);
+    if (part_idx >= self->priv->num_parts) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) beyond end of stream, doing nothing!\n", __debug__, position, position);
+        return 0;
+    }
 
-            /* Uninitialize decompress engine */
-            ret = BZ2_bzDecompressEnd(bzip2_stream);
-            if (ret != BZ_OK) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to uninitialize decompress engine!\n", __debug__);
-                return -1;
-            }
-        } else {
-            /* We should never get here... */
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: Encountered unknown chunk type %u!\n", __debug__, part->type);
-            return -1;
-        }
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position: %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) -> part #%d\n", __debug__, position, position, part_idx);
 
-        /* Set currently cached part */
-        self->priv->cached_part = part_idx;
-    } else {
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: part already cached\n", __debug__);
+    /* Get decoded part */
+    part_data = mirage_filter_stream_simplified_get_part(_self, part_idx, NULL);
+    if (!part_data) {
+        return -1;
     }
 
     /* Copy data */
@@ -798,7 +792,7 @@ static gssize mirage_filter_stream_isz_partial_read (MirageFilterStream *_self,
 
     MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: offset within part: %" G_GOFFSET_MODIFIER "d, copying %" G_GSIZE_MODIFIER "d bytes\n", __debug__, part_offset, count);
 
-    memcpy(buffer, &self->priv->inflate_buffer[part_offset], count);
+    memcpy(buffer, part_data + part_offset, count);
 
     return count;
 }
@@ -839,8 +833,6 @@ static void mirage_filter_stream_isz_init (MirageFilterStreamIsz *self)
     self->priv->num_parts = 0;
     self->priv->parts = NULL;
 
-    self->priv->cached_part = -1;
-    self->priv->inflate_buffer = NULL;
     self->priv->io_buffer = NULL;
 }
 
@@ -855,7 +847,6 @@ static void mirage_filter_stream_isz_finalize (GObject *gobject)
 
     g_free(self->priv->segments);
     g_free(self->priv->parts);
-    g_free(self->priv->inflate_buffer);
     g_free(self->priv->io_buffer);
 
     inflateEnd(&self->priv->zlib_stream);
@@ -875,6 +866,7 @@ static void mirage_filter_stream_isz_class_init (MirageFilterStreamIszClass *kla
     filter_stream_class->open = mirage_filter_stream_isz_open;
 
     filter_stream_class->simplified_partial_read = mirage_filter_stream_isz_partial_read;
+    filter_stream_class->simplified_decode_part = mirage_filter_stream_isz_decode_part;
 }
 
 static void mirage_filter_stream_isz_class_finalize (MirageFilterStreamIszClass *klass G_GNUC_UNUSED)
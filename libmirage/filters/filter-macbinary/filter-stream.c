@@ -47,10 +47,8 @@ struct _MirageFilterStreamMacBinaryPrivate
     NDIF_Part *parts;
     gint num_parts;
 
-    /* Inflate buffer */
-    guint8 *inflate_buffer;
+    /* Inflate buffer size (size of the largest decoded part) */
     guint inflate_buffer_size;
-    gint cached_part;
 
     /* I/O buffer */
     guint8 *io_buffer;
@@ -379,12 +377,7 @@ static gboolean mirage_filter_stream_macbinary_open (MirageFilterStream *_self,
                 return FALSE;
             }
 
-            self->priv->inflate_buffer = g_try_malloc(self->priv->inflate_buffer_size);
-            if (!self->priv->inflate_buffer && self->priv->inflate_buffer_size) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: Error allocating memory for buffers!\n", __debug__);
-                g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_IMAGE_FILE_ERROR, Q_("Error allocating memory for buffers!"));
-                return FALSE;
-            }
+            mirage_filter_stream_simplified_set_part_size(MIRAGE_FILTER_STREAM(self), self->priv->inflate_buffer_size);
         }
 
         /* Look up "bcm#" resource */
@@ -460,11 +453,53 @@ static gssize mirage_filter_stream_macbinary_read_raw_chunk (MirageFilterStreamM
     return have_read;
 }
 
+static gssize mirage_filter_stream_macbinary_decode_part (MirageFilterStream *_self, guint64 index, guint8 *buffer, gsize buffer_size G_GNUC_UNUSED)
+{
+    MirageFilterStreamMacBinary *self = MIRAGE_FILTER_STREAM_MACBINARY(_self);
+    gint part_idx = index;
+    const NDIF_Part *part = &self->priv->parts[part_idx];
+    gint ret;
+
+    /* Read a part */
+    if (part->type == BCEM_RAW) {
+        /* Read uncompressed part */
+        ret = mirage_filter_stream_macbinary_read_raw_chunk (self, buffer, part_idx);
+        if (ret != part->in_length) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read raw chunk!\n", __debug__);
+            return -1;
+        }
+    } else if (part->type == BCEM_ADC) {
+        gsize written_bytes;
+
+        /* Read some compressed data */
+        ret = mirage_filter_stream_macbinary_read_raw_chunk (self, self->priv->io_buffer, part_idx);
+        if (ret != part->in_length) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read raw chunk!\n", __debug__);
+            return -1;
+        }
+
+        /* Inflate */
+        ret = (gint) adc_decompress(part->in_length, self->priv->io_buffer, part->num_sectors * 512,
+                       buffer, &written_bytes);
+
+        g_assert (ret == part->in_length);
+        g_assert (written_bytes == part->num_sectors * 512);
+    } else {
+        /* We should never get here... */
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: Encountered unknown chunk type: %d!\n", __debug__, part->type);
+        return -1;
+    }
+
+    return part->num_sectors * 512;
+}
+
 static gssize mirage_filter_stream_macbinary_partial_read (MirageFilterStream *_self, void *buffer, gsize count)
 {
     MirageFilterStreamMacBinary *self = MIRAGE_FILTER_STREAM_MACBINARY(_self);
 
     goffset position = mirage_filter_stream_simplified_get_position(MIRAGE_FILTER_STREAM(self));
+    const NDIF_Part *part;
+    const guint8 *part_data = NULL;
     gint    part_idx = -1;
 
     /* Find part that corresponds to current position */
@@ -482,58 +517,18 @@ static gssize mirage_filter_stream_macbinary_partial_read (MirageFilterStream *_
         return 0;
     }
 
-    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position: %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) -> part #%d (cached: #%d)\n", __debug__, position, position, part_idx, self->priv->cached_part);
-
-    /* If we do not have part in cache, uncompress it */
-    if (part_idx != self->priv->cached_part) {
-        const NDIF_Part *part = &self->priv->parts[part_idx];
-        gint ret;
-
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: part not cached, reading...\n", __debug__);
-
-        /* Read a part */
-        if (part->type == BCEM_ZERO) {
-            /* We don't use internal buffers for zero data */
-        } else if (part->type == BCEM_RAW) {
-            /* Read uncompressed part */
-            ret = mirage_filter_stream_macbinary_read_raw_chunk (self, self->priv->inflate_buffer, part_idx);
-            if (ret != part->in_length) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read raw chunk!\n", __debug__);
-                return -1;
-            }
-        } else if (part->type == BCEM_ADC) {
-            gsize written_bytes;
-
-            /* Read some compressed data */
-            ret = mirage_filter_stream_macbinary_read_raw_chunk (self, self->priv->io_buffer, part_idx);
-            if (ret != part->in_length) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read raw chunk!\n", __debug__);
-                return -1;
-            }
-
-            /* Inflate */
-            ret = (gint) adc_decompress(part->in_length, self->priv->io_buffer, part->num_sectors * 512,
-                           self->priv->inflate_buffer, &written_bytes);
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position: %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) -> part #%d\n", __debug__, position, position, part_idx);
 
-            g_assert (ret == part->in_length);
-            g_assert (written_bytes == part->num_sectors * 512);
-        } else {
-            /* We should never get here... */
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: Encountered unknown chunk type: %d!\n", __debug__, part->type);
+    /* Get decoded part; zero parts are not decoded */
+    part = &self->priv->parts[part_idx];
+    if (part->type != BCEM_ZERO) {
+        part_data = mirage_filter_stream_simplified_get_part(_self, part_idx, NULL);
+        if (!part_data) {
             return -1;
         }
-
-        /* Set currently cached part */
-        if (part->type != BCEM_ZERO) {
-            self->priv->cached_part = part_idx;
-        }
-    } else {
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: part already cached\n", __debug__);
     }
 
     /* Copy data */
-    const NDIF_Part *part = &self->priv->parts[part_idx];
-
     gsize   part_size = part->num_sectors * 512;
     guint64 part_offset = position - (part->first_sector * 512);
     count = MIN(count, part_size - part_offset);
@@ -543,7 +538,7 @@ static gssize mirage_filter_stream_macbinary_partial_read (MirageFilterStream *_
     if (part->type == BCEM_ZERO) {
         memset(buffer, 0, count);
     } else {
-        memcpy(buffer, &self->priv->inflate_buffer[part_offset], count);
+        memcpy(buffer, &part_data[part_offset], count);
     }
 
     return count;
@@ -579,14 +574,11 @@ static void mirage_filter_stream_macbinary_init (MirageFilterStreamMacBinary *se
 
     self->priv->rsrc_fork = NULL;
     self->priv->parts = NULL;
-    self->priv->inflate_buffer = NULL;
     self->priv->io_buffer = NULL;
 
     self->priv->num_parts = 0;
     self->priv->inflate_buffer_size = 0;
     self->priv->io_buffer_size = 0;
-
-    self->priv->cached_part = -1;
 }
 
 static void mirage_filter_stream_macbinary_finalize (GObject *gobject)
@@ -601,10 +593,6 @@ static void mirage_filter_stream_macbinary_finalize (GObject *gobject)
         g_free(self->priv->parts);
     }
 
-    if (self->priv->inflate_buffer) {
-        g_free(self->priv->inflate_buffer);
-    }
-
     if (self->priv->io_buffer) {
         g_free(self->priv->io_buffer);
     }
@@ -623,6 +611,7 @@ static void mirage_filter_stream_macbinary_class_init (MirageFilterStreamMacBina
     filter_stream_class->open = mirage_filter_stream_macbinary_open;
 
     filter_stream_class->simplified_partial_read = mirage_filter_stream_macbinary_partial_read;
+    filter_stream_class->simplified_decode_part = mirage_filter_stream_macbinary_decode_part;
 }
 
 static void mirage_filter_stream_macbinary_class_finalize (MirageFilterStreamMacBinaryClass *klass G_GNUC_UNUSED)
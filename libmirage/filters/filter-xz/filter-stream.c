@@ -25,6 +25,13 @@
 #define MAX_BLOCK_SIZE 10485760 /* For performance reasons, we support only 10 MB blocks and smaller */
 
 
+typedef struct
+{
+    goffset offset;
+    guint64 size;
+    guint64 uncompressed_size;
+} XZ_Block;
+
 static const guint8 xz_signature[6] = { 0xFD, '7', 'z', 'X', 'Z', 0x00 };
 
 
@@ -37,10 +44,9 @@ struct _MirageFilterStreamXzPrivate
     guint8 *io_buffer;
     gint io_buffer_size;
 
-    /* Block (inflate) buffer */
-    gint cached_block_number;
-    guint8 *block_buffer;
-    gint block_buffer_size;
+    /* Block list */
+    XZ_Block *blocks;
+    gint num_blocks;
 
     /* XZ stream */
     lzma_stream_flags header;
@@ -206,15 +212,28 @@ static gboolean mirage_filter_stream_xz_parse_stream (MirageFilterStreamXz *self
         MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: XZ stream contains a single large block! To allow efficient seeking, consider re-compressing the file using smaller blocks (e.g. 'xz --block-size=1M ...')!\n", __debug__);
     }
 
-    /* Find maximum block size */
+    /* Build block list and find maximum block size */
     lzma_index_iter index_iter;
 
+    self->priv->num_blocks = lzma_index_block_count(self->priv->index);
+    self->priv->blocks = g_try_new(XZ_Block, self->priv->num_blocks);
+    if (!self->priv->blocks) {
+        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_STREAM_ERROR, Q_("Failed to allocate memory for block list!"));
+        return FALSE;
+    }
+
     MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: listing blocks...\n", __debug__);
     lzma_index_iter_init(&index_iter, self->priv->index);
     while (lzma_index_iter_next(&index_iter, LZMA_INDEX_ITER_BLOCK) == 0) {
+        XZ_Block *block = &self->priv->blocks[index_iter.block.number_in_file - 1];
+
         MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: block #%" G_GINT64_MODIFIER "d\n", __debug__, index_iter.block.number_in_file);
         MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "%s: uncompressed size #%" G_GINT64_MODIFIER "d (max: %" G_GINT64_MODIFIER "d)\n", __debug__, index_iter.block.uncompressed_size, max_block_size);
         max_block_size = MAX(max_block_size, index_iter.block.uncompressed_size);
+
+        block->offset = index_iter.block.compressed_file_offset;
+        block->size = index_iter.block.total_size;
+        block->uncompressed_size = index_iter.block.uncompressed_size;
     }
     MIRAGE_DEBUG(self, MIRAGE_DEBUG_PARSER, "\n");
 
@@ -231,18 +250,8 @@ static gboolean mirage_filter_stream_xz_parse_stream (MirageFilterStreamXz *self
     }
 
 
-    /* Allocate block buffer */
-    self->priv->block_buffer_size = max_block_size;
-    self->priv->block_buffer = g_try_malloc(self->priv->block_buffer_size);
-    if (!self->priv->block_buffer) {
-        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_STREAM_ERROR, Q_("Failed to allocate block buffer (%d bytes)!"), self->priv->block_buffer_size);
-        return FALSE;
-    }
-
-    /* Allocate read buffer - 32 kB */
-    if (!mirage_filter_stream_xz_reallocate_read_buffer(self, 32768, error)) {
-        return FALSE;
-    }
+    /* Set part size for part cache */
+    mirage_filter_stream_simplified_set_part_size(MIRAGE_FILTER_STREAM(self), max_block_size);
 
     return TRUE;
 }
@@ -283,105 +292,112 @@ static gboolean mirage_filter_stream_xz_open (MirageFilterStream *_self, MirageS
     return TRUE;
 }
 
-static gssize mirage_filter_stream_xz_partial_read (MirageFilterStream *_self, void *buffer, gsize count)
+static GBytes *mirage_filter_stream_xz_read_raw_part (MirageFilterStream *_self, guint64 index)
 {
     MirageFilterStreamXz *self = MIRAGE_FILTER_STREAM_XZ(_self);
     MirageStream *stream = mirage_filter_stream_get_underlying_stream(_self);
-    goffset position = mirage_filter_stream_simplified_get_position(_self);
-    lzma_index_iter index_iter;
+    const XZ_Block *block;
+    guint8 *raw_data;
 
-    /* Find block that corresponds to current position */
-    lzma_index_iter_init(&index_iter, self->priv->index);
-    if (lzma_index_iter_locate(&index_iter, position)) {
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) beyond end of stream, doing nothing!\n", __debug__, position, position);
-        return 0;
+    if (index >= (guint64)self->priv->num_blocks) {
+        return NULL;
     }
+    block = &self->priv->blocks[index];
 
-    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position: %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) -> block #%" G_GINT64_MODIFIER "d (cached: #%d)\n", __debug__, position, position, index_iter.block.number_in_file, self->priv->cached_block_number);
-
-    /* If we do not have block in cache, uncompress it */
-    if (index_iter.block.number_in_file != self->priv->cached_block_number) {
-        lzma_stream lzma = LZMA_STREAM_INIT;
-        lzma_filter filters[LZMA_FILTERS_MAX+1];
-        lzma_block block;
-
-        guint8 value;
-        gint ret;
-
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: block not cached, reading...\n", __debug__);
-
-        /* Seek to the position */
-        if (!mirage_stream_seek(stream, index_iter.block.compressed_file_offset, G_SEEK_SET, NULL)) {
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to seek to %" G_GINT64_MODIFIER "d in underlying stream!\n", __debug__, index_iter.block.compressed_file_offset);
-            return -1;
-        }
+    /* Seek to the position */
+    if (!mirage_stream_seek(stream, block->offset, G_SEEK_SET, NULL)) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to seek to %" G_GINT64_MODIFIER "d in underlying stream!\n", __debug__, block->offset);
+        return NULL;
+    }
 
-        /* Read first byte of block header */
-        ret = mirage_stream_read(stream, &value, sizeof(value), NULL);
-        if (ret != sizeof(value)) {
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read first byte of block header!\n", __debug__);
-            return -1;
-        }
-        if (!mirage_stream_seek(stream, -sizeof(value), G_SEEK_CUR, NULL)) {
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to seek at beginning of block header!\n", __debug__);
-            return -1;
-        }
+    /* Read whole block, including header */
+    raw_data = g_try_malloc(block->size);
+    if (!raw_data) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to allocate buffer for block (%" G_GINT64_MODIFIER "d bytes)!\n", __debug__, block->size);
+        return NULL;
+    }
 
+    if (mirage_stream_read(stream, raw_data, block->size, NULL) != (gssize)block->size) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read block #%" G_GINT64_MODIFIER "u!\n", __debug__, index);
+        g_free(raw_data);
+        return NULL;
+    }
 
-        /* We need to set some block header fields ourselves */
-        block.version = 0;
-        block.header_size = lzma_block_header_size_decode(value);
-        block.check = self->priv->footer.check;
-        block.compressed_size = LZMA_VLI_UNKNOWN;
-        block.filters = filters;
+    return g_bytes_new_take(raw_data, block->size);
+}
 
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: block header size: %d!\n", __debug__, block.header_size);
+static gssize mirage_filter_stream_xz_decode_raw_part (MirageFilterStream *_self, guint64 index, GBytes *raw_data, guint8 *buffer, gsize buffer_size)
+{
+    MirageFilterStreamXz *self = MIRAGE_FILTER_STREAM_XZ(_self);
+    lzma_filter filters[LZMA_FILTERS_MAX+1];
+    lzma_block block;
+    gsize raw_size;
+    const guint8 *raw_buffer = g_bytes_get_data(raw_data, &raw_size);
+    gsize in_pos, out_pos;
+    gint ret;
+
+    /* NOTE: this function may be called from worker threads, so it uses
+       only the block list and stream flags, which do not change */
+
+    /* We need to set some block header fields ourselves */
+    block.version = 0;
+    block.header_size = lzma_block_header_size_decode(raw_buffer[0]);
+    block.check = self->priv->footer.check;
+    block.filters = filters;
+
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: block header size: %d!\n", __debug__, block.header_size);
+
+    if (block.header_size > raw_size) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: invalid block header size!\n", __debug__);
+        return -1;
+    }
 
+    /* Decode header */
+    ret = lzma_block_header_decode(&block, NULL, raw_buffer);
+    if (ret != LZMA_OK) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to decode block header (error: %d)!\n", __debug__, ret);
+        return -1;
+    }
 
-        /* Read and decode header */
-        ret = mirage_stream_read(stream, self->priv->io_buffer, block.header_size, NULL);
-        if (ret != block.header_size) {
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to read block header!\n", __debug__);
-            return -1;
-        }
+    /* Uncompress */
+    in_pos = block.header_size;
+    out_pos = 0;
 
-        ret = lzma_block_header_decode(&block, NULL, self->priv->io_buffer);
-        if (ret != LZMA_OK) {
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to decode block header (error: %d)!\n", __debug__, ret);
-            return -1;
-        }
+    ret = lzma_block_buffer_decode(&block, NULL, raw_buffer, &in_pos, raw_size, buffer, &out_pos, buffer_size);
 
+    /* Free filter options allocated by header decoder */
+    for (gint i = 0; filters[i].id != LZMA_VLI_UNKNOWN; i++) {
+        free(filters[i].options);
+    }
 
-        /* Initialize LZMA stream */
-        lzma.next_out = self->priv->block_buffer;
-        lzma.avail_out = self->priv->block_buffer_size;
+    if (ret != LZMA_OK) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: error while decoding block: %d (consumed %" G_GSIZE_MODIFIER "d bytes, uncompressed %" G_GSIZE_MODIFIER "d bytes)!\n", __debug__, ret, in_pos, out_pos);
+        return -1;
+    }
 
-        ret = lzma_block_decoder(&lzma, &block);
-        if (ret != LZMA_OK) {
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to initialize block decoder!\n", __debug__);
-            return -1;
-        }
+    return self->priv->blocks[index].uncompressed_size;
+}
 
-        /* Read and uncompress */
-        while (1) {
-            lzma.next_in = self->priv->io_buffer;
-            lzma.avail_in = mirage_stream_read(stream, self->priv->io_buffer, self->priv->io_buffer_size, NULL);
+static gssize mirage_filter_stream_xz_partial_read (MirageFilterStream *_self, void *buffer, gsize count)
+{
+    MirageFilterStreamXz *self = MIRAGE_FILTER_STREAM_XZ(_self);
+    goffset position = mirage_filter_stream_simplified_get_position(_self);
+    lzma_index_iter index_iter;
+    const guint8 *block_data;
 
-            ret = lzma_code(&lzma, LZMA_RUN);
-            if (ret == LZMA_STREAM_END) {
-                break;
-            } else if (ret != LZMA_OK) {
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: error while decoding block: %d (consumed %" G_GINT64_MODIFIER "d bytes, uncompressed %" G_GINT64_MODIFIER "d bytes)!\n", __debug__, ret, lzma.total_in, lzma.total_out);
-                return -1;
-            }
-        }
+    /* Find block that corresponds to current position */
+    lzma_index_iter_init(&index_iter, self->priv->index);
+    if (lzma_index_iter_locate(&index_iter, position)) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) beyond end of stream, doing nothing!\n", __debug__, position, position);
+        return 0;
+    }
 
-        lzma_end(&lzma);
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stream position: %" G_GOFFSET_MODIFIER "d (0x%" G_GOFFSET_MODIFIER "X) -> block #%" G_GINT64_MODIFIER "d\n", __debug__, position, position, index_iter.block.number_in_file);
 
-        /* Store the number of currently stored block */
-        self->priv->cached_block_number = index_iter.block.number_in_file;
-    } else {
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: block already cached\n", __debug__);
+    /* Get decoded block; blocks are numbered from 1 */
+    block_data = mirage_filter_stream_simplified_get_part(_self, index_iter.block.number_in_file - 1, NULL);
+    if (!block_data) {
+        return -1;
     }
 
     /* Copy data */
@@ -390,7 +406,7 @@ static gssize mirage_filter_stream_xz_partial_read (MirageFilterStream *_self, v
 
     MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: offset within block: %" G_GOFFSET_MODIFIER "d, copying %" G_GSIZE_MODIFIER "d bytes\n", __debug__, block_offset, count);
 
-    memcpy(buffer, self->priv->block_buffer + block_offset, count);
+    memcpy(buffer, block_data + block_offset, count);
 
     return count;
 }
@@ -423,12 +439,12 @@ static void mirage_filter_stream_xz_init (MirageFilterStreamXz *self)
         Q_("xz-compressed images (*.xz)"), "application/x-xz"
     );
 
-    self->priv->cached_block_number = -1;
-
     self->priv->index = NULL;
 
+    self->priv->blocks = NULL;
+    self->priv->num_blocks = 0;
+
     self->priv->io_buffer = NULL;
-    self->priv->block_buffer = NULL;
 }
 
 static void mirage_filter_stream_xz_finalize (GObject *gobject)
@@ -437,8 +453,9 @@ static void mirage_filter_stream_xz_finalize (GObject *gobject)
 
     lzma_index_end(self->priv->index, NULL);
 
+    g_free(self->priv->blocks);
+
     g_free(self->priv->io_buffer);
-    g_free(self->priv->block_buffer);
 
     /* Chain up to the parent class */
     return G_OBJECT_CLASS(mirage_filter_stream_xz_parent_class)->finalize(gobject);
@@ -454,6 +471,8 @@ static void mirage_filter_stream_xz_class_init (MirageFilterStreamXzClass *klass
     filter_stream_class->open = mirage_filter_stream_xz_open;
 
     filter_stream_class->simplified_partial_read = mirage_filter_stream_xz_partial_read;
+    filter_stream_class->simplified_read_raw_part = mirage_filter_stream_xz_read_raw_part;
+    filter_stream_class->simplified_decode_raw_part = mirage_filter_stream_xz_decode_raw_part;
 }
 
 static void mirage_filter_stream_xz_class_finalize (MirageFilterStreamXzClass *klass G_GNUC_UNUSED)
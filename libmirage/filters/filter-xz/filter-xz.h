@@ -24,6 +24,7 @@
 #include "config.h"
 #endif
 
+#include <stdlib.h>
 #include <lzma.h>
 
 #include <mirage/mirage.h>
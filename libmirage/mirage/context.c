@@ -71,8 +71,32 @@ struct _MirageContextPrivate
     /* Stream cache */
     GHashTable *input_stream_cache;
     GHashTable *output_stream_cache;
+
+    /* Block cache */
+    GMutex block_cache_mutex;
+    GHashTable *block_cache;
+    GQueue block_cache_lru; /* Most recently used entry at head */
+    gsize block_cache_size;
+    gsize block_cache_max_size;
+
+    guint64 block_cache_hits;
+    guint64 block_cache_misses;
+    guint64 block_cache_evictions;
 };
 
+/* Default block cache size, in bytes */
+#define BLOCK_CACHE_DEFAULT_SIZE (16*1024*1024)
+
+typedef struct
+{
+    gconstpointer owner;
+    guint64 block;
+
+    GBytes *data;
+
+    GList link; /* Link in LRU queue */
+} MirageBlockCacheEntry;
+
 
 /**********************************************************************\
  *                       Input stream cache                           *
@@ -130,6 +154,117 @@ static inline void mirage_context_output_stream_cache_add (MirageContext *self,
 }
 
 
+/**********************************************************************\
+ *                           Block cache                              *
+\**********************************************************************/
+static guint mirage_context_block_cache_entry_hash (gconstpointer key)
+{
+    const MirageBlockCacheEntry *entry = key;
+    return g_direct_hash(entry->owner) ^ g_int64_hash(&entry->block);
+}
+
+static gboolean mirage_context_block_cache_entry_equal (gconstpointer a, gconstpointer b)
+{
+    const MirageBlockCacheEntry *entry_a = a;
+    const MirageBlockCacheEntry *entry_b = b;
+    return entry_a->owner == entry_b->owner && entry_a->block == entry_b->block;
+}
+
+static void mirage_context_block_cache_entry_free (MirageBlockCacheEntry *entry)
+{
+    g_bytes_unref(entry->data);
+    g_slice_free(MirageBlockCacheEntry, entry);
+}
+
+static void mirage_context_block_cache_remove_entry (MirageContext *self, MirageBlockCacheEntry *entry)
+{
+    /* Must be called with block cache mutex held */
+    g_queue_unlink(&self->priv->block_cache_lru, &entry->link);
+    self->priv->block_cache_size -= g_bytes_get_size(entry->data);
+    g_hash_table_remove(self->priv->block_cache, entry); /* Frees the entry */
+}
+
+static void mirage_context_block_cache_trim (MirageContext *self, gsize max_size)
+{
+    /* Must be called with block cache mutex held; evicts least recently
+       used entries until cache fits into given size */
+    while (self->priv->block_cache_size > max_size && self->priv->block_cache_lru.tail) {
+        mirage_context_block_cache_remove_entry(self, self->priv->block_cache_lru.tail->data);
+        self->priv->block_cache_evictions++;
+    }
+}
+
+static void mirage_context_block_cache_set_max_size (MirageContext *self, gsize max_size)
+{
+    g_mutex_lock(&self->priv->block_cache_mutex);
+    self->priv->block_cache_max_size = max_size;
+    mirage_context_block_cache_trim(self, max_size);
+    g_mutex_unlock(&self->priv->block_cache_mutex);
+}
+
+static void mirage_context_block_cache_apply_option (MirageContext *self, GVariant *value)
+{
+    gint64 max_size = -1;
+
+    if (!value) {
+        max_size = BLOCK_CACHE_DEFAULT_SIZE;
+    } else if (g_variant_is_of_type(value, G_VARIANT_TYPE_INT32)) {
+        max_size = g_variant_get_int32(value);
+    } else if (g_variant_is_of_type(value, G_VARIANT_TYPE_UINT32)) {
+        max_size = g_variant_get_uint32(value);
+    } else if (g_variant_is_of_type(value, G_VARIANT_TYPE_INT64)) {
+        max_size = g_variant_get_int64(value);
+    } else if (g_variant_is_of_type(value, G_VARIANT_TYPE_UINT64)) {
+        max_size = MIN(g_variant_get_uint64(value), G_MAXINT64);
+    }
+
+    if (max_size < 0) {
+        return; /* Invalid value; ignore */
+    }
+
+    mirage_context_block_cache_set_max_size(self, max_size);
+}
+
+
+/**********************************************************************\
+ *                        Debug mask summary                          *
+\**********************************************************************/
+/* Number of contexts that have each of the debug mask bits set; used to
+   maintain the library-wide summary of debug masks */
+G_LOCK_DEFINE_STATIC(debug_mask_summary);
+static gint debug_mask_bit_count[32];
+
+/**
+ * mirage_debug_mask_summary:
+ *
+ * Bitwise OR of debug masks of all existing #MirageContext objects.
+ *
+ * Used by MIRAGE_DEBUG() and related macros to skip the debug message
+ * function call (along with evaluation of message arguments) when none
+ * of the contexts has the message's debug level enabled. It should never
+ * be modified directly.
+ */
+gint mirage_debug_mask_summary = 0;
+
+static void mirage_context_update_debug_mask_summary (gint old_mask, gint new_mask)
+{
+    guint summary = 0;
+
+    G_LOCK(debug_mask_summary);
+
+    for (gint i = 0; i < 32; i++) {
+        debug_mask_bit_count[i] += ((new_mask >> i) & 1) - ((old_mask >> i) & 1);
+        if (debug_mask_bit_count[i]) {
+            summary |= 1u << i;
+        }
+    }
+
+    g_atomic_int_set(&mirage_debug_mask_summary, summary);
+
+    G_UNLOCK(debug_mask_summary);
+}
+
+
 /**********************************************************************\
  *                       Public API: debugging                        *
 \**********************************************************************/
@@ -199,6 +334,7 @@ const gchar *mirage_context_get_debug_name (MirageContext *self)
 void mirage_context_set_debug_mask (MirageContext *self, gint debug_mask)
 {
     /* Set debug mask */
+    mirage_context_update_debug_mask_summary(self->priv->debug_mask, debug_mask);
     self->priv->debug_mask = debug_mask;
 }
 
@@ -230,6 +366,9 @@ void mirage_context_clear_options (MirageContext *self)
 {
     /* Remove all entries from hash table */
     g_hash_table_remove_all(self->priv->options);
+
+    /* Reset options that are applied immediately */
+    mirage_context_block_cache_apply_option(self, NULL);
 }
 
 /**
@@ -240,11 +379,39 @@ void mirage_context_clear_options (MirageContext *self)
  *
  * Sets an option to the context. If option with the specified name already
  * exists, it is replaced.
+ *
+ * The "block-cache-size" option, an integer, sets the size of the context's
+ * block cache in bytes (see mirage_context_cache_lookup_block()); setting it
+ * to 0 disables the cache. The change is applied immediately.
+ *
+ * The "filter-stream-cache-parts" option, an integer, sets the number of
+ * decoded parts that each filter stream keeps resident (see
+ * mirage_filter_stream_simplified_get_part()). Each filter stream reads
+ * it when it decodes its first part. The same applies to the
+ * "filter-stream-decode-ahead" option, an integer, which sets the number
+ * of subsequent parts that filter streams decode in parallel; setting it
+ * to 0 disables parallel decoding.
+ *
+ * The "filter-stream-index-cache" option is a string that specifies the
+ * directory in which filter streams store the indices of the files they
+ * open (see mirage_filter_stream_save_index()). By default, indices are
+ * stored in the libmirage/index subdirectory of user's cache directory;
+ * setting the option to an empty string disables the index cache.
+ *
+ * The "file-stream-mmap" option is a boolean that determines whether
+ * read-only file streams on local regular files map the file into memory
+ * (see #MirageFileStream); it is disabled by default, because truncating
+ * a mapped file or removing the medium it resides on results in SIGBUS.
  */
 void mirage_context_set_option (MirageContext *self, const gchar *name, GVariant *value)
 {
     g_variant_ref_sink(value); /* Claim reference */
 	g_hash_table_replace(self->priv->options, g_strdup(name), value); /* Use replace() instead of insert() so that old key gets released */
+
+    /* Options that are applied immediately */
+    if (!g_strcmp0(name, "block-cache-size")) {
+        mirage_context_block_cache_apply_option(self, value);
+    }
 }
 
 /**
@@ -267,6 +434,199 @@ GVariant *mirage_context_get_option (MirageContext *self, const gchar *name)
 }
 
 
+/**********************************************************************\
+ *                      Public API: block cache                       *
+\**********************************************************************/
+/**
+ * mirage_context_cache_lookup_block:
+ * @self: a #MirageContext
+ * @owner: (in): owner of the block
+ * @block: (in): block number
+ *
+ * Looks up the block number @block that was previously stored into the
+ * context's block cache by @owner using mirage_context_cache_insert_block().
+ *
+ * The block cache is a size-bounded, least-recently-used cache of decoded
+ * data blocks (for example, decompressed parts of compressed images), shared
+ * by all objects that use the context. Its size is set via "block-cache-size"
+ * option (see mirage_context_set_option()).
+ *
+ * Within libMirage, the cache is used by filter streams that are based on
+ * the simplified interface, which store their decoded parts into it (see
+ * mirage_filter_stream_simplified_get_part()). Fragments do not cache the
+ * sector data they read, as it is served either from the parts cached by
+ * the filter streams or, for uncompressed image files, from the operating
+ * system's page cache; caching it once more would only duplicate the data.
+ *
+ * This function is thread-safe.
+ *
+ * Returns: (transfer full): a #GBytes with block's data on cache hit, %NULL
+ * on cache miss. The reference should be released using g_bytes_unref()
+ * when no longer needed.
+ */
+GBytes *mirage_context_cache_lookup_block (MirageContext *self, gconstpointer owner, guint64 block)
+{
+    MirageBlockCacheEntry key = { .owner = owner, .block = block };
+    MirageBlockCacheEntry *entry;
+    GBytes *data = NULL;
+
+    g_mutex_lock(&self->priv->block_cache_mutex);
+
+    entry = g_hash_table_lookup(self->priv->block_cache, &key);
+    if (entry) {
+        /* Move to the head of LRU queue */
+        g_queue_unlink(&self->priv->block_cache_lru, &entry->link);
+        g_queue_push_head_link(&self->priv->block_cache_lru, &entry->link);
+
+        data = g_bytes_ref(entry->data);
+        self->priv->block_cache_hits++;
+    } else {
+        self->priv->block_cache_misses++;
+    }
+
+    g_mutex_unlock(&self->priv->block_cache_mutex);
+
+    return data;
+}
+
+/**
+ * mirage_context_cache_contains_block:
+ * @self: a #MirageContext
+ * @owner: (in): owner of the block
+ * @block: (in): block number
+ *
+ * Checks whether the block number @block, stored by @owner, is present in
+ * the context's block cache. Unlike mirage_context_cache_lookup_block(),
+ * this function does not count as an access; it neither updates the block's
+ * position in the least-recently-used order nor the cache statistics, and
+ * is therefore suitable for probing the cache when deciding whether a
+ * block needs to be prefetched.
+ *
+ * This function is thread-safe.
+ *
+ * Returns: %TRUE if the block is present in the cache, %FALSE if it is not.
+ */
+gboolean mirage_context_cache_contains_block (MirageContext *self, gconstpointer owner, guint64 block)
+{
+    MirageBlockCacheEntry key = { .owner = owner, .block = block };
+    gboolean found;
+
+    g_mutex_lock(&self->priv->block_cache_mutex);
+    found = g_hash_table_contains(self->priv->block_cache, &key);
+    g_mutex_unlock(&self->priv->block_cache_mutex);
+
+    return found;
+}
+
+/**
+ * mirage_context_cache_insert_block:
+ * @self: a #MirageContext
+ * @owner: (in): owner of the block
+ * @block: (in): block number
+ * @data: (in): block's data
+ *
+ * Stores data of @owner's block number @block into the context's block
+ * cache, replacing previously stored data, if any. If necessary, least
+ * recently used blocks are evicted from the cache to make space for the
+ * new block. Blocks that are larger than the whole cache are not stored.
+ *
+ * The cache takes its own reference to @data; as the data is shared
+ * between all users of the cache, it must not be modified afterwards.
+ *
+ * This function is thread-safe.
+ */
+void mirage_context_cache_insert_block (MirageContext *self, gconstpointer owner, guint64 block, GBytes *data)
+{
+    MirageBlockCacheEntry key = { .owner = owner, .block = block };
+    MirageBlockCacheEntry *entry;
+    gsize size = g_bytes_get_size(data);
+
+    g_mutex_lock(&self->priv->block_cache_mutex);
+
+    /* Remove old entry */
+    entry = g_hash_table_lookup(self->priv->block_cache, &key);
+    if (entry) {
+        mirage_context_block_cache_remove_entry(self, entry);
+    }
+
+    if (size <= self->priv->block_cache_max_size) {
+        /* Make space */
+        mirage_context_block_cache_trim(self, self->priv->block_cache_max_size - size);
+
+        /* Insert new entry */
+        entry = g_slice_new(MirageBlockCacheEntry);
+        entry->owner = owner;
+        entry->block = block;
+        entry->data = g_bytes_ref(data);
+        entry->link.data = entry;
+        entry->link.prev = entry->link.next = NULL;
+
+        g_hash_table_add(self->priv->block_cache, entry);
+        g_queue_push_head_link(&self->priv->block_cache_lru, &entry->link);
+        self->priv->block_cache_size += size;
+    }
+
+    g_mutex_unlock(&self->priv->block_cache_mutex);
+}
+
+/**
+ * mirage_context_cache_remove_blocks:
+ * @self: a #MirageContext
+ * @owner: (in): owner of the blocks
+ *
+ * Removes all blocks belonging to @owner from the context's block cache.
+ * Objects that store blocks into the cache must call this function before
+ * they are destroyed.
+ *
+ * This function is thread-safe.
+ */
+void mirage_context_cache_remove_blocks (MirageContext *self, gconstpointer owner)
+{
+    GList *entry, *next;
+
+    g_mutex_lock(&self->priv->block_cache_mutex);
+
+    for (entry = self->priv->block_cache_lru.head; entry; entry = next) {
+        next = entry->next;
+        if (((MirageBlockCacheEntry *)entry->data)->owner == owner) {
+            mirage_context_block_cache_remove_entry(self, entry->data);
+        }
+    }
+
+    g_mutex_unlock(&self->priv->block_cache_mutex);
+}
+
+/**
+ * mirage_context_cache_get_statistics:
+ * @self: a #MirageContext
+ * @hits: (out) (allow-none): location to store number of cache hits, or %NULL
+ * @misses: (out) (allow-none): location to store number of cache misses, or %NULL
+ * @evictions: (out) (allow-none): location to store number of evicted blocks, or %NULL
+ * @size: (out) (allow-none): location to store current size of cached data, or %NULL
+ *
+ * Retrieves statistics of the context's block cache.
+ */
+void mirage_context_cache_get_statistics (MirageContext *self, guint64 *hits, guint64 *misses, guint64 *evictions, gsize *size)
+{
+    g_mutex_lock(&self->priv->block_cache_mutex);
+
+    if (hits) {
+        *hits = self->priv->block_cache_hits;
+    }
+    if (misses) {
+        *misses = self->priv->block_cache_misses;
+    }
+    if (evictions) {
+        *evictions = self->priv->block_cache_evictions;
+    }
+    if (size) {
+        *size = self->priv->block_cache_size;
+    }
+
+    g_mutex_unlock(&self->priv->block_cache_mutex);
+}
+
+
 /**********************************************************************\
  *                       Public API: password                         *
 \**********************************************************************/
@@ -463,6 +823,7 @@ MirageStream *mirage_context_create_input_stream (MirageContext *self, const gch
 
     /* Open MirageFileStream on the file */
     file_stream = g_object_new(MIRAGE_TYPE_FILE_STREAM, NULL);
+    mirage_contextual_set_context(MIRAGE_CONTEXTUAL(file_stream), self);
     if (!mirage_file_stream_open(file_stream, filename, FALSE, &local_error)) {
         g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_DATA_FILE_ERROR, Q_("Failed to open read-only file stream on data file: %s!"), local_error->message);
         g_error_free(local_error);
@@ -631,12 +992,25 @@ static void mirage_context_init (MirageContext *self)
     /* Stream cache */
     self->priv->input_stream_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
     self->priv->output_stream_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    /* Block cache */
+    g_mutex_init(&self->priv->block_cache_mutex);
+    self->priv->block_cache = g_hash_table_new_full(mirage_context_block_cache_entry_hash, mirage_context_block_cache_entry_equal, (GDestroyNotify)mirage_context_block_cache_entry_free, NULL);
+    g_queue_init(&self->priv->block_cache_lru);
+    self->priv->block_cache_size = 0;
+    self->priv->block_cache_max_size = BLOCK_CACHE_DEFAULT_SIZE;
+    self->priv->block_cache_hits = 0;
+    self->priv->block_cache_misses = 0;
+    self->priv->block_cache_evictions = 0;
 }
 
 static void mirage_context_finalize (GObject *gobject)
 {
     MirageContext *self = MIRAGE_CONTEXT(gobject);
 
+    /* Remove our debug mask from the summary */
+    mirage_context_update_debug_mask_summary(self->priv->debug_mask, 0);
+
     g_free(self->priv->domain);
     g_free(self->priv->name);
 
@@ -652,6 +1026,10 @@ static void mirage_context_finalize (GObject *gobject)
     g_hash_table_unref(self->priv->input_stream_cache);
     g_hash_table_unref(self->priv->output_stream_cache);
 
+    /* Free block cache */
+    g_hash_table_unref(self->priv->block_cache);
+    g_mutex_clear(&self->priv->block_cache_mutex);
+
     /* Chain up to the parent class */
     return G_OBJECT_CLASS(mirage_context_parent_class)->finalize(gobject);
 }
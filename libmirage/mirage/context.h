@@ -98,6 +98,12 @@ void mirage_context_clear_options (MirageContext *self);
 void mirage_context_set_option (MirageContext *self, const gchar *name, GVariant *value);
 GVariant *mirage_context_get_option (MirageContext *self, const gchar *name);
 
+GBytes *mirage_context_cache_lookup_block (MirageContext *self, gconstpointer owner, guint64 block);
+gboolean mirage_context_cache_contains_block (MirageContext *self, gconstpointer owner, guint64 block);
+void mirage_context_cache_insert_block (MirageContext *self, gconstpointer owner, guint64 block, GBytes *data);
+void mirage_context_cache_remove_blocks (MirageContext *self, gconstpointer owner);
+void mirage_context_cache_get_statistics (MirageContext *self, guint64 *hits, guint64 *misses, guint64 *evictions, gsize *size);
+
 void mirage_context_set_password_function (MirageContext *self, MiragePasswordFunction func, gpointer user_data, GDestroyNotify destroy);
 gchar *mirage_context_obtain_password (MirageContext *self, GError **error);
 
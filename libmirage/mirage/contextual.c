@@ -270,6 +270,109 @@ GVariant *mirage_contextual_get_option (MirageContextual *self, const gchar *nam
 }
 
 
+/**
+ * mirage_contextual_cache_lookup_block:
+ * @self: a #MirageContextual
+ * @block: (in): block number
+ *
+ * Looks up the block number @block that was previously stored into the
+ * context's block cache by @self.
+ *
+ * <note>
+ * This is a convenience function that retrieves a #MirageContext from
+ * @self and calls mirage_context_cache_lookup_block() with @self as owner.
+ * </note>
+ *
+ * Returns: (transfer full): a #GBytes with block's data on cache hit, %NULL
+ * on cache miss or if no context is set.
+ */
+GBytes *mirage_contextual_cache_lookup_block (MirageContextual *self, guint64 block)
+{
+    MirageContext *context = mirage_contextual_get_context(self);
+    GBytes *data = NULL;
+
+    if (context) {
+        data = mirage_context_cache_lookup_block(context, self, block);
+        g_object_unref(context);
+    }
+
+    return data;
+}
+
+/**
+ * mirage_contextual_cache_contains_block:
+ * @self: a #MirageContextual
+ * @block: (in): block number
+ *
+ * Checks whether the block number @block, stored by @self, is present in
+ * the context's block cache, without affecting the cache statistics.
+ *
+ * <note>
+ * This is a convenience function that retrieves a #MirageContext from
+ * @self and calls mirage_context_cache_contains_block() with @self as owner.
+ * </note>
+ *
+ * Returns: %TRUE if the block is present in the cache, %FALSE if it is not
+ * or if no context is set.
+ */
+gboolean mirage_contextual_cache_contains_block (MirageContextual *self, guint64 block)
+{
+    MirageContext *context = mirage_contextual_get_context(self);
+    gboolean found = FALSE;
+
+    if (context) {
+        found = mirage_context_cache_contains_block(context, self, block);
+        g_object_unref(context);
+    }
+
+    return found;
+}
+
+/**
+ * mirage_contextual_cache_insert_block:
+ * @self: a #MirageContextual
+ * @block: (in): block number
+ * @data: (in): block's data
+ *
+ * Stores data of block number @block into the context's block cache.
+ *
+ * <note>
+ * This is a convenience function that retrieves a #MirageContext from
+ * @self and calls mirage_context_cache_insert_block() with @self as owner.
+ * </note>
+ */
+void mirage_contextual_cache_insert_block (MirageContextual *self, guint64 block, GBytes *data)
+{
+    MirageContext *context = mirage_contextual_get_context(self);
+
+    if (context) {
+        mirage_context_cache_insert_block(context, self, block, data);
+        g_object_unref(context);
+    }
+}
+
+/**
+ * mirage_contextual_cache_remove_blocks:
+ * @self: a #MirageContextual
+ *
+ * Removes all blocks that were stored into the context's block cache by @self.
+ *
+ * <note>
+ * This is a convenience function that retrieves a #MirageContext from
+ * @self and calls mirage_context_cache_remove_blocks() with @self as owner.
+ * </note>
+ */
+void mirage_contextual_cache_remove_blocks (MirageContextual *self)
+{
+    MirageContext *context = mirage_contextual_get_context(self);
+
+    if (context) {
+        mirage_context_cache_remove_blocks(context, self);
+        g_object_unref(context);
+    }
+}
+
+
 /**
  * mirage_contextual_obtain_password:
  * @self: a #MirageContextual
@@ -73,6 +73,11 @@ void mirage_contextual_debug_print_buffer (MirageContextual *self, gint level, c
 
 GVariant *mirage_contextual_get_option (MirageContextual *self, const gchar *name);
 
+GBytes *mirage_contextual_cache_lookup_block (MirageContextual *self, guint64 block);
+gboolean mirage_contextual_cache_contains_block (MirageContextual *self, guint64 block);
+void mirage_contextual_cache_insert_block (MirageContextual *self, guint64 block, GBytes *data);
+void mirage_contextual_cache_remove_blocks (MirageContextual *self);
+
 gchar *mirage_contextual_obtain_password (MirageContextual *self, GError **error);
 
 MirageStream *mirage_contextual_create_input_stream (MirageContextual *self, const gchar *filename, GError **error);
@@ -39,6 +39,11 @@
  * The actual printing of debug messages within the code is achieved by
  * mirage_contextual_debug_messagev() or mirage_contextual_debug_message(),
  * or by convenience macro MIRAGE_DEBUG().
+ *
+ * To keep disabled debug messages cheap, MIRAGE_DEBUG() first checks the
+ * message's debug level against the summary of debug masks of all contexts,
+ * and calls the debug message function only if the level is enabled in any
+ * of them.
  */
 
 /**
@@ -81,6 +86,35 @@ typedef enum _MirageDebugMask
 } MirageDebugMask;
 
 
+/**
+ * MIRAGE_DEBUG_DISABLED_LEVELS:
+ *
+ * Debug levels for which debug messages are compiled out. Defaults to
+ * none; code that is built with this macro defined to a combination of
+ * #MirageDebugMask values before including libMirage headers (libMirage
+ * itself does so when configured with VERBOSE_DEBUG disabled) omits
+ * the corresponding MIRAGE_DEBUG() calls entirely.
+ */
+#ifndef MIRAGE_DEBUG_DISABLED_LEVELS
+#define MIRAGE_DEBUG_DISABLED_LEVELS 0
+#endif
+
+extern gint mirage_debug_mask_summary;
+
+/**
+ * MIRAGE_DEBUG_MAY_BE_ACTIVE:
+ * @lvl: (in): debug level
+ *
+ * Quick check whether debug level @lvl may be active for any object; it
+ * evaluates to %FALSE if the level is compiled out or if none of the
+ * existing contexts has it enabled in its debug mask, and to %TRUE
+ * otherwise (and always for %MIRAGE_DEBUG_ERROR and %MIRAGE_DEBUG_WARNING).
+ * Used by MIRAGE_DEBUG() and related macros before resolving the object's
+ * context and formatting the message.
+ */
+#define MIRAGE_DEBUG_MAY_BE_ACTIVE(lvl) \
+    ((lvl) < 0 || (!((lvl) & MIRAGE_DEBUG_DISABLED_LEVELS) && (g_atomic_int_get(&mirage_debug_mask_summary) & (lvl))))
+
 /**
  * MIRAGE_DEBUG:
  * @obj: (in): object
@@ -90,9 +124,16 @@ typedef enum _MirageDebugMask
  * Debugging macro, provided for convenience. It performs cast to
  * #MirageContextual interface on @obj and calls mirage_contextual_debug_message()
  * with debug level @lvl and debug message, specified by format string and
- * format arguments.
+ * format arguments. If the debug level is not active in any context (see
+ * MIRAGE_DEBUG_MAY_BE_ACTIVE()), neither the function is called nor the
+ * format arguments are evaluated.
  */
-#define MIRAGE_DEBUG(obj, lvl, ...) mirage_contextual_debug_message(MIRAGE_CONTEXTUAL(obj), lvl, __VA_ARGS__)
+#define MIRAGE_DEBUG(obj, lvl, ...) \
+    G_STMT_START { \
+        if (MIRAGE_DEBUG_MAY_BE_ACTIVE(lvl)) { \
+            mirage_contextual_debug_message(MIRAGE_CONTEXTUAL(obj), lvl, __VA_ARGS__); \
+        } \
+    } G_STMT_END
 
 /**
  * MIRAGE_DEBUG_ON:
@@ -101,9 +142,10 @@ typedef enum _MirageDebugMask
  *
  * Debugging macro, provided for convenience. It performs cast to
  * #MirageContextual interface on @obj and calls mirage_contextual_debug_is_active()
- * with debug level @lvl.
+ * with debug level @lvl, unless the debug level is not active in any
+ * context.
  */
-#define MIRAGE_DEBUG_ON(obj, lvl) mirage_contextual_debug_is_active(MIRAGE_CONTEXTUAL(obj), lvl)
+#define MIRAGE_DEBUG_ON(obj, lvl) (MIRAGE_DEBUG_MAY_BE_ACTIVE(lvl) && mirage_contextual_debug_is_active(MIRAGE_CONTEXTUAL(obj), lvl))
 
 
 /**
@@ -117,8 +159,13 @@ typedef enum _MirageDebugMask
  *
  * Debugging macro, provided for convenience. It performs cast to
  * #MirageContextual interface on @obj and calls mirage_contextual_debug_print_buffer()
- * with given arguments.
+ * with given arguments, unless the debug level is not active in any context.
  */
-#define MIRAGE_DEBUG_PRINT_BUFFER(obj, lvl, prefix, width, buffer, buffer_length) mirage_contextual_debug_print_buffer(MIRAGE_CONTEXTUAL(obj), lvl, prefix, width, buffer, buffer_length)
+#define MIRAGE_DEBUG_PRINT_BUFFER(obj, lvl, prefix, width, buffer, buffer_length) \
+    G_STMT_START { \
+        if (MIRAGE_DEBUG_MAY_BE_ACTIVE(lvl)) { \
+            mirage_contextual_debug_print_buffer(MIRAGE_CONTEXTUAL(obj), lvl, prefix, width, buffer, buffer_length); \
+        } \
+    } G_STMT_END
 
 #endif /* __MIRAGE_DEBUG_H__ */
@@ -67,20 +67,63 @@ struct _MirageDiscPrivate
 
     /* Session list */
     GList *sessions_list;
+    GPtrArray *tracks_index; /* Tracks of all sessions in layout order, for address lookup */
 
     /* DPM */
     gint dpm_start;
     gint dpm_resolution;
     gint dpm_num_entries;
     guint32 *dpm_data;
+
+    /* Sector pool */
+    GMutex sector_pool_mutex;
+    GPtrArray *sector_pool;
+    guint64 sector_pool_allocations;
+    guint64 sector_pool_acquisitions;
 };
 
+/* Maximum number of idle sector objects kept in the pool */
+#define SECTOR_POOL_SIZE 16
+
 
 /**********************************************************************\
  *                          Private functions                         *
 \**********************************************************************/
 static void mirage_disc_remove_session (MirageDisc *self, MirageSession *session);
 
+static gboolean mirage_disc_add_track_to_index (MirageTrack *track, GPtrArray *tracks_index)
+{
+    g_ptr_array_add(tracks_index, track);
+    return TRUE;
+}
+
+static MirageTrack *mirage_disc_find_track (MirageDisc *self, gint address)
+{
+    /* Binary search over tracks index; tracks are laid out back to back,
+       so their start sectors are sorted. Tracks' current start sectors and
+       lengths are used, which keeps the lookup valid even if the last track
+       has been extended without the layout change being committed yet.
+       Returned track is not referenced */
+    guint lo = 0;
+    guint hi = self->priv->tracks_index->len;
+
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+        MirageTrack *track = g_ptr_array_index(self->priv->tracks_index, mid);
+        gint start_sector = mirage_track_layout_get_start_sector(track);
+
+        if (address < start_sector) {
+            hi = mid;
+        } else if (address >= start_sector + mirage_track_layout_get_length(track)) {
+            lo = mid + 1;
+        } else {
+            return track;
+        }
+    }
+
+    return NULL;
+}
+
 static void mirage_disc_commit_topdown_change (MirageDisc *self)
 {
     /* Rearrange sessions: set numbers, set first tracks, set start sectors */
@@ -103,6 +146,12 @@ static void mirage_disc_commit_topdown_change (MirageDisc *self)
         mirage_session_layout_set_start_sector(session, cur_session_address);
         cur_session_address += mirage_session_layout_get_length(session);
     }
+
+    /* Rebuild tracks index */
+    g_ptr_array_set_size(self->priv->tracks_index, 0);
+    for (GList *entry = self->priv->sessions_list; entry; entry = entry->next) {
+        mirage_session_enumerate_tracks(entry->data, (MirageEnumTrackCallback)mirage_disc_add_track_to_index, self->priv->tracks_index);
+    }
 }
 
 static void mirage_disc_commit_bottomup_change (MirageDisc *self)
@@ -1223,11 +1272,9 @@ MirageTrack *mirage_disc_get_track_by_number (MirageDisc *self, gint number, GEr
  * address that is part of the track to be retrieved (i.e. lying between track's
  * start and end sector).
  *
- * The function attempts to find appropriate session using
- * mirage_disc_get_session_by_address(), then retrieves the track using
- * mirage_session_get_track_by_address().
- *
- * The rest of behavior is same as of mirage_session_get_track_by_address().
+ * The track is looked up in the disc's index of tracks, which is rebuilt
+ * whenever the disc layout changes; the lookup thus takes logarithmic
+ * time with regard to the number of tracks in the layout.
  *
  * Returns: (transfer full): a #MirageTrack on success, %NULL on failure.
  * The reference to the object should be released using g_object_unref()
@@ -1235,20 +1282,15 @@ MirageTrack *mirage_disc_get_track_by_number (MirageDisc *self, gint number, GEr
  */
 MirageTrack *mirage_disc_get_track_by_address (MirageDisc *self, gint address, GError **error)
 {
-    MirageSession *session;
-    MirageTrack *track;
+    MirageTrack *track = mirage_disc_find_track(self, address);
 
-    /* We get session by sector */
-    session = mirage_disc_get_session_by_address(self, address, error);
-    if (!session) {
-        return FALSE;
+    /* If we didn't find anything... */
+    if (!track) {
+        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_DISC_ERROR, Q_("Track containing address %d not found!"), address);
+        return NULL;
     }
 
-    /* And now we get the track */
-    track = mirage_session_get_track_by_address(session, address, error);
-    g_object_unref(session);
-
-    return track;
+    return g_object_ref(track);
 }
 
 
@@ -1356,23 +1398,196 @@ gboolean mirage_disc_get_disc_structure (MirageDisc *self, gint layer, gint type
  */
 MirageSector *mirage_disc_get_sector (MirageDisc *self, gint address, GError **error)
 {
-    MirageTrack *track;
-    MirageSector *sector;
+    /* Fetch the right track; it is owned by the disc, so we do not need
+       to take a reference to it */
+    MirageTrack *track = mirage_disc_find_track(self, address);
+    if (!track) {
+        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_DISC_ERROR, Q_("Track containing address %d not found!"), address);
+        return NULL;
+    }
 
-    /* Fetch the right track */
-    track = mirage_disc_get_track_by_address(self, address, error);
+    /* Get the sector */
+    return mirage_track_get_sector(track, address, TRUE, error);
+}
+
+/**
+ * mirage_disc_read_sector:
+ * @self: a #MirageDisc
+ * @address: (in): sector address
+ * @sector: (in): a #MirageSector to fill
+ * @error: (out) (allow-none): location to store error, or %NULL
+ *
+ * Reads sector at sector address @address into existing @sector object,
+ * replacing its previous contents.
+ *
+ * This function attempts to retrieve appropriate track using
+ * mirage_disc_get_track_by_address(), then fills the sector object using
+ * mirage_track_read_sector(). Together with mirage_disc_acquire_sector() and
+ * mirage_disc_release_sector(), it allows sectors to be read without
+ * constructing new sector objects and allocating memory for their data.
+ *
+ * Returns: %TRUE on success, %FALSE on failure
+ */
+gboolean mirage_disc_read_sector (MirageDisc *self, gint address, MirageSector *sector, GError **error)
+{
+    /* Fetch the right track; it is owned by the disc, so we do not need
+       to take a reference to it */
+    MirageTrack *track = mirage_disc_find_track(self, address);
     if (!track) {
+        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_DISC_ERROR, Q_("Track containing address %d not found!"), address);
         return FALSE;
     }
 
-    /* Get the sector */
-    sector = mirage_track_get_sector(track, address, TRUE, error);
-    /* Unref track */
-    g_object_unref(track);
+    /* Fill the sector */
+    return mirage_track_read_sector(track, address, TRUE, sector, error);
+}
+
+/**
+ * mirage_disc_acquire_sector:
+ * @self: a #MirageDisc
+ *
+ * Acquires a sector object from disc's pool of reusable sector objects;
+ * if the pool is empty, a new sector object is created. The acquired
+ * sector can be filled using mirage_disc_read_sector(), and should be
+ * returned to the pool using mirage_disc_release_sector() when no
+ * longer needed.
+ *
+ * This function is thread-safe.
+ *
+ * Returns: (transfer full): a #MirageSector
+ */
+MirageSector *mirage_disc_acquire_sector (MirageDisc *self)
+{
+    MirageSector *sector = NULL;
+
+    g_mutex_lock(&self->priv->sector_pool_mutex);
+
+    self->priv->sector_pool_acquisitions++;
+    if (self->priv->sector_pool->len) {
+        sector = g_ptr_array_remove_index_fast(self->priv->sector_pool, self->priv->sector_pool->len - 1);
+    } else {
+        self->priv->sector_pool_allocations++;
+    }
+
+    g_mutex_unlock(&self->priv->sector_pool_mutex);
+
+    if (!sector) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_DISC, "%s: sector pool empty; creating new sector object\n", __debug__);
+        sector = g_object_new(MIRAGE_TYPE_SECTOR, NULL);
+    }
 
     return sector;
 }
 
+/**
+ * mirage_disc_release_sector:
+ * @self: a #MirageDisc
+ * @sector: (in) (transfer full): a #MirageSector
+ *
+ * Returns @sector, previously obtained with mirage_disc_acquire_sector(),
+ * to disc's pool of reusable sector objects. If the pool is already full,
+ * the sector object is released instead.
+ *
+ * This function is thread-safe.
+ */
+void mirage_disc_release_sector (MirageDisc *self, MirageSector *sector)
+{
+    g_mutex_lock(&self->priv->sector_pool_mutex);
+
+    if (self->priv->sector_pool->len < SECTOR_POOL_SIZE) {
+        g_ptr_array_add(self->priv->sector_pool, sector);
+        sector = NULL;
+    }
+
+    g_mutex_unlock(&self->priv->sector_pool_mutex);
+
+    if (sector) {
+        g_object_unref(sector);
+    }
+}
+
+/**
+ * mirage_disc_get_sector_pool_statistics:
+ * @self: a #MirageDisc
+ * @allocations: (out) (allow-none): location to store number of sector objects created by the pool, or %NULL
+ * @acquisitions: (out) (allow-none): location to store number of sector objects acquired from the pool, or %NULL
+ *
+ * Retrieves statistics of disc's pool of reusable sector objects. In steady
+ * state, the number of allocations should remain constant while number of
+ * acquisitions increases with each sector read through the pool.
+ */
+void mirage_disc_get_sector_pool_statistics (MirageDisc *self, guint64 *allocations, guint64 *acquisitions)
+{
+    g_mutex_lock(&self->priv->sector_pool_mutex);
+
+    if (allocations) {
+        *allocations = self->priv->sector_pool_allocations;
+    }
+    if (acquisitions) {
+        *acquisitions = self->priv->sector_pool_acquisitions;
+    }
+
+    g_mutex_unlock(&self->priv->sector_pool_mutex);
+}
+
+/**
+ * mirage_disc_read_sectors:
+ * @self: a #MirageDisc
+ * @address: (in): address of first sector
+ * @num_sectors: (in): number of sectors to read
+ * @data_length: (in): expected length of sectors' user data
+ * @buffer: (out caller-allocates) (array): buffer to read user data into
+ * @error: (out) (allow-none): location to store error, or %NULL
+ *
+ * Reads user data of up to @num_sectors consecutive sectors, starting at
+ * sector address @address, into caller-provided @buffer, which must be large
+ * enough to hold @num_sectors times @data_length bytes.
+ *
+ * This is a batched counterpart to retrieving sectors one by one using
+ * mirage_disc_get_sector() and copying their data obtained via
+ * mirage_sector_get_data(). The range is split at session boundaries and
+ * each part is read using mirage_session_read_sectors(). Reading stops at
+ * the end of the layout, or at the first sector whose user data length
+ * does not match @data_length; in that case, the number of returned
+ * sectors is smaller than @num_sectors, and the caller can use
+ * mirage_disc_get_sector() to examine the offending sector.
+ *
+ * Returns: number of read sectors on success, -1 on failure
+ */
+gint mirage_disc_read_sectors (MirageDisc *self, gint address, gint num_sectors, gint data_length, guint8 *buffer, GError **error)
+{
+    gint num_read = 0;
+
+    while (num_read < num_sectors) {
+        MirageSession *session;
+        gint session_count, session_read;
+
+        /* Fetch the right session; failure to do so is an error only for
+           the first sector of the range */
+        session = mirage_disc_get_session_by_address(self, address + num_read, num_read ? NULL : error);
+        if (!session) {
+            return num_read ? num_read : -1;
+        }
+
+        session_count = MIN(num_sectors - num_read, mirage_session_layout_get_start_sector(session) + mirage_session_layout_get_length(session) - (address + num_read));
+        session_read = mirage_session_read_sectors(session, address + num_read, session_count, data_length, buffer + (gsize)num_read * data_length, error);
+
+        g_object_unref(session);
+
+        if (session_read < 0) {
+            return -1;
+        }
+
+        num_read += session_read;
+
+        if (session_read < session_count) {
+            break;
+        }
+    }
+
+    return num_read;
+}
+
 /**
  * mirage_disc_put_sector:
  * @self: a #MirageDisc
@@ -1572,6 +1787,7 @@ static void mirage_disc_init (MirageDisc *self)
     self->priv = mirage_disc_get_instance_private(self);
 
     self->priv->sessions_list = NULL;
+    self->priv->tracks_index = g_ptr_array_new();
 
     self->priv->filenames = NULL;
 
@@ -1584,12 +1800,21 @@ static void mirage_disc_init (MirageDisc *self)
 
     /* Create disc structures hash table */
     self->priv->disc_structures = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)g_byte_array_unref);
+
+    /* Sector pool */
+    g_mutex_init(&self->priv->sector_pool_mutex);
+    self->priv->sector_pool = g_ptr_array_sized_new(SECTOR_POOL_SIZE);
+    self->priv->sector_pool_allocations = 0;
+    self->priv->sector_pool_acquisitions = 0;
 }
 
 static void mirage_disc_dispose (GObject *gobject)
 {
     MirageDisc *self = MIRAGE_DISC(gobject);
 
+    /* Clear tracks index; it does not hold references */
+    g_ptr_array_set_size(self->priv->tracks_index, 0);
+
     /* Unref sessions */
     for (GList *entry = self->priv->sessions_list; entry; entry = entry->next) {
         if (entry->data) {
@@ -1608,6 +1833,13 @@ static void mirage_disc_dispose (GObject *gobject)
         self->priv->disc_structures = NULL;
     }
 
+    /* Unref pooled sectors */
+    if (self->priv->sector_pool) {
+        g_ptr_array_foreach(self->priv->sector_pool, (GFunc)g_object_unref, NULL);
+        g_ptr_array_free(self->priv->sector_pool, TRUE);
+        self->priv->sector_pool = NULL;
+    }
+
     /* Chain up to the parent class */
     return G_OBJECT_CLASS(mirage_disc_parent_class)->dispose(gobject);
 }
@@ -1617,11 +1849,14 @@ static void mirage_disc_finalize (GObject *gobject)
     MirageDisc *self = MIRAGE_DISC(gobject);
 
     g_list_free(self->priv->sessions_list);
+    g_ptr_array_free(self->priv->tracks_index, TRUE);
 
     g_strfreev(self->priv->filenames);
 
     g_free(self->priv->dpm_data);
 
+    g_mutex_clear(&self->priv->sector_pool_mutex);
+
     /* Chain up to the parent class */
     return G_OBJECT_CLASS(mirage_disc_parent_class)->finalize(gobject);
 }
@@ -153,8 +153,15 @@ gboolean mirage_disc_get_disc_structure (MirageDisc *self, gint layer, gint type
 
 /* Direct sector access */
 MirageSector *mirage_disc_get_sector (MirageDisc *self, gint address, GError **error);
+gboolean mirage_disc_read_sector (MirageDisc *self, gint address, MirageSector *sector, GError **error);
+gint mirage_disc_read_sectors (MirageDisc *self, gint address, gint num_sectors, gint data_length, guint8 *buffer, GError **error);
 gboolean mirage_disc_put_sector (MirageDisc *self, MirageSector *sector, GError **error);
 
+/* Sector pool */
+MirageSector *mirage_disc_acquire_sector (MirageDisc *self);
+void mirage_disc_release_sector (MirageDisc *self, MirageSector *sector);
+void mirage_disc_get_sector_pool_statistics (MirageDisc *self, guint64 *allocations, guint64 *acquisitions);
+
 /* DPM */
 void mirage_disc_set_dpm_data (MirageDisc *self, gint start, gint resolution, gint num_entries, const guint32 *data);
 void mirage_disc_get_dpm_data (MirageDisc *self, gint *start, gint *resolution, gint *num_entries, const guint32 **data);
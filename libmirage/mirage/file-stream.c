@@ -29,6 +29,15 @@
  *
  * A #MirageFileStream is found at the bottom of all filter chains used
  * by libMirage's image parsers and writers.
+ *
+ * If enabled by the "file-stream-mmap" context option, #MirageFileStream
+ * that is opened in read-only mode on a local regular file maps the file
+ * into memory instead of reading it via GIO stream, and serves reads
+ * directly from the mapping. Note that if a mapped file is truncated by
+ * another process, or the medium it resides on is removed, accessing the
+ * mapping results in SIGBUS signal being raised instead of a read error;
+ * therefore, memory mapping is disabled by default, and should be enabled
+ * only when the image files are known not to change while they are open.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -58,9 +67,72 @@ struct _MirageFileStreamPrivate
 
     /* Filename the stream was opened on */
     gchar *filename;
+
+    /* Memory-mapped file; used instead of above stream objects */
+    GMappedFile *mapped_file;
+    const guint8 *mapped_data;
+    gsize mapped_length;
+    goffset position;
 };
 
 
+/**********************************************************************\
+ *                          Memory mapping                            *
+\**********************************************************************/
+static gboolean mirage_file_stream_use_mapping (MirageFileStream *self)
+{
+    GVariant *value;
+    gboolean use_mapping = FALSE;
+
+    /* Memory mapping needs to be enabled via context option; see the
+       note about SIGBUS in the section description above */
+    value = mirage_contextual_get_option(MIRAGE_CONTEXTUAL(self), "file-stream-mmap");
+    if (value) {
+        if (g_variant_is_of_type(value, G_VARIANT_TYPE_BOOLEAN)) {
+            use_mapping = g_variant_get_boolean(value);
+        } else {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: invalid type for file-stream-mmap option; using default!\n", __debug__);
+        }
+        g_variant_unref(value);
+    }
+
+    return use_mapping;
+}
+
+static gboolean mirage_file_stream_map_file (MirageFileStream *self, const gchar *filename)
+{
+    GError *local_error = NULL;
+
+    self->priv->mapped_file = g_mapped_file_new(filename, FALSE, &local_error);
+    if (!self->priv->mapped_file) {
+        /* Not fatal; we fall back to GIO stream */
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: failed to map file '%s': %s\n", __debug__, filename, local_error->message);
+        g_error_free(local_error);
+        return FALSE;
+    }
+
+    self->priv->mapped_data = (const guint8 *)g_mapped_file_get_contents(self->priv->mapped_file);
+    self->priv->mapped_length = g_mapped_file_get_length(self->priv->mapped_file);
+    self->priv->position = 0;
+
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: mapped file '%s' (%" G_GSIZE_FORMAT " bytes)\n", __debug__, filename, self->priv->mapped_length);
+
+    return TRUE;
+}
+
+static void mirage_file_stream_unmap_file (MirageFileStream *self)
+{
+    if (self->priv->mapped_file) {
+        g_mapped_file_unref(self->priv->mapped_file);
+        self->priv->mapped_file = NULL;
+    }
+
+    self->priv->mapped_data = NULL;
+    self->priv->mapped_length = 0;
+    self->priv->position = 0;
+}
+
+
 /**********************************************************************\
  *                             Public API                             *
 \**********************************************************************/
@@ -89,13 +161,16 @@ gboolean mirage_file_stream_open (MirageFileStream *self, const gchar *filename,
         self->priv->stream = NULL;
     }
 
+    mirage_file_stream_unmap_file(self);
+
     g_free(self->priv->filename);
     self->priv->filename = NULL;
 
     self->priv->input_stream = NULL;
     self->priv->output_stream = NULL;
 
-    /* Open file; at the bottom of the chain, there's always a GFileStream */
+    /* Open file; at the bottom of the chain, there's always either a
+       GFileStream or a memory-mapped file */
     file = g_file_new_for_path(filename);
 
     if (writable) {
@@ -115,6 +190,13 @@ gboolean mirage_file_stream_open (MirageFileStream *self, const gchar *filename,
             return FALSE;
         }
 
+        /* Local regular files are mapped into memory, if possible */
+        if (file_type == G_FILE_TYPE_REGULAR && g_file_is_native(file) && mirage_file_stream_use_mapping(self) && mirage_file_stream_map_file(self, filename)) {
+            g_object_unref(file);
+            self->priv->filename = g_strdup(filename);
+            return TRUE;
+        }
+
         /* Create GFileInputStream */
         self->priv->stream = g_file_read(file, NULL, &local_error);
 
@@ -158,6 +240,19 @@ static gssize mirage_file_stream_read (MirageStream *_self, void *buffer, gsize
 {
     MirageFileStream *self = MIRAGE_FILE_STREAM(_self);
 
+    if (self->priv->mapped_file) {
+        /* Reading beyond the end of file yields no data */
+        if (self->priv->position >= (goffset)self->priv->mapped_length) {
+            return 0;
+        }
+
+        count = MIN(count, self->priv->mapped_length - self->priv->position);
+        memcpy(buffer, self->priv->mapped_data + self->priv->position, count);
+        self->priv->position += count;
+
+        return count;
+    }
+
     if (!self->priv->input_stream) {
         MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: no file input stream!\n", __debug__);
         g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_STREAM_ERROR, Q_("No file input stream!"));
@@ -184,6 +279,39 @@ static gboolean mirage_file_stream_seek (MirageStream *_self, goffset offset, GS
 {
     MirageFileStream *self = MIRAGE_FILE_STREAM(_self);
 
+    if (self->priv->mapped_file) {
+        goffset new_position;
+
+        switch (type) {
+            case G_SEEK_SET: {
+                new_position = offset;
+                break;
+            }
+            case G_SEEK_CUR: {
+                new_position = self->priv->position + offset;
+                break;
+            }
+            case G_SEEK_END: {
+                new_position = self->priv->mapped_length + offset;
+                break;
+            }
+            default: {
+                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: invalid seek type!\n", __debug__);
+                g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_STREAM_ERROR, Q_("Invalid seek type!"));
+                return FALSE;
+            }
+        }
+
+        if (new_position < 0) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: seek before beginning of stream!\n", __debug__);
+            g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_STREAM_ERROR, Q_("Seek before beginning of stream!"));
+            return FALSE;
+        }
+
+        self->priv->position = new_position;
+        return TRUE;
+    }
+
     if (!self->priv->stream) {
         MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: no file stream!\n", __debug__);
         g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_STREAM_ERROR, Q_("No file stream!"));
@@ -198,6 +326,10 @@ static goffset mirage_file_stream_tell (MirageStream *_self)
 {
     MirageFileStream *self = MIRAGE_FILE_STREAM(_self);
 
+    if (self->priv->mapped_file) {
+        return self->priv->position;
+    }
+
     if (!self->priv->stream) {
         MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: no file stream!\n", __debug__);
         return -1;
@@ -293,6 +425,11 @@ static void mirage_file_stream_init (MirageFileStream *self)
     self->priv->stream = NULL;
 
     self->priv->filename = NULL;
+
+    self->priv->mapped_file = NULL;
+    self->priv->mapped_data = NULL;
+    self->priv->mapped_length = 0;
+    self->priv->position = 0;
 }
 
 static void mirage_file_stream_dispose (GObject *gobject)
@@ -305,6 +442,9 @@ static void mirage_file_stream_dispose (GObject *gobject)
         self->priv->stream = NULL;
     }
 
+    /* Unmap file */
+    mirage_file_stream_unmap_file(self);
+
     /* Chain up to the parent class */
     return G_OBJECT_CLASS(mirage_file_stream_parent_class)->dispose(gobject);
 }
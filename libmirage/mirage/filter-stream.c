@@ -45,6 +45,30 @@
  * mirage_filter_stream_simplified_set_stream_length() function. In
  * simplified_partial_read, the current position in the stream, which is
  * managed by the framework, can be obtained using mirage_filter_stream_simplified_get_position().
+ *
+ * Filter streams that decode data in parts (for example, compressed blocks)
+ * can additionally use the part cache provided by the simplified interface.
+ * Such implementation sets the maximum size of a decoded part using
+ * mirage_filter_stream_simplified_set_part_size(), implements the
+ * simplified_decode_part function, and obtains the decoded parts via
+ * mirage_filter_stream_simplified_get_part(). The framework keeps the
+ * most recently used parts resident (their number is given by the
+ * "filter-stream-cache-parts" context option), and shares decoded parts
+ * via the context's block cache.
+ *
+ * If decoding of a part can be split into reading its raw data from the
+ * underlying stream and decoding the raw data without accessing the
+ * stream's state, the implementation can instead provide the
+ * simplified_read_raw_part and simplified_decode_raw_part functions. In
+ * that case, the framework decodes the parts that follow the most recently
+ * accessed one in parallel, using a pool of worker threads. The number of
+ * parts that are decoded ahead is given by the "filter-stream-decode-ahead"
+ * context option; setting it to 0 disables parallel decoding.
+ *
+ * Filter streams that need to scan the whole underlying stream in order
+ * to build an index of its parts can store the index into the on-disk
+ * index cache using mirage_filter_stream_save_index(), and retrieve it
+ * when the same file is opened again using mirage_filter_stream_load_index().
  */
 
 #ifdef HAVE_CONFIG_H
@@ -58,9 +82,41 @@
 #define __debug__ "FilterStream"
 
 
+/* Default number of resident decoded parts */
+#define DEFAULT_CACHE_PARTS 4
+#define MAX_CACHE_PARTS 256
+
+/* Default number of parts decoded ahead, per processor */
+#define DEFAULT_DECODE_AHEAD_PER_CPU 2
+#define MAX_DECODE_AHEAD 64
+
+/* Number of consecutively accessed parts after which decode-ahead kicks in */
+#define DECODE_AHEAD_SEQUENTIAL_PARTS 2
+
+
 /**********************************************************************\
  *                          Private structure                         *
 \**********************************************************************/
+typedef struct
+{
+    gboolean valid;
+    guint64 index;
+    guint64 last_used;
+
+    GBytes *data;
+} MirageFilterStreamPartSlot;
+
+typedef struct
+{
+    MirageFilterStream *stream;
+    guint64 index;
+
+    GBytes *raw_data;
+
+    gboolean done;
+    GBytes *data; /* NULL if decoding failed */
+} MirageFilterStreamDecodeJob;
+
 struct _MirageFilterStreamPrivate
 {
     MirageFilterStreamInfo info;
@@ -70,6 +126,22 @@ struct _MirageFilterStreamPrivate
     /* Simplified interface */
     guint64 stream_length;
     goffset position;
+
+    /* Part cache */
+    gsize part_size;
+    MirageFilterStreamPartSlot *part_slots;
+    gint num_part_slots;
+    guint64 part_slots_counter;
+
+    /* Parallel decoding */
+    gint decode_ahead;
+    guint64 last_part; /* Last accessed part; G_MAXUINT64 if none */
+    gint sequential_parts; /* Number of consecutively accessed parts */
+    GHashTable *decode_jobs;
+    gint num_running_jobs;
+
+    GMutex decode_mutex;
+    GCond decode_cond;
 };
 
 
@@ -130,6 +202,451 @@ void mirage_filter_stream_info_free (MirageFilterStreamInfo *info)
 }
 
 
+/**********************************************************************\
+ *                            Part decoding                           *
+\**********************************************************************/
+static GBytes *mirage_filter_stream_decode_raw_part (MirageFilterStream *self, guint64 index, GBytes *raw_data)
+{
+    guint8 *buffer;
+    gssize decoded_length;
+
+    buffer = g_try_malloc(self->priv->part_size);
+    if (!buffer && self->priv->part_size) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to allocate part buffer (%" G_GSIZE_MODIFIER "d bytes)!\n", __debug__, self->priv->part_size);
+        return NULL;
+    }
+
+    decoded_length = MIRAGE_FILTER_STREAM_GET_CLASS(self)->simplified_decode_raw_part(self, index, raw_data, buffer, self->priv->part_size);
+    if (decoded_length == -1) {
+        g_free(buffer);
+        return NULL;
+    }
+
+    return g_bytes_new_take(buffer, decoded_length);
+}
+
+static GBytes *mirage_filter_stream_decode_part (MirageFilterStream *self, guint64 index)
+{
+    MirageFilterStreamClass *klass = MIRAGE_FILTER_STREAM_GET_CLASS(self);
+
+    if (klass->simplified_decode_part) {
+        guint8 *buffer;
+        gssize decoded_length;
+
+        /* Zero-initialized, as implementations are not required to
+           write all of the buffer (e.g., reserved fields of sectors) */
+        buffer = g_try_malloc0(self->priv->part_size);
+        if (!buffer && self->priv->part_size) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to allocate part buffer (%" G_GSIZE_MODIFIER "d bytes)!\n", __debug__, self->priv->part_size);
+            return NULL;
+        }
+
+        decoded_length = klass->simplified_decode_part(self, index, buffer, self->priv->part_size);
+        if (decoded_length == -1) {
+            g_free(buffer);
+            return NULL;
+        }
+
+        return g_bytes_new_take(buffer, decoded_length);
+    } else if (klass->simplified_read_raw_part && klass->simplified_decode_raw_part) {
+        GBytes *raw_data;
+        GBytes *data;
+
+        raw_data = klass->simplified_read_raw_part(self, index);
+        if (!raw_data) {
+            return NULL;
+        }
+
+        data = mirage_filter_stream_decode_raw_part(self, index, raw_data);
+        g_bytes_unref(raw_data);
+
+        return data;
+    }
+
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: simplified decode part function is not implemented!\n", __debug__);
+    return NULL;
+}
+
+
+/**********************************************************************\
+ *                         Parallel decoding                          *
+\**********************************************************************/
+static void mirage_filter_stream_decode_job_free (MirageFilterStreamDecodeJob *job)
+{
+    if (job->raw_data) {
+        g_bytes_unref(job->raw_data);
+    }
+    if (job->data) {
+        g_bytes_unref(job->data);
+    }
+    g_slice_free(MirageFilterStreamDecodeJob, job);
+}
+
+static void mirage_filter_stream_decode_job_run (MirageFilterStreamDecodeJob *job, gpointer user_data G_GNUC_UNUSED)
+{
+    MirageFilterStream *self = job->stream;
+    GBytes *data;
+
+    /* Executed in worker thread; only the job and raw part decoding
+       function may be accessed here */
+    data = mirage_filter_stream_decode_raw_part(self, job->index, job->raw_data);
+
+    g_bytes_unref(job->raw_data);
+    job->raw_data = NULL;
+
+    g_mutex_lock(&self->priv->decode_mutex);
+    job->data = data;
+    job->done = TRUE;
+    self->priv->num_running_jobs--;
+    g_cond_broadcast(&self->priv->decode_cond);
+    g_mutex_unlock(&self->priv->decode_mutex);
+}
+
+static GThreadPool *mirage_filter_stream_get_decode_pool (void)
+{
+    static gsize initialized = 0;
+    static GThreadPool *pool = NULL;
+
+    /* Pool is shared by all filter streams */
+    if (g_once_init_enter(&initialized)) {
+        pool = g_thread_pool_new((GFunc)mirage_filter_stream_decode_job_run, NULL, g_get_num_processors(), FALSE, NULL);
+        g_once_init_leave(&initialized, 1);
+    }
+
+    return pool;
+}
+
+static GBytes *mirage_filter_stream_claim_decoded_part (MirageFilterStream *self, guint64 index)
+{
+    MirageFilterStreamDecodeJob *job;
+    GBytes *data = NULL;
+
+    if (!self->priv->decode_jobs) {
+        return NULL;
+    }
+
+    /* NOTE: the job table is modified only by the thread that reads from
+       the stream; worker threads modify only the jobs' state */
+    job = g_hash_table_lookup(self->priv->decode_jobs, &index);
+    if (!job) {
+        return NULL;
+    }
+
+    /* Wait for the job to finish */
+    g_mutex_lock(&self->priv->decode_mutex);
+    while (!job->done) {
+        g_cond_wait(&self->priv->decode_cond, &self->priv->decode_mutex);
+    }
+    g_mutex_unlock(&self->priv->decode_mutex);
+
+    data = job->data;
+    job->data = NULL;
+
+    g_hash_table_remove(self->priv->decode_jobs, &index);
+
+    return data;
+}
+
+static gboolean mirage_filter_stream_part_is_resident (MirageFilterStream *self, guint64 index)
+{
+    for (gint i = 0; i < self->priv->num_part_slots; i++) {
+        if (self->priv->part_slots[i].valid && self->priv->part_slots[i].index == index) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static void mirage_filter_stream_decode_ahead (MirageFilterStream *self, guint64 index)
+{
+    GHashTableIter iter;
+    MirageFilterStreamDecodeJob *job;
+
+    if (!self->priv->decode_jobs) {
+        return;
+    }
+
+    /* Drop the finished jobs that fall outside the decode-ahead window */
+    g_mutex_lock(&self->priv->decode_mutex);
+    g_hash_table_iter_init(&iter, self->priv->decode_jobs);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&job)) {
+        if (job->done && (job->index <= index || job->index > index + self->priv->decode_ahead)) {
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+    g_mutex_unlock(&self->priv->decode_mutex);
+
+    /* Submit jobs for parts within the window that are not available yet */
+    for (guint64 i = index + 1; i <= index + self->priv->decode_ahead; i++) {
+        GBytes *raw_data;
+
+        if (g_hash_table_contains(self->priv->decode_jobs, &i) || mirage_filter_stream_part_is_resident(self, i)) {
+            continue;
+        }
+
+        /* Already decoded; probe the cache without affecting its statistics */
+        if (mirage_contextual_cache_contains_block(MIRAGE_CONTEXTUAL(self), i)) {
+            continue;
+        }
+
+        /* Raw data is read here, because underlying stream must not be
+           accessed from worker threads */
+        raw_data = MIRAGE_FILTER_STREAM_GET_CLASS(self)->simplified_read_raw_part(self, i);
+        if (!raw_data) {
+            /* Most likely we are past the last part */
+            break;
+        }
+
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: submitting part #%" G_GINT64_MODIFIER "u for decoding\n", __debug__, i);
+
+        job = g_slice_new0(MirageFilterStreamDecodeJob);
+        job->stream = self;
+        job->index = i;
+        job->raw_data = raw_data;
+
+        g_hash_table_insert(self->priv->decode_jobs, &job->index, job);
+
+        g_mutex_lock(&self->priv->decode_mutex);
+        self->priv->num_running_jobs++;
+        g_mutex_unlock(&self->priv->decode_mutex);
+
+        g_thread_pool_push(mirage_filter_stream_get_decode_pool(), job, NULL);
+    }
+}
+
+static void mirage_filter_stream_decode_jobs_cleanup (MirageFilterStream *self)
+{
+    if (!self->priv->decode_jobs) {
+        return;
+    }
+
+    /* Wait for running jobs to finish */
+    g_mutex_lock(&self->priv->decode_mutex);
+    while (self->priv->num_running_jobs) {
+        g_cond_wait(&self->priv->decode_cond, &self->priv->decode_mutex);
+    }
+    g_mutex_unlock(&self->priv->decode_mutex);
+
+    g_hash_table_unref(self->priv->decode_jobs);
+    self->priv->decode_jobs = NULL;
+}
+
+
+/**********************************************************************\
+ *                            Index cache                             *
+\**********************************************************************/
+/* Amount of data at the beginning and at the end of the underlying stream
+   that is hashed to validate a cached index */
+#define INDEX_CACHE_HASH_SIZE 65536
+
+/* Limits of the index cache; when an index is stored, cached indices that
+   have not been used for longer than INDEX_CACHE_MAX_AGE seconds are
+   removed, and so are the least recently used ones, until the total size
+   of the cache falls within INDEX_CACHE_MAX_SIZE bytes */
+#define INDEX_CACHE_MAX_AGE (90*24*60*60)
+#define INDEX_CACHE_MAX_SIZE (64*1024*1024)
+
+typedef struct
+{
+    gchar *filename;
+    gint64 mtime;
+    guint64 size;
+} MirageFilterStreamIndexCacheEntry;
+
+static gchar *mirage_filter_stream_get_index_cache_dir (MirageFilterStream *self)
+{
+    GVariant *value;
+    gchar *directory = NULL;
+
+    /* Cache directory can be set via context option; an empty string
+       disables the index cache */
+    value = mirage_contextual_get_option(MIRAGE_CONTEXTUAL(self), "filter-stream-index-cache");
+    if (value) {
+        if (g_variant_is_of_type(value, G_VARIANT_TYPE_STRING)) {
+            directory = g_variant_dup_string(value, NULL);
+        } else {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: invalid type for filter-stream-index-cache option; using default!\n", __debug__);
+        }
+        g_variant_unref(value);
+    }
+
+    if (!directory) {
+        directory = g_build_filename(g_get_user_cache_dir(), "libmirage", "index", NULL);
+    }
+
+    if (!directory[0]) {
+        g_free(directory);
+        return NULL;
+    }
+
+    return directory;
+}
+
+static gboolean mirage_filter_stream_get_index_cache_key (MirageFilterStream *self, guint64 *size, gint64 *mtime, gchar **content_hash)
+{
+    MirageStream *stream = self->priv->underlying_stream;
+    const gchar *filename = mirage_stream_get_filename(stream);
+    GStatBuf st;
+    GChecksum *checksum;
+    guint8 *buffer;
+    gssize read_length;
+
+    /* Only streams that are backed by a local file can be cached */
+    if (!filename || g_stat(filename, &st) < 0) {
+        return FALSE;
+    }
+    *mtime = st.st_mtime;
+
+    /* Size of the underlying stream; if there are other filter streams
+       below us, it differs from the size of the file */
+    if (!mirage_stream_seek(stream, 0, G_SEEK_END, NULL)) {
+        return FALSE;
+    }
+    *size = mirage_stream_tell(stream);
+
+    /* Hashing the whole stream would defeat the purpose of the cache, so
+       we hash its beginning and its end */
+    buffer = g_malloc(INDEX_CACHE_HASH_SIZE);
+    checksum = g_checksum_new(G_CHECKSUM_SHA256);
+
+    mirage_stream_seek(stream, 0, G_SEEK_SET, NULL);
+    read_length = mirage_stream_read(stream, buffer, INDEX_CACHE_HASH_SIZE, NULL);
+    if (read_length > 0) {
+        g_checksum_update(checksum, buffer, read_length);
+    }
+
+    if (*size > INDEX_CACHE_HASH_SIZE) {
+        mirage_stream_seek(stream, -INDEX_CACHE_HASH_SIZE, G_SEEK_END, NULL);
+        read_length = mirage_stream_read(stream, buffer, INDEX_CACHE_HASH_SIZE, NULL);
+        if (read_length > 0) {
+            g_checksum_update(checksum, buffer, read_length);
+        }
+    }
+
+    *content_hash = g_strdup(g_checksum_get_string(checksum));
+
+    g_checksum_free(checksum);
+    g_free(buffer);
+
+    return TRUE;
+}
+
+static gchar *mirage_filter_stream_get_index_cache_filename (MirageFilterStream *self, const gchar *index_id)
+{
+    const gchar *filename = mirage_stream_get_filename(self->priv->underlying_stream);
+    gchar *directory;
+    gchar *key;
+    gchar *basename;
+    gchar *cache_filename;
+
+    directory = mirage_filter_stream_get_index_cache_dir(self);
+    if (!directory) {
+        return NULL;
+    }
+
+    /* Cache file is named after the hash of index ID and the filename;
+       remaining properties of the file are stored inside the cache file
+       and validated on load, so a stale index is replaced */
+    key = g_strdup_printf("%s\n%s", index_id, filename);
+    basename = g_compute_checksum_for_string(G_CHECKSUM_SHA1, key, -1);
+    cache_filename = g_build_filename(directory, basename, NULL);
+
+    g_free(basename);
+    g_free(key);
+    g_free(directory);
+
+    return cache_filename;
+}
+
+
+static gboolean mirage_filter_stream_is_index_cache_filename (const gchar *basename)
+{
+    /* Cache files are named after SHA1 hash; other files that may be
+       found in the cache directory are not ours to remove */
+    if (strlen(basename) != 40) {
+        return FALSE;
+    }
+
+    for (gint i = 0; i < 40; i++) {
+        if (!g_ascii_isxdigit(basename[i])) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static gint sort_index_cache_entries_by_mtime (const MirageFilterStreamIndexCacheEntry *entry1, const MirageFilterStreamIndexCacheEntry *entry2)
+{
+    /* Most recently used first */
+    if (entry1->mtime > entry2->mtime) {
+        return -1;
+    } else if (entry1->mtime < entry2->mtime) {
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+static void mirage_filter_stream_prune_index_cache (MirageFilterStream *self, const gchar *directory)
+{
+    GArray *entries;
+    GDir *dir;
+    const gchar *basename;
+    gint64 now = g_get_real_time() / G_USEC_PER_SEC;
+    guint64 total_size = 0;
+
+    dir = g_dir_open(directory, 0, NULL);
+    if (!dir) {
+        return;
+    }
+
+    /* Gather cache files; modification time of a cache file is updated
+       whenever the index is loaded, so it reflects the time of last use */
+    entries = g_array_new(FALSE, FALSE, sizeof(MirageFilterStreamIndexCacheEntry));
+
+    while ((basename = g_dir_read_name(dir))) {
+        MirageFilterStreamIndexCacheEntry entry;
+        GStatBuf st;
+
+        if (!mirage_filter_stream_is_index_cache_filename(basename)) {
+            continue;
+        }
+
+        entry.filename = g_build_filename(directory, basename, NULL);
+        if (g_stat(entry.filename, &st) < 0 || !S_ISREG(st.st_mode)) {
+            g_free(entry.filename);
+            continue;
+        }
+        entry.mtime = st.st_mtime;
+        entry.size = st.st_size;
+
+        g_array_append_val(entries, entry);
+    }
+
+    g_dir_close(dir);
+
+    /* Remove stale entries, and the least recently used ones that exceed
+       the size limit */
+    g_array_sort(entries, (GCompareFunc)sort_index_cache_entries_by_mtime);
+
+    for (guint i = 0; i < entries->len; i++) {
+        MirageFilterStreamIndexCacheEntry *entry = &g_array_index(entries, MirageFilterStreamIndexCacheEntry, i);
+
+        total_size += entry->size;
+        if (now - entry->mtime > INDEX_CACHE_MAX_AGE || total_size > INDEX_CACHE_MAX_SIZE) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: removing cached index: %s\n", __debug__, entry->filename);
+            g_unlink(entry->filename);
+            total_size -= entry->size;
+        }
+
+        g_free(entry->filename);
+    }
+
+    g_array_free(entries, TRUE);
+}
+
+
 /**********************************************************************\
  *                             Public API                             *
 \**********************************************************************/
@@ -254,6 +771,355 @@ goffset mirage_filter_stream_simplified_get_position (MirageFilterStream *self)
     return self->priv->position;
 }
 
+/**
+ * mirage_filter_stream_simplified_set_part_size:
+ * @self: a #MirageFilterStream
+ * @part_size: (in): maximum size of a decoded part
+ *
+ * Sets the maximum size of a decoded part.
+ *
+ * This function is intented for use in filter stream implementations that
+ * are based on the simplified interface and use the part cache. It should
+ * be used by the implementation to set the part size during stream parsing;
+ * the set size is then used to allocate buffers that are passed to
+ * implementation's simplified_decode_part function. Changing the part size
+ * discards all resident parts.
+ */
+void mirage_filter_stream_simplified_set_part_size (MirageFilterStream *self, gsize part_size)
+{
+    self->priv->part_size = part_size;
+
+    /* Invalidate resident parts */
+    for (gint i = 0; i < self->priv->num_part_slots; i++) {
+        MirageFilterStreamPartSlot *slot = &self->priv->part_slots[i];
+        if (slot->data) {
+            g_bytes_unref(slot->data);
+            slot->data = NULL;
+        }
+        slot->valid = FALSE;
+    }
+}
+
+static void mirage_filter_stream_part_cache_init (MirageFilterStream *self)
+{
+    GVariant *value;
+    gint num_slots = DEFAULT_CACHE_PARTS;
+
+    /* Number of resident parts can be set via context option */
+    value = mirage_contextual_get_option(MIRAGE_CONTEXTUAL(self), "filter-stream-cache-parts");
+    if (value) {
+        if (g_variant_is_of_type(value, G_VARIANT_TYPE_INT32)) {
+            num_slots = CLAMP(g_variant_get_int32(value), 1, MAX_CACHE_PARTS);
+        } else {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: invalid type for filter-stream-cache-parts option; using default!\n", __debug__);
+        }
+        g_variant_unref(value);
+    }
+
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: keeping up to %d decoded parts resident\n", __debug__, num_slots);
+
+    self->priv->part_slots = g_new0(MirageFilterStreamPartSlot, num_slots);
+    self->priv->num_part_slots = num_slots;
+
+    /* Parallel decoding requires the raw part interface */
+    if (MIRAGE_FILTER_STREAM_GET_CLASS(self)->simplified_read_raw_part && MIRAGE_FILTER_STREAM_GET_CLASS(self)->simplified_decode_raw_part) {
+        gint decode_ahead = MIN(g_get_num_processors() * DEFAULT_DECODE_AHEAD_PER_CPU, MAX_DECODE_AHEAD);
+
+        /* Single processor gains nothing from decoding ahead */
+        if (g_get_num_processors() < 2) {
+            decode_ahead = 0;
+        }
+
+        /* Number of parts decoded ahead can be set via context option */
+        value = mirage_contextual_get_option(MIRAGE_CONTEXTUAL(self), "filter-stream-decode-ahead");
+        if (value) {
+            if (g_variant_is_of_type(value, G_VARIANT_TYPE_INT32)) {
+                decode_ahead = CLAMP(g_variant_get_int32(value), 0, MAX_DECODE_AHEAD);
+            } else {
+                MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: invalid type for filter-stream-decode-ahead option; using default!\n", __debug__);
+            }
+            g_variant_unref(value);
+        }
+
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: decoding up to %d parts ahead\n", __debug__, decode_ahead);
+
+        self->priv->decode_ahead = decode_ahead;
+        if (decode_ahead) {
+            self->priv->decode_jobs = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, (GDestroyNotify)mirage_filter_stream_decode_job_free);
+        }
+    }
+}
+
+/**
+ * mirage_filter_stream_simplified_get_part:
+ * @self: a #MirageFilterStream
+ * @index: (in): index of the part
+ * @length: (out) (allow-none): location to store length of the decoded part, or %NULL
+ *
+ * Retrieves the decoded data of the part with index @index.
+ *
+ * This function is intented for use in filter stream implementations that
+ * are based on the simplified interface and use the part cache. If the part
+ * is neither resident nor available in the context's block cache, it is
+ * decoded using the implementation's simplified_decode_part function (or
+ * simplified_read_raw_part and simplified_decode_raw_part functions). The
+ * least recently used resident part is discarded to make room for it.
+ * If the implementation supports parallel decoding and the parts are being
+ * accessed sequentially, the subsequent parts are submitted for decoding in
+ * worker threads.
+ *
+ * Returns: (transfer none): pointer to the decoded data on success, %NULL on
+ * failure. The data belongs to the filter stream and is valid until the next
+ * call of this function.
+ */
+const guint8 *mirage_filter_stream_simplified_get_part (MirageFilterStream *self, guint64 index, gsize *length)
+{
+    MirageFilterStreamPartSlot *slot = NULL;
+    GBytes *data;
+
+    if (!self->priv->part_slots) {
+        mirage_filter_stream_part_cache_init(self);
+    }
+
+    /* Keep track of sequential access, which determines whether parts
+       are decoded ahead */
+    if (index != self->priv->last_part) {
+        if (self->priv->last_part != G_MAXUINT64 && index == self->priv->last_part + 1) {
+            self->priv->sequential_parts++;
+        } else {
+            self->priv->sequential_parts = 0;
+        }
+        self->priv->last_part = index;
+    }
+
+    /* Look for the part among the resident ones; at the same time, find
+       the least recently used slot in case we need to replace it */
+    for (gint i = 0; i < self->priv->num_part_slots; i++) {
+        MirageFilterStreamPartSlot *cur_slot = &self->priv->part_slots[i];
+
+        if (cur_slot->valid && cur_slot->index == index) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: part #%" G_GINT64_MODIFIER "u is resident\n", __debug__, index);
+            cur_slot->last_used = ++self->priv->part_slots_counter;
+            if (length) {
+                *length = g_bytes_get_size(cur_slot->data);
+            }
+            return g_bytes_get_data(cur_slot->data, NULL);
+        }
+
+        if (!slot || !cur_slot->valid || (slot->valid && cur_slot->last_used < slot->last_used)) {
+            slot = cur_slot;
+        }
+    }
+
+    /* Release the slot */
+    if (slot->data) {
+        g_bytes_unref(slot->data);
+        slot->data = NULL;
+    }
+    slot->valid = FALSE;
+
+    /* Part might have already been decoded ahead by a worker thread */
+    data = mirage_filter_stream_claim_decoded_part(self, index);
+    if (data) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: part #%" G_GINT64_MODIFIER "u has been decoded ahead\n", __debug__, index);
+        mirage_contextual_cache_insert_block(MIRAGE_CONTEXTUAL(self), index, data);
+    }
+
+    /* Try context's block cache */
+    if (!data) {
+        data = mirage_contextual_cache_lookup_block(MIRAGE_CONTEXTUAL(self), index);
+        if (data) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: part #%" G_GINT64_MODIFIER "u found in block cache\n", __debug__, index);
+        }
+    }
+
+    /* Decode the part */
+    if (!data) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: part #%" G_GINT64_MODIFIER "u not cached, decoding...\n", __debug__, index);
+
+        data = mirage_filter_stream_decode_part(self, index);
+        if (!data) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to decode part #%" G_GINT64_MODIFIER "u!\n", __debug__, index);
+            return NULL;
+        }
+
+        /* Store part into context's block cache */
+        mirage_contextual_cache_insert_block(MIRAGE_CONTEXTUAL(self), index, data);
+    }
+
+    /* Make the part resident */
+    slot->valid = TRUE;
+    slot->index = index;
+    slot->last_used = ++self->priv->part_slots_counter;
+    slot->data = data;
+
+    /* Keep the worker threads busy with subsequent parts; but only when
+       parts are being accessed sequentially, as decoding ahead is wasted
+       effort otherwise */
+    if (self->priv->sequential_parts >= DECODE_AHEAD_SEQUENTIAL_PARTS) {
+        mirage_filter_stream_decode_ahead(self, index);
+    }
+
+    if (length) {
+        *length = g_bytes_get_size(data);
+    }
+    return g_bytes_get_data(data, NULL);
+}
+
+
+/**
+ * mirage_filter_stream_load_index:
+ * @self: a #MirageFilterStream
+ * @index_id: (in): identifier of the index format
+ * @index_type: (in): expected type of the index
+ *
+ * Loads the index of the underlying stream's data from the on-disk index
+ * cache.
+ *
+ * This function is intended for use in filter stream implementations that
+ * need to scan the whole underlying stream in order to build an index of
+ * its parts. The index is looked up by @index_id and the underlying
+ * stream's filename, and is returned only if the size, modification time
+ * and content hash of the underlying stream match the ones that were
+ * recorded when the index was stored using mirage_filter_stream_save_index().
+ * @index_id should be changed whenever the index format changes.
+ *
+ * The location of the index cache is given by the "filter-stream-index-cache"
+ * context option; setting it to an empty string disables the index cache.
+ * The size of the cache is bounded; indices that have not been used for a
+ * long time are removed when new ones are stored.
+ *
+ * Returns: (transfer full): a #GVariant of type @index_type on success, or
+ * %NULL if valid index is not available. The reference should be released
+ * using g_variant_unref() when no longer needed.
+ */
+GVariant *mirage_filter_stream_load_index (MirageFilterStream *self, const gchar *index_id, const GVariantType *index_type)
+{
+    gchar *cache_filename;
+    gchar *data;
+    gsize length;
+    GVariant *cache;
+    GVariant *index = NULL;
+
+    const gchar *cached_id;
+    const gchar *cached_filename;
+    guint64 cached_size;
+    gint64 cached_mtime;
+    const gchar *cached_hash;
+    GVariant *cached_index;
+
+    guint64 size;
+    gint64 mtime;
+    gchar *content_hash;
+
+    cache_filename = mirage_filter_stream_get_index_cache_filename(self, index_id);
+    if (!cache_filename) {
+        return NULL;
+    }
+
+    if (!g_file_get_contents(cache_filename, &data, &length, NULL)) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: index not found in cache\n", __debug__);
+        g_free(cache_filename);
+        return NULL;
+    }
+
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: found cached index: %s\n", __debug__, cache_filename);
+
+    /* Cache file is not trusted; GVariant deals with malformed data */
+    cache = g_variant_new_from_data(G_VARIANT_TYPE("(sstxsv)"), data, length, FALSE, g_free, data);
+    g_variant_ref_sink(cache);
+    g_variant_get(cache, "(&s&stx&sv)", &cached_id, &cached_filename, &cached_size, &cached_mtime, &cached_hash, &cached_index);
+
+    /* Validate the index against current state of the file */
+    if (!mirage_filter_stream_get_index_cache_key(self, &size, &mtime, &content_hash)) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to obtain properties of underlying stream!\n", __debug__);
+    } else {
+        if (g_strcmp0(cached_id, index_id) || g_strcmp0(cached_filename, mirage_stream_get_filename(self->priv->underlying_stream))) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: cached index belongs to different file or index format\n", __debug__);
+        } else if (cached_size != size || cached_mtime != mtime || g_strcmp0(cached_hash, content_hash)) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: file has changed since index was cached\n", __debug__);
+        } else if (!g_variant_is_of_type(cached_index, index_type)) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: cached index is of invalid type!\n", __debug__);
+        } else {
+            index = g_variant_ref(cached_index);
+
+            /* Mark the index as recently used, so it is not pruned */
+            g_utime(cache_filename, NULL);
+        }
+        g_free(content_hash);
+    }
+
+    g_variant_unref(cached_index);
+    g_variant_unref(cache);
+    g_free(cache_filename);
+
+    return index;
+}
+
+/**
+ * mirage_filter_stream_save_index:
+ * @self: a #MirageFilterStream
+ * @index_id: (in): identifier of the index format
+ * @index: (in): index
+ *
+ * Stores the index of the underlying stream's data into the on-disk index
+ * cache, so that it can be retrieved using mirage_filter_stream_load_index()
+ * when the same file is opened again. Along with the index, the size,
+ * modification time and content hash of the underlying stream are stored.
+ *
+ * If @index is floating, it is consumed. Failure to store the index is
+ * not considered an error; it merely results in the index being rebuilt
+ * the next time.
+ */
+void mirage_filter_stream_save_index (MirageFilterStream *self, const gchar *index_id, GVariant *index)
+{
+    GError *local_error = NULL;
+    gchar *cache_filename;
+    gchar *directory;
+    GVariant *cache;
+
+    guint64 size;
+    gint64 mtime;
+    gchar *content_hash;
+
+    g_variant_ref_sink(index);
+
+    cache_filename = mirage_filter_stream_get_index_cache_filename(self, index_id);
+    if (!cache_filename) {
+        g_variant_unref(index);
+        return;
+    }
+
+    if (!mirage_filter_stream_get_index_cache_key(self, &size, &mtime, &content_hash)) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: underlying stream is not a local file; not caching index\n", __debug__);
+        g_variant_unref(index);
+        g_free(cache_filename);
+        return;
+    }
+
+    cache = g_variant_new("(sstxsv)", index_id, mirage_stream_get_filename(self->priv->underlying_stream), size, mtime, content_hash, index);
+    g_variant_ref_sink(cache);
+
+    directory = g_path_get_dirname(cache_filename);
+    g_mkdir_with_parents(directory, 0700);
+
+    if (!g_file_set_contents(cache_filename, g_variant_get_data(cache), g_variant_get_size(cache), &local_error)) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to store index into cache: %s\n", __debug__, local_error->message);
+        g_error_free(local_error);
+    } else {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_STREAM, "%s: stored index into cache: %s\n", __debug__, cache_filename);
+
+        /* Keep the cache within its limits */
+        mirage_filter_stream_prune_index_cache(self, directory);
+    }
+
+    g_free(directory);
+    g_variant_unref(cache);
+    g_free(content_hash);
+    g_variant_unref(index);
+    g_free(cache_filename);
+}
+
 
 /**********************************************************************\
  *                MirageStream methods implementations                *
@@ -362,6 +1228,14 @@ static gssize mirage_filter_stream_read_impl (MirageFilterStream *self, void *bu
             return -1;
         }
 
+        /* Implementation could not provide any data at current position
+           (e.g., its part index does not cover it); treat it as end of
+           stream rather than retrying forever */
+        if (read_len == 0) {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: partial read returned no data at position %" G_GOFFSET_MODIFIER "d; stopping!\n", __debug__, self->priv->position);
+            break;
+        }
+
         ptr += read_len;
         total_read += read_len;
         count -= read_len;
@@ -496,12 +1370,36 @@ static void mirage_filter_stream_init (MirageFilterStream *self)
 
     self->priv->stream_length = 0;
     self->priv->position = 0;
+
+    self->priv->part_size = 0;
+    self->priv->part_slots = NULL;
+    self->priv->num_part_slots = 0;
+    self->priv->part_slots_counter = 0;
+
+    self->priv->decode_ahead = 0;
+    self->priv->last_part = G_MAXUINT64;
+    self->priv->sequential_parts = 0;
+    self->priv->decode_jobs = NULL;
+    self->priv->num_running_jobs = 0;
+
+    g_mutex_init(&self->priv->decode_mutex);
+    g_cond_init(&self->priv->decode_cond);
 }
 
 static void mirage_filter_stream_dispose (GObject *gobject)
 {
     MirageFilterStream *self = MIRAGE_FILTER_STREAM(gobject);
 
+    /* Wait for parts that are being decoded in worker threads */
+    mirage_filter_stream_decode_jobs_cleanup(self);
+
+    /* Drop our blocks from context's block cache; this must be done
+       while context is still attached */
+    mirage_contextual_cache_remove_blocks(MIRAGE_CONTEXTUAL(self));
+
+    /* Release resident parts */
+    mirage_filter_stream_simplified_set_part_size(self, self->priv->part_size);
+
     /* Unref underlying stream (if we have it) */
     if (self->priv->underlying_stream) {
         g_object_unref(self->priv->underlying_stream);
@@ -520,6 +1418,12 @@ static void mirage_filter_stream_finalize (GObject *gobject)
     /* Free info structure */
     mirage_filter_stream_info_free(&self->priv->info);
 
+    /* Free part cache slots */
+    g_free(self->priv->part_slots);
+
+    g_mutex_clear(&self->priv->decode_mutex);
+    g_cond_clear(&self->priv->decode_cond);
+
     /* Chain up to the parent class */
     return G_OBJECT_CLASS(mirage_filter_stream_parent_class)->finalize(gobject);
 }
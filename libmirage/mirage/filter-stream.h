@@ -89,6 +89,9 @@ struct _MirageFilterStream
  * @seek: seeks to a location within stream
  * @simplified_partial_read: reads a chunk of requested data from stream (part of simplified interface)
  * @simplified_partial_write: writes a chunk of requested data to stream (part of simplified interface)
+ * @simplified_decode_part: decodes a part of stream into provided buffer and returns its length, or -1 on failure (part of simplified interface)
+ * @simplified_read_raw_part: reads raw (encoded) data of a part from underlying stream, or returns %NULL if part cannot be read (part of simplified interface)
+ * @simplified_decode_raw_part: decodes raw data of a part into provided buffer and returns its length, or -1 on failure; may be called from worker threads (part of simplified interface)
  *
  * The class structure for the <structname>MirageFilterStream</structname> type.
  */
@@ -108,6 +111,9 @@ struct _MirageFilterStreamClass
     /* Simplified read/write interface */
     gssize (*simplified_partial_read) (MirageFilterStream *self, void *buffer, gsize count);
     gssize (*simplified_partial_write) (MirageFilterStream *self, const void *buffer, gsize count);
+    gssize (*simplified_decode_part) (MirageFilterStream *self, guint64 index, guint8 *buffer, gsize buffer_size);
+    GBytes *(*simplified_read_raw_part) (MirageFilterStream *self, guint64 index);
+    gssize (*simplified_decode_raw_part) (MirageFilterStream *self, guint64 index, GBytes *raw_data, guint8 *buffer, gsize buffer_size);
 };
 
 /* Used by MIRAGE_TYPE_FILTER_STREAM */
@@ -122,6 +128,11 @@ gboolean mirage_filter_stream_open (MirageFilterStream *self, MirageStream *stre
 
 void mirage_filter_stream_simplified_set_stream_length (MirageFilterStream *self, gsize length);
 goffset mirage_filter_stream_simplified_get_position (MirageFilterStream *self);
+void mirage_filter_stream_simplified_set_part_size (MirageFilterStream *self, gsize part_size);
+const guint8 *mirage_filter_stream_simplified_get_part (MirageFilterStream *self, guint64 index, gsize *length);
+
+GVariant *mirage_filter_stream_load_index (MirageFilterStream *self, const gchar *index_id, const GVariantType *index_type);
+void mirage_filter_stream_save_index (MirageFilterStream *self, const gchar *index_id, GVariant *index);
 
 
 G_END_DECLS
@@ -457,6 +457,119 @@ gboolean mirage_fragment_read_main_data (MirageFragment *self, gint address, gui
     return TRUE;
 }
 
+/**
+ * mirage_fragment_read_main_data_range:
+ * @self: a #MirageFragment
+ * @address: (in): address of first sector
+ * @num_sectors: (in): number of sectors to read
+ * @buffer: (out caller-allocates) (array): buffer to read data into
+ * @length: (out) (allow-none): location to store per-sector read data length, or %NULL
+ * @error: (out) (allow-none): location to store error, or %NULL
+ *
+ * Reads main channel data for @num_sectors consecutive sectors, starting
+ * at fragment-relative @address (given in sectors), into caller-provided
+ * @buffer. The buffer must be large enough to hold @num_sectors times
+ * main channel data sector size (see mirage_fragment_main_data_get_size()).
+ * Data of consecutive sectors is stored back-to-back; if main channel data
+ * is interleaved with internal subchannel data, the latter is skipped.
+ *
+ * Compared to calling mirage_fragment_read_main_data() for each sector,
+ * the whole range is read using a single seek and read on the underlying
+ * stream, and no memory is allocated for the data. Data that cannot be read
+ * (missing stream or truncated image) is zero-filled. The length stored
+ * in @length is the same as the one mirage_fragment_read_main_data() would
+ * return, i.e., 0 if fragment has no main channel data stream.
+ *
+ * Returns: %TRUE on success, %FALSE on failure
+ */
+gboolean mirage_fragment_read_main_data_range (MirageFragment *self, gint address, gint num_sectors, guint8 *buffer, gint *length, GError **error)
+{
+    gint size_full;
+    gsize range_length;
+    guint64 position;
+    gssize read_len;
+
+    if (length) {
+        *length = 0;
+    }
+
+    /* Validate range */
+    if (address < 0 || num_sectors < 0 || address + num_sectors > self->priv->length) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: sector range %d-%d is not within fragment!\n", __debug__, address, address + num_sectors - 1);
+        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_FRAGMENT_ERROR, Q_("Sector range %d-%d is not within fragment!"), address, address + num_sectors - 1);
+        return FALSE;
+    }
+
+    range_length = (gsize)num_sectors * self->priv->main_size;
+    if (!range_length) {
+        return TRUE;
+    }
+
+    /* We need a stream to read data from... but if it's missing, we
+       don't read anything and this is not considered an error */
+    if (!self->priv->main_stream) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_FRAGMENT, "%s: no main channel data input stream!\n", __debug__);
+        memset(buffer, 0, range_length);
+        return TRUE;
+    }
+
+    if (length) {
+        *length = self->priv->main_size;
+    }
+
+    size_full = self->priv->main_size;
+    if (self->priv->subchannel_format & MIRAGE_SUBCHANNEL_DATA_FORMAT_INTERNAL) {
+        size_full += self->priv->subchannel_size;
+    }
+
+    position = mirage_fragment_main_data_get_position(self, address);
+
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_FRAGMENT, "%s: reading %d sectors from position 0x%" G_GINT64_MODIFIER "X\n", __debug__, num_sectors, position);
+
+    /* Note: we ignore all errors here in order to be able to cope with truncated mini images */
+    mirage_stream_seek(self->priv->main_stream, position, G_SEEK_SET, NULL);
+
+    if (size_full == self->priv->main_size || num_sectors == 1) {
+        /* Sectors are stored back-to-back (or there is only one of them);
+           read directly into caller's buffer */
+        read_len = mirage_stream_read(self->priv->main_stream, buffer, range_length, NULL);
+        if (read_len < 0) {
+            read_len = 0;
+        }
+        if ((gsize)read_len < range_length) {
+            memset(buffer + read_len, 0, range_length - read_len);
+        }
+    } else {
+        /* Main channel data is interleaved with subchannel data; read the
+           whole span into temporary buffer and strip the subchannel */
+        gsize span_length = (gsize)num_sectors * size_full;
+        guint8 *span_buffer = g_try_malloc0(span_length);
+
+        if (!span_buffer) {
+            g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_FRAGMENT_ERROR, Q_("Failed to allocate memory!"));
+            return FALSE;
+        }
+
+        mirage_stream_read(self->priv->main_stream, span_buffer, span_length, NULL);
+
+        for (gint i = 0; i < num_sectors; i++) {
+            memcpy(buffer + (gsize)i * self->priv->main_size, span_buffer + (gsize)i * size_full, self->priv->main_size);
+        }
+
+        g_free(span_buffer);
+    }
+
+    /* Binary audio files may need to be swapped from BE to LE */
+    if (self->priv->main_format == MIRAGE_MAIN_DATA_FORMAT_AUDIO_SWAP) {
+        for (gsize i = 0; i < range_length; i+=2) {
+            guint16 *ptr = (guint16 *)&buffer[i];
+            *ptr = GUINT16_SWAP_LE_BE(*ptr);
+        }
+    }
+
+    return TRUE;
+}
+
 
 /**
  * mirage_fragment_write_main_data:
@@ -711,11 +824,9 @@ static guint64 mirage_fragment_subchannel_data_get_position (MirageFragment *sel
  *
  * Returns: %TRUE on success, %FALSE on failure
  */
-gboolean mirage_fragment_read_subchannel_data (MirageFragment *self, gint address, guint8 **buffer, gint *length, GError **error G_GNUC_UNUSED)
+gboolean mirage_fragment_read_subchannel_data (MirageFragment *self, gint address, guint8 **buffer, gint *length, GError **error)
 {
-    MirageStream *stream;
-    guint64 position;
-    gint read_len;
+    guint8 *data_buffer;
 
     /* Clear both variables */
     *length = 0;
@@ -723,12 +834,83 @@ gboolean mirage_fragment_read_subchannel_data (MirageFragment *self, gint addres
         *buffer = NULL;
     }
 
+    /* If we are not interested in data, do not bother reading it */
+    if (!buffer) {
+        gboolean has_stream;
+
+        if (self->priv->subchannel_format & MIRAGE_SUBCHANNEL_DATA_FORMAT_INTERNAL) {
+            has_stream = self->priv->main_stream != NULL;
+        } else {
+            has_stream = self->priv->subchannel_stream != NULL;
+        }
+
+        if (self->priv->subchannel_size && has_stream) {
+            *length = 96; /* Always 96, because we do the processing here */
+        }
+
+        return TRUE;
+    }
+
+    /* Data */
+    data_buffer = g_malloc0(96);
+    if (!mirage_fragment_read_subchannel_data_range(self, address, 1, data_buffer, length, error)) {
+        g_free(data_buffer);
+        return FALSE;
+    }
+
+    if (*length) {
+        *buffer = data_buffer;
+    } else {
+        g_free(data_buffer);
+    }
+
+    return TRUE;
+}
+
+/**
+ * mirage_fragment_read_subchannel_data_range:
+ * @self: a #MirageFragment
+ * @address: (in): address of first sector
+ * @num_sectors: (in): number of sectors to read
+ * @buffer: (out caller-allocates) (array): buffer to read data into
+ * @length: (out) (allow-none): location to store per-sector read data length, or %NULL
+ * @error: (out) (allow-none): location to store error, or %NULL
+ *
+ * Reads subchannel data for @num_sectors consecutive sectors, starting
+ * at fragment-relative @address (given in sectors), into caller-provided
+ * @buffer, which must be large enough to hold 96 bytes of data for each
+ * sector. Regardless of fragment's subchannel data format, the data is
+ * stored as 96-byte interleaved PW subchannel, same as with
+ * mirage_fragment_read_subchannel_data(); however, no memory is allocated
+ * for the data.
+ *
+ * If fragment has no subchannel data, @buffer is zero-filled and 0 is
+ * stored into @length; otherwise, 96 is stored.
+ *
+ * Returns: %TRUE on success, %FALSE on failure
+ */
+gboolean mirage_fragment_read_subchannel_data_range (MirageFragment *self, gint address, gint num_sectors, guint8 *buffer, gint *length, GError **error)
+{
+    MirageStream *stream;
+    guint8 raw_buffer[96];
+
+    if (length) {
+        *length = 0;
+    }
+
+    memset(buffer, 0, (gsize)num_sectors * 96);
+
     /* If there's no subchannel, return 0 for the length */
     if (!self->priv->subchannel_size) {
         MIRAGE_DEBUG(self, MIRAGE_DEBUG_FRAGMENT, "%s: no subchannel (size = 0)!\n", __debug__);
         return TRUE;
     }
 
+    if (self->priv->subchannel_size > (gint)sizeof(raw_buffer)) {
+        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_FRAGMENT_ERROR, Q_("Unsupported subchannel data size %d!"), self->priv->subchannel_size);
+        return FALSE;
+    }
+
     /* We need a stream to read data from... but if it's missing, we
        don't read anything and this is not considered an error */
     if (self->priv->subchannel_format & MIRAGE_SUBCHANNEL_DATA_FORMAT_INTERNAL) {
@@ -744,39 +926,32 @@ gboolean mirage_fragment_read_subchannel_data (MirageFragment *self, gint addres
         return TRUE;
     }
 
-
-    /* Determine position within file */
-    position = mirage_fragment_subchannel_data_get_position(self, address);
-
-
     /* Length */
-    *length = 96; /* Always 96, because we do the processing here */
+    if (length) {
+        *length = 96; /* Always 96, because we do the processing here */
+    }
 
-    /* Data */
-    if (buffer) {
-        guint8 *data_buffer = g_malloc0(96);
-        guint8 *raw_buffer = g_malloc0(self->priv->subchannel_size);
+    for (gint i = 0; i < num_sectors; i++) {
+        guint8 *data_buffer = buffer + (gsize)i * 96;
+
+        /* Determine position within file */
+        guint64 position = mirage_fragment_subchannel_data_get_position(self, address + i);
 
         MIRAGE_DEBUG(self, MIRAGE_DEBUG_FRAGMENT, "%s: reading from position 0x%" G_GINT64_MODIFIER "X\n", __debug__, position);
+
         /* We read into temporary buffer, because we might need to perform some
            magic on the data */
+        memset(raw_buffer, 0, sizeof(raw_buffer));
         mirage_stream_seek(stream, position, G_SEEK_SET, NULL);
-        read_len = mirage_stream_read(stream, raw_buffer, self->priv->subchannel_size, NULL);
-
-        if (read_len != self->priv->subchannel_size) {
-            /*mirage_error(MIRAGE_E_READFAILED, error);
-            g_free(raw_buffer);
-            g_free(data_buffer);
-            return FALSE;*/
-        }
+        mirage_stream_read(stream, raw_buffer, self->priv->subchannel_size, NULL);
 
         /* If we happen to deal with anything that's not RAW 96-byte interleaved PW,
            we transform it into that here... less fuss for upper level stuff this way */
         if (self->priv->subchannel_format & MIRAGE_SUBCHANNEL_DATA_FORMAT_PW96_LINEAR) {
             /* 96-byte deinterleaved PW; grab each subchannel and interleave it
                into destination buffer */
-            for (gint i = 0; i < 8; i++) {
-                mirage_helper_subchannel_interleave(7 - i, raw_buffer + i*12, data_buffer);
+            for (gint j = 0; j < 8; j++) {
+                mirage_helper_subchannel_interleave(7 - j, raw_buffer + j*12, data_buffer);
             }
         } else if (self->priv->subchannel_format & MIRAGE_SUBCHANNEL_DATA_FORMAT_PW96_INTERLEAVED) {
             /* 96-byte interleaved PW; just copy it */
@@ -785,10 +960,6 @@ gboolean mirage_fragment_read_subchannel_data (MirageFragment *self, gint addres
             /* 16-byte Q; interleave it and pretend everything else's 0 */
             mirage_helper_subchannel_interleave(SUBCHANNEL_Q, raw_buffer, data_buffer);
         }
-
-        g_free(raw_buffer);
-
-        *buffer = data_buffer;
     }
 
     return TRUE;
@@ -127,6 +127,7 @@ void mirage_fragment_main_data_set_format (MirageFragment *self, gint format);
 gint mirage_fragment_main_data_get_format (MirageFragment *self);
 
 gboolean mirage_fragment_read_main_data (MirageFragment *self, gint address, guint8 **buffer, gint *length, GError **error);
+gboolean mirage_fragment_read_main_data_range (MirageFragment *self, gint address, gint num_sectors, guint8 *buffer, gint *length, GError **error);
 gboolean mirage_fragment_write_main_data (MirageFragment *self, gint address, const guint8 *buffer, gint length, GError **error);
 
 /* Subchannel */
@@ -140,6 +141,7 @@ void mirage_fragment_subchannel_data_set_format (MirageFragment *self, gint form
 gint mirage_fragment_subchannel_data_get_format (MirageFragment *self);
 
 gboolean mirage_fragment_read_subchannel_data (MirageFragment *self, gint address, guint8 **buffer, gint *length, GError **error);
+gboolean mirage_fragment_read_subchannel_data_range (MirageFragment *self, gint address, gint num_sectors, guint8 *buffer, gint *length, GError **error);
 gboolean mirage_fragment_write_subchannel_data (MirageFragment *self, gint address, const guint8 *buffer, gint length, GError **error);
 
 gboolean mirage_fragment_is_writable (MirageFragment *self);
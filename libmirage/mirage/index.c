@@ -27,6 +27,9 @@
  * #MirageIndex object represents an index within a track. It is a
  * container object that stores the index number and corresponding
  * address.
+ *
+ * When index' address is changed, #MirageIndex::layout-changed signal is
+ * emitted, which allows the parent #MirageTrack to rearrange its indices.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -88,8 +91,15 @@ gint mirage_index_get_number (MirageIndex *self)
  */
 void mirage_index_set_address (MirageIndex *self, gint address)
 {
+    if (self->priv->address == address) {
+        return;
+    }
+
     /* Set address */
     self->priv->address = address;
+
+    /* Signal index change */
+    g_signal_emit_by_name(self, "layout-changed", NULL);
 }
 
 /**
@@ -121,6 +131,14 @@ static void mirage_index_init (MirageIndex *self)
     self->priv->address = 0;
 }
 
-static void mirage_index_class_init (MirageIndexClass *klass G_GNUC_UNUSED)
+static void mirage_index_class_init (MirageIndexClass *klass)
 {
+    /* Signals */
+    /**
+     * MirageIndex::layout-changed:
+     * @index: a #MirageIndex
+     *
+     * Emitted when address of #MirageIndex is changed.
+     */
+    g_signal_new("layout-changed", G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_LAST, 0, NULL, NULL, g_cclosure_marshal_VOID__VOID, G_TYPE_NONE, 0, NULL);
 }
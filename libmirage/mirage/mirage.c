@@ -197,12 +197,21 @@ gboolean mirage_initialize (GError **error)
         return FALSE;
     }
 
+    /* Select the fastest EDC/ECC implementation supported by the CPU */
+    mirage_helper_sector_edc_ecc_set_implementation(NULL, NULL);
+
     /* Allocate LUT for ECMA-130 sector scrambler */
     ecma_130_scrambler_lut = mirage_helper_init_ecma_130b_scrambler_lut();
     if (!ecma_130_scrambler_lut) {
         return FALSE;
     }
 
+    /* Allocate LUT for subchannel interleaving */
+    subchannel_spread_lut = mirage_helper_init_subchannel_spread_lut();
+    if (!subchannel_spread_lut) {
+        return FALSE;
+    }
+
     /* We're officially initialized now */
     libmirage.initialized = TRUE;
 
@@ -259,6 +268,10 @@ gboolean mirage_shutdown (GError **error)
     g_free(ecma_130_scrambler_lut);
     ecma_130_scrambler_lut = NULL;
 
+    /* Free subchannel interleaving LUT */
+    g_free(subchannel_spread_lut);
+    subchannel_spread_lut = NULL;
+
     /* We're not initialized anymore */
     libmirage.initialized = FALSE;
 
@@ -756,13 +756,15 @@ static void mirage_sector_generate_subheader (MirageSector *self)
     switch (self->priv->type) {
         case MIRAGE_SECTOR_MODE2_FORM1: {
             guint8 *subheader = self->priv->sector_data+16;
-            subheader[2] |= (0 << 5); /* Form 1 */
+            memset(subheader, 0, 8);
+            subheader[2] = (0 << 5); /* Form 1 */
             subheader[5] = subheader[2];
             break;
         }
         case MIRAGE_SECTOR_MODE2_FORM2: {
             guint8 *subheader = self->priv->sector_data+16;
-            subheader[2] |= (1 << 5); /* Form 2 */
+            memset(subheader, 0, 8);
+            subheader[2] = (1 << 5); /* Form 2 */
             subheader[5] = subheader[2];
             break;
         }
@@ -807,6 +809,9 @@ static void mirage_sector_generate_edc_ecc (MirageSector *self)
                 mirage_sector_generate_header(self);
             }
 
+            /* Clear intermediate field, which is covered by ECC */
+            memset(self->priv->sector_data+0x814, 0, 8);
+
             /* Generate EDC */
             mirage_helper_sector_edc_ecc_compute_edc_block(self->priv->sector_data+0x00, 0x810, self->priv->sector_data+0x810);
             /* Generate ECC P/Q codes */
@@ -880,6 +885,16 @@ gboolean mirage_sector_feed_data (MirageSector *self, gint address, MirageSector
     /* Reset data validity flags */
     self->priv->real_data = self->priv->valid_data = 0;
 
+    /* Clear the buffers; sector objects may be reused (see
+       mirage_disc_acquire_sector()), and generators expect the parts of
+       data that they do not write to be zero. Raw main channel data is
+       copied over the whole buffer below, so there is no need to clear it */
+    if (type != MIRAGE_SECTOR_RAW && type != MIRAGE_SECTOR_RAW_SCRAMBLED) {
+        memset(self->priv->sector_data, 0, sizeof(self->priv->sector_data));
+    }
+    memset(self->priv->subchan_pw, 0, sizeof(self->priv->subchan_pw));
+    memset(self->priv->subchan_q, 0, sizeof(self->priv->subchan_q));
+
     /* Store address and sector type */
     self->priv->address = address;
     self->priv->type = type;
@@ -1432,6 +1447,62 @@ gboolean mirage_sector_set_edc_ecc (MirageSector *self, const guint8 *buf, gint
     return TRUE;
 }
 
+/**
+ * mirage_sector_get_main_data:
+ * @self: a #MirageSector
+ * @parts: (in): main channel parts that need to be valid; a combination of #MirageSectorValidData flags
+ * @ret_buf: (out) (transfer none) (allow-none) (array length=ret_len): location to store pointer to buffer containing main channel data, or %NULL
+ * @ret_len: (out) (allow-none): location to store length of main channel data, or %NULL. Length is given in bytes.
+ * @error: (out) (allow-none): location to store error, or %NULL
+ *
+ * Retrieves sector's main channel data, in its raw, 2352-byte layout. The
+ * pointer to sector's data buffer is stored into @ret_buf; therefore, the
+ * buffer should not be modified.
+ *
+ * Of the parts that make up main channel data, only those specified by @parts
+ * are guaranteed to be valid; if they are not provided by image file(s), they
+ * are generated. Parts that are not applicable to sector's type are ignored.
+ * This allows caller to extract several parts of sector's data from a single
+ * buffer, instead of retrieving them one by one using mirage_sector_get_sync(),
+ * mirage_sector_get_header(), mirage_sector_get_subheader(),
+ * mirage_sector_get_data() and mirage_sector_get_edc_ecc(), while avoiding
+ * generation of parts that it does not need.
+ *
+ * Returns: %TRUE on success, %FALSE on failure
+ */
+gboolean mirage_sector_get_main_data (MirageSector *self, gint parts, const guint8 **ret_buf, gint *ret_len, GError **error G_GNUC_UNUSED)
+{
+    /* Generate the requested parts that are not provided; generation
+       routines take care of incompatible sector types */
+    gint need_to_generate = parts & ~self->priv->valid_data;
+
+    if (need_to_generate & MIRAGE_VALID_SYNC) {
+        mirage_sector_generate_sync(self);
+    }
+    if (need_to_generate & MIRAGE_VALID_HEADER) {
+        mirage_sector_generate_header(self);
+    }
+    if (need_to_generate & MIRAGE_VALID_SUBHEADER) {
+        mirage_sector_generate_subheader(self);
+    }
+    if (need_to_generate & MIRAGE_VALID_DATA) {
+        mirage_sector_generate_data(self);
+    }
+    if (need_to_generate & MIRAGE_VALID_EDC_ECC) {
+        mirage_sector_generate_edc_ecc(self);
+    }
+
+    /* Return the whole buffer */
+    if (ret_buf) {
+        *ret_buf = self->priv->sector_data;
+    }
+    if (ret_len) {
+        *ret_len = sizeof(self->priv->sector_data);
+    }
+
+    return TRUE;
+}
+
 /**
  * mirage_sector_get_subchannel:
  * @self: a #MirageSector
@@ -1450,8 +1521,8 @@ gboolean mirage_sector_set_edc_ecc (MirageSector *self, const guint8 *buf, gint
  */
 gboolean mirage_sector_get_subchannel (MirageSector *self, MirageSectorSubchannelFormat format, const guint8 **ret_buf, gint *ret_len, GError **error)
 {
-    /* Generate subchannel if it's not provided */
-    if (!(self->priv->valid_data & MIRAGE_VALID_SUBCHAN)) {
+    /* Generate subchannel if it's not provided (and actually requested) */
+    if (format != MIRAGE_SUBCHANNEL_NONE && !(self->priv->valid_data & MIRAGE_VALID_SUBCHAN)) {
         mirage_sector_generate_subchannel(self);
     }
 
@@ -1709,220 +1780,23 @@ static void mirage_sector_class_init (MirageSectorClass *klass G_GNUC_UNUSED)
 /**********************************************************************\
  *                        Subchannel generation                       *
 \**********************************************************************/
-static gint subchannel_generate_p (MirageSector *self, guint8 *buf)
-{
-    MirageTrack *track;
-    gint track_start;
-    gint relative_address;
-
-    /* Get sector's parent track */
-    track = mirage_object_get_parent(MIRAGE_OBJECT(self));
-    if (!track) {
-        MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to get sector's parent!\n", __debug__);
-        return 12;
-    }
-
-    relative_address = self->priv->address - mirage_track_layout_get_start_sector(track);
-    track_start = mirage_track_get_track_start(track);
-
-    /* P subchannel being 0xFF indicates we're in the pregap */
-    if (relative_address < track_start) {
-        memset(buf, 0xFF, 12);
-    } else {
-        memset(buf, 0, 12);
-    }
-
-    /* Release sector's parent track */
-    g_object_unref(track);
-
-    return 12;
-}
-
-static gint subchannel_generate_q (MirageSector *self, guint8 *buf)
+static void mirage_sector_generate_subchannel (MirageSector *self)
 {
     MirageTrack *track;
 
-    gint mode_switch;
-    gint relative_address, absolute_address;
-    guint16 crc;
+    /* Generate subchannel: only P/Q can be generated at the moment
+       (other subchannels are set to 0) */
 
-    /* Get sector's parent track */
+    /* Get sector's parent track; subchannel is generated from its properties */
     track = mirage_object_get_parent(MIRAGE_OBJECT(self));
     if (!track) {
         MIRAGE_DEBUG(self, MIRAGE_DEBUG_WARNING, "%s: failed to get sector's parent!\n", __debug__);
-        return 12;
-    }
-
-    absolute_address = self->priv->address;
-    relative_address = self->priv->address - mirage_track_layout_get_start_sector(track);
-
-    /* We support Mode-1, Mode-2 and Mode-3 Q; according to INF8090 and MMC-3,
-       "if used, they shall exist in at least one out of 100 consecutive sectors".
-       So we put MCN in every 25th sector and ISRC in every 50th sector */
-
-    /* Track number, index, absolute and relative track adresses are converted
-       from HEX to BCD */
-
-    switch (relative_address % 100) {
-        case 25: {
-            /* MCN is to be returned; check if we actually have it */
-            MirageSession *session;
-
-            session = mirage_object_get_parent(MIRAGE_OBJECT(track));
-
-            if (!mirage_session_get_mcn(session)) {
-                mode_switch = 0x01;
-            } else {
-                mode_switch = 0x02;
-            }
-
-            g_object_unref(session);
-
-            break;
-        }
-        case 50: {
-            /* ISRC is to be returned; verify that this is an audio track and
-               that it actually has ISRC set */
-            gint mode = mirage_sector_get_sector_type(self);
-
-            if (mode != MIRAGE_SECTOR_AUDIO) {
-                mode_switch = 0x01;
-            } else if (!mirage_track_get_isrc(track)) {
-                mode_switch = 0x01;
-            } else {
-                mode_switch = 0x03;
-            }
-
-            break;
-        }
-        default: {
-            /* Current position */
-            mode_switch = 1;
-            break;
-        }
-    }
-
-    switch (mode_switch) {
-        case 0x01: {
-            /* Mode-1: Current position */
-            gint ctl, track_number;
-            gint track_start;
-            MirageIndex *index;
-
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_SECTOR, "%s: generating Mode-1 Q: Position\n", __debug__);
-
-            ctl = mirage_track_get_ctl(track);
-            track_number = mirage_track_layout_get_track_number(track);
-
-            track_start = mirage_track_get_track_start(track);
-
-            buf[0] = (ctl << 0x04) | 0x01; /* Mode-1 Q */
-            buf[1] = mirage_helper_hex2bcd(track_number); /* Track number */
-
-            /* Index: try getting index object by address; if it's not found, we
-               check if sector lies before track start... */
-            index = mirage_track_get_index_by_address(track, relative_address, NULL);
-            if (index) {
-                gint index_number = mirage_index_get_number(index);
-                MIRAGE_DEBUG(self, MIRAGE_DEBUG_SECTOR, "%s: relative address 0x%X belongs to index with number: %d\n", __debug__, relative_address, index_number);
-                buf[2] = index_number;
-                g_object_unref(index);
-            } else {
-                /* No index... check if address is in a pregap (strictly less than track start) */
-                if (relative_address < track_start) {
-                    MIRAGE_DEBUG(self, MIRAGE_DEBUG_SECTOR, "%s: relative address 0x%X is part of a pregap\n", __debug__, relative_address);
-                    buf[2] = 0;
-                } else {
-                    MIRAGE_DEBUG(self, MIRAGE_DEBUG_SECTOR, "%s: relative address 0x%X belongs to index 1\n", __debug__, relative_address);
-                    buf[2] = 1;
-                }
-            }
-            buf[2] = mirage_helper_hex2bcd(buf[2]);
-
-            /* Relative M/S/F; when converting, we do not add 2 seconds */
-            mirage_helper_lba2msf(ABS(relative_address - track_start), FALSE, &buf[3], &buf[4], &buf[5]);
-            buf[3] = mirage_helper_hex2bcd(buf[3]);
-            buf[4] = mirage_helper_hex2bcd(buf[4]);
-            buf[5] = mirage_helper_hex2bcd(buf[5]);
-            buf[6] = 0; /* Zero */
-            /* Absolute M/S/F */
-            mirage_helper_lba2msf(absolute_address, TRUE, &buf[7], &buf[8], &buf[9]);
-            buf[7] = mirage_helper_hex2bcd(buf[7]);
-            buf[8] = mirage_helper_hex2bcd(buf[8]);
-            buf[9] = mirage_helper_hex2bcd(buf[9]);
-            break;
-        }
-        case 0x02: {
-            /* Mode-2: MCN */
-            gint ctl;
-
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_SECTOR, "%s: generating Mode-2 Q: MCN\n", __debug__);
-
-            ctl = mirage_track_get_ctl(track);
-            buf[0] = (ctl << 0x04) | 0x02; /* Mode-2 Q */
-
-            /* MCN */
-            MirageSession *session;
-
-            const gchar *mcn;
-
-            session = mirage_object_get_parent(MIRAGE_OBJECT(track));
-
-            mcn = mirage_session_get_mcn(session);
-
-            g_object_unref(session);
-
-            mirage_helper_subchannel_q_encode_mcn(&buf[1], mcn);
-            buf[8] = 0; /* zero */
-            /* AFRAME */
-            mirage_helper_lba2msf(absolute_address, TRUE, NULL, NULL, &buf[9]);
-            buf[9] = mirage_helper_hex2bcd(buf[9]);
-            break;
-        }
-        case 0x03: {
-            /* Mode-3: ISRC */
-            gint ctl;
-
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_SECTOR, "%s: generating Mode-3 Q: ISRC\n", __debug__);
-
-            ctl = mirage_track_get_ctl(track);
-            buf[0] = (ctl << 0x04) | 0x03; /* Mode-3 Q */
-
-            /* ISRC*/
-            const gchar *isrc = mirage_track_get_isrc(track);
-            mirage_helper_subchannel_q_encode_isrc(&buf[1], isrc);
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_SECTOR, "%s: ISRC string: %s bytes: %02X %02X %02X %02X %02X %02X %02X %02X\n", __debug__, isrc, buf[1], buf[2], buf[3], buf[4], buf[5], buf[6], buf[7], buf[8]);
-            /* AFRAME */
-            mirage_helper_lba2msf(absolute_address, TRUE, NULL, NULL, &buf[9]);
-            buf[9] = mirage_helper_hex2bcd(buf[9]);
-            break;
-        }
+        memset(self->priv->subchan_pw, 0, sizeof(self->priv->subchan_pw));
+        return;
     }
 
-    /* CRC */
-    crc = mirage_helper_subchannel_q_calculate_crc(&buf[0]);
-    buf[10] = (crc & 0xFF00) >> 0x08;
-    buf[11] = (crc & 0x00FF) >> 0x00;
+    mirage_track_generate_subchannel(track, self->priv->address, TRUE, 1, MIRAGE_SUBCHANNEL_PW, self->priv->subchan_pw, NULL);
 
     /* Release sector's parent track */
     g_object_unref(track);
-
-    return 12;
-}
-
-static void mirage_sector_generate_subchannel (MirageSector *self)
-{
-    guint8 tmp_buf[12];
-
-    /* Generate subchannel: only P/Q can be generated at the moment
-       (other subchannels are set to 0) */
-
-    memset(self->priv->subchan_pw, 0, sizeof(self->priv->subchan_pw));
-
-    /* Read P subchannel into temporary buffer, then interleave it */
-    subchannel_generate_p(self, tmp_buf);
-    mirage_helper_subchannel_interleave(SUBCHANNEL_P, tmp_buf, self->priv->subchan_pw);
-    /* Read Q subchannel into temporary buffer, then interleave it */
-    subchannel_generate_q(self, tmp_buf);
-    mirage_helper_subchannel_interleave(SUBCHANNEL_Q, tmp_buf, self->priv->subchan_pw);
 }
@@ -128,6 +128,8 @@ gboolean mirage_sector_set_data (MirageSector *self, const guint8 *buf, gint len
 gboolean mirage_sector_get_edc_ecc (MirageSector *self, const guint8 **ret_buf, gint *ret_len, GError **error);
 gboolean mirage_sector_set_edc_ecc (MirageSector *self, const guint8 *buf, gint len, GError **error);
 
+gboolean mirage_sector_get_main_data (MirageSector *self, gint parts, const guint8 **ret_buf, gint *ret_len, GError **error);
+
 gboolean mirage_sector_get_subchannel (MirageSector *self, MirageSectorSubchannelFormat format, const guint8 **ret_buf, gint *ret_len, GError **error);
 gboolean mirage_sector_set_subchannel (MirageSector *self, MirageSectorSubchannelFormat format, const guint8 *buf, gint len, GError **error);
 
@@ -913,6 +913,60 @@ MirageTrack *mirage_session_get_track_by_address (MirageSession *self, gint addr
     return g_object_ref(track);
 }
 
+/**
+ * mirage_session_read_sectors:
+ * @self: a #MirageSession
+ * @address: (in): address of first sector
+ * @num_sectors: (in): number of sectors to read
+ * @data_length: (in): expected length of sectors' user data
+ * @buffer: (out caller-allocates) (array): buffer to read user data into
+ * @error: (out) (allow-none): location to store error, or %NULL
+ *
+ * Reads user data of up to @num_sectors consecutive sectors, starting at
+ * disc-relative @address, into caller-provided @buffer, which must be large
+ * enough to hold @num_sectors times @data_length bytes.
+ *
+ * The read may span multiple tracks; the range is split at track boundaries
+ * and each part is read using mirage_track_read_sectors(). Reading stops
+ * at the end of the session or at the first sector whose user data length
+ * does not match @data_length.
+ *
+ * Returns: number of read sectors on success, -1 on failure
+ */
+gint mirage_session_read_sectors (MirageSession *self, gint address, gint num_sectors, gint data_length, guint8 *buffer, GError **error)
+{
+    gint num_read = 0;
+
+    while (num_read < num_sectors) {
+        MirageTrack *track;
+        gint track_count, track_read;
+
+        /* Fetch the right track; failure to do so is an error only for the
+           first sector of the range */
+        track = mirage_session_get_track_by_address(self, address + num_read, num_read ? NULL : error);
+        if (!track) {
+            return num_read ? num_read : -1;
+        }
+
+        track_count = MIN(num_sectors - num_read, mirage_track_layout_get_start_sector(track) + mirage_track_layout_get_length(track) - (address + num_read));
+        track_read = mirage_track_read_sectors(track, address + num_read, TRUE, track_count, data_length, buffer + (gsize)num_read * data_length, error);
+
+        g_object_unref(track);
+
+        if (track_read < 0) {
+            return -1;
+        }
+
+        num_read += track_read;
+
+        if (track_read < track_count) {
+            break;
+        }
+    }
+
+    return num_read;
+}
+
 /**
  * mirage_session_enumerate_tracks:
  * @self: a #MirageSession
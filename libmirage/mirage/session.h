@@ -153,6 +153,7 @@ void mirage_session_remove_track_by_object (MirageSession *self, MirageTrack *tr
 MirageTrack *mirage_session_get_track_by_index (MirageSession *self, gint index, GError **error);
 MirageTrack *mirage_session_get_track_by_number (MirageSession *self, gint number, GError **error);
 MirageTrack *mirage_session_get_track_by_address (MirageSession *self, gint address, GError **error);
+gint mirage_session_read_sectors (MirageSession *self, gint address, gint num_sectors, gint data_length, guint8 *buffer, GError **error);
 gboolean mirage_session_enumerate_tracks (MirageSession *self, MirageEnumTrackCallback func, gpointer user_data);
 MirageTrack *mirage_session_get_track_before (MirageSession *self, MirageTrack *track, GError **error);
 MirageTrack *mirage_session_get_track_after (MirageSession *self, MirageTrack *track, GError **error);
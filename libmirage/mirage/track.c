@@ -63,18 +63,30 @@ struct _MirageTrackPrivate
 
     /* List of index changes (indexes > 1) */
     GList *indices_list;
+    GArray *indices_table; /* Index boundaries, for per-sector lookup */
 
     /* List of data fragments */
     GList *fragments_list;
+    GPtrArray *fragments_index; /* Fragments in layout order, for address lookup */
 
     /* CD-Text list */
     GList *languages_list;
+
+    /* Batched layout update */
+    gint layout_update_depth; /* Nesting depth of layout updates */
+    gboolean layout_update_pending; /* Have sectors been appended within layout update? */
 };
 
 
 /**********************************************************************\
  *                          Private functions                         *
 \**********************************************************************/
+typedef struct
+{
+    gint address;
+    gint number;
+} MirageTrackIndexBoundary;
+
 static gchar *mirage_track_scan_for_isrc (MirageTrack *self)
 {
     MirageFragment *fragment = mirage_track_find_fragment_with_subchannel(self, NULL);
@@ -130,6 +142,84 @@ static gchar *mirage_track_scan_for_isrc (MirageTrack *self)
 }
 
 
+static gboolean mirage_track_get_user_data_layout (MirageSectorType sector_type, gint main_size, gint *data_offset, gint *data_length)
+{
+    /* Determines offset and length of user data within main channel data
+       of given size, for the layouts that can be sliced without having to
+       construct sector object. Mode 2 Mixed and raw sectors need to have
+       their type determined from the data, so they are not handled here */
+    switch (sector_type) {
+        case MIRAGE_SECTOR_AUDIO: {
+            *data_length = 2352;
+            switch (main_size) {
+                case 0: *data_offset = 0; return TRUE;
+                case 2352: *data_offset = 0; return TRUE;
+            }
+            break;
+        }
+        case MIRAGE_SECTOR_MODE1: {
+            *data_length = 2048;
+            switch (main_size) {
+                case 0: *data_offset = 0; return TRUE;
+                case 2048: *data_offset = 0; return TRUE;
+                case 2352: *data_offset = 16; return TRUE;
+            }
+            break;
+        }
+        case MIRAGE_SECTOR_MODE2: {
+            *data_length = 2336;
+            switch (main_size) {
+                case 0: *data_offset = 0; return TRUE;
+                case 2336: *data_offset = 0; return TRUE;
+                case 2352: *data_offset = 16; return TRUE;
+            }
+            break;
+        }
+        case MIRAGE_SECTOR_MODE2_FORM1: {
+            *data_length = 2048;
+            switch (main_size) {
+                case 0: *data_offset = 0; return TRUE;
+                case 2048: *data_offset = 0; return TRUE;
+                case 2336: *data_offset = 8; return TRUE;
+                case 2352: *data_offset = 24; return TRUE;
+            }
+            break;
+        }
+        case MIRAGE_SECTOR_MODE2_FORM2: {
+            *data_length = 2324;
+            switch (main_size) {
+                case 0: *data_offset = 0; return TRUE;
+                case 2324: *data_offset = 0; return TRUE;
+                case 2336: *data_offset = 12; return TRUE;
+                case 2352: *data_offset = 24; return TRUE;
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+
+    return FALSE;
+}
+
+static void mirage_track_rebuild_indices_table (MirageTrack *self)
+{
+    /* Compact copy of indices' addresses and numbers, in list (i.e.,
+       address) order */
+    g_array_set_size(self->priv->indices_table, 0);
+
+    for (GList *entry = self->priv->indices_list; entry; entry = entry->next) {
+        MirageIndex *index = entry->data;
+        MirageTrackIndexBoundary boundary;
+
+        boundary.address = mirage_index_get_address(index);
+        boundary.number = mirage_index_get_number(index);
+
+        g_array_append_val(self->priv->indices_table, boundary);
+    }
+}
+
 static void mirage_track_rearrange_indices (MirageTrack *self)
 {
     /* Rearrange indices: set their numbers */
@@ -161,16 +251,47 @@ static void mirage_track_commit_topdown_change (MirageTrack *self)
     /* No need to rearrange indices, because they don't have anything to do with
        the global layout */
 
-    /* Rearrange fragments: set start sectors */
+    /* Rearrange fragments: set start sectors, and rebuild the index */
     gint cur_fragment_address = 0;
 
+    g_ptr_array_set_size(self->priv->fragments_index, 0);
+
     for (GList *entry = self->priv->fragments_list; entry; entry = entry->next) {
         MirageFragment *fragment = entry->data;
 
         /* Set fragment's start address */
         mirage_fragment_set_address(fragment, cur_fragment_address);
         cur_fragment_address += mirage_fragment_get_length(fragment);
+
+        g_ptr_array_add(self->priv->fragments_index, fragment);
+    }
+}
+
+static MirageFragment *mirage_track_find_fragment (MirageTrack *self, gint address)
+{
+    /* Binary search over fragments index; fragments are laid out back to
+       back, so their addresses are sorted. Fragments' current addresses
+       and lengths are used, which keeps the lookup valid even if the last
+       fragment has been extended without the layout change being committed
+       yet. Returned fragment is not referenced */
+    guint lo = 0;
+    guint hi = self->priv->fragments_index->len;
+
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+        MirageFragment *fragment = g_ptr_array_index(self->priv->fragments_index, mid);
+        gint fragment_address = mirage_fragment_get_address(fragment);
+
+        if (address < fragment_address) {
+            hi = mid;
+        } else if (address >= fragment_address + mirage_fragment_get_length(fragment)) {
+            lo = mid + 1;
+        } else {
+            return fragment;
+        }
     }
+
+    return NULL;
 }
 
 static void mirage_track_commit_bottomup_change (MirageTrack *self)
@@ -227,14 +348,41 @@ static void mirage_track_remove_fragment (MirageTrack *self, MirageFragment *fra
     mirage_track_commit_bottomup_change(self);
 }
 
+static gint sort_indices_by_address (MirageIndex *index1, MirageIndex *index2)
+{
+    gint address1 = mirage_index_get_address(index1);
+    gint address2 = mirage_index_get_address(index2);
+
+    if (address1 < address2) {
+        return -1;
+    } else if (address1 > address2) {
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+static void mirage_track_index_layout_changed_handler (MirageTrack *self, MirageIndex *index G_GNUC_UNUSED)
+{
+    /* Index' address changed; restore address order of indices, and
+       rearrange them. Note that indices do *not* trigger a bottom-up change */
+    self->priv->indices_list = g_list_sort(self->priv->indices_list, (GCompareFunc)sort_indices_by_address);
+    mirage_track_rearrange_indices(self);
+    mirage_track_rebuild_indices_table(self);
+}
+
 static void mirage_track_remove_index (MirageTrack *self, MirageIndex *index)
 {
+    /* Disconnect signal handler (find it by handler function and user data) */
+    g_signal_handlers_disconnect_by_func(index, mirage_track_index_layout_changed_handler, self);
+
     /* Remove it from list and unref it */
     self->priv->indices_list = g_list_remove(self->priv->indices_list, index);
     g_object_unref(index);
 
     /* Rearrange indices; note that indices do *not* trigger a bottom-up change */
     mirage_track_rearrange_indices(self);
+    mirage_track_rebuild_indices_table(self);
 }
 
 static void mirage_track_remove_language (MirageTrack *self, MirageLanguage *language)
@@ -245,20 +393,6 @@ static void mirage_track_remove_language (MirageTrack *self, MirageLanguage *lan
 }
 
 
-static gint sort_indices_by_address (MirageIndex *index1, MirageIndex *index2)
-{
-    gint address1 = mirage_index_get_address(index1);
-    gint address2 = mirage_index_get_address(index2);
-
-    if (address1 < address2) {
-        return -1;
-    } else if (address1 > address2) {
-        return 1;
-    } else {
-        return 0;
-    }
-}
-
 static gint sort_languages_by_code (MirageLanguage *language1, MirageLanguage *language2)
 {
     gint code1 = mirage_language_get_code(language1);
@@ -274,6 +408,124 @@ static gint sort_languages_by_code (MirageLanguage *language1, MirageLanguage *l
 }
 
 
+/* Track properties that go into generated Q subchannel; they are looked
+   up once per subchannel generation request, MCN and ISRC only when
+   first needed */
+typedef struct
+{
+    gint start_sector; /* Disc-absolute address of track's first sector */
+    gint track_start; /* Track-relative address of index 01 */
+    guint8 ctl; /* CTL nibble */
+    guint8 track_number; /* BCD-encoded track number */
+
+    gboolean mcn_retrieved;
+    const gchar *mcn;
+    gboolean isrc_retrieved;
+    const gchar *isrc;
+} MirageTrackSubchannelInfo;
+
+static inline guint8 mirage_track_subchannel_bcd (gint value)
+{
+    /* Same as mirage_helper_hex2bcd() */
+    return (value >= 0 && value <= 99) ? ((value / 10) << 4) | (value % 10) : value;
+}
+
+static void mirage_track_subchannel_encode_msf (gint address, gboolean diff, guint8 *buf)
+{
+    mirage_helper_lba2msf(address, diff, &buf[0], &buf[1], &buf[2]);
+    buf[0] = mirage_track_subchannel_bcd(buf[0]);
+    buf[1] = mirage_track_subchannel_bcd(buf[1]);
+    buf[2] = mirage_track_subchannel_bcd(buf[2]);
+}
+
+static void mirage_track_generate_subchannel_q (MirageTrack *self, MirageTrackSubchannelInfo *info, gint relative_address, gint index_number, guint8 *buf)
+{
+    gint absolute_address = info->start_sector + relative_address;
+    gint mode_switch = 0x01;
+    guint16 crc;
+
+    /* We support Mode-1, Mode-2 and Mode-3 Q; according to INF8090 and MMC-3,
+       "if used, they shall exist in at least one out of 100 consecutive sectors".
+       So we put MCN in every 25th sector and ISRC in every 50th sector */
+    switch (relative_address % 100) {
+        case 25: {
+            /* MCN is to be returned; check if we actually have it. Note
+               that if MCN is provided by subchannel data, the first retrieval
+               scans the subchannel of session's first track; the result is
+               then cached by the session */
+            if (!info->mcn_retrieved) {
+                MirageSession *session = mirage_object_get_parent(MIRAGE_OBJECT(self));
+                if (session) {
+                    info->mcn = mirage_session_get_mcn(session);
+                    g_object_unref(session);
+                }
+                info->mcn_retrieved = TRUE;
+            }
+            if (info->mcn) {
+                mode_switch = 0x02;
+            }
+            break;
+        }
+        case 50: {
+            /* ISRC is to be returned; verify that this is an audio track and
+               that it actually has ISRC set. As with MCN, the first retrieval
+               may scan track's subchannel data */
+            if (!info->isrc_retrieved) {
+                if (self->priv->sector_type == MIRAGE_SECTOR_AUDIO) {
+                    info->isrc = mirage_track_get_isrc(self);
+                }
+                info->isrc_retrieved = TRUE;
+            }
+            if (info->isrc) {
+                mode_switch = 0x03;
+            }
+            break;
+        }
+    }
+
+    /* Track number, index, absolute and relative track adresses are
+       BCD-encoded */
+    switch (mode_switch) {
+        case 0x01: {
+            /* Mode-1: Current position */
+            buf[0] = (info->ctl << 0x04) | 0x01; /* Mode-1 Q */
+            buf[1] = info->track_number; /* Track number */
+            buf[2] = mirage_track_subchannel_bcd(index_number); /* Index */
+            /* Relative M/S/F; when converting, we do not add 2 seconds */
+            mirage_track_subchannel_encode_msf(ABS(relative_address - info->track_start), FALSE, &buf[3]);
+            buf[6] = 0; /* Zero */
+            /* Absolute M/S/F */
+            mirage_track_subchannel_encode_msf(absolute_address, TRUE, &buf[7]);
+            break;
+        }
+        case 0x02: {
+            /* Mode-2: MCN */
+            buf[0] = (info->ctl << 0x04) | 0x02; /* Mode-2 Q */
+            mirage_helper_subchannel_q_encode_mcn(&buf[1], info->mcn);
+            buf[8] = 0; /* zero */
+            /* AFRAME */
+            mirage_helper_lba2msf(absolute_address, TRUE, NULL, NULL, &buf[9]);
+            buf[9] = mirage_track_subchannel_bcd(buf[9]);
+            break;
+        }
+        case 0x03: {
+            /* Mode-3: ISRC */
+            buf[0] = (info->ctl << 0x04) | 0x03; /* Mode-3 Q */
+            mirage_helper_subchannel_q_encode_isrc(&buf[1], info->isrc);
+            /* AFRAME */
+            mirage_helper_lba2msf(absolute_address, TRUE, NULL, NULL, &buf[9]);
+            buf[9] = mirage_track_subchannel_bcd(buf[9]);
+            break;
+        }
+    }
+
+    /* CRC */
+    crc = mirage_helper_subchannel_q_calculate_crc(&buf[0]);
+    buf[10] = (crc & 0xFF00) >> 0x08;
+    buf[11] = (crc & 0x00FF) >> 0x00;
+}
+
+
 /******************************************************************************\
  *                                 Public API                                 *
 \******************************************************************************/
@@ -472,13 +724,48 @@ const gchar *mirage_track_get_isrc (MirageTrack *self)
  */
 MirageSector *mirage_track_get_sector (MirageTrack *self, gint address, gboolean abs, GError **error)
 {
-    MirageSector *sector;
+    /* Create sector object */
+    MirageSector *sector = g_object_new(MIRAGE_TYPE_SECTOR, NULL);
+
+    /* Fill it */
+    if (!mirage_track_read_sector(self, address, abs, sector, error)) {
+        g_object_unref(sector);
+        return NULL;
+    }
+
+    return sector;
+}
+
+/**
+ * mirage_track_read_sector:
+ * @self: a #MirageTrack
+ * @address: (in): sector address
+ * @abs: (in): absolute address
+ * @sector: (in): a #MirageSector to fill
+ * @error: (out) (allow-none): location to store error, or %NULL
+ *
+ * Reads sector at @address into existing @sector object, replacing its
+ * previous contents. @address and @abs have the same meaning as in
+ * mirage_track_get_sector().
+ *
+ * Unlike mirage_track_get_sector(), this function does not create a new
+ * sector object, and does not allocate any memory for the sector's data;
+ * therefore, it can be used together with a pool of reusable sector objects
+ * (see mirage_disc_acquire_sector()) to read sectors without any heap
+ * allocations.
+ *
+ * Returns: %TRUE on success, %FALSE on failure
+ */
+gboolean mirage_track_read_sector (MirageTrack *self, gint address, gboolean abs, MirageSector *sector, GError **error)
+{
     MirageFragment *fragment;
+    MirageTrack *parent;
     GError *local_error = NULL;
     gint absolute_address, relative_address;
     gint fragment_start;
-    guint8 *main_buffer, *subchannel_buffer;
+    guint8 main_buffer[2352], subchannel_buffer[96];
     gint main_length, subchannel_length;
+    gboolean succeeded = TRUE;
 
     MIRAGE_DEBUG(self, MIRAGE_DEBUG_TRACK, "%s: getting sector for address 0x%X (%d); absolute: %i\n", __debug__, address, address, abs);
 
@@ -494,15 +781,15 @@ MirageSector *mirage_track_get_sector (MirageTrack *self, gint address, gboolean
     /* Sector must lie within track boundaries... */
     if (relative_address < 0 || relative_address >= self->priv->length) {
         g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_TRACK_ERROR, Q_("Sector address out of range!"));
-        return NULL;
+        return FALSE;
     }
 
-    /* Get data fragment to feed from */
-    fragment = mirage_track_get_fragment_by_address(self, relative_address, &local_error);
+    /* Get data fragment to feed from; the fragment is owned by the track,
+       so we do not need to take a reference to it */
+    fragment = mirage_track_find_fragment(self, relative_address);
     if (!fragment) {
-        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_TRACK_ERROR, Q_("Failed to get fragment to feed sector: %s"), local_error->message);
-        g_error_free(local_error);
-        return NULL;
+        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_TRACK_ERROR, Q_("Fragment with address %d not found!"), relative_address);
+        return FALSE;
     }
 
     /* Fragments work with fragment-relative addresses, so get fragment's start address */
@@ -511,45 +798,306 @@ MirageSector *mirage_track_get_sector (MirageTrack *self, gint address, gboolean
     MIRAGE_DEBUG(self, MIRAGE_DEBUG_SECTOR, "%s: got fragment %p for track-relative address 0x%X; fragment relative address: 0x%X\n", __debug__, fragment, address, address - fragment_start);
 
     /* Main channel data */
-    if (!mirage_fragment_read_main_data(fragment, relative_address - fragment_start, &main_buffer, &main_length, &local_error)) {
+    if (mirage_fragment_main_data_get_size(fragment) > (gint)sizeof(main_buffer)) {
+        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_TRACK_ERROR, Q_("Unsupported main channel data size %d!"), mirage_fragment_main_data_get_size(fragment));
+        return FALSE;
+    }
+
+    if (!mirage_fragment_read_main_data_range(fragment, relative_address - fragment_start, 1, main_buffer, &main_length, &local_error)) {
         g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_TRACK_ERROR, Q_("Failed read main channel data: %s"), local_error->message);
         g_error_free(local_error);
-        g_object_unref(fragment);
-        return NULL;
+        return FALSE;
     }
 
     /* Subchannel data */
-    if (!mirage_fragment_read_subchannel_data(fragment, relative_address - fragment_start, &subchannel_buffer, &subchannel_length, &local_error)) {
+    if (!mirage_fragment_read_subchannel_data_range(fragment, relative_address - fragment_start, 1, subchannel_buffer, &subchannel_length, &local_error)) {
         g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_TRACK_ERROR, Q_("Failed to read subchannel data: %s"), local_error->message);
         g_error_free(local_error);
-        g_object_unref(fragment);
-        g_free(main_buffer);
-        return NULL;
+        return FALSE;
     }
 
-    /* Create sector object */
-    sector = g_object_new(MIRAGE_TYPE_SECTOR, NULL);
-    mirage_object_set_parent(MIRAGE_OBJECT(sector), self);
+    /* Make track sector's parent; when sector object is reused, this is
+       usually already the case, so avoid re-setting it */
+    parent = mirage_object_get_parent(MIRAGE_OBJECT(sector));
+    if (parent != self) {
+        mirage_object_set_parent(MIRAGE_OBJECT(sector), self);
+    }
+    if (parent) {
+        g_object_unref(parent);
+    }
 
     /* Feed data to sector; fragment's reading code guarantees that
        subchannel format is PW96 */
-    if (!mirage_sector_feed_data(sector, absolute_address, self->priv->sector_type, main_buffer, main_length, MIRAGE_SUBCHANNEL_PW, subchannel_buffer, subchannel_length, 0, &local_error)) {
+    if (!mirage_sector_feed_data(sector, absolute_address, self->priv->sector_type, main_buffer, main_length, MIRAGE_SUBCHANNEL_PW, subchannel_length ? subchannel_buffer : NULL, subchannel_length, 0, &local_error)) {
         g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_TRACK_ERROR, Q_("Failed to feed data: %s"), local_error->message);
         g_error_free(local_error);
+        succeeded = FALSE;
+    }
 
-        g_object_unref(sector);
-        sector = NULL;
+    return succeeded;
+}
+
+/**
+ * mirage_track_read_sectors:
+ * @self: a #MirageTrack
+ * @address: (in): address of first sector
+ * @abs: (in): absolute address
+ * @num_sectors: (in): number of sectors to read
+ * @data_length: (in): expected length of sectors' user data
+ * @buffer: (out caller-allocates) (array): buffer to read user data into
+ * @error: (out) (allow-none): location to store error, or %NULL
+ *
+ * Reads user data of up to @num_sectors consecutive sectors, starting at
+ * @address, into caller-provided @buffer, which must be large enough to hold
+ * @num_sectors times @data_length bytes. @abs specifies whether @address is
+ * absolute or relative, same as in mirage_track_get_sector().
+ *
+ * Reading stops at the end of the track, or at the first sector whose user
+ * data length (as would be returned by mirage_sector_get_data()) does not
+ * match @data_length; this is not considered an error, and the number of
+ * sectors that were actually read is returned.
+ *
+ * Whenever the track's sector type and fragments' main channel data layout
+ * allow user data to be extracted directly, consecutive sectors within
+ * a fragment are read with a single read operation and without constructing
+ * intermediate #MirageSector objects.
+ *
+ * Returns: number of read sectors on success, -1 on failure
+ */
+gint mirage_track_read_sectors (MirageTrack *self, gint address, gboolean abs, gint num_sectors, gint data_length, guint8 *buffer, GError **error)
+{
+    gint relative_address;
+    gint num_read = 0;
+    guint8 *raw_buffer = NULL;
+    gsize raw_buffer_size = 0;
+    MirageSector *sector = NULL;
+
+    /* We need track-relative address */
+    if (abs) {
+        relative_address = address - mirage_track_layout_get_start_sector(self);
+    } else {
+        relative_address = address;
     }
 
-    /* Cleanup */
-    g_free(main_buffer);
-    g_free(subchannel_buffer);
-    g_object_unref(fragment);
+    /* First sector must lie within track boundaries... */
+    if (relative_address < 0 || relative_address >= self->priv->length) {
+        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_TRACK_ERROR, Q_("Sector address out of range!"));
+        return -1;
+    }
 
-    return sector;
+    /* ... and we do not read past its end */
+    num_sectors = MIN(num_sectors, self->priv->length - relative_address);
+
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_TRACK, "%s: reading %d sectors starting at track-relative address 0x%X (%d)\n", __debug__, num_sectors, relative_address, relative_address);
+
+    while (num_read < num_sectors) {
+        GError *local_error = NULL;
+        MirageFragment *fragment;
+        gint fragment_start, fragment_address, fragment_count;
+        gint main_size, data_offset, sector_data_length;
+
+        fragment = mirage_track_get_fragment_by_address(self, relative_address, &local_error);
+        if (!fragment) {
+            g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_TRACK_ERROR, Q_("Failed to get fragment to read sectors: %s"), local_error->message);
+            g_error_free(local_error);
+            num_read = -1;
+            break;
+        }
+
+        fragment_start = mirage_fragment_get_address(fragment);
+        fragment_address = relative_address - fragment_start;
+        fragment_count = MIN(num_sectors - num_read, mirage_fragment_get_length(fragment) - fragment_address);
+        main_size = mirage_fragment_main_data_get_size(fragment);
+
+        if (!mirage_track_get_user_data_layout(self->priv->sector_type, main_size, &data_offset, &sector_data_length)) {
+            /* Main channel data layout that cannot be sliced directly; go
+               through sector object, one sector at a time */
+            const guint8 *data;
+            gint length;
+
+            g_object_unref(fragment);
+
+            if (!sector) {
+                sector = g_object_new(MIRAGE_TYPE_SECTOR, NULL);
+            }
+
+            if (!mirage_track_read_sector(self, relative_address, FALSE, sector, error)) {
+                num_read = -1;
+                break;
+            }
+
+            mirage_sector_get_data(sector, &data, &length, NULL);
+            if (length != data_length) {
+                break;
+            }
+            memcpy(buffer + (gsize)num_read * data_length, data, data_length);
+
+            relative_address++;
+            num_read++;
+            continue;
+        }
+
+        if (sector_data_length != data_length) {
+            g_object_unref(fragment);
+            break;
+        }
+
+        if (!main_size) {
+            /* No main channel data; user data is zero-filled */
+            memset(buffer + (gsize)num_read * data_length, 0, (gsize)fragment_count * data_length);
+        } else if (main_size == data_length) {
+            /* Main channel data consists only of user data; read directly
+               into caller's buffer */
+            if (!mirage_fragment_read_main_data_range(fragment, fragment_address, fragment_count, buffer + (gsize)num_read * data_length, NULL, &local_error)) {
+                g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_TRACK_ERROR, Q_("Failed read main channel data: %s"), local_error->message);
+                g_error_free(local_error);
+                g_object_unref(fragment);
+                num_read = -1;
+                break;
+            }
+        } else {
+            /* Read main channel data into temporary buffer and extract
+               user data from it */
+            gsize required_size = (gsize)fragment_count * main_size;
+            if (raw_buffer_size < required_size) {
+                g_free(raw_buffer);
+                raw_buffer = g_malloc(required_size);
+                raw_buffer_size = required_size;
+            }
+
+            if (!mirage_fragment_read_main_data_range(fragment, fragment_address, fragment_count, raw_buffer, NULL, &local_error)) {
+                g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_TRACK_ERROR, Q_("Failed read main channel data: %s"), local_error->message);
+                g_error_free(local_error);
+                g_object_unref(fragment);
+                num_read = -1;
+                break;
+            }
+
+            for (gint i = 0; i < fragment_count; i++) {
+                memcpy(buffer + (gsize)(num_read + i) * data_length, raw_buffer + (gsize)i * main_size + data_offset, data_length);
+            }
+        }
+
+        g_object_unref(fragment);
+
+        relative_address += fragment_count;
+        num_read += fragment_count;
+    }
+
+    g_free(raw_buffer);
+    if (sector) {
+        g_object_unref(sector);
+    }
+
+    return num_read;
 }
 
 
+/**
+ * mirage_track_generate_subchannel:
+ * @self: a #MirageTrack
+ * @address: (in): address of first sector
+ * @abs: (in): absolute address
+ * @num_sectors: (in): number of sectors to generate subchannel for
+ * @format: (in): subchannel format
+ * @buffer: (out caller-allocates) (array): buffer to generate subchannel data into
+ * @error: (out) (allow-none): location to store error, or %NULL
+ *
+ * Generates subchannel data of @num_sectors consecutive sectors, starting
+ * at @address, into caller-provided @buffer. @format must be either
+ * %MIRAGE_SUBCHANNEL_PW, in which case 96 bytes of interleaved PW subchannel
+ * are generated per sector, or %MIRAGE_SUBCHANNEL_Q, in which case 16 bytes
+ * of deinterleaved Q subchannel are generated per sector. @abs specifies
+ * whether @address is absolute or relative, same as in mirage_track_get_sector().
+ *
+ * Generated data is the same as the one that #MirageSector generates when
+ * subchannel is not provided by image file(s): P subchannel marks the pregap,
+ * Q subchannel carries current position, as well as MCN and ISRC (if set) in
+ * every 25th and 50th sector out of 100, respectively, and R-W subchannels
+ * are empty. It is based solely on track's properties; subchannel data of
+ * track's fragments is not read, and the sectors are not required to lie
+ * within track's current length.
+ *
+ * Track's properties are looked up once per call, which makes this function
+ * suitable for generating subchannel of long runs of sectors.
+ *
+ * Returns: %TRUE on success, %FALSE on failure
+ */
+gboolean mirage_track_generate_subchannel (MirageTrack *self, gint address, gboolean abs, gint num_sectors, MirageSectorSubchannelFormat format, guint8 *buffer, GError **error)
+{
+    const MirageTrackIndexBoundary *boundaries = (const MirageTrackIndexBoundary *)self->priv->indices_table->data;
+    guint num_boundaries = self->priv->indices_table->len;
+    guint next_boundary = 0;
+    MirageTrackSubchannelInfo info;
+    gint relative_address;
+    gint sector_size;
+
+    switch (format) {
+        case MIRAGE_SUBCHANNEL_PW: {
+            sector_size = 96;
+            break;
+        }
+        case MIRAGE_SUBCHANNEL_Q: {
+            sector_size = 16;
+            break;
+        }
+        default: {
+            MIRAGE_DEBUG(self, MIRAGE_DEBUG_TRACK, "%s: subchannel format %d not supported!\n", __debug__, format);
+            g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_TRACK_ERROR, Q_("Subchannel format %d not supported!"), format);
+            return FALSE;
+        }
+    }
+
+    /* Gather track's properties */
+    memset(&info, 0, sizeof(info));
+    info.start_sector = mirage_track_layout_get_start_sector(self);
+    info.track_start = self->priv->track_start;
+    info.ctl = mirage_track_get_ctl(self);
+    info.track_number = mirage_track_subchannel_bcd(self->priv->track_number);
+
+    /* We need track-relative address */
+    if (abs) {
+        relative_address = address - info.start_sector;
+    } else {
+        relative_address = address;
+    }
+
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_TRACK, "%s: generating subchannel for %d sectors starting at track-relative address 0x%X (%d)\n", __debug__, num_sectors, relative_address, relative_address);
+
+    for (gint i = 0; i < num_sectors; i++, relative_address++) {
+        guint8 *ptr = buffer + (gsize)i * sector_size;
+        gboolean pregap = relative_address < info.track_start;
+        gint index_number;
+        guint8 q[12];
+
+        /* Index; the table of index boundaries is walked along with the
+           address. Before the first boundary, we are either in pregap
+           (index 00) or in index 01 */
+        while (next_boundary < num_boundaries && boundaries[next_boundary].address <= relative_address) {
+            next_boundary++;
+        }
+        if (next_boundary > 0) {
+            index_number = boundaries[next_boundary - 1].number;
+        } else {
+            index_number = pregap ? 0 : 1;
+        }
+
+        mirage_track_generate_subchannel_q(self, &info, relative_address, index_number, q);
+
+        if (format == MIRAGE_SUBCHANNEL_PW) {
+            /* P subchannel being 0xFF indicates we're in the pregap; when
+               interleaved, it sets the most significant bit of each byte */
+            memset(ptr, pregap ? 0x80 : 0x00, 96);
+            mirage_helper_subchannel_interleave(SUBCHANNEL_Q, q, ptr);
+        } else {
+            memcpy(ptr, q, 12);
+            memset(ptr + 12, 0, 4);
+        }
+    }
+
+    return TRUE;
+}
+
 /**
  * mirage_track_put_sector:
  * @self: a #MirageTrack
@@ -586,8 +1134,10 @@ gboolean mirage_track_put_sector (MirageTrack *self, MirageSector *sector, GErro
     }
 
     /* We allow appending of sector to the track only if relative address
-       matches track's length, and if there is no track following this one */
-    if (relative_address == self->priv->length) {
+       matches track's length, and if there is no track following this one.
+       Within a layout update, the latter needs to be verified only for the
+       first appended sector */
+    if (relative_address == self->priv->length && !self->priv->layout_update_pending) {
         MirageTrack *next_track = mirage_track_get_next(self, NULL);
         if (next_track) {
             g_object_unref(next_track);
@@ -604,8 +1154,19 @@ gboolean mirage_track_put_sector (MirageTrack *self, MirageSector *sector, GErro
             g_error_free(local_error);
             return FALSE;
         }
-        /* Extend fragment so that we can write into it */
-        mirage_fragment_set_length(fragment, mirage_fragment_get_length(fragment) + 1);
+        /* Extend fragment so that we can write into it. Within a layout
+           update, the bottom-up change is deferred until the update is
+           committed; only track's own length is updated in the mean time */
+        if (self->priv->layout_update_depth) {
+            g_signal_handlers_block_by_func(fragment, mirage_track_fragment_layout_changed_handler, self);
+            mirage_fragment_set_length(fragment, mirage_fragment_get_length(fragment) + 1);
+            g_signal_handlers_unblock_by_func(fragment, mirage_track_fragment_layout_changed_handler, self);
+
+            self->priv->length++;
+            self->priv->layout_update_pending = TRUE;
+        } else {
+            mirage_fragment_set_length(fragment, mirage_fragment_get_length(fragment) + 1);
+        }
     } else {
         fragment = mirage_track_get_fragment_by_address(self, relative_address, &local_error);
         if (!fragment) {
@@ -656,6 +1217,56 @@ gboolean mirage_track_put_sector (MirageTrack *self, MirageSector *sector, GErro
     return TRUE;
 }
 
+/**
+ * mirage_track_layout_begin_update:
+ * @self: a #MirageTrack
+ *
+ * Begins a batched layout update on track. Until the update is committed
+ * using mirage_track_layout_commit_update(), sectors that are appended to
+ * the track using mirage_track_put_sector() update only the length of the
+ * track and its last fragment; the bottom-up change, which propagates the
+ * new length to the parent session and disc and causes the whole disc
+ * layout to be recomputed, is performed only once, when the update is
+ * committed. This makes appending a large number of sectors linear in
+ * the number of sectors, instead of being proportional to the size of
+ * the layout as well.
+ *
+ * While the update is in progress, the layout of track's parent objects
+ * is not updated; therefore, sectors should be put via the track itself,
+ * and no tracks or sessions should be added after it. Layout updates
+ * can be nested; the change is committed once the outermost update is.
+ */
+void mirage_track_layout_begin_update (MirageTrack *self)
+{
+    self->priv->layout_update_depth++;
+}
+
+/**
+ * mirage_track_layout_commit_update:
+ * @self: a #MirageTrack
+ *
+ * Commits a batched layout update that was started using
+ * mirage_track_layout_begin_update().
+ *
+ * <note>
+ * Causes bottom-up change, if sectors were appended within the update.
+ * </note>
+ */
+void mirage_track_layout_commit_update (MirageTrack *self)
+{
+    g_return_if_fail(self->priv->layout_update_depth > 0);
+
+    if (--self->priv->layout_update_depth) {
+        return;
+    }
+
+    if (self->priv->layout_update_pending) {
+        MIRAGE_DEBUG(self, MIRAGE_DEBUG_TRACK, "%s: committing deferred layout change\n", __debug__);
+        self->priv->layout_update_pending = FALSE;
+        mirage_track_commit_bottomup_change(self);
+    }
+}
+
 /**
  * mirage_track_layout_get_session_number:
  * @self: a #MirageTrack
@@ -960,19 +1571,7 @@ MirageFragment *mirage_track_get_fragment_by_index (MirageTrack *self, gint inde
  */
 MirageFragment *mirage_track_get_fragment_by_address (MirageTrack *self, gint address, GError **error)
 {
-    MirageFragment *fragment = NULL;
-
-    /* Go over all fragments */
-    for (GList *entry = self->priv->fragments_list; entry; entry = entry->next) {
-        fragment = entry->data;
-
-        /* Break the loop if address lies within fragment boundaries */
-        if (mirage_fragment_contains_address(fragment, address)) {
-            break;
-        } else {
-            fragment = NULL;
-        }
-    }
+    MirageFragment *fragment = mirage_track_find_fragment(self, address);
 
     /* If we didn't find anything... */
     if (!fragment) {
@@ -1134,8 +1733,12 @@ gboolean mirage_track_add_index (MirageTrack *self, gint address, GError **error
     /* Insert index into indices list */
     self->priv->indices_list = g_list_insert_sorted(self->priv->indices_list, index, (GCompareFunc)sort_indices_by_address);
 
+    /* Connect index modification signal */
+    g_signal_connect_swapped(index, "layout-changed", (GCallback)mirage_track_index_layout_changed_handler, self);
+
     /* Rearrange indices; note that indices do *not* trigger a bottom-up change */
     mirage_track_rearrange_indices(self);
+    mirage_track_rebuild_indices_table(self);
 
     return TRUE;
 }
@@ -1260,6 +1863,48 @@ MirageIndex *mirage_track_get_index_by_address (MirageTrack *self, gint address,
     return g_object_ref(index);
 }
 
+/**
+ * mirage_track_get_index_number_by_address:
+ * @self: a #MirageTrack
+ * @address: (in): track-relative sector address
+ *
+ * Retrieves number of index that the sector at track-relative @address
+ * belongs to. Sectors that lie before track start (see
+ * mirage_track_set_track_start()) belong to index 00, and the ones between
+ * track start and the first index greater than 01 belong to index 01.
+ *
+ * Unlike mirage_track_get_index_by_address(), this function does not retrieve
+ * index objects; it performs a look-up in track's table of index boundaries,
+ * which makes it suitable for per-sector use, such as subchannel generation.
+ *
+ * Returns: index number
+ */
+gint mirage_track_get_index_number_by_address (MirageTrack *self, gint address)
+{
+    const MirageTrackIndexBoundary *boundaries = (const MirageTrackIndexBoundary *)self->priv->indices_table->data;
+    guint lo = 0;
+    guint hi = self->priv->indices_table->len;
+
+    /* Binary search for the last index whose address doesn't surpass
+       requested address */
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (boundaries[mid].address <= address) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo > 0) {
+        return boundaries[lo - 1].number;
+    }
+
+    /* No index; pregap (strictly before track start) or index 01 */
+    return (address < self->priv->track_start) ? 0 : 1;
+}
+
 /**
  * mirage_track_enumerate_indices:
  * @self: a #MirageTrack
@@ -1581,7 +2226,9 @@ static void mirage_track_init (MirageTrack *self)
     self->priv = mirage_track_get_instance_private(self);
 
     self->priv->fragments_list = NULL;
+    self->priv->fragments_index = g_ptr_array_new();
     self->priv->indices_list = NULL;
+    self->priv->indices_table = g_array_new(FALSE, FALSE, sizeof(MirageTrackIndexBoundary));
     self->priv->languages_list = NULL;
 
     self->priv->isrc = NULL;
@@ -1589,12 +2236,18 @@ static void mirage_track_init (MirageTrack *self)
     self->priv->isrc_scan_complete = TRUE;
 
     self->priv->track_number = 1;
+
+    self->priv->layout_update_depth = 0;
+    self->priv->layout_update_pending = FALSE;
 }
 
 static void mirage_track_dispose (GObject *gobject)
 {
     MirageTrack *self = MIRAGE_TRACK(gobject);
 
+    /* Clear fragments index; it does not hold references */
+    g_ptr_array_set_size(self->priv->fragments_index, 0);
+
     /* Unref fragments */
     for (GList *entry = self->priv->fragments_list; entry; entry = entry->next) {
         if (entry->data) {
@@ -1611,6 +2264,7 @@ static void mirage_track_dispose (GObject *gobject)
     for (GList *entry = self->priv->indices_list; entry; entry = entry->next) {
         if (entry->data) {
             MirageIndex *index = entry->data;
+            g_signal_handlers_disconnect_by_func(index, mirage_track_index_layout_changed_handler, self);
             g_object_unref(index);
 
             entry->data = NULL;
@@ -1636,6 +2290,8 @@ static void mirage_track_finalize (GObject *gobject)
     MirageTrack *self = MIRAGE_TRACK(gobject);
 
     g_list_free(self->priv->fragments_list);
+    g_ptr_array_free(self->priv->fragments_index, TRUE);
+    g_array_free(self->priv->indices_table, TRUE);
     g_list_free(self->priv->indices_list);
     g_list_free(self->priv->languages_list);
 
@@ -150,6 +150,9 @@ const gchar *mirage_track_get_isrc (MirageTrack *self);
 
 /* Get/put sector */
 MirageSector *mirage_track_get_sector (MirageTrack *self, gint address, gboolean abs, GError **error);
+gboolean mirage_track_read_sector (MirageTrack *self, gint address, gboolean abs, MirageSector *sector, GError **error);
+gint mirage_track_read_sectors (MirageTrack *self, gint address, gboolean abs, gint num_sectors, gint data_length, guint8 *buffer, GError **error);
+gboolean mirage_track_generate_subchannel (MirageTrack *self, gint address, gboolean abs, gint num_sectors, MirageSectorSubchannelFormat format, guint8 *buffer, GError **error);
 gboolean mirage_track_put_sector (MirageTrack *self, MirageSector *sector, GError **error);
 
 /* Layout */
@@ -162,6 +165,9 @@ gint mirage_track_layout_get_length (MirageTrack *self);
 
 gboolean mirage_track_layout_contains_address (MirageTrack *self, gint address);
 
+void mirage_track_layout_begin_update (MirageTrack *self);
+void mirage_track_layout_commit_update (MirageTrack *self);
+
 /* Data fragments handling */
 gint mirage_track_get_number_of_fragments (MirageTrack *self);
 void mirage_track_add_fragment (MirageTrack *self, gint index, MirageFragment *fragment);
@@ -184,6 +190,7 @@ gboolean mirage_track_remove_index_by_number (MirageTrack *self, gint number, GE
 void mirage_track_remove_index_by_object (MirageTrack *self, MirageIndex *index);
 MirageIndex *mirage_track_get_index_by_number (MirageTrack *self, gint number, GError **error);
 MirageIndex *mirage_track_get_index_by_address (MirageTrack *self, gint address, GError **error);
+gint mirage_track_get_index_number_by_address (MirageTrack *self, gint address);
 gboolean mirage_track_enumerate_indices (MirageTrack *self, MirageEnumIndexCallback func, gpointer user_data);
 
 /* Languages (CD-Text) handling */
@@ -971,6 +971,54 @@ void mirage_helper_subchannel_q_decode_isrc (const guint8 *buf, gchar *isrc)
     isrc[11] = ((buf[7] >> 4) & 0x0F) + '0';
 }
 
+/**
+ * subchannel_spread_lut:
+ *
+ * Global look-up table for interleaving and deinterleaving subchannel
+ * data in mirage_helper_subchannel_interleave() and
+ * mirage_helper_subchannel_deinterleave().
+ *
+ * The entry for byte value b is a 64-bit word whose eight bytes (in
+ * memory order) are set to bits of b, the most significant one first;
+ * i.e., byte j holds bit (7 - j) of b. Interleaving a byte of subchannel
+ * data therefore comes down to shifting the word to subchannel's bit
+ * position and OR-ing it into eight bytes of interleaved data.
+ *
+ * The look-up table buffer is allocated and initialized by
+ * mirage_initialize(), using mirage_helper_init_subchannel_spread_lut().
+ * It is freed and cleared by mirage_shutdown().
+ */
+guint64 *subchannel_spread_lut = NULL;
+
+/**
+ * mirage_helper_init_subchannel_spread_lut:
+ *
+ * Calculates a look-up table for interleaving subchannel data.
+ *
+ * Returns: Pointer to the look-up table or NULL on failure.
+ */
+guint64 *mirage_helper_init_subchannel_spread_lut (void)
+{
+    guint64 *spread_lut = g_try_new(guint64, 256);
+    if (!spread_lut) {
+        return NULL;
+    }
+
+    /* Generate look-up table; bytes are composed in memory order, so the
+       table works regardless of host's endianness */
+    for (guint i = 0; i < 256; i++) {
+        guint8 bytes[8];
+
+        for (guint j = 0; j < 8; j++) {
+            bytes[j] = (i >> (7 - j)) & 0x01;
+        }
+
+        memcpy(&spread_lut[i], bytes, sizeof(bytes));
+    }
+
+    return spread_lut;
+}
+
 /**
  * mirage_helper_subchannel_interleave:
  * @subchan: (in): subchannel type
@@ -982,15 +1030,14 @@ void mirage_helper_subchannel_q_decode_isrc (const guint8 *buf, gchar *isrc)
  */
 void mirage_helper_subchannel_interleave (gint subchan, const guint8 *channel12, guint8 *channel96)
 {
-    guint8 *ptr = channel96;
-    guint8 val;
-
     for (gint i = 0; i < 12; i++) {
-        for (gint j = 0; j < 8; j++) {
-            val = (channel12[i] & (0x01 << j)) >> j; /* Make it 1 or 0 */
-            ptr[7-j] |= (val << subchan);
-        }
-        ptr += 8;
+        guint64 word;
+
+        /* Each byte of spread word is either 0 or 1, so shifting does not
+           carry bits across bytes */
+        memcpy(&word, channel96 + i*8, sizeof(word));
+        word |= subchannel_spread_lut[channel12[i]] << subchan;
+        memcpy(channel96 + i*8, &word, sizeof(word));
     }
 }
 
@@ -1006,10 +1053,15 @@ void mirage_helper_subchannel_interleave (gint subchan, const guint8 *channel12,
 void mirage_helper_subchannel_deinterleave (gint subchan, const guint8 *channel96, guint8 *channel12)
 {
     for (gint i = 0; i < 12; i++) {
-        for (gint j = 0; j < 8; j++) {
-            guint8 val = (channel96[i*8+j] & (0x01 << subchan)) >> subchan;
-            channel12[i] |= (val << (7-j));
-        }
+        guint64 word;
+
+        /* Isolate subchannel's bit in each of eight bytes; with bytes in
+           little-endian order, byte j holds it at bit (8*j), and the
+           multiplication gathers all of them in the top byte of the
+           product, byte j's at bit (7 - j) */
+        memcpy(&word, channel96 + i*8, sizeof(word));
+        word = (GUINT64_FROM_LE(word) >> subchan) & G_GUINT64_CONSTANT(0x0101010101010101);
+        channel12[i] |= (word * G_GUINT64_CONSTANT(0x8040201008040201)) >> 56;
     }
 }
 
@@ -1068,6 +1120,477 @@ static const guint8 ecc_b_lut[256] = {
     0x54, 0xA0, 0xA1, 0x55
 };
 
+/* ecc_b_lut is a multiplication by a constant in GF(2^8), and therefore
+   linear; ecc_b_lut[x] == ecc_b_lut[x & 0x0F] ^ ecc_b_hi_lut[x >> 4].
+   Used by the PSHUFB-based vector implementation */
+static const guint8 ecc_b_hi_lut[16] = {
+    0x00, 0xFB, 0xEB, 0x10, 0xCB, 0x30, 0x20, 0xDB, 0x8B, 0x70, 0x60, 0x9B,
+    0x40, 0xBB, 0xAB, 0x50
+};
+
+/* Parameters of P and Q layer, as used by all callers; these are the only
+   ones for which vectorized implementations are provided */
+#define ECC_P_MAJOR_COUNT  86
+#define ECC_P_MINOR_COUNT  24
+#define ECC_P_MAJOR_MULT    2
+#define ECC_P_MINOR_INC    86
+
+#define ECC_Q_MAJOR_COUNT  52
+#define ECC_Q_MINOR_COUNT  43
+#define ECC_Q_MAJOR_MULT   86
+#define ECC_Q_MINOR_INC    88
+
+#define ECC_Q_SIZE (ECC_Q_MAJOR_COUNT * ECC_Q_MINOR_COUNT)
+
+
+/* Generic implementation */
+static guint32 mirage_helper_compute_edc_generic (const guint8 *src, guint size)
+{
+    return mirage_helper_calculate_crc32_fast(src, size, crc32_d8018001_lut, TRUE, FALSE);
+}
+
+static void mirage_helper_compute_ecc_generic (const guint8 *src, guint32 major_count, guint32 minor_count, guint32 major_mult, guint32 minor_inc, guint8 *dest)
+{
+    guint32 size = major_count * minor_count;
+    guint32 index;
+    guint8 ecc_a, ecc_b, temp;
+
+    for (guint32 major = 0; major < major_count; major++) {
+        index = (major >> 1) * major_mult + (major & 1);
+        ecc_a = 0;
+        ecc_b = 0;
+        for (guint32 minor = 0; minor < minor_count; minor++) {
+            temp = src[index];
+            index += minor_inc;
+            if (index >= size) {
+                index -= size;
+            }
+            ecc_a ^= temp;
+            ecc_b ^= temp;
+            ecc_a = ecc_f_lut[ecc_a];
+        }
+        ecc_a = ecc_b_lut[ecc_f_lut[ecc_a] ^ ecc_b];
+        dest[major              ] = ecc_a;
+        dest[major + major_count] = ecc_a ^ ecc_b;
+    }
+}
+
+static void mirage_helper_compute_ecc_p_generic (const guint8 *src, guint8 *dest)
+{
+    mirage_helper_compute_ecc_generic(src, ECC_P_MAJOR_COUNT, ECC_P_MINOR_COUNT, ECC_P_MAJOR_MULT, ECC_P_MINOR_INC, dest);
+}
+
+static void mirage_helper_compute_ecc_q_generic (const guint8 *src, guint8 *dest)
+{
+    mirage_helper_compute_ecc_generic(src, ECC_Q_MAJOR_COUNT, ECC_Q_MINOR_COUNT, ECC_Q_MAJOR_MULT, ECC_Q_MINOR_INC, dest);
+}
+
+static gboolean mirage_helper_edc_ecc_generic_supported (void)
+{
+    return TRUE;
+}
+
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_EDC_ECC_X86 1
+
+#include <immintrin.h>
+
+/* Vectorized implementations for x86. They are compiled with per-function
+   target attributes, so that the rest of the library is built for the
+   baseline architecture; the implementation is chosen at runtime, based
+   on CPU features.
+
+   ECC: the majors (i.e., columns of P layer and diagonals of Q layer) are
+   independent of each other, so we process 16 (SSE2) or 32 (AVX2) of them
+   at once. Multiplication by alpha (ecc_f_lut) is computed as a shift and
+   a conditional XOR with the reduced generator polynomial (0x1D), and the
+   final multiplication by constant (ecc_b_lut) either with scalar code or
+   using PSHUFB on nibbles. The P layer bytes of consecutive majors are
+   consecutive in memory; for the Q layer, each pair of majors reads two
+   consecutive bytes at an even offset, which are gathered as 16-bit words.
+   When the number of majors is not a multiple of the vector width, the last
+   vector is moved back to overlap the previous one.
+
+   EDC: CRC-32 over the reflected polynomial 0xD8018001 is computed by
+   folding 128-bit blocks with carry-less multiplication (PCLMULQDQ), with
+   the folded remainder and any tail bytes reduced by the slice-by-8 table
+   code. Folding constants are x^(n*32-33) mod P(x), for n of 4*128+32,
+   4*128-32, 128+32 and 128-32 respectively. */
+static inline guint16 mirage_helper_ecc_load_pair (const guint8 *src, guint32 index)
+{
+    guint16 pair;
+    memcpy(&pair, src + index, sizeof(pair));
+    return pair;
+}
+
+static void mirage_helper_ecc_store_scalar (const guint8 *ecc_a, const guint8 *ecc_b, guint32 first, guint32 count, guint32 major_count, guint8 *dest)
+{
+    for (guint32 i = 0; i < count; i++) {
+        guint8 a = ecc_b_lut[ecc_f_lut[ecc_a[i]] ^ ecc_b[i]];
+        dest[first + i              ] = a;
+        dest[first + i + major_count] = a ^ ecc_b[i];
+    }
+}
+
+
+/* SSE2 */
+__attribute__((target("sse2")))
+static inline __m128i mirage_helper_gf_mul2_sse2 (__m128i x)
+{
+    __m128i carry = _mm_cmplt_epi8(x, _mm_setzero_si128());
+    return _mm_xor_si128(_mm_add_epi8(x, x), _mm_and_si128(carry, _mm_set1_epi8(0x1D)));
+}
+
+__attribute__((target("sse2")))
+static void mirage_helper_compute_ecc_p_sse2 (const guint8 *src, guint8 *dest)
+{
+    for (guint32 major = 0; major < ECC_P_MAJOR_COUNT; major += 16) {
+        guint32 first = MIN(major, ECC_P_MAJOR_COUNT - 16);
+        __m128i ecc_a = _mm_setzero_si128();
+        __m128i ecc_b = _mm_setzero_si128();
+        guint8 a[16], b[16];
+
+        for (guint32 minor = 0; minor < ECC_P_MINOR_COUNT; minor++) {
+            __m128i temp = _mm_loadu_si128((const __m128i *)(src + first + minor * ECC_P_MINOR_INC));
+            ecc_a = mirage_helper_gf_mul2_sse2(_mm_xor_si128(ecc_a, temp));
+            ecc_b = _mm_xor_si128(ecc_b, temp);
+        }
+
+        _mm_storeu_si128((__m128i *)a, ecc_a);
+        _mm_storeu_si128((__m128i *)b, ecc_b);
+        mirage_helper_ecc_store_scalar(a, b, first, 16, ECC_P_MAJOR_COUNT, dest);
+    }
+}
+
+__attribute__((target("sse2")))
+static void mirage_helper_compute_ecc_q_sse2 (const guint8 *src, guint8 *dest)
+{
+    for (guint32 major = 0; major < ECC_Q_MAJOR_COUNT; major += 16) {
+        guint32 first = MIN(major, ECC_Q_MAJOR_COUNT - 16);
+        __m128i ecc_a = _mm_setzero_si128();
+        __m128i ecc_b = _mm_setzero_si128();
+        guint32 index[8];
+        guint8 a[16], b[16];
+
+        for (gint i = 0; i < 8; i++) {
+            index[i] = (first/2 + i) * ECC_Q_MAJOR_MULT;
+        }
+
+        for (guint32 minor = 0; minor < ECC_Q_MINOR_COUNT; minor++) {
+            __m128i temp = _mm_set_epi16(
+                mirage_helper_ecc_load_pair(src, index[7]), mirage_helper_ecc_load_pair(src, index[6]),
+                mirage_helper_ecc_load_pair(src, index[5]), mirage_helper_ecc_load_pair(src, index[4]),
+                mirage_helper_ecc_load_pair(src, index[3]), mirage_helper_ecc_load_pair(src, index[2]),
+                mirage_helper_ecc_load_pair(src, index[1]), mirage_helper_ecc_load_pair(src, index[0])
+            );
+            for (gint i = 0; i < 8; i++) {
+                index[i] += ECC_Q_MINOR_INC;
+                if (index[i] >= ECC_Q_SIZE) {
+                    index[i] -= ECC_Q_SIZE;
+                }
+            }
+            ecc_a = mirage_helper_gf_mul2_sse2(_mm_xor_si128(ecc_a, temp));
+            ecc_b = _mm_xor_si128(ecc_b, temp);
+        }
+
+        _mm_storeu_si128((__m128i *)a, ecc_a);
+        _mm_storeu_si128((__m128i *)b, ecc_b);
+        mirage_helper_ecc_store_scalar(a, b, first, 16, ECC_Q_MAJOR_COUNT, dest);
+    }
+}
+
+static gboolean mirage_helper_edc_ecc_sse2_supported (void)
+{
+    return __builtin_cpu_supports("sse2");
+}
+
+
+/* AVX2 */
+__attribute__((target("avx2")))
+static inline __m256i mirage_helper_gf_mul2_avx2 (__m256i x)
+{
+    __m256i carry = _mm256_cmpgt_epi8(_mm256_setzero_si256(), x);
+    return _mm256_xor_si256(_mm256_add_epi8(x, x), _mm256_and_si256(carry, _mm256_set1_epi8(0x1D)));
+}
+
+__attribute__((target("avx2")))
+static inline void mirage_helper_ecc_store_avx2 (__m256i ecc_a, __m256i ecc_b, guint32 first, guint32 major_count, guint8 *dest)
+{
+    const __m256i lo_lut = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)ecc_b_lut));
+    const __m256i hi_lut = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)ecc_b_hi_lut));
+    const __m256i nibble_mask = _mm256_set1_epi8(0x0F);
+
+    /* ecc_a = ecc_b_lut[ecc_f_lut[ecc_a] ^ ecc_b] */
+    ecc_a = _mm256_xor_si256(mirage_helper_gf_mul2_avx2(ecc_a), ecc_b);
+    ecc_a = _mm256_xor_si256(
+        _mm256_shuffle_epi8(lo_lut, _mm256_and_si256(ecc_a, nibble_mask)),
+        _mm256_shuffle_epi8(hi_lut, _mm256_and_si256(_mm256_srli_epi16(ecc_a, 4), nibble_mask))
+    );
+
+    _mm256_storeu_si256((__m256i *)(dest + first), ecc_a);
+    _mm256_storeu_si256((__m256i *)(dest + first + major_count), _mm256_xor_si256(ecc_a, ecc_b));
+}
+
+__attribute__((target("avx2")))
+static void mirage_helper_compute_ecc_p_avx2 (const guint8 *src, guint8 *dest)
+{
+    for (guint32 major = 0; major < ECC_P_MAJOR_COUNT; major += 32) {
+        guint32 first = MIN(major, ECC_P_MAJOR_COUNT - 32);
+        __m256i ecc_a = _mm256_setzero_si256();
+        __m256i ecc_b = _mm256_setzero_si256();
+
+        for (guint32 minor = 0; minor < ECC_P_MINOR_COUNT; minor++) {
+            __m256i temp = _mm256_loadu_si256((const __m256i *)(src + first + minor * ECC_P_MINOR_INC));
+            ecc_a = mirage_helper_gf_mul2_avx2(_mm256_xor_si256(ecc_a, temp));
+            ecc_b = _mm256_xor_si256(ecc_b, temp);
+        }
+
+        mirage_helper_ecc_store_avx2(ecc_a, ecc_b, first, ECC_P_MAJOR_COUNT, dest);
+    }
+}
+
+__attribute__((target("avx2")))
+static void mirage_helper_compute_ecc_q_avx2 (const guint8 *src, guint8 *dest)
+{
+    for (guint32 major = 0; major < ECC_Q_MAJOR_COUNT; major += 32) {
+        guint32 first = MIN(major, ECC_Q_MAJOR_COUNT - 32);
+        __m256i ecc_a = _mm256_setzero_si256();
+        __m256i ecc_b = _mm256_setzero_si256();
+        guint32 index[16];
+
+        for (gint i = 0; i < 16; i++) {
+            index[i] = (first/2 + i) * ECC_Q_MAJOR_MULT;
+        }
+
+        for (guint32 minor = 0; minor < ECC_Q_MINOR_COUNT; minor++) {
+            __m256i temp = _mm256_set_epi16(
+                mirage_helper_ecc_load_pair(src, index[15]), mirage_helper_ecc_load_pair(src, index[14]),
+                mirage_helper_ecc_load_pair(src, index[13]), mirage_helper_ecc_load_pair(src, index[12]),
+                mirage_helper_ecc_load_pair(src, index[11]), mirage_helper_ecc_load_pair(src, index[10]),
+                mirage_helper_ecc_load_pair(src, index[9]), mirage_helper_ecc_load_pair(src, index[8]),
+                mirage_helper_ecc_load_pair(src, index[7]), mirage_helper_ecc_load_pair(src, index[6]),
+                mirage_helper_ecc_load_pair(src, index[5]), mirage_helper_ecc_load_pair(src, index[4]),
+                mirage_helper_ecc_load_pair(src, index[3]), mirage_helper_ecc_load_pair(src, index[2]),
+                mirage_helper_ecc_load_pair(src, index[1]), mirage_helper_ecc_load_pair(src, index[0])
+            );
+            for (gint i = 0; i < 16; i++) {
+                index[i] += ECC_Q_MINOR_INC;
+                if (index[i] >= ECC_Q_SIZE) {
+                    index[i] -= ECC_Q_SIZE;
+                }
+            }
+            ecc_a = mirage_helper_gf_mul2_avx2(_mm256_xor_si256(ecc_a, temp));
+            ecc_b = _mm256_xor_si256(ecc_b, temp);
+        }
+
+        mirage_helper_ecc_store_avx2(ecc_a, ecc_b, first, ECC_Q_MAJOR_COUNT, dest);
+    }
+}
+
+
+/* PCLMULQDQ */
+#define EDC_FOLD(x, k, data) _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128((x), (k), 0x00), _mm_clmulepi64_si128((x), (k), 0x11)), (data))
+
+__attribute__((target("sse2,pclmul")))
+static guint32 mirage_helper_compute_edc_pclmul (const guint8 *src, guint size)
+{
+    const __m128i k1k2 = _mm_set_epi64x(G_GINT64_CONSTANT(0x12e7928a2), G_GINT64_CONSTANT(0x1f8931102));
+    const __m128i k3k4 = _mm_set_epi64x(G_GINT64_CONSTANT(0x1d5934102), G_GINT64_CONSTANT(0x06c90c100));
+    __m128i x0, x1, x2, x3;
+    guint8 remainder[32];
+
+    if (size < 64) {
+        return mirage_helper_compute_edc_generic(src, size);
+    }
+
+    /* Initial value is zero, so the first four blocks are loaded as-is */
+    x0 = _mm_loadu_si128((const __m128i *)(src +  0));
+    x1 = _mm_loadu_si128((const __m128i *)(src + 16));
+    x2 = _mm_loadu_si128((const __m128i *)(src + 32));
+    x3 = _mm_loadu_si128((const __m128i *)(src + 48));
+    src += 64;
+    size -= 64;
+
+    /* Fold by four */
+    while (size >= 64) {
+        x0 = EDC_FOLD(x0, k1k2, _mm_loadu_si128((const __m128i *)(src +  0)));
+        x1 = EDC_FOLD(x1, k1k2, _mm_loadu_si128((const __m128i *)(src + 16)));
+        x2 = EDC_FOLD(x2, k1k2, _mm_loadu_si128((const __m128i *)(src + 32)));
+        x3 = EDC_FOLD(x3, k1k2, _mm_loadu_si128((const __m128i *)(src + 48)));
+        src += 64;
+        size -= 64;
+    }
+
+    /* Fold into single block */
+    x0 = EDC_FOLD(x0, k3k4, x1);
+    x0 = EDC_FOLD(x0, k3k4, x2);
+    x0 = EDC_FOLD(x0, k3k4, x3);
+
+    while (size >= 16) {
+        x0 = EDC_FOLD(x0, k3k4, _mm_loadu_si128((const __m128i *)src));
+        src += 16;
+        size -= 16;
+    }
+
+    /* The folded block, followed by remaining bytes, has the same CRC as
+       the whole data */
+    _mm_storeu_si128((__m128i *)remainder, x0);
+    memcpy(remainder + 16, src, size);
+
+    return mirage_helper_compute_edc_generic(remainder, 16 + size);
+}
+
+#undef EDC_FOLD
+
+static gboolean mirage_helper_edc_ecc_sse2_pclmul_supported (void)
+{
+    return __builtin_cpu_supports("sse2") && __builtin_cpu_supports("pclmul");
+}
+
+static gboolean mirage_helper_edc_ecc_avx2_pclmul_supported (void)
+{
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("pclmul");
+}
+
+#endif /* x86 */
+
+
+/* Implementation table; ordered from the slowest to the fastest one */
+typedef struct
+{
+    const gchar *name;
+    gboolean (*supported) (void);
+    guint32 (*compute_edc) (const guint8 *src, guint size);
+    void (*compute_ecc_p) (const guint8 *src, guint8 *dest);
+    void (*compute_ecc_q) (const guint8 *src, guint8 *dest);
+} MirageEdcEccImplementation;
+
+static const MirageEdcEccImplementation edc_ecc_implementations[] = {
+    {
+        "generic",
+        mirage_helper_edc_ecc_generic_supported,
+        mirage_helper_compute_edc_generic,
+        mirage_helper_compute_ecc_p_generic,
+        mirage_helper_compute_ecc_q_generic,
+    },
+#ifdef HAVE_EDC_ECC_X86
+    {
+        "sse2",
+        mirage_helper_edc_ecc_sse2_supported,
+        mirage_helper_compute_edc_generic,
+        mirage_helper_compute_ecc_p_sse2,
+        mirage_helper_compute_ecc_q_sse2,
+    },
+    {
+        "sse2-pclmul",
+        mirage_helper_edc_ecc_sse2_pclmul_supported,
+        mirage_helper_compute_edc_pclmul,
+        mirage_helper_compute_ecc_p_sse2,
+        mirage_helper_compute_ecc_q_sse2,
+    },
+    {
+        "avx2-pclmul",
+        mirage_helper_edc_ecc_avx2_pclmul_supported,
+        mirage_helper_compute_edc_pclmul,
+        mirage_helper_compute_ecc_p_avx2,
+        mirage_helper_compute_ecc_q_avx2,
+    },
+#endif
+};
+
+static const MirageEdcEccImplementation *edc_ecc_implementation = &edc_ecc_implementations[0];
+
+
+/**
+ * mirage_helper_sector_edc_ecc_get_implementations:
+ *
+ * Retrieves names of EDC/ECC implementations that are supported by the
+ * CPU. The first one is always "generic", which is portable table-driven
+ * implementation; the rest, if any, are listed in the order of increasing
+ * performance.
+ *
+ * Returns: (transfer none) (array zero-terminated=1): %NULL-terminated array
+ * of implementation names. The array belongs to libMirage and should not
+ * be modified or freed.
+ */
+const gchar * const *mirage_helper_sector_edc_ecc_get_implementations (void)
+{
+    static const gchar *names[G_N_ELEMENTS(edc_ecc_implementations) + 1];
+    static gsize initialized = 0;
+
+    if (g_once_init_enter(&initialized)) {
+        gint num_names = 0;
+        for (guint i = 0; i < G_N_ELEMENTS(edc_ecc_implementations); i++) {
+            if (edc_ecc_implementations[i].supported()) {
+                names[num_names++] = edc_ecc_implementations[i].name;
+            }
+        }
+        names[num_names] = NULL;
+        g_once_init_leave(&initialized, 1);
+    }
+
+    return names;
+}
+
+/**
+ * mirage_helper_sector_edc_ecc_get_implementation:
+ *
+ * Retrieves name of EDC/ECC implementation that is currently in use.
+ *
+ * Returns: (transfer none): implementation name
+ */
+const gchar *mirage_helper_sector_edc_ecc_get_implementation (void)
+{
+    const MirageEdcEccImplementation *implementation = g_atomic_pointer_get(&edc_ecc_implementation);
+    return implementation->name;
+}
+
+/**
+ * mirage_helper_sector_edc_ecc_set_implementation:
+ * @name: (in) (allow-none): implementation name, or %NULL
+ * @error: (out) (allow-none): location to store error, or %NULL
+ *
+ * Selects EDC/ECC implementation that is used by
+ * mirage_helper_sector_edc_ecc_compute_edc_block() and
+ * mirage_helper_sector_edc_ecc_compute_ecc_block(). If @name is %NULL,
+ * the fastest implementation supported by the CPU is selected; this is
+ * done by mirage_initialize().
+ *
+ * All implementations produce identical results; this function is
+ * primarily intended for benchmarking and testing.
+ *
+ * Returns: %TRUE on success, %FALSE on failure (unknown implementation,
+ * or implementation not supported by the CPU)
+ */
+gboolean mirage_helper_sector_edc_ecc_set_implementation (const gchar *name, GError **error)
+{
+    const MirageEdcEccImplementation *implementation = NULL;
+
+    for (guint i = 0; i < G_N_ELEMENTS(edc_ecc_implementations); i++) {
+        if (name && g_strcmp0(edc_ecc_implementations[i].name, name)) {
+            continue;
+        }
+        if (!edc_ecc_implementations[i].supported()) {
+            if (name) {
+                g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_LIBRARY_ERROR, Q_("EDC/ECC implementation '%s' is not supported by the CPU!"), name);
+                return FALSE;
+            }
+            continue;
+        }
+        implementation = &edc_ecc_implementations[i];
+    }
+
+    if (!implementation) {
+        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_LIBRARY_ERROR, Q_("Unknown EDC/ECC implementation '%s'!"), name);
+        return FALSE;
+    }
+
+    g_atomic_pointer_set(&edc_ecc_implementation, implementation);
+
+    return TRUE;
+}
+
 /**
  * mirage_helper_sector_edc_ecc_compute_edc_block:
  * @src: (in) (array length=size): data to calculate EDC data for
@@ -1102,10 +1625,11 @@ static const guint8 ecc_b_lut[256] = {
  */
 void mirage_helper_sector_edc_ecc_compute_edc_block (const guint8 *src, guint16 size, guint8 *dest)
 {
+    const MirageEdcEccImplementation *implementation = g_atomic_pointer_get(&edc_ecc_implementation);
     guint32 edc;
     guint32 *dest2 = (guint32 *) dest;
 
-    edc = mirage_helper_calculate_crc32_fast(src, size, crc32_d8018001_lut, TRUE, FALSE);
+    edc = implementation->compute_edc(src, size);
     *dest2 = GUINT32_TO_LE(edc);
 }
 
@@ -1144,27 +1668,14 @@ void mirage_helper_sector_edc_ecc_compute_edc_block (const guint8 *src, guint16
  */
 void mirage_helper_sector_edc_ecc_compute_ecc_block (const guint8 *src, guint32 major_count, guint32 minor_count, guint32 major_mult, guint32 minor_inc, guint8 *dest)
 {
-    guint32 size = major_count * minor_count;
-    guint32 index;
-    guint8 ecc_a, ecc_b, temp;
+    const MirageEdcEccImplementation *implementation = g_atomic_pointer_get(&edc_ecc_implementation);
 
-    for (guint32 major = 0; major < major_count; major++) {
-        index = (major >> 1) * major_mult + (major & 1);
-        ecc_a = 0;
-        ecc_b = 0;
-        for (guint32 minor = 0; minor < minor_count; minor++) {
-            temp = src[index];
-            index += minor_inc;
-            if (index >= size) {
-                index -= size;
-            }
-            ecc_a ^= temp;
-            ecc_b ^= temp;
-            ecc_a = ecc_f_lut[ecc_a];
-        }
-        ecc_a = ecc_b_lut[ecc_f_lut[ecc_a] ^ ecc_b];
-        dest[major              ] = ecc_a;
-        dest[major + major_count] = ecc_a ^ ecc_b;
+    if (major_count == ECC_P_MAJOR_COUNT && minor_count == ECC_P_MINOR_COUNT && major_mult == ECC_P_MAJOR_MULT && minor_inc == ECC_P_MINOR_INC) {
+        implementation->compute_ecc_p(src, dest);
+    } else if (major_count == ECC_Q_MAJOR_COUNT && minor_count == ECC_Q_MINOR_COUNT && major_mult == ECC_Q_MAJOR_MULT && minor_inc == ECC_Q_MINOR_INC) {
+        implementation->compute_ecc_q(src, dest);
+    } else {
+        mirage_helper_compute_ecc_generic(src, major_count, minor_count, major_mult, minor_inc, dest);
     }
 }
 
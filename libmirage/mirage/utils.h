@@ -125,6 +125,10 @@ typedef enum _MirageSubChannel
     SUBCHANNEL_P = 7,
 } MirageSubChannel;
 
+extern guint64 *subchannel_spread_lut;
+
+guint64 *mirage_helper_init_subchannel_spread_lut (void);
+
 void mirage_helper_subchannel_interleave (gint subchan, const guint8 *channel12, guint8 *channel96);
 void mirage_helper_subchannel_deinterleave (gint subchan, const guint8 *channel96, guint8 *channel12);
 
@@ -132,6 +136,10 @@ void mirage_helper_subchannel_deinterleave (gint subchan, const guint8 *channel9
 void mirage_helper_sector_edc_ecc_compute_edc_block (const guint8 *src, guint16 size, guint8 *dest);
 void mirage_helper_sector_edc_ecc_compute_ecc_block (const guint8 *src, guint32 major_count, guint32 minor_count, guint32 major_mult, guint32 minor_inc, guint8 *dest);
 
+const gchar * const *mirage_helper_sector_edc_ecc_get_implementations (void);
+const gchar *mirage_helper_sector_edc_ecc_get_implementation (void);
+gboolean mirage_helper_sector_edc_ecc_set_implementation (const gchar *name, GError **error);
+
 MirageSectorType mirage_helper_determine_sector_type (const guint8 *buf);
 
 /* Text data encoding */
@@ -83,6 +83,9 @@ struct _MirageWriterPrivate
 
     /* Progress signalling */
     guint progress_step;
+
+    /* Conversion pipeline */
+    guint conversion_batch_size;
 };
 
 
@@ -552,25 +555,511 @@ void mirage_writer_set_conversion_progress_step (MirageWriter *self, guint step)
     self->priv->progress_step = step;
 }
 
-
 /**
- * mirage_writer_convert_image:
+ * mirage_writer_get_conversion_batch_size:
  * @self: a #MirageWriter
- * @filename: (in): filename of output image
- * @original_disc: (in): disc layout obtained from original image
- * @parameters: (in) (element-type utf8 GLib.Variant): writer parameters
- * @cancellable: (in) (allow-none): optional %GCancellable object, NULL to ignore.
- * @error: (out) (allow-none): location to store error, or %NULL
  *
- * Convenience function that converts an already-opened image stored in
- * @original_disc and writes it to @filename. If conversion progress
- * reporting is enabled via mirage_writer_set_conversion_progress_step(),
- * the #MirageWriter::conversion-progress signal is emitted at specified
- * time intervals during conversion.
+ * Retrieves conversion batch size setting.
  *
- * Returns: %TRUE on success, %FALSE on failure
+ * Returns: the value of conversion batch size.
  */
-gboolean mirage_writer_convert_image (MirageWriter *self, const gchar *filename, MirageDisc *original_disc, GHashTable *parameters, GCancellable *cancellable, GError **error)
+guint mirage_writer_get_conversion_batch_size (MirageWriter *self)
+{
+    return self->priv->conversion_batch_size;
+}
+
+/**
+ * mirage_writer_set_conversion_batch_size:
+ * @self: a #MirageWriter
+ * @batch_size: new conversion batch size value
+ *
+ * Sets the number of sectors that mirage_writer_convert_image() passes
+ * through its conversion pipeline at once. Reading sectors from the
+ * original image, reconstructing their data, and writing them into the
+ * new image are performed by separate threads, with a bounded number of
+ * batches in flight. Setting @batch_size to 0 disables the pipeline, and
+ * sectors are copied one by one in the calling thread.
+ */
+void mirage_writer_set_conversion_batch_size (MirageWriter *self, guint batch_size)
+{
+    self->priv->conversion_batch_size = batch_size;
+}
+
+
+/**********************************************************************\
+ *                       Conversion pipeline                          *
+\**********************************************************************/
+/* Sectors of a track are copied through a three-stage pipeline: a reader
+   thread reads batches of sectors from the original track, a pool of
+   worker threads reconstructs the data that the destination fragments
+   require (sync, headers, EDC/ECC, subchannel), and the calling thread
+   puts the sectors into the new track, in order. The number of batches
+   in flight is bounded, which limits the memory used by the pipeline.
+
+   Only the reader thread accesses the original track's fragments, and
+   only the calling thread accesses the new disc. Reconstruction reads
+   the original track's (and its session's) properties; the lazily
+   computed ones among them, ISRC and MCN, have already been retrieved
+   by the time the pipeline is started, so the workers do not modify
+   any shared object. If the original track does not provide subchannel
+   but destination fragments require it, workers generate it for the
+   whole batch at once, from the original track's properties. */
+typedef struct
+{
+    guint sequence; /* Sequence number of the batch */
+    gint address; /* Track-relative address of first sector */
+    gint num_sectors; /* Number of sectors that were read */
+    MirageSector **sectors;
+    GError *error; /* Error that stopped reading, if any */
+} MirageConversionBatch;
+
+typedef struct
+{
+    gint address;
+    gint length;
+    gint main_size;
+    gint subchannel_size;
+} MirageConversionFragment;
+
+typedef struct
+{
+    MirageDisc *original_disc;
+    MirageTrack *original_track;
+    gint num_sectors;
+    gint batch_size;
+
+    /* Layout of destination fragments */
+    GArray *fragments;
+    gboolean generate_subchannel; /* Generate subchannel per batch? */
+
+    GThreadPool *workers;
+
+    GMutex mutex;
+    GCond cond;
+    gint batches_in_flight;
+    gint max_batches_in_flight;
+    GHashTable *completed_batches; /* Sequence number -> batch */
+    gboolean abort;
+} MirageConversionPipeline;
+
+
+static void mirage_writer_conversion_batch_free (MirageConversionBatch *batch, MirageDisc *original_disc)
+{
+    for (gint i = 0; i < batch->num_sectors; i++) {
+        mirage_disc_release_sector(original_disc, batch->sectors[i]);
+    }
+    g_free(batch->sectors);
+    if (batch->error) {
+        g_error_free(batch->error);
+    }
+    g_free(batch);
+}
+
+static gpointer mirage_writer_conversion_reader (MirageConversionPipeline *pipeline)
+{
+    for (gint address = 0, sequence = 0; address < pipeline->num_sectors; address += pipeline->batch_size, sequence++) {
+        MirageConversionBatch *batch;
+        gint count = MIN(pipeline->batch_size, pipeline->num_sectors - address);
+
+        /* Wait for a free slot */
+        g_mutex_lock(&pipeline->mutex);
+        while (pipeline->batches_in_flight >= pipeline->max_batches_in_flight && !pipeline->abort) {
+            g_cond_wait(&pipeline->cond, &pipeline->mutex);
+        }
+        if (pipeline->abort) {
+            g_mutex_unlock(&pipeline->mutex);
+            break;
+        }
+        pipeline->batches_in_flight++;
+        g_mutex_unlock(&pipeline->mutex);
+
+        /* Read batch */
+        batch = g_new0(MirageConversionBatch, 1);
+        batch->sequence = sequence;
+        batch->address = address;
+        batch->sectors = g_new0(MirageSector *, count);
+
+        while (batch->num_sectors < count) {
+            MirageSector *sector = mirage_disc_acquire_sector(pipeline->original_disc);
+            if (!mirage_track_read_sector(pipeline->original_track, address + batch->num_sectors, FALSE, sector, &batch->error)) {
+                mirage_disc_release_sector(pipeline->original_disc, sector);
+                break;
+            }
+            batch->sectors[batch->num_sectors++] = sector;
+        }
+
+        /* Pass it on for reconstruction */
+        g_thread_pool_push(pipeline->workers, batch, NULL);
+
+        if (batch->error) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static void mirage_writer_conversion_worker (MirageConversionBatch *batch, MirageConversionPipeline *pipeline)
+{
+    MirageConversionFragment *fragment = NULL;
+
+    /* Generate subchannel of the whole batch in a single pass, and hand it
+       over to sectors */
+    if (pipeline->generate_subchannel && batch->num_sectors) {
+        guint8 *subchannel = g_malloc((gsize)batch->num_sectors * 96);
+
+        if (mirage_track_generate_subchannel(pipeline->original_track, batch->address, FALSE, batch->num_sectors, MIRAGE_SUBCHANNEL_PW, subchannel, NULL)) {
+            for (gint i = 0; i < batch->num_sectors; i++) {
+                mirage_sector_set_subchannel(batch->sectors[i], MIRAGE_SUBCHANNEL_PW, subchannel + (gsize)i * 96, 96, NULL);
+            }
+        }
+
+        g_free(subchannel);
+    }
+
+    /* Generate the data that destination fragments will extract from
+       sectors; sectors keep generated data, so putting them into the new
+       track afterwards merely copies it. Errors are ignored here, as they
+       are reported when sectors are put into the track */
+    for (gint i = 0; i < batch->num_sectors; i++) {
+        gint address = batch->address + i;
+        const guint8 *main_data, *subchannel_data;
+
+        if (!fragment || address >= fragment->address + fragment->length) {
+            fragment = NULL;
+            for (guint j = 0; j < pipeline->fragments->len; j++) {
+                MirageConversionFragment *entry = &g_array_index(pipeline->fragments, MirageConversionFragment, j);
+                if (address >= entry->address && address < entry->address + entry->length) {
+                    fragment = entry;
+                    break;
+                }
+            }
+            if (!fragment) {
+                break;
+            }
+        }
+
+        mirage_sector_extract_data(batch->sectors[i], &main_data, fragment->main_size, fragment->subchannel_size ? MIRAGE_SUBCHANNEL_PW : MIRAGE_SUBCHANNEL_NONE, &subchannel_data, fragment->subchannel_size ? 96 : 0, NULL);
+    }
+
+    /* Hand the batch over to the writing stage */
+    g_mutex_lock(&pipeline->mutex);
+    g_hash_table_insert(pipeline->completed_batches, GUINT_TO_POINTER(batch->sequence), batch);
+    g_cond_broadcast(&pipeline->cond);
+    g_mutex_unlock(&pipeline->mutex);
+}
+
+static gboolean mirage_writer_put_converted_sector (MirageWriter *self, MirageTrack *new_track, MirageSector *sector, gint disc_layout_start, guint progress_step_size, guint *conversion_progress, GError **error)
+{
+    if (progress_step_size) {
+        gint sector_count = mirage_sector_get_address(sector) - disc_layout_start;
+
+        if (sector_count >= *conversion_progress*progress_step_size) {
+            g_signal_emit_by_name(self, "conversion-progress", *conversion_progress*self->priv->progress_step, NULL);
+            (*conversion_progress)++;
+        }
+    }
+
+    return mirage_track_put_sector(new_track, sector, error);
+}
+
+static gboolean mirage_writer_convert_track_sectors (MirageWriter *self, MirageDisc *original_disc, MirageTrack *original_track, MirageTrack *new_track, gint disc_layout_start, guint progress_step_size, guint *conversion_progress, GCancellable *cancellable, GError **error)
+{
+    MirageConversionPipeline pipeline;
+    GThread *reader;
+    gint num_batches;
+    gint num_workers;
+    gboolean succeeded = TRUE;
+
+    gint num_sectors = mirage_track_layout_get_length(original_track);
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_WRITER, "%s: copying sectors (%d)\n", __debug__, num_sectors);
+
+    /* Serial copy, one sector at a time */
+    if (!self->priv->conversion_batch_size) {
+        for (gint sector_address = 0; sector_address < num_sectors; sector_address++) {
+            /* Get sector from original track using track-relative address... */
+            MirageSector *sector = mirage_track_get_sector(original_track, sector_address, FALSE, error);
+            if (sector) {
+                /* ... and put it into new track */
+                succeeded = mirage_writer_put_converted_sector(self, new_track, sector, disc_layout_start, progress_step_size, conversion_progress, error);
+                g_object_unref(sector);
+            } else {
+                succeeded = FALSE;
+            }
+
+            /* Check if conversion is to be cancelled at user's request */
+            succeeded &= !g_cancellable_set_error_if_cancelled(cancellable, error);
+
+            if (!succeeded) {
+                return FALSE;
+            }
+        }
+
+        return TRUE;
+    }
+
+    if (!num_sectors) {
+        return TRUE;
+    }
+
+    /* Set up pipeline */
+    num_workers = CLAMP(g_get_num_processors(), 1, 8);
+
+    pipeline.original_disc = original_disc;
+    pipeline.original_track = original_track;
+    pipeline.num_sectors = num_sectors;
+    pipeline.batch_size = self->priv->conversion_batch_size;
+    pipeline.batches_in_flight = 0;
+    pipeline.max_batches_in_flight = 2*num_workers + 2;
+    pipeline.completed_batches = g_hash_table_new(g_direct_hash, g_direct_equal);
+    pipeline.abort = FALSE;
+    pipeline.generate_subchannel = FALSE;
+    g_mutex_init(&pipeline.mutex);
+    g_cond_init(&pipeline.cond);
+
+    pipeline.fragments = g_array_new(FALSE, FALSE, sizeof(MirageConversionFragment));
+    for (gint i = 0; i < mirage_track_get_number_of_fragments(new_track); i++) {
+        MirageFragment *fragment = mirage_track_get_fragment_by_index(new_track, i, NULL);
+        MirageConversionFragment entry = {
+            .address = mirage_fragment_get_address(fragment),
+            .length = mirage_fragment_get_length(fragment),
+            .main_size = mirage_fragment_main_data_get_size(fragment),
+            .subchannel_size = mirage_fragment_subchannel_data_get_size(fragment),
+        };
+        g_array_append_val(pipeline.fragments, entry);
+        g_object_unref(fragment);
+
+        pipeline.generate_subchannel |= entry.subchannel_size != 0;
+    }
+
+    /* Subchannel is generated only if original track does not provide it */
+    if (pipeline.generate_subchannel) {
+        MirageFragment *fragment = mirage_track_find_fragment_with_subchannel(original_track, NULL);
+        if (fragment) {
+            pipeline.generate_subchannel = FALSE;
+            g_object_unref(fragment);
+        }
+    }
+
+    pipeline.workers = g_thread_pool_new((GFunc)mirage_writer_conversion_worker, &pipeline, num_workers, FALSE, error);
+    if (!pipeline.workers) {
+        succeeded = FALSE;
+        goto end;
+    }
+
+    reader = g_thread_try_new("Conversion reader", (GThreadFunc)mirage_writer_conversion_reader, &pipeline, error);
+    if (!reader) {
+        g_thread_pool_free(pipeline.workers, FALSE, TRUE);
+        succeeded = FALSE;
+        goto end;
+    }
+
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_WRITER, "%s: conversion pipeline: %d worker(s), batch size %d\n", __debug__, num_workers, pipeline.batch_size);
+
+    /* Put sectors into new track, batch by batch and in order */
+    num_batches = (num_sectors + pipeline.batch_size - 1) / pipeline.batch_size;
+    for (gint sequence = 0; sequence < num_batches && succeeded; sequence++) {
+        MirageConversionBatch *batch;
+
+        g_mutex_lock(&pipeline.mutex);
+        while (!(batch = g_hash_table_lookup(pipeline.completed_batches, GUINT_TO_POINTER(sequence)))) {
+            g_cond_wait(&pipeline.cond, &pipeline.mutex);
+        }
+        g_hash_table_remove(pipeline.completed_batches, GUINT_TO_POINTER(sequence));
+        g_mutex_unlock(&pipeline.mutex);
+
+        for (gint i = 0; i < batch->num_sectors && succeeded; i++) {
+            succeeded = mirage_writer_put_converted_sector(self, new_track, batch->sectors[i], disc_layout_start, progress_step_size, conversion_progress, error);
+        }
+
+        /* Read error */
+        if (succeeded && batch->error) {
+            g_propagate_error(error, batch->error);
+            batch->error = NULL;
+            succeeded = FALSE;
+        }
+
+        /* Check if conversion is to be cancelled at user's request */
+        succeeded &= !g_cancellable_set_error_if_cancelled(cancellable, succeeded ? error : NULL);
+
+        mirage_writer_conversion_batch_free(batch, original_disc);
+
+        /* Free the slot, or stop the reader */
+        g_mutex_lock(&pipeline.mutex);
+        pipeline.batches_in_flight--;
+        pipeline.abort = !succeeded;
+        g_cond_broadcast(&pipeline.cond);
+        g_mutex_unlock(&pipeline.mutex);
+    }
+
+    /* Shut down the pipeline, and discard batches that were not written */
+    g_thread_join(reader);
+    g_thread_pool_free(pipeline.workers, FALSE, TRUE);
+
+    GHashTableIter iter;
+    MirageConversionBatch *batch;
+    g_hash_table_iter_init(&iter, pipeline.completed_batches);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&batch)) {
+        mirage_writer_conversion_batch_free(batch, original_disc);
+    }
+
+end:
+    g_hash_table_unref(pipeline.completed_batches);
+    g_array_free(pipeline.fragments, TRUE);
+    g_cond_clear(&pipeline.cond);
+    g_mutex_clear(&pipeline.mutex);
+
+    return succeeded;
+}
+
+/**********************************************************************\
+ *                       Synthetic image generation                   *
+\**********************************************************************/
+#define SYNTHETIC_CHUNK_SIZE 64
+
+static inline guint32 mirage_writer_synthetic_next (guint32 *state)
+{
+    /* xorshift32 */
+    guint32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static gint mirage_writer_generate_sector_data (MirageSectorType type, gint address, guint32 seed, gboolean pregap, guint8 *buffer)
+{
+    static const guint8 subheader_form1[8] = { 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x08, 0x00 };
+    static const guint8 subheader_form2[8] = { 0x00, 0x00, 0x28, 0x00, 0x00, 0x00, 0x28, 0x00 };
+
+    guint8 *data = buffer;
+    gint data_length;
+    gint length;
+    guint32 state;
+
+    /* Determine the part of the sector that is fed to the sector object;
+       for Mode 2 Form 1/2, the subheader is provided as well, so that the
+       form is known */
+    switch (type) {
+        case MIRAGE_SECTOR_AUDIO: {
+            length = data_length = 2352;
+            break;
+        }
+        case MIRAGE_SECTOR_MODE0: {
+            /* Mode 0 data is always zero */
+            memset(buffer, 0, 2336);
+            return 2336;
+        }
+        case MIRAGE_SECTOR_MODE1: {
+            length = data_length = 2048;
+            break;
+        }
+        case MIRAGE_SECTOR_MODE2: {
+            length = data_length = 2336;
+            break;
+        }
+        case MIRAGE_SECTOR_MODE2_FORM1: {
+            memcpy(buffer, subheader_form1, sizeof(subheader_form1));
+            data = buffer + sizeof(subheader_form1);
+            data_length = 2048;
+            length = 2056;
+            break;
+        }
+        case MIRAGE_SECTOR_MODE2_FORM2: {
+            memcpy(buffer, subheader_form2, sizeof(subheader_form2));
+            data = buffer + sizeof(subheader_form2);
+            data_length = 2324;
+            length = 2332;
+            break;
+        }
+        default: {
+            return -1;
+        }
+    }
+
+    /* Pregap sectors are empty */
+    if (pregap) {
+        memset(data, 0, data_length);
+        return length;
+    }
+
+    /* Seed the generator from seed and sector address only, so that
+       sector content does not depend on the order of generation */
+    state = (seed ^ ((guint32)address * 0x9E3779B9U)) | 1;
+    for (gint i = 0; i < 4; i++) {
+        mirage_writer_synthetic_next(&state);
+    }
+
+    /* Roughly half of the chunks repeat the preceding one, which makes
+       the data about 2:1 compressible */
+    for (gint offset = 0; offset < data_length; offset += SYNTHETIC_CHUNK_SIZE) {
+        gint chunk_length = MIN(SYNTHETIC_CHUNK_SIZE, data_length - offset);
+        guint32 value = 0;
+
+        if (offset && (mirage_writer_synthetic_next(&state) & 1)) {
+            memcpy(data + offset, data + offset - SYNTHETIC_CHUNK_SIZE, chunk_length);
+            continue;
+        }
+
+        for (gint i = 0; i < chunk_length; i++) {
+            if (!(i & 3)) {
+                value = mirage_writer_synthetic_next(&state);
+            }
+            data[offset + i] = value >> ((i & 3) * 8);
+        }
+    }
+
+    return length;
+}
+
+static gboolean mirage_writer_generate_track_sectors (MirageWriter *self, MirageTrack *original_track, MirageTrack *new_track, guint32 seed, gint disc_layout_start, guint progress_step_size, guint *conversion_progress, GCancellable *cancellable, GError **error)
+{
+    MirageSectorType sector_type = mirage_track_get_sector_type(original_track);
+    gint num_sectors = mirage_track_layout_get_length(original_track);
+    gint start_sector = mirage_track_layout_get_start_sector(original_track);
+    gint track_start = mirage_track_get_track_start(original_track);
+    guint8 buffer[2352];
+
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_WRITER, "%s: generating sectors (%d)\n", __debug__, num_sectors);
+
+    for (gint i = 0; i < num_sectors; i++) {
+        gint address = start_sector + i;
+        gint length = mirage_writer_generate_sector_data(sector_type, address, seed, i < track_start, buffer);
+        MirageSector *sector;
+        gboolean succeeded;
+
+        if (length < 0) {
+            g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_WRITER_ERROR, Q_("Cannot generate sectors of type %d!"), sector_type);
+            return FALSE;
+        }
+
+        /* Sector needs a parent track in order to generate subchannel */
+        sector = g_object_new(MIRAGE_TYPE_SECTOR, NULL);
+        mirage_object_set_parent(MIRAGE_OBJECT(sector), original_track);
+
+        succeeded = mirage_sector_feed_data(sector, address, sector_type, buffer, length, MIRAGE_SUBCHANNEL_NONE, NULL, 0, 0, error) &&
+            mirage_writer_put_converted_sector(self, new_track, sector, disc_layout_start, progress_step_size, conversion_progress, error);
+        g_object_unref(sector);
+
+        /* Check if generation is to be cancelled at user's request */
+        succeeded &= !g_cancellable_set_error_if_cancelled(cancellable, succeeded ? error : NULL);
+
+        if (!succeeded) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+
+/**********************************************************************\
+ *                          Image conversion                          *
+\**********************************************************************/
+/* Common implementation of mirage_writer_convert_image() and
+   mirage_writer_generate_image(); if @synthetic is set, the layout of
+   @original_disc is reproduced, but sector data is generated from @seed */
+static gboolean mirage_writer_write_image (MirageWriter *self, const gchar *filename, MirageDisc *original_disc, gboolean synthetic, guint32 seed, GHashTable *parameters, GCancellable *cancellable, GError **error)
 {
     /* Conversion progress tracking */
     gint num_all_sectors = mirage_disc_layout_get_length(original_disc);
@@ -578,7 +1067,7 @@ gboolean mirage_writer_convert_image (MirageWriter *self, const gchar *filename,
     guint progress_step_size = num_all_sectors*self->priv->progress_step/100;
     guint conversion_progress = 0;
 
-    MIRAGE_DEBUG(self, MIRAGE_DEBUG_WRITER, "%s: image conversion; filename '%s', original disc: %p\n", __debug__, filename, original_disc);
+    MIRAGE_DEBUG(self, MIRAGE_DEBUG_WRITER, "%s: image %s; filename '%s', original disc: %p\n", __debug__, synthetic ? "generation" : "conversion", filename, original_disc);
 
     /* Create disc */
     MirageDisc *new_disc = g_object_new(MIRAGE_TYPE_DISC, NULL);
@@ -649,7 +1138,7 @@ gboolean mirage_writer_convert_image (MirageWriter *self, const gchar *filename,
             gint num_fragments;
 
             gint track_start;
-            gint num_sectors;
+            gboolean succeeded;
 
             MIRAGE_DEBUG(self, MIRAGE_DEBUG_WRITER, "%s: processing track %d...\n", __debug__, j);
 
@@ -731,43 +1220,19 @@ gboolean mirage_writer_convert_image (MirageWriter *self, const gchar *filename,
                 g_object_unref(fragment);
             }
 
-            /* Now, copy sectors, one by one */
-            num_sectors = mirage_track_layout_get_length(original_track);
-            MIRAGE_DEBUG(self, MIRAGE_DEBUG_WRITER, "%s: copying sectors (%d)\n", __debug__, num_sectors);
-            for (gint sector_address = 0; sector_address < num_sectors; sector_address++) {
-                gboolean succeeded = TRUE;
-
-                /* Get sector from original track using track-relative address... */
-                MirageSector *sector = mirage_track_get_sector(original_track, sector_address, FALSE, error);
-                if (sector) {
-                    if (progress_step_size) {
-                        gint sector_count = mirage_sector_get_address(sector) - disc_layout_start;
-
-                        if (sector_count >= conversion_progress*progress_step_size) {
-                            g_signal_emit_by_name(self, "conversion-progress", conversion_progress*self->priv->progress_step, NULL);
-                            conversion_progress++;
-                        }
-                    }
-
-                    /* ... and put it into new track */
-                    succeeded = mirage_track_put_sector(new_track, sector, error);
-
-                    g_object_unref(sector);
-                } else {
-                    succeeded = FALSE;
-                }
-
-                /* Check if conversion is to be cancelled at user's request */
-                succeeded &= !g_cancellable_set_error_if_cancelled(cancellable, error);
-
-                if (!succeeded) {
-                    g_object_unref(new_track);
-                    g_object_unref(original_track);
-                    g_object_unref(new_session);
-                    g_object_unref(original_session);
-                    g_object_unref(new_disc);
-                    return FALSE;
-                }
+            /* Now, copy (or generate) sectors */
+            if (synthetic) {
+                succeeded = mirage_writer_generate_track_sectors(self, original_track, new_track, seed, disc_layout_start, progress_step_size, &conversion_progress, cancellable, error);
+            } else {
+                succeeded = mirage_writer_convert_track_sectors(self, original_disc, original_track, new_track, disc_layout_start, progress_step_size, &conversion_progress, cancellable, error);
+            }
+            if (!succeeded) {
+                g_object_unref(new_track);
+                g_object_unref(original_track);
+                g_object_unref(new_session);
+                g_object_unref(original_session);
+                g_object_unref(new_disc);
+                return FALSE;
             }
 
             g_object_unref(new_track);
@@ -788,6 +1253,64 @@ gboolean mirage_writer_convert_image (MirageWriter *self, const gchar *filename,
     return TRUE;
 }
 
+/**
+ * mirage_writer_convert_image:
+ * @self: a #MirageWriter
+ * @filename: (in): filename of output image
+ * @original_disc: (in): disc layout obtained from original image
+ * @parameters: (in) (element-type utf8 GLib.Variant): writer parameters
+ * @cancellable: (in) (allow-none): optional %GCancellable object, NULL to ignore.
+ * @error: (out) (allow-none): location to store error, or %NULL
+ *
+ * Convenience function that converts an already-opened image stored in
+ * @original_disc and writes it to @filename. If conversion progress
+ * reporting is enabled via mirage_writer_set_conversion_progress_step(),
+ * the #MirageWriter::conversion-progress signal is emitted at specified
+ * time intervals during conversion.
+ *
+ * Unless disabled via mirage_writer_set_conversion_batch_size(), sectors
+ * are copied using a pipeline that reads and reconstructs them in
+ * background threads; the signal is still emitted from the calling thread.
+ *
+ * Returns: %TRUE on success, %FALSE on failure
+ */
+gboolean mirage_writer_convert_image (MirageWriter *self, const gchar *filename, MirageDisc *original_disc, GHashTable *parameters, GCancellable *cancellable, GError **error)
+{
+    return mirage_writer_write_image(self, filename, original_disc, FALSE, 0, parameters, cancellable, error);
+}
+
+/**
+ * mirage_writer_generate_image:
+ * @self: a #MirageWriter
+ * @filename: (in): filename of output image
+ * @template_disc: (in): disc describing the layout of generated image
+ * @seed: (in): seed for generated sector data
+ * @parameters: (in) (element-type utf8 GLib.Variant): writer parameters
+ * @cancellable: (in) (allow-none): optional %GCancellable object, NULL to ignore.
+ * @error: (out) (allow-none): location to store error, or %NULL
+ *
+ * Generates a synthetic image and writes it to @filename. The layout of
+ * the image (sessions, tracks, their sector types and fragment lengths)
+ * is copied from @template_disc, which is typically constructed by the
+ * caller and does not need any data streams.
+ *
+ * Sector data is pseudo-random, and depends only on @seed and sector
+ * address; generating an image with same layout, seed and parameters
+ * therefore always yields identical files. Pregap sectors are left empty.
+ * About half of the data is repeated, so that generated images are
+ * compressible. Supported sector types are audio, Mode 0, Mode 1, Mode 2
+ * and Mode 2 Form 1/2.
+ *
+ * Conversion progress is reported in the same way as with
+ * mirage_writer_convert_image().
+ *
+ * Returns: %TRUE on success, %FALSE on failure
+ */
+gboolean mirage_writer_generate_image (MirageWriter *self, const gchar *filename, MirageDisc *template_disc, guint32 seed, GHashTable *parameters, GCancellable *cancellable, GError **error)
+{
+    return mirage_writer_write_image(self, filename, template_disc, TRUE, seed, parameters, cancellable, error);
+}
+
 
 /**********************************************************************\
  *                             Object init                            *
@@ -807,6 +1330,9 @@ static void mirage_writer_init (MirageWriter *self)
 
     /* Conversion progress; disabled by default */
     self->priv->progress_step = 0;
+
+    /* Conversion pipeline; enabled by default */
+    self->priv->conversion_batch_size = 64;
 }
 
 static void mirage_writer_dispose (GObject *gobject)
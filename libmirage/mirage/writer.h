@@ -154,7 +154,12 @@ gboolean mirage_writer_finalize_image (MirageWriter *self, MirageDisc *disc, GEr
 
 guint mirage_writer_get_conversion_progress_step (MirageWriter *self);
 void mirage_writer_set_conversion_progress_step (MirageWriter *self, guint step);
+
+guint mirage_writer_get_conversion_batch_size (MirageWriter *self);
+void mirage_writer_set_conversion_batch_size (MirageWriter *self, guint batch_size);
+
 gboolean mirage_writer_convert_image (MirageWriter *self, const gchar *filename, MirageDisc *original_disc, GHashTable *parameters, GCancellable *cancellable, GError **error);
+gboolean mirage_writer_generate_image (MirageWriter *self, const gchar *filename, MirageDisc *template_disc, guint32 seed, GHashTable *parameters, GCancellable *cancellable, GError **error);
 
 G_END_DECLS
 
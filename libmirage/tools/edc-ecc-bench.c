@@ -0,0 +1,204 @@
+/*
+ *  libMirage: EDC/ECC micro-benchmark
+ *  Copyright (C) 2006-2014 Rok Mandeljc
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* Compares EDC/ECC implementations that are available on the running CPU:
+   each one is first checked against the generic implementation, and then
+   timed on generating EDC/ECC for Mode 1, Mode 2 Form 1 and Mode 2 Form 2
+   sectors. */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <mirage/mirage.h>
+
+
+static gint num_sectors = 100000;
+
+static GOptionEntry option_entries[] = {
+    { "sectors", 'n', 0, G_OPTION_ARG_INT, &num_sectors, "Number of sectors to process per test", "N" },
+    { NULL }
+};
+
+
+/**********************************************************************\
+ *                             Sector data                            *
+\**********************************************************************/
+static void generate_edc_ecc (guint8 *sector, MirageSectorType type)
+{
+    switch (type) {
+        case MIRAGE_SECTOR_MODE1: {
+            mirage_helper_sector_edc_ecc_compute_edc_block(sector+0x00, 0x810, sector+0x810);
+            mirage_helper_sector_edc_ecc_compute_ecc_block(sector+0xC, 86, 24, 2, 86, sector+0x81C);
+            mirage_helper_sector_edc_ecc_compute_ecc_block(sector+0xC, 52, 43, 86, 88, sector+0x8C8);
+            break;
+        }
+        case MIRAGE_SECTOR_MODE2_FORM1: {
+            /* Header is zeroed while computing ECC */
+            guint8 header[4];
+            memcpy(header, sector+0xC, 4);
+            memset(sector+0xC, 0, 4);
+            mirage_helper_sector_edc_ecc_compute_edc_block(sector+0x10, 0x808, sector+0x818);
+            mirage_helper_sector_edc_ecc_compute_ecc_block(sector+0xC, 86, 24, 2, 86, sector+0x81C);
+            mirage_helper_sector_edc_ecc_compute_ecc_block(sector+0xC, 52, 43, 86, 88, sector+0x8C8);
+            memcpy(sector+0xC, header, 4);
+            break;
+        }
+        case MIRAGE_SECTOR_MODE2_FORM2: {
+            mirage_helper_sector_edc_ecc_compute_edc_block(sector+0x10, 0x91C, sector+0x92C);
+            break;
+        }
+        default: {
+            g_assert_not_reached();
+        }
+    }
+}
+
+static guint8 *create_test_data (gint count)
+{
+    guint8 *data = g_malloc(count * 2352);
+    GRand *rand = g_rand_new_with_seed(0x43444d55);
+
+    for (gint i = 0; i < count * 2352; i += 4) {
+        guint32 value = g_rand_int(rand);
+        memcpy(data + i, &value, 4);
+    }
+
+    g_rand_free(rand);
+
+    return data;
+}
+
+
+/**********************************************************************\
+ *                              Benchmark                             *
+\**********************************************************************/
+static const struct {
+    MirageSectorType type;
+    const gchar *name;
+} sector_types[] = {
+    { MIRAGE_SECTOR_MODE1, "Mode 1" },
+    { MIRAGE_SECTOR_MODE2_FORM1, "Mode 2 Form 1" },
+    { MIRAGE_SECTOR_MODE2_FORM2, "Mode 2 Form 2" },
+};
+
+/* Number of distinct sectors that are cycled through; small enough to
+   stay in cache, so that we measure computation rather than memory */
+#define NUM_TEST_SECTORS 64
+
+static gboolean verify_implementation (const gchar *name, const guint8 *data)
+{
+    guint8 reference[2352], sector[2352];
+
+    for (guint t = 0; t < G_N_ELEMENTS(sector_types); t++) {
+        for (gint i = 0; i < NUM_TEST_SECTORS; i++) {
+            memcpy(reference, data + i*2352, 2352);
+            memcpy(sector, data + i*2352, 2352);
+
+            mirage_helper_sector_edc_ecc_set_implementation("generic", NULL);
+            generate_edc_ecc(reference, sector_types[t].type);
+
+            mirage_helper_sector_edc_ecc_set_implementation(name, NULL);
+            generate_edc_ecc(sector, sector_types[t].type);
+
+            if (memcmp(reference, sector, 2352)) {
+                g_printerr("%s: result mismatch for %s sector #%d!\n", name, sector_types[t].name, i);
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+static gdouble run_benchmark (const gchar *name, MirageSectorType type, guint8 *data)
+{
+    gint64 start, end;
+
+    mirage_helper_sector_edc_ecc_set_implementation(name, NULL);
+
+    start = g_get_monotonic_time();
+    for (gint i = 0; i < num_sectors; i++) {
+        generate_edc_ecc(data + (i % NUM_TEST_SECTORS)*2352, type);
+    }
+    end = g_get_monotonic_time();
+
+    return (gdouble)(end - start) / num_sectors * 1000.0; /* ns per sector */
+}
+
+
+/**********************************************************************\
+ *                                Main                                *
+\**********************************************************************/
+int main (int argc, char **argv)
+{
+    GOptionContext *context;
+    GError *local_error = NULL;
+    const gchar * const *implementations;
+    gdouble baseline[G_N_ELEMENTS(sector_types)];
+    guint8 *data;
+    gboolean succeeded = TRUE;
+
+    context = g_option_context_new("- benchmark libMirage EDC/ECC implementations");
+    g_option_context_add_main_entries(context, option_entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &local_error)) {
+        g_printerr("Failed to parse options: %s\n", local_error->message);
+        g_error_free(local_error);
+        g_option_context_free(context);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(context);
+
+    if (num_sectors <= 0) {
+        g_printerr("Number of sectors must be positive!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!mirage_initialize(&local_error)) {
+        g_printerr("Failed to initialize libMirage: %s\n", local_error->message);
+        g_error_free(local_error);
+        return EXIT_FAILURE;
+    }
+
+    g_print("Default implementation: %s\n\n", mirage_helper_sector_edc_ecc_get_implementation());
+
+    data = create_test_data(NUM_TEST_SECTORS);
+    implementations = mirage_helper_sector_edc_ecc_get_implementations();
+
+    g_print("%-16s %-16s %12s %10s\n", "Implementation", "Sector type", "ns/sector", "Speed-up");
+    for (gint i = 0; implementations[i]; i++) {
+        if (!verify_implementation(implementations[i], data)) {
+            succeeded = FALSE;
+            continue;
+        }
+
+        for (guint t = 0; t < G_N_ELEMENTS(sector_types); t++) {
+            gdouble ns = run_benchmark(implementations[i], sector_types[t].type, data);
+            if (i == 0) {
+                baseline[t] = ns;
+            }
+            g_print("%-16s %-16s %12.1f %9.2fx\n", implementations[i], sector_types[t].name, ns, baseline[t] / ns);
+        }
+    }
+
+    g_free(data);
+
+    mirage_shutdown(NULL);
+
+    return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,500 @@
+/*
+ *  libMirage: read-path benchmark
+ *  Copyright (C) 2006-2014 Rok Mandeljc
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* Loads an image and measures the performance of libMirage's read path:
+   time needed to load the image, sequential and random sector access via
+   mirage_disc_get_sector(), reads into pooled sector objects, and READ
+   CD-style extraction of raw sector data with subchannel. For each test,
+   throughput, per-sector latency percentiles and allocation counts are
+   reported, so that results can be compared between libMirage versions,
+   parsers and filter streams. */
+
+/* Needed for clock_gettime() with -std=c99 */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <mirage/mirage.h>
+
+/* Heap usage is only available with glibc */
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define HAVE_MALLINFO2 1
+#endif
+
+
+/**********************************************************************\
+ *                              Options                               *
+\**********************************************************************/
+static gint num_sectors = 10000;
+static gint num_random = -1;
+static gint load_runs = 3;
+static gint seed = 0;
+static gint debug_mask = 0;
+static gchar *password = NULL;
+static gchar **tests = NULL;
+static gchar **filenames = NULL;
+
+static GOptionEntry option_entries[] = {
+    { "sectors", 'n', 0, G_OPTION_ARG_INT, &num_sectors, "Number of sectors to read in sequential tests (default: 10000)", "N" },
+    { "random", 'r', 0, G_OPTION_ARG_INT, &num_random, "Number of sectors to read in random test (default: same as --sectors)", "N" },
+    { "load-runs", 'l', 0, G_OPTION_ARG_INT, &load_runs, "Number of times the image is loaded in load test (default: 3)", "N" },
+    { "seed", 's', 0, G_OPTION_ARG_INT, &seed, "Seed for random test (default: 0)", "SEED" },
+    { "debug-mask", 'd', 0, G_OPTION_ARG_INT, &debug_mask, "libMirage debug mask (default: 0)", "MASK" },
+    { "password", 'p', 0, G_OPTION_ARG_STRING, &password, "Password for encrypted images", "PASSWORD" },
+    { "test", 't', 0, G_OPTION_ARG_STRING_ARRAY, &tests, "Test to run; can be given multiple times (load, sequential, random, pooled, readcd; default: all)", "TEST" },
+    { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &filenames, NULL, "IMAGE_FILE..." },
+    { NULL }
+};
+
+static gboolean test_enabled (const gchar *name)
+{
+    if (!tests) {
+        return TRUE;
+    }
+
+    for (gint i = 0; tests[i]; i++) {
+        if (!g_strcmp0(tests[i], name)) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+
+/**********************************************************************\
+ *                         Timing and statistics                      *
+\**********************************************************************/
+static gint64 get_time_ns (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (gint64)ts.tv_sec * G_GINT64_CONSTANT(1000000000) + ts.tv_nsec;
+}
+
+static gint64 get_heap_usage (void)
+{
+#ifdef HAVE_MALLINFO2
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return -1;
+#endif
+}
+
+typedef struct
+{
+    const gchar *name;
+
+    gint num_ops;
+    gint num_errors;
+    guint64 num_bytes;
+
+    gint64 *latencies; /* ns, one per operation */
+    gint64 total_time; /* ns */
+
+    /* Allocations */
+    guint64 num_objects; /* Newly created sector objects */
+    gint64 heap_start;
+    gint64 heap_end;
+
+    /* Block cache */
+    guint64 cache_hits;
+    guint64 cache_misses;
+} BenchResult;
+
+static void bench_result_init (BenchResult *result, const gchar *name, gint num_ops)
+{
+    memset(result, 0, sizeof(*result));
+    result->name = name;
+    result->latencies = g_new0(gint64, MAX(num_ops, 1));
+}
+
+static void bench_result_free (BenchResult *result)
+{
+    g_free(result->latencies);
+}
+
+static gint compare_gint64 (gconstpointer a, gconstpointer b)
+{
+    gint64 x = *(const gint64 *)a;
+    gint64 y = *(const gint64 *)b;
+    return (x > y) - (x < y);
+}
+
+static gdouble get_percentile (const gint64 *sorted, gint count, gdouble percentile)
+{
+    gint index;
+
+    if (!count) {
+        return 0;
+    }
+
+    index = (gint)(percentile / 100.0 * (count - 1) + 0.5);
+    return sorted[CLAMP(index, 0, count - 1)] / 1000.0; /* µs */
+}
+
+static void print_header (void)
+{
+    g_print("%-12s %8s %12s %10s %10s %10s %10s %10s %12s %12s\n", "Test", "Sectors", "Sectors/s", "MB/s", "p50 [us]", "p99 [us]", "max [us]", "Objects", "Heap delta", "Cache h/m");
+}
+
+static void print_result (BenchResult *result)
+{
+    gdouble seconds = result->total_time / 1e9;
+    gchar *heap_str;
+    gchar *cache_str;
+
+    qsort(result->latencies, result->num_ops, sizeof(gint64), compare_gint64);
+
+    if (result->heap_start >= 0 && result->heap_end >= 0) {
+        heap_str = g_strdup_printf("%+" G_GINT64_FORMAT, result->heap_end - result->heap_start);
+    } else {
+        heap_str = g_strdup("n/a");
+    }
+    cache_str = g_strdup_printf("%" G_GUINT64_FORMAT "/%" G_GUINT64_FORMAT, result->cache_hits, result->cache_misses);
+
+    g_print("%-12s %8d %12.0f %10.2f %10.2f %10.2f %10.2f %10" G_GUINT64_FORMAT " %12s %12s\n",
+        result->name,
+        result->num_ops,
+        seconds > 0 ? result->num_ops / seconds : 0,
+        seconds > 0 ? result->num_bytes / seconds / (1024*1024) : 0,
+        get_percentile(result->latencies, result->num_ops, 50),
+        get_percentile(result->latencies, result->num_ops, 99),
+        get_percentile(result->latencies, result->num_ops, 100),
+        result->num_objects,
+        heap_str,
+        cache_str);
+
+    if (result->num_errors) {
+        g_print("%-12s %d read(s) failed!\n", "", result->num_errors);
+    }
+
+    g_free(heap_str);
+    g_free(cache_str);
+}
+
+
+/**********************************************************************\
+ *                             Image loading                          *
+\**********************************************************************/
+static gchar *password_function (gpointer user_data G_GNUC_UNUSED)
+{
+    return g_strdup(password);
+}
+
+static MirageContext *create_context (void)
+{
+    MirageContext *context = g_object_new(MIRAGE_TYPE_CONTEXT, NULL);
+
+    mirage_context_set_debug_domain(context, "MIRAGE");
+    mirage_context_set_debug_name(context, "mirage-bench");
+    mirage_context_set_debug_mask(context, debug_mask);
+    mirage_context_set_password_function(context, password_function, NULL, NULL);
+
+    return context;
+}
+
+static MirageDisc *load_image (MirageContext *context, gint64 *load_time, GError **error)
+{
+    MirageDisc *disc;
+    gint64 start;
+
+    start = get_time_ns();
+    disc = mirage_context_load_image(context, filenames, error);
+    *load_time = get_time_ns() - start;
+
+    return disc;
+}
+
+static gboolean run_load_test (void)
+{
+    gint64 *times = g_new0(gint64, load_runs);
+    gint64 first_time;
+    gboolean succeeded = TRUE;
+
+    for (gint i = 0; i < load_runs; i++) {
+        MirageContext *context = create_context();
+        GError *local_error = NULL;
+        MirageDisc *disc;
+
+        disc = load_image(context, &times[i], &local_error);
+        g_object_unref(context);
+
+        if (!disc) {
+            g_printerr("Failed to load image: %s\n", local_error->message);
+            g_error_free(local_error);
+            succeeded = FALSE;
+            break;
+        }
+        g_object_unref(disc);
+    }
+
+    if (succeeded) {
+        first_time = times[0];
+        qsort(times, load_runs, sizeof(gint64), compare_gint64);
+        g_print("Load time (%d runs): first %.3f ms, min %.3f ms, median %.3f ms, max %.3f ms\n\n",
+            load_runs, first_time / 1e6, times[0] / 1e6, times[load_runs/2] / 1e6, times[load_runs-1] / 1e6);
+    }
+
+    g_free(times);
+
+    return succeeded;
+}
+
+
+/**********************************************************************\
+ *                              Read tests                            *
+\**********************************************************************/
+typedef enum
+{
+    READ_GET_SECTOR,
+    READ_POOLED,
+    READ_RAW_SUBCHANNEL,
+} ReadMethod;
+
+static void begin_test (BenchResult *result, MirageContext *context)
+{
+    mirage_context_cache_get_statistics(context, &result->cache_hits, &result->cache_misses, NULL, NULL);
+    result->heap_start = get_heap_usage();
+}
+
+static void end_test (BenchResult *result, MirageContext *context)
+{
+    guint64 hits, misses;
+
+    result->heap_end = get_heap_usage();
+    mirage_context_cache_get_statistics(context, &hits, &misses, NULL, NULL);
+    result->cache_hits = hits - result->cache_hits;
+    result->cache_misses = misses - result->cache_misses;
+}
+
+static void run_read_test (BenchResult *result, MirageContext *context, MirageDisc *disc, const gint *addresses, gint count, ReadMethod method)
+{
+    MirageSector *sector = NULL;
+    guint64 allocations_start = 0, allocations_end = 0;
+    gint64 test_start;
+
+    bench_result_init(result, result->name, count);
+
+    mirage_disc_get_sector_pool_statistics(disc, &allocations_start, NULL);
+    begin_test(result, context);
+
+    if (method != READ_GET_SECTOR) {
+        sector = mirage_disc_acquire_sector(disc);
+    }
+
+    test_start = get_time_ns();
+
+    for (gint i = 0; i < count; i++) {
+        gint64 start = get_time_ns();
+        const guint8 *data;
+        gint data_length;
+
+        switch (method) {
+            case READ_GET_SECTOR: {
+                MirageSector *new_sector = mirage_disc_get_sector(disc, addresses[i], NULL);
+                if (!new_sector) {
+                    result->num_errors++;
+                    break;
+                }
+                if (mirage_sector_get_data(new_sector, &data, &data_length, NULL)) {
+                    result->num_bytes += data_length;
+                }
+                result->num_objects++;
+                g_object_unref(new_sector);
+                break;
+            }
+            case READ_POOLED: {
+                if (!mirage_disc_read_sector(disc, addresses[i], sector, NULL)) {
+                    result->num_errors++;
+                    break;
+                }
+                if (mirage_sector_get_data(sector, &data, &data_length, NULL)) {
+                    result->num_bytes += data_length;
+                }
+                break;
+            }
+            case READ_RAW_SUBCHANNEL: {
+                const guint8 *subchannel;
+                if (!mirage_disc_read_sector(disc, addresses[i], sector, NULL) ||
+                    !mirage_sector_extract_data(sector, &data, 2352, MIRAGE_SUBCHANNEL_PW, &subchannel, 96, NULL)) {
+                    result->num_errors++;
+                    break;
+                }
+                result->num_bytes += 2352 + 96;
+                break;
+            }
+        }
+
+        result->latencies[result->num_ops++] = get_time_ns() - start;
+    }
+
+    result->total_time = get_time_ns() - test_start;
+
+    if (sector) {
+        mirage_disc_release_sector(disc, sector);
+    }
+
+    end_test(result, context);
+
+    if (method != READ_GET_SECTOR) {
+        mirage_disc_get_sector_pool_statistics(disc, &allocations_end, NULL);
+        result->num_objects = allocations_end - allocations_start;
+    }
+}
+
+static void run_read_tests (MirageContext *context, MirageDisc *disc)
+{
+    gint start_sector = mirage_disc_layout_get_start_sector(disc);
+    gint length = mirage_disc_layout_get_length(disc);
+    gint count = MIN(num_sectors, length);
+    gint random_count = num_random < 0 ? count : num_random;
+    gint *sequential_addresses;
+    gint *random_addresses;
+    GRand *rng;
+
+    g_print("Disc layout: start sector %d, length %d sectors, %d session(s), %d track(s)\n\n",
+        start_sector, length, mirage_disc_get_number_of_sessions(disc), mirage_disc_get_number_of_tracks(disc));
+
+    sequential_addresses = g_new(gint, MAX(count, 1));
+    for (gint i = 0; i < count; i++) {
+        sequential_addresses[i] = start_sector + i;
+    }
+
+    rng = g_rand_new_with_seed(seed);
+    random_addresses = g_new(gint, MAX(random_count, 1));
+    for (gint i = 0; i < random_count; i++) {
+        random_addresses[i] = g_rand_int_range(rng, start_sector, start_sector + MAX(length, 1));
+    }
+    g_rand_free(rng);
+
+    print_header();
+
+    if (test_enabled("sequential")) {
+        BenchResult result = { .name = "sequential" };
+        run_read_test(&result, context, disc, sequential_addresses, count, READ_GET_SECTOR);
+        print_result(&result);
+        bench_result_free(&result);
+    }
+
+    if (test_enabled("random")) {
+        BenchResult result = { .name = "random" };
+        run_read_test(&result, context, disc, random_addresses, random_count, READ_GET_SECTOR);
+        print_result(&result);
+        bench_result_free(&result);
+    }
+
+    if (test_enabled("pooled")) {
+        BenchResult result = { .name = "pooled" };
+        run_read_test(&result, context, disc, sequential_addresses, count, READ_POOLED);
+        print_result(&result);
+        bench_result_free(&result);
+    }
+
+    if (test_enabled("readcd")) {
+        BenchResult result = { .name = "readcd" };
+        run_read_test(&result, context, disc, sequential_addresses, count, READ_RAW_SUBCHANNEL);
+        print_result(&result);
+        bench_result_free(&result);
+    }
+
+    g_free(sequential_addresses);
+    g_free(random_addresses);
+}
+
+
+/**********************************************************************\
+ *                                Main                                *
+\**********************************************************************/
+int main (int argc, char **argv)
+{
+    GOptionContext *option_context;
+    GError *local_error = NULL;
+    MirageContext *context;
+    MirageDisc *disc;
+    gint64 load_time;
+    gint ret = EXIT_SUCCESS;
+
+    option_context = g_option_context_new("- benchmark libMirage read path");
+    g_option_context_add_main_entries(option_context, option_entries, NULL);
+    if (!g_option_context_parse(option_context, &argc, &argv, &local_error)) {
+        g_printerr("Failed to parse options: %s\n", local_error->message);
+        g_error_free(local_error);
+        g_option_context_free(option_context);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(option_context);
+
+    if (!filenames || !filenames[0]) {
+        g_printerr("No image file given!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (num_sectors < 0 || load_runs < 1) {
+        g_printerr("Invalid number of sectors or load runs!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!mirage_initialize(&local_error)) {
+        g_printerr("Failed to initialize libMirage: %s\n", local_error->message);
+        g_error_free(local_error);
+        return EXIT_FAILURE;
+    }
+
+    g_print("libMirage %s; EDC/ECC implementation: %s\n", mirage_version_long, mirage_helper_sector_edc_ecc_get_implementation());
+    g_print("Image: %s\n\n", filenames[0]);
+
+    /* Load test; each run uses a new context, so that the block cache
+       is cold */
+    if (test_enabled("load") && !run_load_test()) {
+        ret = EXIT_FAILURE;
+        goto end;
+    }
+
+    /* Read tests share a single loaded image */
+    if (test_enabled("sequential") || test_enabled("random") || test_enabled("pooled") || test_enabled("readcd")) {
+        context = create_context();
+        disc = load_image(context, &load_time, &local_error);
+        if (!disc) {
+            g_printerr("Failed to load image: %s\n", local_error->message);
+            g_error_free(local_error);
+            g_object_unref(context);
+            ret = EXIT_FAILURE;
+            goto end;
+        }
+
+        run_read_tests(context, disc);
+
+        g_object_unref(disc);
+        g_object_unref(context);
+    }
+
+end:
+    mirage_shutdown(NULL);
+
+    g_strfreev(filenames);
+    g_strfreev(tests);
+    g_free(password);
+
+    return ret;
+}
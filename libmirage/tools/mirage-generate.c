@@ -0,0 +1,758 @@
+/*
+ *  libMirage: synthetic image generator
+ *  Copyright (C) 2006-2014 Rok Mandeljc
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* Generates deterministic test images using mirage_writer_generate_image()
+   and any of libMirage's image writers. The disc layout is given as a list
+   of tracks with their sector types and lengths; sector data depends only
+   on the seed. Data files of the written image can optionally be wrapped
+   in gzip, xz or ECM, so that the corresponding filter streams can be
+   benchmarked as well. The descriptor file (if any) is left as it is;
+   libMirage finds the data files by their compressed names. */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <gio/gio.h>
+#include <mirage/mirage.h>
+
+#ifdef HAVE_LIBLZMA
+#include <lzma.h>
+#endif
+
+
+/**********************************************************************\
+ *                              Options                               *
+\**********************************************************************/
+static gchar *output = NULL;
+static gchar *writer_id = NULL;
+static gchar **track_specs = NULL;
+static gint seed = 0;
+static gboolean write_raw = FALSE;
+static gboolean write_subchannel = FALSE;
+static gchar *compression = NULL;
+static gint debug_mask = 0;
+
+static GOptionEntry option_entries[] = {
+    { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output, "Output image file", "FILE" },
+    { "writer", 'w', 0, G_OPTION_ARG_STRING, &writer_id, "Image writer ID (default: WRITER-TOC)", "ID" },
+    { "track", 't', 0, G_OPTION_ARG_STRING_ARRAY, &track_specs, "Track, given as TYPE:LENGTH; can be given multiple times (types: audio, mode0, mode1, mode2, mode2-form1, mode2-form2; default: mode1:10000)", "TYPE:LENGTH" },
+    { "seed", 's', 0, G_OPTION_ARG_INT, &seed, "Seed for sector data (default: 0)", "SEED" },
+    { "raw", 'r', 0, G_OPTION_ARG_NONE, &write_raw, "Write full 2352-byte sectors", NULL },
+    { "subchannel", 'S', 0, G_OPTION_ARG_NONE, &write_subchannel, "Write subchannel data (implies --raw)", NULL },
+    { "compress", 'c', 0, G_OPTION_ARG_STRING, &compression, "Wrap data files in gzip, xz or ecm", "FORMAT" },
+    { "debug-mask", 'd', 0, G_OPTION_ARG_INT, &debug_mask, "libMirage debug mask (default: 0)", "MASK" },
+    { NULL }
+};
+
+static const struct {
+    const gchar *name;
+    MirageSectorType type;
+} sector_types[] = {
+    { "audio", MIRAGE_SECTOR_AUDIO },
+    { "mode0", MIRAGE_SECTOR_MODE0 },
+    { "mode1", MIRAGE_SECTOR_MODE1 },
+    { "mode2", MIRAGE_SECTOR_MODE2 },
+    { "mode2-form1", MIRAGE_SECTOR_MODE2_FORM1 },
+    { "mode2-form2", MIRAGE_SECTOR_MODE2_FORM2 },
+};
+
+
+/**********************************************************************\
+ *                              Context                               *
+\**********************************************************************/
+static MirageContext *create_context (void)
+{
+    MirageContext *context = g_object_new(MIRAGE_TYPE_CONTEXT, NULL);
+
+    mirage_context_set_debug_domain(context, "MIRAGE");
+    mirage_context_set_debug_name(context, "mirage-generate");
+    mirage_context_set_debug_mask(context, debug_mask);
+
+    return context;
+}
+
+
+/**********************************************************************\
+ *                           Template disc                            *
+\**********************************************************************/
+static gboolean parse_track_spec (const gchar *spec, MirageSectorType *type, gint *length)
+{
+    gchar **tokens = g_strsplit(spec, ":", 2);
+    gboolean valid = FALSE;
+
+    if (g_strv_length(tokens) == 2) {
+        gchar *end;
+
+        *length = strtol(tokens[1], &end, 10);
+
+        for (guint i = 0; i < G_N_ELEMENTS(sector_types); i++) {
+            if (!g_ascii_strcasecmp(tokens[0], sector_types[i].name)) {
+                *type = sector_types[i].type;
+                valid = !*end && *length > 0;
+                break;
+            }
+        }
+    }
+
+    g_strfreev(tokens);
+
+    return valid;
+}
+
+static MirageDisc *create_template_disc (GError **error)
+{
+    static const gchar *default_track_specs[] = { "mode1:10000", NULL };
+    const gchar * const *specs = track_specs ? (const gchar * const *)track_specs : default_track_specs;
+
+    MirageDisc *disc;
+    MirageSession *session;
+    MirageSessionType session_type = MIRAGE_SESSION_CDDA;
+    MirageSectorType previous_type = MIRAGE_SECTOR_AUDIO;
+
+    disc = g_object_new(MIRAGE_TYPE_DISC, NULL);
+    mirage_disc_set_medium_type(disc, MIRAGE_MEDIUM_CD);
+    mirage_disc_layout_set_start_sector(disc, -150);
+
+    session = g_object_new(MIRAGE_TYPE_SESSION, NULL);
+    mirage_disc_add_session_by_index(disc, -1, session);
+
+    for (gint i = 0; specs[i]; i++) {
+        MirageSectorType type;
+        MirageTrack *track;
+        MirageFragment *fragment;
+        gint length;
+        gint pregap = 0;
+
+        if (!parse_track_spec(specs[i], &type, &length)) {
+            g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_LIBRARY_ERROR, "Invalid track specification '%s'!", specs[i]);
+            g_object_unref(session);
+            g_object_unref(disc);
+            return NULL;
+        }
+
+        track = g_object_new(MIRAGE_TYPE_TRACK, NULL);
+        mirage_session_add_track_by_index(session, -1, track);
+        mirage_track_set_sector_type(track, type);
+
+        /* First track, and tracks that switch between audio and data,
+           get a 150-sector pregap */
+        if (!i || ((type == MIRAGE_SECTOR_AUDIO) != (previous_type == MIRAGE_SECTOR_AUDIO))) {
+            pregap = 150;
+
+            fragment = g_object_new(MIRAGE_TYPE_FRAGMENT, NULL);
+            mirage_fragment_set_length(fragment, pregap);
+            mirage_track_add_fragment(track, -1, fragment);
+            g_object_unref(fragment);
+
+            mirage_track_set_track_start(track, pregap);
+        }
+
+        /* Data fragment; it has no stream, as data is generated */
+        fragment = g_object_new(MIRAGE_TYPE_FRAGMENT, NULL);
+        mirage_fragment_set_length(fragment, length);
+        mirage_track_add_fragment(track, -1, fragment);
+        g_object_unref(fragment);
+
+        g_object_unref(track);
+
+        /* Session type follows the track types */
+        if (type == MIRAGE_SECTOR_MODE2 || type == MIRAGE_SECTOR_MODE2_FORM1 || type == MIRAGE_SECTOR_MODE2_FORM2) {
+            session_type = MIRAGE_SESSION_CDROM_XA;
+        } else if (type != MIRAGE_SECTOR_AUDIO && session_type == MIRAGE_SESSION_CDDA) {
+            session_type = MIRAGE_SESSION_CDROM;
+        }
+
+        previous_type = type;
+    }
+
+    mirage_session_set_session_type(session, session_type);
+    g_object_unref(session);
+
+    return disc;
+}
+
+
+/**********************************************************************\
+ *                            ECM encoder                             *
+\**********************************************************************/
+#define ECM_LITERAL 0
+#define ECM_MODE1_2352 1
+#define ECM_MODE2_FORM1_2336 2
+#define ECM_MODE2_FORM2_2336 3
+
+#define ECM_FLUSH_SIZE 1048576
+
+typedef struct
+{
+    GOutputStream *stream;
+
+    /* Pending record */
+    gint type;
+    guint32 count;
+    GByteArray *payload;
+
+    /* EDC of the whole decoded data */
+    guint32 edc;
+    guint32 edc_lut[256];
+} EcmEncoder;
+
+static const guint8 ecm_signature[4] = { 'E', 'C', 'M', 0x00 };
+
+static void ecm_encoder_init (EcmEncoder *encoder, GOutputStream *stream)
+{
+    encoder->stream = stream;
+    encoder->type = ECM_LITERAL;
+    encoder->count = 0;
+    encoder->payload = g_byte_array_sized_new(ECM_FLUSH_SIZE);
+    encoder->edc = 0;
+
+    /* EDC is a reflected CRC-32 with polynomial 0xD8018001 */
+    for (guint32 i = 0; i < 256; i++) {
+        guint32 edc = i;
+        for (gint j = 0; j < 8; j++) {
+            edc = (edc >> 1) ^ (edc & 1 ? 0xD8018001 : 0);
+        }
+        encoder->edc_lut[i] = edc;
+    }
+}
+
+static void ecm_encoder_free (EcmEncoder *encoder)
+{
+    g_byte_array_free(encoder->payload, TRUE);
+}
+
+static gboolean ecm_encoder_write_record_header (EcmEncoder *encoder, gint type, guint32 count, GError **error)
+{
+    guint8 header[5];
+    gsize length = 0;
+    guint32 num = count - 1; /* End marker is encoded with count of 0 */
+
+    header[length++] = ((num >= 32) << 7) | ((num & 31) << 2) | type;
+    num >>= 5;
+    while (num) {
+        header[length++] = ((num >= 128) << 7) | (num & 127);
+        num >>= 7;
+    }
+
+    return g_output_stream_write_all(encoder->stream, header, length, NULL, NULL, error);
+}
+
+static gboolean ecm_encoder_flush (EcmEncoder *encoder, GError **error)
+{
+    if (!encoder->count) {
+        return TRUE;
+    }
+
+    if (!ecm_encoder_write_record_header(encoder, encoder->type, encoder->count, error) ||
+        !g_output_stream_write_all(encoder->stream, encoder->payload->data, encoder->payload->len, NULL, NULL, error)) {
+        return FALSE;
+    }
+
+    encoder->count = 0;
+    g_byte_array_set_size(encoder->payload, 0);
+
+    return TRUE;
+}
+
+/* Appends @count units of given type to the pending record; consecutive
+   units of the same type are merged into a single record */
+static gboolean ecm_encoder_put (EcmEncoder *encoder, gint type, guint32 count, const guint8 *payload, gsize payload_length, GError **error)
+{
+    if (encoder->count && (encoder->type != type || encoder->payload->len >= ECM_FLUSH_SIZE)) {
+        if (!ecm_encoder_flush(encoder, error)) {
+            return FALSE;
+        }
+    }
+
+    encoder->type = type;
+    encoder->count += count;
+    g_byte_array_append(encoder->payload, payload, payload_length);
+
+    return TRUE;
+}
+
+static void ecm_encoder_update_edc (EcmEncoder *encoder, const guint8 *data, gsize length)
+{
+    guint32 edc = encoder->edc;
+
+    for (gsize i = 0; i < length; i++) {
+        edc = (edc >> 8) ^ encoder->edc_lut[(edc ^ data[i]) & 0xFF];
+    }
+
+    encoder->edc = edc;
+}
+
+static gboolean ecm_encoder_finish (EcmEncoder *encoder, GError **error)
+{
+    guint32 edc = GUINT32_TO_LE(encoder->edc);
+
+    return ecm_encoder_flush(encoder, error) &&
+        ecm_encoder_write_record_header(encoder, ECM_LITERAL, 0, error) &&
+        g_output_stream_write_all(encoder->stream, &edc, sizeof(edc), NULL, NULL, error);
+}
+
+/* Checks whether 2352-byte Mode 1 sector can be reconstructed from its
+   address and user data; mirrors the reconstruction in ECM filter */
+static gboolean ecm_sector_is_mode1 (const guint8 *sector)
+{
+    guint8 buffer[2352];
+
+    if (memcmp(sector, mirage_pattern_sync, sizeof(mirage_pattern_sync)) || sector[0x00F] != 1) {
+        return FALSE;
+    }
+
+    memcpy(buffer, sector, 0x810);
+    memset(buffer+0x810, 0, sizeof(buffer) - 0x810);
+
+    mirage_helper_sector_edc_ecc_compute_edc_block(buffer+0x000, 0x810, buffer+0x810);
+    mirage_helper_sector_edc_ecc_compute_ecc_block(buffer+0x00C, 86, 24, 2, 86, buffer+0x81C); /* P */
+    mirage_helper_sector_edc_ecc_compute_ecc_block(buffer+0x00C, 52, 43, 86, 88, buffer+0x8C8); /* Q */
+
+    return !memcmp(buffer, sector, sizeof(buffer));
+}
+
+/* Determines ECM type of 2336-byte Mode 2 block (subheader onwards) */
+static gint ecm_block_get_mode2_type (const guint8 *block)
+{
+    guint8 sector[2352];
+
+    /* Both copies of subheader must match */
+    if (memcmp(block, block+4, 4)) {
+        return ECM_LITERAL;
+    }
+
+    /* Form 1 */
+    memset(sector, 0, sizeof(sector));
+    memcpy(sector+0x010, block, 0x808);
+    mirage_helper_sector_edc_ecc_compute_edc_block(sector+0x010, 0x808, sector+0x818);
+    mirage_helper_sector_edc_ecc_compute_ecc_block(sector+0x00C, 86, 24, 2, 86, sector+0x81C); /* P */
+    mirage_helper_sector_edc_ecc_compute_ecc_block(sector+0x00C, 52, 43, 86, 88, sector+0x8C8); /* Q */
+    if (!memcmp(sector+0x010, block, 2336)) {
+        return ECM_MODE2_FORM1_2336;
+    }
+
+    /* Form 2 */
+    memcpy(sector+0x010, block, 0x91C);
+    mirage_helper_sector_edc_ecc_compute_edc_block(sector+0x010, 0x91C, sector+0x92C);
+    if (!memcmp(sector+0x010, block, 2336)) {
+        return ECM_MODE2_FORM2_2336;
+    }
+
+    return ECM_LITERAL;
+}
+
+static gboolean ecm_encode_mode2_block (EcmEncoder *encoder, const guint8 *block, GError **error)
+{
+    switch (ecm_block_get_mode2_type(block)) {
+        case ECM_MODE2_FORM1_2336: {
+            return ecm_encoder_put(encoder, ECM_MODE2_FORM1_2336, 1, block+4, 0x804, error);
+        }
+        case ECM_MODE2_FORM2_2336: {
+            return ecm_encoder_put(encoder, ECM_MODE2_FORM2_2336, 1, block+4, 0x918, error);
+        }
+        default: {
+            return ecm_encoder_put(encoder, ECM_LITERAL, 2336, block, 2336, error);
+        }
+    }
+}
+
+/* Encodes a single sector; @main_size is the size of main channel data
+   in the file (2352 or 2336 can be reduced, everything else is stored
+   literally), and @subchannel_size the size of interleaved subchannel */
+static gboolean ecm_encode_sector (EcmEncoder *encoder, const guint8 *sector, gint main_size, gint subchannel_size, GError **error)
+{
+    gboolean succeeded;
+
+    if (main_size == 2352) {
+        if (ecm_sector_is_mode1(sector)) {
+            guint8 payload[3+2048];
+            memcpy(payload, sector+0x00C, 3);
+            memcpy(payload+3, sector+0x010, 2048);
+            succeeded = ecm_encoder_put(encoder, ECM_MODE1_2352, 1, payload, sizeof(payload), error);
+        } else if (!memcmp(sector, mirage_pattern_sync, sizeof(mirage_pattern_sync)) && sector[0x00F] == 2) {
+            /* Sync and header are stored literally */
+            succeeded = ecm_encoder_put(encoder, ECM_LITERAL, 16, sector, 16, error) &&
+                ecm_encode_mode2_block(encoder, sector+16, error);
+        } else {
+            succeeded = ecm_encoder_put(encoder, ECM_LITERAL, 2352, sector, 2352, error);
+        }
+    } else if (main_size == 2336) {
+        succeeded = ecm_encode_mode2_block(encoder, sector, error);
+    } else {
+        succeeded = ecm_encoder_put(encoder, ECM_LITERAL, main_size, sector, main_size, error);
+    }
+
+    if (succeeded && subchannel_size) {
+        succeeded = ecm_encoder_put(encoder, ECM_LITERAL, subchannel_size, sector+main_size, subchannel_size, error);
+    }
+
+    ecm_encoder_update_edc(encoder, sector, main_size + subchannel_size);
+
+    return succeeded;
+}
+
+static gboolean compress_ecm (GInputStream *input, GOutputStream *output, gint main_size, gint subchannel_size, GError **error)
+{
+    gint sector_size = main_size + subchannel_size;
+    gsize buffer_size = 64*sector_size;
+    guint8 *buffer = g_malloc(buffer_size);
+    gboolean succeeded;
+    EcmEncoder encoder;
+
+    ecm_encoder_init(&encoder, output);
+
+    succeeded = g_output_stream_write_all(output, ecm_signature, sizeof(ecm_signature), NULL, NULL, error);
+
+    while (succeeded) {
+        gsize length, offset;
+
+        if (!g_input_stream_read_all(input, buffer, buffer_size, &length, NULL, error)) {
+            succeeded = FALSE;
+            break;
+        }
+
+        /* Whole sectors */
+        for (offset = 0; succeeded && offset + sector_size <= length; offset += sector_size) {
+            succeeded = ecm_encode_sector(&encoder, buffer+offset, main_size, subchannel_size, error);
+        }
+
+        /* Trailing data */
+        if (succeeded && offset < length) {
+            succeeded = ecm_encoder_put(&encoder, ECM_LITERAL, length - offset, buffer+offset, length - offset, error);
+            ecm_encoder_update_edc(&encoder, buffer+offset, length - offset);
+        }
+
+        if (length < buffer_size) {
+            break;
+        }
+    }
+
+    succeeded = succeeded && ecm_encoder_finish(&encoder, error);
+
+    ecm_encoder_free(&encoder);
+    g_free(buffer);
+
+    return succeeded;
+}
+
+
+/**********************************************************************\
+ *                           Compression                              *
+\**********************************************************************/
+static gboolean compress_gzip (GInputStream *input, GOutputStream *output, GError **error)
+{
+    GZlibCompressor *compressor = g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_GZIP, 6);
+    GOutputStream *converter = g_converter_output_stream_new(output, G_CONVERTER(compressor));
+    gboolean succeeded;
+
+    succeeded = g_output_stream_splice(converter, input, G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET, NULL, error) >= 0;
+
+    g_object_unref(converter);
+    g_object_unref(compressor);
+
+    return succeeded;
+}
+
+#ifdef HAVE_LIBLZMA
+/* Filter stream only supports blocks of up to 10 MB */
+#define XZ_BLOCK_SIZE 1048576
+
+static gboolean compress_xz (GInputStream *input, GOutputStream *output, GError **error)
+{
+    lzma_stream strm = LZMA_STREAM_INIT;
+    guint8 *in_buffer = g_malloc(XZ_BLOCK_SIZE);
+    guint8 out_buffer[65536];
+    gboolean eof = FALSE;
+    gboolean succeeded = TRUE;
+
+    if (lzma_easy_encoder(&strm, 6, LZMA_CHECK_CRC64) != LZMA_OK) {
+        g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_STREAM_ERROR, "Failed to initialize xz encoder!");
+        g_free(in_buffer);
+        return FALSE;
+    }
+
+    while (succeeded && !eof) {
+        gsize in_length;
+        lzma_action action;
+        lzma_ret ret;
+
+        if (!g_input_stream_read_all(input, in_buffer, XZ_BLOCK_SIZE, &in_length, NULL, error)) {
+            succeeded = FALSE;
+            break;
+        }
+        eof = in_length < XZ_BLOCK_SIZE;
+
+        /* Every input block is flushed into its own xz block, so that
+           filter stream can seek within the file */
+        action = eof ? LZMA_FINISH : LZMA_FULL_FLUSH;
+
+        strm.next_in = in_buffer;
+        strm.avail_in = in_length;
+
+        do {
+            strm.next_out = out_buffer;
+            strm.avail_out = sizeof(out_buffer);
+
+            ret = lzma_code(&strm, action);
+            if (ret != LZMA_OK && ret != LZMA_STREAM_END) {
+                g_set_error(error, MIRAGE_ERROR, MIRAGE_ERROR_STREAM_ERROR, "xz encoder error %d!", ret);
+                succeeded = FALSE;
+                break;
+            }
+
+            if (!g_output_stream_write_all(output, out_buffer, sizeof(out_buffer) - strm.avail_out, NULL, NULL, error)) {
+                succeeded = FALSE;
+                break;
+            }
+        } while (ret != LZMA_STREAM_END);
+    }
+
+    lzma_end(&strm);
+    g_free(in_buffer);
+
+    return succeeded && g_output_stream_close(output, NULL, error);
+}
+#endif
+
+static gboolean compression_supported (const gchar *name)
+{
+    return !g_strcmp0(name, "gzip") ||
+#ifdef HAVE_LIBLZMA
+        !g_strcmp0(name, "xz") ||
+#endif
+        !g_strcmp0(name, "ecm");
+}
+
+static gboolean compress_file (const gchar *filename, gint main_size, gint subchannel_size, GError **error)
+{
+    gchar *compressed_filename = g_strconcat(filename, ".", compression, NULL);
+    GFile *file = g_file_new_for_path(filename);
+    GFile *compressed_file = g_file_new_for_path(compressed_filename);
+    GFileInputStream *input;
+    GFileOutputStream *output;
+    gboolean succeeded = FALSE;
+
+    input = g_file_read(file, NULL, error);
+    if (!input) {
+        goto end;
+    }
+
+    output = g_file_replace(compressed_file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, error);
+    if (!output) {
+        g_object_unref(input);
+        goto end;
+    }
+
+    if (!g_strcmp0(compression, "gzip")) {
+        succeeded = compress_gzip(G_INPUT_STREAM(input), G_OUTPUT_STREAM(output), error);
+#ifdef HAVE_LIBLZMA
+    } else if (!g_strcmp0(compression, "xz")) {
+        succeeded = compress_xz(G_INPUT_STREAM(input), G_OUTPUT_STREAM(output), error);
+#endif
+    } else {
+        succeeded = compress_ecm(G_INPUT_STREAM(input), G_OUTPUT_STREAM(output), main_size, subchannel_size, error) &&
+            g_output_stream_close(G_OUTPUT_STREAM(output), NULL, error);
+    }
+
+    g_object_unref(output);
+    g_object_unref(input);
+
+    /* Replace original with the compressed file */
+    if (succeeded) {
+        succeeded = g_file_delete(file, NULL, error);
+        g_print("  %s -> %s\n", filename, compressed_filename);
+    } else {
+        g_file_delete(compressed_file, NULL, NULL);
+    }
+
+end:
+    g_object_unref(compressed_file);
+    g_object_unref(file);
+    g_free(compressed_filename);
+
+    return succeeded;
+}
+
+typedef struct
+{
+    gint main_size;
+    gint subchannel_size;
+} DataFileInfo;
+
+/* Loads the generated image to verify it and to find its data files,
+   and wraps each of them with chosen compression */
+static gboolean compress_image (GError **error)
+{
+    MirageContext *context = create_context();
+    gchar *filenames[] = { output, NULL };
+    GHashTable *data_files;
+    GHashTableIter iter;
+    gpointer key, value;
+    MirageDisc *disc;
+    gboolean succeeded = TRUE;
+
+    disc = mirage_context_load_image(context, filenames, error);
+    if (!disc) {
+        g_object_unref(context);
+        return FALSE;
+    }
+
+    data_files = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+
+    for (gint i = 0; i < mirage_disc_get_number_of_tracks(disc); i++) {
+        MirageTrack *track = mirage_disc_get_track_by_index(disc, i, NULL);
+
+        for (gint j = 0; j < mirage_track_get_number_of_fragments(track); j++) {
+            MirageFragment *fragment = mirage_track_get_fragment_by_index(track, j, NULL);
+            const gchar *filename = mirage_fragment_main_data_get_filename(fragment);
+
+            if (filename && !g_hash_table_contains(data_files, filename)) {
+                DataFileInfo *info = g_new0(DataFileInfo, 1);
+
+                info->main_size = mirage_fragment_main_data_get_size(fragment);
+                if (mirage_fragment_subchannel_data_get_format(fragment) & MIRAGE_SUBCHANNEL_DATA_FORMAT_INTERNAL) {
+                    info->subchannel_size = mirage_fragment_subchannel_data_get_size(fragment);
+                }
+
+                g_hash_table_insert(data_files, g_strdup(filename), info);
+            }
+
+            g_object_unref(fragment);
+        }
+
+        g_object_unref(track);
+    }
+
+    /* Release the image before touching its files */
+    g_object_unref(disc);
+    g_object_unref(context);
+
+    g_print("Compressing data files (%s):\n", compression);
+
+    g_hash_table_iter_init(&iter, data_files);
+    while (succeeded && g_hash_table_iter_next(&iter, &key, &value)) {
+        DataFileInfo *info = value;
+        succeeded = compress_file(key, info->main_size, info->subchannel_size, error);
+    }
+
+    g_hash_table_unref(data_files);
+
+    return succeeded;
+}
+
+
+/**********************************************************************\
+ *                                Main                                *
+\**********************************************************************/
+int main (int argc, char **argv)
+{
+    GOptionContext *option_context;
+    GError *local_error = NULL;
+    MirageContext *context;
+    MirageWriter *writer = NULL;
+    MirageDisc *template_disc = NULL;
+    GHashTable *parameters;
+    gint ret = EXIT_FAILURE;
+
+    option_context = g_option_context_new("- generate synthetic test images");
+    g_option_context_add_main_entries(option_context, option_entries, NULL);
+    if (!g_option_context_parse(option_context, &argc, &argv, &local_error)) {
+        g_printerr("Failed to parse options: %s\n", local_error->message);
+        g_error_free(local_error);
+        g_option_context_free(option_context);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(option_context);
+
+    if (!output) {
+        g_printerr("No output file given!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (compression && !compression_supported(compression)) {
+        g_printerr("Unsupported compression '%s'!\n", compression);
+        return EXIT_FAILURE;
+    }
+
+    if (!mirage_initialize(&local_error)) {
+        g_printerr("Failed to initialize libMirage: %s\n", local_error->message);
+        g_error_free(local_error);
+        return EXIT_FAILURE;
+    }
+
+    context = create_context();
+
+    /* Template disc */
+    template_disc = create_template_disc(&local_error);
+    if (!template_disc) {
+        goto end;
+    }
+
+    /* Writer */
+    writer = mirage_create_writer(writer_id ? writer_id : "WRITER-TOC", &local_error);
+    if (!writer) {
+        goto end;
+    }
+    mirage_contextual_set_context(MIRAGE_CONTEXTUAL(writer), context);
+
+    parameters = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
+    g_hash_table_insert(parameters, g_strdup("writer.write_raw"), g_variant_ref_sink(g_variant_new_boolean(write_raw)));
+    g_hash_table_insert(parameters, g_strdup("writer.write_subchannel"), g_variant_ref_sink(g_variant_new_boolean(write_subchannel)));
+
+    g_print("Generating %s: %d sectors, seed %d\n", output, mirage_disc_layout_get_length(template_disc), seed);
+
+    if (!mirage_writer_generate_image(writer, output, template_disc, seed, parameters, NULL, &local_error)) {
+        g_hash_table_unref(parameters);
+        goto end;
+    }
+    g_hash_table_unref(parameters);
+
+    /* Drop the writer, so that all its output streams get closed */
+    g_object_unref(writer);
+    writer = NULL;
+
+    if (compression && !compress_image(&local_error)) {
+        goto end;
+    }
+
+    ret = EXIT_SUCCESS;
+
+end:
+    if (local_error) {
+        g_printerr("Failed to generate image: %s\n", local_error->message);
+        g_error_free(local_error);
+    }
+
+    if (writer) {
+        g_object_unref(writer);
+    }
+    if (template_disc) {
+        g_object_unref(template_disc);
+    }
+    g_object_unref(context);
+
+    mirage_shutdown(NULL);
+
+    g_free(output);
+    g_free(writer_id);
+    g_strfreev(track_specs);
+    g_free(compression);
+
+    return ret;
+}